@@ -2,7 +2,7 @@
 #-------------------------------------------------------------------------------
 #	Process test wave file into data files that can be plotted.
 #-------------------------------------------------------------------------------
-	ab_wav_fft --input=test_1.wav --output=test_1.csv --average=20 --interval=1000
+	ab_wav_fft --input=test_1.wav --output=test_1.csv --average=20 --interval=1000 --stream
 	gnuplot -c $AUDIO_BENCH/gnuplot/fft_display_v2.gp test_1_0000ms.csv test_1_0000ms.png "0000ms 28dB" "Frequency" "Level (dBFS)"
 	gnuplot -c $AUDIO_BENCH/gnuplot/fft_display_v2.gp test_1_1000ms.csv test_1_1000ms.png "1000ms 28dB" "Frequency" "Level (dBFS)"
 	gnuplot -c $AUDIO_BENCH/gnuplot/fft_display_v2.gp test_1_2000ms.csv test_1_2000ms.png "2000ms 28dB" "Frequency" "Level (dBFS)"
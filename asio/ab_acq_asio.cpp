@@ -35,39 +35,144 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
+#include <atomic>
 #include <popt.h>
 #include <sndfile.h>
 #include "asiosys.h"
 #include "asio.h"
 #include "iasiodrv.h"
 #include "asiodrivers.h"
+#include "ab_asio_convert.h"
+#include "ab_ring.h"
+#include "ab_asio_timing.h"
+#include "ab_monitor.h"
+#include "ab_window.h"
 
 // Global ASIO state
+#define MAX_RECORD_CHANNELS 32      // Size of bufferInfos[]
 static IASIO* asioDriver = nullptr;
 static ASIODriverInfo driverInfo;
-static ASIOBufferInfo bufferInfos[32]; // Support up to 32 channels
+static ASIOBufferInfo bufferInfos[MAX_RECORD_CHANNELS];
 static ASIOCallbacks asioCallbacks;
 static long numInputChannels = 0;
 static long numOutputChannels = 0;
 static long preferredBufferSize = 0;
 static ASIOSampleRate currentSampleRate = 48000.0;
-static bool acquisitionActive = false;
-static long totalSamplesProcessed = 0;
+static std::atomic<bool> acquisitionActive(false);
 
 // Acquisition parameters
-static SNDFILE* outputFile = nullptr;
 static SF_INFO sfInfo;
-static long channelToRecord = 0;
-static long samplesToAcquire = 0;
-static long samplesAcquired = 0;
+static SNDFILE* outputFiles[MAX_RECORD_CHANNELS];   // One interleaved file, or one per channel
+static int numOutputFiles = 0;
+static long recordChannels[MAX_RECORD_CHANNELS];    // Driver channel numbers, in bufferInfos[] order
+static long numRecordChannels = 0;
+static long long framesToAcquire = 0;               // 64-bit: long is 32 bits on Windows
+static std::atomic<long long> framesAcquired(0);
 static long outputBitDepth = 32;
 
+// Callback state, prepared in setupASIOBuffers() so bufferSwitch never
+// allocates, queries the driver or touches the file
+static AbAsioToFloatFn inputConverters[MAX_RECORD_CHANNELS];  // Per channel, see ab_asio_convert.h
+static float* conversionBuffer = nullptr;           // numRecordChannels blocks of preferredBufferSize
+static const float* channelBuffers[MAX_RECORD_CHANNELS];
+static float* interleaveBuffer = nullptr;
+
+// Single-producer/single-consumer ring between the ASIO callback and the
+// writer thread (libaudiobench, see ab_ring.h). Holds interleaved frames.
+#define RING_SECONDS        4       // Ring capacity in seconds of audio
+#define WRITE_CHUNK         16384   // Largest single sf_writef_float() call, in frames
+#define WRITER_POLL_MS      10      // Writer sleep when the ring is empty
+static AbRing* ring = nullptr;
+static std::atomic<long> droppedFrames(0);
+static std::atomic<bool> writerDone(false);
+static float* splitBuffer = nullptr;                // Writer-side de-interleave for --split
+static sf_count_t framesWritten = 0;                // Writer thread only until joined
+static std::atomic<bool> writeError(false);
+
+// Callback timing and missed buffers (see ab_asio_timing.h)
+static AbCbStats cbStats;
+static std::atomic<long> driverXruns(0);
+
+// Monitor mode (--monitor): the main thread drains the ring into an
+// AbMonitor instead of a file (libaudiobench, see ab_monitor.h)
+#define MONITOR_INTERVAL    0.5     // Default seconds between updates
+#define MONITOR_FUNDAMENTAL 1000.0  // Default THD fundamental, Hz
+#define MONITOR_FRAME_SIZE  8192    // Tone frame for the THD+N estimate
+#define MONITOR_HARMONICS   10
+#define MONITOR_TRACK_HZ    50.0    // Fundamental tracking range, +/- Hz
+static std::atomic<bool> interrupted(false);
+
 // Forward declarations
 static void bufferSwitch(long index, ASIOBool processNow);
 static void sampleRateChanged(ASIOSampleRate sRate);
 static long asioMessages(long selector, long value, void* message, double* opt);
 static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow);
 
+//------------------------------------------------------------------------------
+// Ring buffer and writer thread
+//------------------------------------------------------------------------------
+
+// Write interleaved frames to the single output file, or split them into
+// one mono file per channel
+static bool writeFrames(const float* frames, sf_count_t count)
+{
+    if (numOutputFiles == 1) {
+        return sf_writef_float(outputFiles[0], frames, count) == count;
+    }
+
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        for (sf_count_t i = 0; i < count; i++) {
+            splitBuffer[i] = frames[i * numRecordChannels + ch];
+        }
+        if (sf_writef_float(outputFiles[ch], splitBuffer, count) != count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Consumer side: drains the ring to the output file(s) until writerDone is
+// set and everything queued before it has been written. Writes straight
+// from the ring's spans, in chunks of at most WRITE_CHUNK frames.
+static DWORD WINAPI writerThread(LPVOID)
+{
+    const size_t chunk = (size_t)WRITE_CHUNK * numRecordChannels;
+
+    for (;;) {
+        bool done = writerDone.load(std::memory_order_acquire);
+        AbRingSpans spans;
+
+        if (ab_ring_peek(ring, &spans) == 0) {
+            if (done) {
+                break;
+            }
+            Sleep(WRITER_POLL_MS);
+            continue;
+        }
+
+        for (int s = 0; s < 2; s++) {
+            for (size_t offset = 0; offset < spans.count[s]; ) {
+                size_t count = spans.count[s] - offset;
+                if (count > chunk) {
+                    count = chunk;
+                }
+
+                sf_count_t frames = (sf_count_t)(count / numRecordChannels);
+                bool ok = writeFrames(spans.data[s] + offset, frames);
+                ab_ring_consume(ring, count);
+                if (!ok) {
+                    writeError.store(true, std::memory_order_release);
+                    return 0;
+                }
+                framesWritten += frames;
+                offset += count;
+            }
+        }
+    }
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 // ASIO Callbacks
 //------------------------------------------------------------------------------
@@ -79,94 +184,45 @@ static void bufferSwitch(long index, ASIOBool processNow)
 
 static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow)
 {
-    if (!acquisitionActive || !outputFile) {
+    if (!acquisitionActive.load(std::memory_order_relaxed)) {
         return nullptr;
     }
 
-    // Process the input buffer for the channel we're recording
-    ASIOBufferInfo* info = &bufferInfos[channelToRecord];
+    double start = ab_cbstats_now();
+    if (bufferInfos[0].buffers[index]) {
+        long long acquired = framesAcquired.load(std::memory_order_relaxed);
+        long framesToWrite = preferredBufferSize;
 
-    if (info->buffers[index]) {
-        ASIOChannelInfo channelInfo;
-        channelInfo.channel = info->channelNum;
-        channelInfo.isInput = ASIOTrue;
-        ASIOGetChannelInfo(&channelInfo);
-        
-        long bufferSize = preferredBufferSize;
-        long samplesToWrite = bufferSize;
-        
-        if (samplesAcquired + samplesToWrite > samplesToAcquire) {
-            samplesToWrite = samplesToAcquire - samplesAcquired;
+        if (acquired + framesToWrite > framesToAcquire) {
+            framesToWrite = (long)(framesToAcquire - acquired);
         }
-        
-        // Convert samples based on ASIO sample type
-        void* buffer = info->buffers[index];
-        float* floatBuffer = new float[samplesToWrite];
-
-        switch (channelInfo.type) {
-            case ASIOSTInt16LSB:
-            {
-                short* samples = (short*)buffer;
-                for (long i = 0; i < samplesToWrite; i++) {
-                    floatBuffer[i] = samples[i] / 32768.0f;
-                }
-                break;
-            }
-            case ASIOSTInt24LSB:
-            {
-                unsigned char* samples = (unsigned char*)buffer;
-                for (long i = 0; i < samplesToWrite; i++) {
-                    // Reconstruct 24-bit signed integer from 3 bytes (LSB first)
-                    int s24 = samples[i*3] | (samples[i*3+1] << 8) | (samples[i*3+2] << 16);
-                    // Sign extend from 24-bit to 32-bit
-                    if (s24 & 0x800000) {
-                        s24 |= 0xFF000000;
-                    }
-                    floatBuffer[i] = s24 / 8388608.0f;  // 2^23
-                }
-                break;
-            }
-            case ASIOSTInt32LSB:
-            {
-                int* samples = (int*)buffer;
-                for (long i = 0; i < samplesToWrite; i++) {
-                    floatBuffer[i] = samples[i] / 2147483648.0f;
-                }
-                break;
-            }
-            case ASIOSTFloat32LSB:
-            {
-                float* samples = (float*)buffer;
-                memcpy(floatBuffer, samples, samplesToWrite * sizeof(float));
-                break;
-            }
-            case ASIOSTFloat64LSB:
-            {
-                double* samples = (double*)buffer;
-                for (long i = 0; i < samplesToWrite; i++) {
-                    floatBuffer[i] = (float)samples[i];
-                }
-                break;
-            }
-            default:
-                printf("Unsupported sample type: %ld\n", channelInfo.type);
-                delete[] floatBuffer;
-                return nullptr;
+
+        // Convert every channel of this buffer half, so all channels stay
+        // sample-aligned, then interleave and hand off to the writer
+        for (long ch = 0; ch < numRecordChannels; ch++) {
+            inputConverters[ch](bufferInfos[ch].buffers[index],
+                                conversionBuffer + ch * preferredBufferSize, framesToWrite);
         }
 
-        // Write to WAV file - libsndfile handles conversion to target bit depth
-        sf_write_float(outputFile, floatBuffer, samplesToWrite);
-        delete[] floatBuffer;
-        
-        samplesAcquired += samplesToWrite;
-        totalSamplesProcessed += samplesToWrite;
-        
-        if (samplesAcquired >= samplesToAcquire) {
-            acquisitionActive = false;
-            printf("\nAcquisition complete: %ld samples acquired\n", samplesAcquired);
+        const float* block = conversionBuffer;
+        if (numRecordChannels > 1) {
+            ab_asio_interleave(interleaveBuffer, channelBuffers, (int)numRecordChannels, framesToWrite);
+            block = interleaveBuffer;
+        }
+
+        long pushed = (long)(ab_ring_write(ring, block, (size_t)framesToWrite * numRecordChannels) /
+                             numRecordChannels);
+        if (pushed < framesToWrite) {
+            droppedFrames.fetch_add(framesToWrite - pushed, std::memory_order_relaxed);
+        }
+
+        framesAcquired.store(acquired + framesToWrite, std::memory_order_relaxed);
+        if (acquired + framesToWrite >= framesToAcquire) {
+            acquisitionActive.store(false, std::memory_order_release);
         }
     }
-    
+
+    ab_asio_record_timing(&cbStats, timeInfo, preferredBufferSize, start);
     return nullptr;
 }
 
@@ -186,7 +242,8 @@ static long asioMessages(long selector, long value, void* message, double* opt)
                 value == kAsioLatenciesChanged ||
                 value == kAsioSupportsTimeInfo ||
                 value == kAsioSupportsTimeCode ||
-                value == kAsioSupportsInputMonitor)
+                value == kAsioSupportsInputMonitor ||
+                value == kAsioOverload)
                 return 1;
             break;
             
@@ -195,6 +252,9 @@ static long asioMessages(long selector, long value, void* message, double* opt)
             return 1;
             
         case kAsioResyncRequest:
+        case kAsioOverload:
+            // Lost sync or a late buffer: counted with the callback stats
+            driverXruns.fetch_add(1, std::memory_order_relaxed);
             return 1;
             
         case kAsioLatenciesChanged:
@@ -277,7 +337,7 @@ static bool initASIO(const char* driverName)
     return true;
 }
 
-static bool setupASIOBuffers(long inputChannel)
+static bool setupASIOBuffers()
 {
     // Setup callbacks
     asioCallbacks.bufferSwitch = bufferSwitch;
@@ -285,35 +345,153 @@ static bool setupASIOBuffers(long inputChannel)
     asioCallbacks.asioMessage = asioMessages;
     asioCallbacks.bufferSwitchTimeInfo = bufferSwitchTimeInfo;
     
-    // Create buffer info for the input channel we want to record
+    // Create buffer info for every input channel we want to record
     memset(bufferInfos, 0, sizeof(bufferInfos));
     
-    bufferInfos[0].isInput = ASIOTrue;
-    bufferInfos[0].channelNum = inputChannel;
-    bufferInfos[0].buffers[0] = bufferInfos[0].buffers[1] = nullptr;
-    
-    channelToRecord = 0; // Index in bufferInfos array
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        bufferInfos[ch].isInput = ASIOTrue;
+        bufferInfos[ch].channelNum = recordChannels[ch];
+        bufferInfos[ch].buffers[0] = bufferInfos[ch].buffers[1] = nullptr;
+    }
     
     // Create buffers
-    ASIOError err = ASIOCreateBuffers(bufferInfos, 1, preferredBufferSize, &asioCallbacks);
+    ASIOError err = ASIOCreateBuffers(bufferInfos, numRecordChannels, preferredBufferSize, &asioCallbacks);
     if (err != ASE_OK) {
         printf("ASIOCreateBuffers failed with error: %ld\n", err);
         return false;
     }
     
-    // Get channel info
-    ASIOChannelInfo channelInfo;
-    channelInfo.channel = inputChannel;
-    channelInfo.isInput = ASIOTrue;
-    err = ASIOGetChannelInfo(&channelInfo);
-    if (err == ASE_OK) {
-        printf("Channel %ld: %s, Type: %ld\n", 
-               inputChannel, channelInfo.name, channelInfo.type);
+    // Get channel info once; the callback uses the cached sample types
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        ASIOChannelInfo channelInfo;
+        channelInfo.channel = recordChannels[ch];
+        channelInfo.isInput = ASIOTrue;
+        err = ASIOGetChannelInfo(&channelInfo);
+        if (err != ASE_OK) {
+            printf("ASIOGetChannelInfo failed with error: %ld\n", err);
+            ASIODisposeBuffers();
+            return false;
+        }
+        printf("Channel %ld: %s, Type: %ld\n",
+               recordChannels[ch], channelInfo.name, channelInfo.type);
+
+        if (!ab_asio_sample_type_supported(channelInfo.type)) {
+            printf("Unsupported sample type: %ld\n", channelInfo.type);
+            ASIODisposeBuffers();
+            return false;
+        }
+        inputConverters[ch] = ab_asio_input_converter(channelInfo.type);
     }
-    
+
+    // Preallocate conversion buffers and ring (power-of-two frame count)
+    size_t ringFrames = 1;
+    while (ringFrames < (size_t)(currentSampleRate * RING_SECONDS) ||
+           ringFrames < (size_t)preferredBufferSize * 4) {
+        ringFrames <<= 1;
+    }
+    ring = ab_ring_create(ringFrames, (int)numRecordChannels);
+    if (!ring) {
+        printf("Failed to allocate ring buffer\n");
+        ASIODisposeBuffers();
+        return false;
+    }
+
+    conversionBuffer = new float[preferredBufferSize * numRecordChannels];
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        channelBuffers[ch] = conversionBuffer + ch * preferredBufferSize;
+    }
+    interleaveBuffer = new float[preferredBufferSize * numRecordChannels];
+    splitBuffer = new float[WRITE_CHUNK];
+    droppedFrames.store(0);
+
     return true;
 }
 
+static void freeAcquisitionBuffers()
+{
+    delete[] conversionBuffer;
+    delete[] interleaveBuffer;
+    delete[] splitBuffer;
+    ab_ring_destroy(ring);
+    conversionBuffer = nullptr;
+    interleaveBuffer = nullptr;
+    splitBuffer = nullptr;
+    ring = nullptr;
+}
+
+static void closeOutputFiles()
+{
+    for (int i = 0; i < numOutputFiles; i++) {
+        if (outputFiles[i]) {
+            sf_close(outputFiles[i]);
+            outputFiles[i] = nullptr;
+        }
+    }
+    numOutputFiles = 0;
+}
+
+// Parse a channel list such as "0", "0,1" or "0-3,6"; returns the number
+// of channels stored or -1 on a syntax/range error
+static long parseChannelList(const char* spec, long* list, long maxCount, long available)
+{
+    long count = 0;
+    const char* p = spec;
+
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+            p = end;
+        }
+        if (first < 0 || last < first || last >= available) {
+            return -1;
+        }
+        for (long ch = first; ch <= last; ch++) {
+            for (long i = 0; i < count; i++) {
+                if (list[i] == ch) {
+                    return -1;  // Duplicate channel
+                }
+            }
+            if (count >= maxCount) {
+                return -1;
+            }
+            list[count++] = ch;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+// Build "<base>_ch<N><ext>" from "<base><ext>" for per-channel output
+static void channelFilename(char* dest, size_t size, const char* filename, long channel)
+{
+    const char* dot = strrchr(filename, '.');
+    const char* slash = strrchr(filename, '/');
+    const char* backslash = strrchr(filename, '\\');
+    if (dot && ((slash && dot < slash) || (backslash && dot < backslash))) {
+        dot = nullptr;  // Dot belongs to a directory name
+    }
+    if (!dot) {
+        snprintf(dest, size, "%s_ch%ld", filename, channel);
+    } else {
+        snprintf(dest, size, "%.*s_ch%ld%s", (int)(dot - filename), filename, channel, dot);
+    }
+}
+
 static void shutdownASIO()
 {
     if (asioDriver) {
@@ -354,6 +532,126 @@ static void listASIODrivers()
 // Main Program
 //------------------------------------------------------------------------------
 
+//------------------------------------------------------------------------------
+// Monitor mode
+//------------------------------------------------------------------------------
+
+// Ctrl+C / Ctrl+Break end a monitor run cleanly instead of killing the process
+static BOOL WINAPI consoleHandler(DWORD type)
+{
+    if (type == CTRL_C_EVENT || type == CTRL_BREAK_EVENT) {
+        interrupted.store(true);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// AbMonitor update callback: one console line per channel, or one JSON line
+static void monitorUpdate(const AbMonitor* mon, void* user)
+{
+    bool json = *(const bool*)user;
+    uint64_t dropped = (uint64_t)droppedFrames.load(std::memory_order_relaxed);
+
+    if (json) {
+        ab_monitor_write_json(mon, stdout, dropped);
+    } else {
+        ab_monitor_print(mon, stdout, dropped);
+    }
+}
+
+// Feed everything queued in the ring to the monitor, straight from the
+// ring's spans; returns the samples taken
+static size_t drainMonitor(AbMonitor* mon, bool* json)
+{
+    AbRingSpans spans;
+    size_t total = ab_ring_peek(ring, &spans);
+
+    for (int s = 0; s < 2; s++) {
+        if (spans.count[s] > 0) {
+            ab_monitor_push(mon, spans.data[s], spans.count[s] / numRecordChannels, monitorUpdate, json);
+        }
+    }
+    ab_ring_consume(ring, total);
+    return total;
+}
+
+// Live level and THD+N monitor on the selected channels: the callback fills
+// the ring as for a capture, this thread analyses it and nothing is written
+// to disk. duration 0 runs until Ctrl+C. With json set, the update lines on
+// stdout are JSON objects (each starts with '{'; the driver banner printed
+// by initASIO() comes before them) and the run's own messages go to stderr.
+static int runMonitor(double duration, double interval, double fundamental, bool json,
+                      const char* statsFilename)
+{
+    FILE* info = json ? stderr : stdout;
+
+    if (fundamental >= currentSampleRate / 2.0) {
+        fprintf(stderr, "Error: Fundamental %.1f Hz is not below Nyquist (%.1f Hz)\n",
+                fundamental, currentSampleRate / 2.0);
+        return 1;
+    }
+    framesToAcquire = (duration > 0.0) ? (long long)(duration * currentSampleRate) : LLONG_MAX;
+    if (framesToAcquire == 0) {
+        fprintf(stderr, "Error: Duration too short for sample rate %.0f Hz\n", currentSampleRate);
+        return 1;
+    }
+
+    if (!setupASIOBuffers()) {
+        return 1;
+    }
+
+    AbMonitor monitor;
+    const AbWindow* window = ab_window_get(AB_WINDOW_HANN, MONITOR_FRAME_SIZE, 0.0);
+    if (window == nullptr ||
+        ab_monitor_init(&monitor, currentSampleRate, (int)numRecordChannels, interval, fundamental,
+                        MONITOR_HARMONICS, MONITOR_FRAME_SIZE, window->coeffs, MONITOR_TRACK_HZ) != 0) {
+        fprintf(stderr, "Error: Failed to allocate monitor state\n");
+        ab_window_cache_free();
+        return 1;
+    }
+
+    fprintf(info, "\nMonitoring %ld channel(s) at %.0f Hz, update %.2f s, fundamental %.1f Hz (+/- %.0f Hz)\n",
+            numRecordChannels, currentSampleRate, interval, fundamental, MONITOR_TRACK_HZ);
+    fprintf(info, "Levels in dBFS; THD marked '*' while the tone tracker settles\n");
+
+    framesAcquired = 0;
+    ab_cbstats_init(&cbStats, currentSampleRate);
+    driverXruns = 0;
+    interrupted = false;
+    SetConsoleCtrlHandler(consoleHandler, TRUE);
+    acquisitionActive = true;
+
+    int status = 0;
+    ASIOError err = ASIOStart();
+    if (err != ASE_OK) {
+        fprintf(stderr, "ASIOStart failed with error: %ld\n", err);
+        acquisitionActive = false;
+        status = 1;
+    } else {
+        fprintf(info, "Monitoring... (Press Ctrl+C to stop)\n");
+        fflush(info);
+
+        while (acquisitionActive.load(std::memory_order_acquire) && !interrupted.load()) {
+            if (drainMonitor(&monitor, &json) == 0) {
+                Sleep(WRITER_POLL_MS);
+            }
+        }
+        acquisitionActive = false;
+        ASIOStop();
+        drainMonitor(&monitor, &json);
+
+        fprintf(info, "Done: %.1f s monitored, %llu updates, %ld frames dropped\n",
+                (double)monitor.frames / currentSampleRate, (unsigned long long)monitor.updates,
+                droppedFrames.load());
+        ab_asio_write_timing(&cbStats, driverXruns.load(), "ab_acq_asio", statsFilename);
+    }
+    SetConsoleCtrlHandler(consoleHandler, FALSE);
+
+    ab_monitor_free(&monitor);
+    ab_window_cache_free();
+    return status;
+}
+
 int main(int argc, const char** argv)
 {
     CoInitialize(nullptr);
@@ -364,11 +662,17 @@ int main(int argc, const char** argv)
     int acquireMode = 0;
     int versionFlag = 0;
     char* driverName = nullptr;
-    long inputChannel = 0;
+    char* channelSpec = nullptr;
+    int splitMode = 0;
     double duration = 1.0;  // Duration in seconds
     long bitDepth = 32;     // Bit depth: 16, 24, or 32
     char* outputFilename = nullptr;
     double requestedRate = 0.0;
+    char* statsFilename = nullptr;
+    int monitorMode = 0;
+    double interval = MONITOR_INTERVAL;
+    double fundamental = MONITOR_FUNDAMENTAL;
+    int jsonMode = 0;
 
     struct poptOption options[] = {
         {"version", 'v', POPT_ARG_NONE, &versionFlag, 0,
@@ -381,8 +685,10 @@ int main(int argc, const char** argv)
          "List channels for specified driver", nullptr},
         {"acquire", 'a', POPT_ARG_NONE, &acquireMode, 0,
          "Acquire audio samples", nullptr},
-        {"channel", 'c', POPT_ARG_LONG, &inputChannel, 0,
-         "Input channel number (default: 0)", "NUM"},
+        {"channel", 'c', POPT_ARG_STRING, &channelSpec, 0,
+         "Input channel(s) to record, e.g. 0, 0,1 or 0-7 (default: 0)", "LIST"},
+        {"split", 's', POPT_ARG_NONE, &splitMode, 0,
+         "Write one mono WAV per channel (FILE_chN.wav) instead of one interleaved file", nullptr},
         {"time", 't', POPT_ARG_DOUBLE, &duration, 0,
          "Recording duration in seconds (default: 1.0)", "SECONDS"},
         {"bits", 'b', POPT_ARG_LONG, &bitDepth, 0,
@@ -391,6 +697,16 @@ int main(int argc, const char** argv)
          "Output WAV file (default: output.wav)", "FILE"},
         {"rate", 'r', POPT_ARG_DOUBLE, &requestedRate, 0,
          "Sample rate in Hz (default: use current driver rate)", "HZ"},
+        {"stats", 'j', POPT_ARG_STRING, &statsFilename, 0,
+         "Write callback timing and xrun statistics as JSON", "FILE"},
+        {"monitor", 'm', POPT_ARG_NONE, &monitorMode, 0,
+         "Monitor levels and THD+N live instead of recording (-t 0 runs until Ctrl+C)", nullptr},
+        {"update", 'u', POPT_ARG_DOUBLE, &interval, 0,
+         "Monitor update interval in seconds (default: 0.5)", "SECONDS"},
+        {"freq", 'F', POPT_ARG_DOUBLE, &fundamental, 0,
+         "Monitor THD fundamental in Hz, tracked +/- 50 Hz (default: 1000)", "HZ"},
+        {"json", 'J', POPT_ARG_NONE, &jsonMode, 0,
+         "Monitor updates as JSON lines on stdout", nullptr},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -402,12 +718,17 @@ int main(int argc, const char** argv)
         "Operation Modes:\n"
         "  --list              List all available ASIO drivers\n"
         "  --driver <name> --channels    Show channels for specified driver\n"
-        "  --driver <name> --acquire     Acquire audio samples\n\n"
+        "  --driver <name> --acquire     Acquire audio samples\n"
+        "  --driver <name> --monitor     Live levels and THD+N, nothing written to disk\n\n"
         "Examples:\n"
         "  ab_acq_asio --list\n"
         "  ab_acq_asio -d \"ASIO4ALL v2\" --channels\n"
         "  ab_acq_asio -d \"ASIO4ALL v2\" -a -c 0 -t 2.0 -o test.wav -r 48000\n"
-        "  ab_acq_asio -d \"ASIO4ALL v2\" -a -c 0 -t 5.0 -b 24 -o test_24bit.wav\n");
+        "  ab_acq_asio -d \"ASIO4ALL v2\" -a -c 0 -t 5.0 -b 24 -o test_24bit.wav\n"
+        "  ab_acq_asio -d \"ASIO4ALL v2\" -a -c 0-7 -t 5.0 -o dut_8ch.wav\n"
+        "  ab_acq_asio -d \"ASIO4ALL v2\" -a -c 0-7 -s -t 5.0 -o dut.wav   # dut_ch0.wav ... dut_ch7.wav\n"
+        "  ab_acq_asio -d \"ASIO4ALL v2\" -m -c 0,1 -t 0                  # Monitor until Ctrl+C\n"
+        "  ab_acq_asio -d \"ASIO4ALL v2\" -m -c 0 -F 997 -u 0.2 -J       # JSON lines, 5 per second\n");
 
     int rc = poptGetNextOpt(popt_ctx);
     if (rc < -1) {
@@ -468,7 +789,7 @@ int main(int argc, const char** argv)
                     printf("  %2ld: %s (Type: 0x%lx)\n", i, channelInfo.name, channelInfo.type);
                 }
             }
-        } else if (acquireMode) {
+        } else if (acquireMode || monitorMode) {
             // Set sample rate if requested
             if (requestedRate > 0.0) {
                 if (ASIOCanSampleRate(requestedRate) == ASE_OK) {
@@ -483,10 +804,12 @@ int main(int argc, const char** argv)
                 }
             }
             
-            // Validate channel
-            if (inputChannel < 0 || inputChannel >= numInputChannels) {
-                printf("Error: Invalid input channel %ld (available: 0-%ld)\n",
-                       inputChannel, numInputChannels - 1);
+            // Validate channel list
+            numRecordChannels = parseChannelList(channelSpec ? channelSpec : "0", recordChannels,
+                                                 MAX_RECORD_CHANNELS, numInputChannels);
+            if (numRecordChannels <= 0) {
+                printf("Error: Invalid input channel list '%s' (available: 0-%ld, up to %d channels)\n",
+                       channelSpec ? channelSpec : "0", numInputChannels - 1, MAX_RECORD_CHANNELS);
                 shutdownASIO();
                 poptFreeContext(popt_ctx);
                 CoUninitialize();
@@ -503,16 +826,31 @@ int main(int argc, const char** argv)
             }
 
             // Validate and calculate sample count from duration
-            if (duration <= 0.0) {
-                printf("Error: Duration must be greater than 0 seconds\n");
+            if (duration < 0.0 || (duration == 0.0 && !monitorMode)) {
+                printf("Error: Duration must be greater than 0 seconds (0 is allowed with --monitor)\n");
                 shutdownASIO();
                 poptFreeContext(popt_ctx);
                 CoUninitialize();
                 return 1;
             }
 
-            long samples = (long)(duration * currentSampleRate);
-            if (samples == 0) {
+            // Monitor mode: analyse live, no output file
+            if (monitorMode) {
+                int status = 1;
+                if (interval <= 0.0 || fundamental <= 0.0) {
+                    printf("Error: Update interval and fundamental must be positive\n");
+                } else {
+                    status = runMonitor(duration, interval, fundamental, jsonMode != 0, statsFilename);
+                }
+                shutdownASIO();
+                freeAcquisitionBuffers();
+                poptFreeContext(popt_ctx);
+                CoUninitialize();
+                return status;
+            }
+
+            long frames = (long)(duration * currentSampleRate);
+            if (frames == 0) {
                 printf("Error: Duration too short for sample rate %.0f Hz\n", currentSampleRate);
                 shutdownASIO();
                 poptFreeContext(popt_ctx);
@@ -520,10 +858,10 @@ int main(int argc, const char** argv)
                 return 1;
             }
 
-            // Open output file
+            // Open output file(s): one interleaved file, or one mono file per channel
             memset(&sfInfo, 0, sizeof(sfInfo));
             sfInfo.samplerate = (int)currentSampleRate;
-            sfInfo.channels = 1;  // Mono recording
+            sfInfo.channels = splitMode ? 1 : (int)numRecordChannels;
 
             // Set format based on bit depth
             if (bitDepth == 16) {
@@ -534,48 +872,85 @@ int main(int argc, const char** argv)
                 sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
             }
 
-            outputFile = sf_open(outputFilename, SFM_WRITE, &sfInfo);
-            if (!outputFile) {
-                printf("Error: Cannot open output file: %s\n", outputFilename);
-                printf("libsndfile error: %s\n", sf_strerror(nullptr));
-                shutdownASIO();
-                poptFreeContext(popt_ctx);
-                CoUninitialize();
-                return 1;
+            int filesToOpen = splitMode ? (int)numRecordChannels : 1;
+            for (int i = 0; i < filesToOpen; i++) {
+                char channelPath[MAX_PATH];
+                const char* path = outputFilename;
+                if (splitMode) {
+                    channelFilename(channelPath, sizeof(channelPath), outputFilename, recordChannels[i]);
+                    path = channelPath;
+                }
+
+                SF_INFO info = sfInfo;
+                outputFiles[i] = sf_open(path, SFM_WRITE, &info);
+                if (!outputFiles[i]) {
+                    printf("Error: Cannot open output file: %s\n", path);
+                    printf("libsndfile error: %s\n", sf_strerror(nullptr));
+                    closeOutputFiles();
+                    shutdownASIO();
+                    poptFreeContext(popt_ctx);
+                    CoUninitialize();
+                    return 1;
+                }
+                numOutputFiles = i + 1;
+                printf("Output file: %s\n", path);
             }
-            
-            printf("\nAcquiring %.2f seconds (%" "ld samples) from channel %ld at %.0f Hz\n",
-                   duration, samples, inputChannel, currentSampleRate);
-            printf("Output file: %s\n", outputFilename);
+
+            printf("\nAcquiring %.2f seconds (%ld samples) from %ld channel(s) (%s) at %.0f Hz\n",
+                   duration, frames, numRecordChannels, channelSpec ? channelSpec : "0",
+                   currentSampleRate);
 
             // Display format based on bit depth
+            const char* layout = (sfInfo.channels == 1) ? "mono" : "interleaved";
             if (bitDepth == 16) {
-                printf("Format: WAV file (16-bit PCM, mono)\n\n");
+                printf("Format: WAV file (16-bit PCM, %s)\n\n", layout);
             } else if (bitDepth == 24) {
-                printf("Format: WAV file (24-bit PCM, mono)\n\n");
+                printf("Format: WAV file (24-bit PCM, %s)\n\n", layout);
             } else {
-                printf("Format: WAV file (32-bit float, mono)\n\n");
+                printf("Format: WAV file (32-bit float, %s)\n\n", layout);
             }
             
             // Setup buffers and start acquisition
-            if (!setupASIOBuffers(inputChannel)) {
-                sf_close(outputFile);
+            if (!setupASIOBuffers()) {
+                closeOutputFiles();
                 shutdownASIO();
                 poptFreeContext(popt_ctx);
                 CoUninitialize();
                 return 1;
             }
 
-            samplesToAcquire = samples;
-            samplesAcquired = 0;
+            framesToAcquire = frames;
+            framesAcquired = 0;
             outputBitDepth = bitDepth;
+            framesWritten = 0;
+            writeError = false;
+            writerDone = false;
+
+            HANDLE writer = CreateThread(nullptr, 0, writerThread, nullptr, 0, nullptr);
+            if (writer == nullptr) {
+                printf("Error: Failed to start writer thread\n");
+                closeOutputFiles();
+                shutdownASIO();
+                freeAcquisitionBuffers();
+                poptFreeContext(popt_ctx);
+                CoUninitialize();
+                return 1;
+            }
+
+            ab_cbstats_init(&cbStats, currentSampleRate);
+            driverXruns = 0;
             acquisitionActive = true;
 
             ASIOError err = ASIOStart();
             if (err != ASE_OK) {
                 printf("ASIOStart failed with error: %ld\n", err);
-                sf_close(outputFile);
+                acquisitionActive = false;
+                writerDone.store(true, std::memory_order_release);
+                WaitForSingleObject(writer, INFINITE);
+                CloseHandle(writer);
+                closeOutputFiles();
                 shutdownASIO();
+                freeAcquisitionBuffers();
                 poptFreeContext(popt_ctx);
                 CoUninitialize();
                 return 1;
@@ -584,19 +959,39 @@ int main(int argc, const char** argv)
             printf("Acquiring... (Press Ctrl+C to stop)\n");
             
             // Wait for acquisition to complete
-            while (acquisitionActive) {
+            int ticks = 0;
+            while (acquisitionActive.load(std::memory_order_acquire) &&
+                   !writeError.load(std::memory_order_acquire)) {
                 Sleep(100);
-                if (totalSamplesProcessed % 48000 == 0 && totalSamplesProcessed > 0) {
-                    printf("Samples: %ld / %ld\r", samplesAcquired, samplesToAcquire);
+                if (++ticks % 10 == 0) {
+                    printf("Samples: %lld / %lld\r", framesAcquired.load(), framesToAcquire);
                     fflush(stdout);
                 }
             }
+            acquisitionActive = false;
+            ASIOStop();
+            printf("\nAcquisition complete: %lld samples acquired\n", framesAcquired.load());
+            ab_asio_write_timing(&cbStats, driverXruns.load(), "ab_acq_asio", statsFilename);
+
+            // Let the writer drain what is left in the ring
+            writerDone.store(true, std::memory_order_release);
+            WaitForSingleObject(writer, INFINITE);
+            CloseHandle(writer);
+
+            if (writeError.load()) {
+                printf("Error: Write to %s failed\n", outputFilename);
+            }
+            if (droppedFrames.load() > 0) {
+                printf("Warning: %ld samples dropped per channel (disk writer fell behind)\n", droppedFrames.load());
+            }
 
-            sf_close(outputFile);
-            printf("\nAcquisition complete. WAV file written to: %s\n", outputFilename);
+            closeOutputFiles();
+            printf("WAV file(s) written: %lld samples x %ld channel(s)\n",
+                   (long long)framesWritten, numRecordChannels);
         }
 
         shutdownASIO();
+        freeAcquisitionBuffers();
     } else {
         // No valid mode specified, show help
         poptPrintHelp(popt_ctx, stderr, 0);
@@ -0,0 +1,771 @@
+//------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2025 Anthony Verbeck
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//------------------------------------------------------------------------------
+
+/*
+ * ab_asio_convert.h
+ * ASIO sample conversion shared by the ASIO tools
+ *
+ * Converts one channel's driver buffer to normalized float (-1.0 to +1.0)
+ * and back, and interleaves per-channel float buffers into frames.
+ *
+ * Every ASIO PCM and float type is covered, in both byte orders: Int16,
+ * packed Int24, Int32, Int32 with 16/18/20/24 significant bits (right
+ * justified, as ASIOSTInt32LSB16..24 and their MSB forms), Float32 and
+ * Float64. One kernel is compiled per sample type and direction from the
+ * templates below, so the byte order, container and bit count are
+ * constants inside the loop; a tool picks its kernels once per channel at
+ * buffer-creation time (ab_asio_input_converter / ab_asio_output_converter)
+ * and the callback only makes one indirect call per channel per buffer.
+ *
+ * SSE2 handles four or eight samples per step, including byte swapping;
+ * packed 24-bit reads and writes three 32-bit words per four samples
+ * instead of twelve single bytes. Without SSE2 the same templates fall
+ * back to scalar loops with identical results.
+ *
+ * Float to integer:
+ * - Input is clipped to -1.0 to +1.0 and scaled by 2^(bits-1) - 1, then
+ *   truncated toward zero (as src/ab_core.c does for WAV data)
+ * - AB_ASIO_DITHER adds TPDF dither of +/- 1 LSB of the target's
+ *   significant bits before rounding to nearest; it is ignored for 32-bit
+ *   integers and floats, whose LSB is below float resolution
+ * - AB_ASIO_CLIP also clips float targets to -1.0 to +1.0 (integer
+ *   targets always saturate)
+ */
+
+#ifndef AB_ASIO_CONVERT_H
+#define AB_ASIO_CONVERT_H
+
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "asio.h"
+#include "ab_simd.h"
+
+#define AB_ASIO_DITHER      1       // TPDF dither for integer targets of 24 bits or less
+#define AB_ASIO_CLIP        2       // Clip float targets to -1.0 to +1.0
+
+#define AB_ASIO_INT32_FLOAT_MAX 2147483520.0f   // Largest float below 2^31
+
+// Per-channel dither generator: four xorshift32 lanes, one per SSE2 lane
+struct AbAsioDither {
+    uint32_t state[4];
+};
+
+typedef void (*AbAsioToFloatFn)(const void* src, float* dst, long n);
+typedef void (*AbAsioFromFloatFn)(const float* src, void* dst, long n, AbAsioDither* dither);
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_dither_init
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Seeds the four lanes from seed (use a different seed per channel so
+//    the channels' dither is uncorrelated); xorshift needs non-zero state
+//------------------------------------------------------------------------------
+static inline void ab_asio_dither_init(AbAsioDither* dither, uint32_t seed)
+{
+    for (int i = 0; i < 4; i++) {
+        uint32_t x = (seed + (uint32_t)i) * 2654435761u;
+        dither->state[i] = x ? x : 0x9E3779B9u;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Scalar helpers
+//------------------------------------------------------------------------------
+
+static inline uint16_t ab_asio_swap16(uint16_t v)
+{
+    return (uint16_t)((v << 8) | (v >> 8));
+}
+
+static inline uint32_t ab_asio_swap32(uint32_t v)
+{
+    return (v << 24) | ((v << 8) & 0x00FF0000u) | ((v >> 8) & 0x0000FF00u) | (v >> 24);
+}
+
+static inline uint64_t ab_asio_swap64(uint64_t v)
+{
+    return ((uint64_t)ab_asio_swap32((uint32_t)v) << 32) | ab_asio_swap32((uint32_t)(v >> 32));
+}
+
+// One TPDF value in (-1, 1): the difference of the two 16-bit halves of
+// a xorshift32 draw
+static inline float ab_asio_tpdf(uint32_t* lane)
+{
+    uint32_t x = *lane;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *lane = x;
+    return (float)((int32_t)(x & 0xFFFF) - (int32_t)(x >> 16)) * (1.0f / 65536.0f);
+}
+
+// Clip, scale and quantize one sample; top caps the scaled value (2^31
+// does not fit an int32)
+template <bool Dither>
+static inline int32_t ab_asio_quantize(float x, float scale, float top, uint32_t* lane)
+{
+    if (x > 1.0f) x = 1.0f;
+    if (x < -1.0f) x = -1.0f;
+    x *= scale;
+    if (Dither) {
+        x += ab_asio_tpdf(lane);
+        if (x > scale) x = scale;
+        if (x < -scale) x = -scale;
+        return (int32_t)lrintf(x);
+    }
+    if (x > top) x = top;
+    return (int32_t)x;
+}
+
+static inline uint32_t ab_asio_load32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline void ab_asio_store32(uint8_t* p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+}
+
+#ifdef AB_SIMD_SSE2
+//------------------------------------------------------------------------------
+// SSE2 helpers
+//------------------------------------------------------------------------------
+
+static inline __m128i ab_asio_swap16_x8(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static inline __m128i ab_asio_swap32_x4(__m128i v)
+{
+    v = ab_asio_swap16_x8(v);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+}
+
+static inline __m128i ab_asio_swap64_x2(__m128i v)
+{
+    return _mm_shuffle_epi32(ab_asio_swap32_x4(v), 0xB1);
+}
+
+// Four lanes of ab_asio_tpdf()
+static inline __m128 ab_asio_tpdf_x4(__m128i* lanes)
+{
+    __m128i x = *lanes;
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    *lanes = x;
+    __m128i d = _mm_sub_epi32(_mm_and_si128(x, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(x, 16));
+    return _mm_mul_ps(_mm_cvtepi32_ps(d), _mm_set1_ps(1.0f / 65536.0f));
+}
+
+// Four lanes of ab_asio_quantize(); cvtps rounds to nearest like lrintf
+template <bool Dither>
+static inline __m128i ab_asio_quantize_x4(__m128 x, __m128 scale, __m128 top, __m128i* lanes)
+{
+    x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+    x = _mm_mul_ps(x, scale);
+    if (Dither) {
+        x = _mm_add_ps(x, ab_asio_tpdf_x4(lanes));
+        x = _mm_max_ps(_mm_min_ps(x, scale), _mm_sub_ps(_mm_setzero_ps(), scale));
+        return _mm_cvtps_epi32(x);
+    }
+    return _mm_cvttps_epi32(_mm_min_ps(x, top));
+}
+#endif
+
+//------------------------------------------------------------------------------
+//  Name:       AbAsioInt16
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Int16LSB / Int16MSB; Swap is true for MSB
+//------------------------------------------------------------------------------
+template <bool Swap>
+struct AbAsioInt16 {
+    static void toFloat(const void* src, float* dst, long n)
+    {
+        const uint16_t* in = (const uint16_t*)src;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+        for (; i + 8 <= n; i += 8) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+            if (Swap) s = ab_asio_swap16_x8(s);
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);     // Sign extend
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+#endif
+        for (; i < n; i++) {
+            uint16_t v = Swap ? ab_asio_swap16(in[i]) : in[i];
+            dst[i] = (int16_t)v / 32768.0f;
+        }
+    }
+
+    template <bool Dither>
+    static void fromFloat(const float* src, void* dst, long n, AbAsioDither* dither)
+    {
+        uint16_t* out = (uint16_t*)dst;
+        uint32_t* lanes = Dither ? dither->state : nullptr;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        __m128i state = Dither ? _mm_loadu_si128((const __m128i*)lanes) : _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i a = ab_asio_quantize_x4<Dither>(_mm_loadu_ps(src + i), scale, scale, &state);
+            __m128i b = ab_asio_quantize_x4<Dither>(_mm_loadu_ps(src + i + 4), scale, scale, &state);
+            __m128i s = _mm_packs_epi32(a, b);
+            if (Swap) s = ab_asio_swap16_x8(s);
+            _mm_storeu_si128((__m128i*)(out + i), s);
+        }
+        if (Dither) _mm_storeu_si128((__m128i*)lanes, state);
+#endif
+        for (; i < n; i++) {
+            uint16_t v = (uint16_t)(int16_t)ab_asio_quantize<Dither>(src[i], 32767.0f, 32767.0f,
+                                                                    Dither ? &lanes[i & 3] : nullptr);
+            out[i] = Swap ? ab_asio_swap16(v) : v;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+//  Name:       AbAsioInt32
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - 32-bit containers with Bits significant bits, right-justified and
+//    sign-extended: Int32LSB (Bits = 32), Int32LSB16/18/20/24 and their
+//    MSB forms (Swap = true)
+//  - Reading shifts the value to the top of the word first, so a driver
+//    that leaves the unused high bits unextended still converts correctly
+//------------------------------------------------------------------------------
+template <int Bits, bool Swap>
+struct AbAsioInt32 {
+    static void toFloat(const void* src, float* dst, long n)
+    {
+        const uint32_t* in = (const uint32_t*)src;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+            if (Swap) s = ab_asio_swap32_x4(s);
+            if (Bits < 32) s = _mm_slli_epi32(s, 32 - Bits);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+        }
+#endif
+        for (; i < n; i++) {
+            uint32_t v = Swap ? ab_asio_swap32(in[i]) : in[i];
+            dst[i] = (int32_t)(v << ((32 - Bits) % 32)) / 2147483648.0f;
+        }
+    }
+
+    template <bool Dither>
+    static void fromFloat(const float* src, void* dst, long n, AbAsioDither* dither)
+    {
+        const float full = (Bits == 32) ? 2147483647.0f : (float)((1LL << (Bits - 1)) - 1);
+        const float top = (Bits == 32) ? AB_ASIO_INT32_FLOAT_MAX : full;
+        uint32_t* out = (uint32_t*)dst;
+        uint32_t* lanes = Dither ? dither->state : nullptr;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(full);
+        const __m128 cap = _mm_set1_ps(top);
+        __m128i state = Dither ? _mm_loadu_si128((const __m128i*)lanes) : _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = ab_asio_quantize_x4<Dither>(_mm_loadu_ps(src + i), scale, cap, &state);
+            if (Swap) s = ab_asio_swap32_x4(s);
+            _mm_storeu_si128((__m128i*)(out + i), s);
+        }
+        if (Dither) _mm_storeu_si128((__m128i*)lanes, state);
+#endif
+        for (; i < n; i++) {
+            uint32_t v = (uint32_t)ab_asio_quantize<Dither>(src[i], full, top, Dither ? &lanes[i & 3] : nullptr);
+            out[i] = Swap ? ab_asio_swap32(v) : v;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+//  Name:       AbAsioInt24
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Packed 3-byte samples: Int24LSB, or Int24MSB (Swap = true)
+//  - Four samples are exactly three 32-bit words; each sample is
+//    assembled at the top of an int32 from at most two words, so the
+//    sign comes for free and the scale is 2^-31
+//------------------------------------------------------------------------------
+template <bool Swap>
+struct AbAsioInt24 {
+    static inline void unpack4(const uint8_t* p, int32_t* t)
+    {
+        uint32_t w0 = ab_asio_load32(p);
+        uint32_t w1 = ab_asio_load32(p + 4);
+        uint32_t w2 = ab_asio_load32(p + 8);
+        if (Swap) {
+            w0 = ab_asio_swap32(w0);
+            w1 = ab_asio_swap32(w1);
+            w2 = ab_asio_swap32(w2);
+            t[0] = (int32_t)(w0 & 0xFFFFFF00u);
+            t[1] = (int32_t)((w0 << 24) | ((w1 >> 8) & 0x00FFFF00u));
+            t[2] = (int32_t)((w1 << 16) | ((w2 >> 16) & 0x0000FF00u));
+            t[3] = (int32_t)(w2 << 8);
+        } else {
+            t[0] = (int32_t)(w0 << 8);
+            t[1] = (int32_t)((w1 << 16) | ((w0 >> 24) << 8));
+            t[2] = (int32_t)((w2 << 24) | ((w1 >> 16) << 8));
+            t[3] = (int32_t)(w2 & 0xFFFFFF00u);
+        }
+    }
+
+    static inline void pack4(const int32_t* q, uint8_t* p)
+    {
+        uint32_t q0 = (uint32_t)q[0], q1 = (uint32_t)q[1], q2 = (uint32_t)q[2], q3 = (uint32_t)q[3];
+        if (Swap) {
+            ab_asio_store32(p, ab_asio_swap32((q0 << 8) | ((q1 >> 16) & 0xFFu)));
+            ab_asio_store32(p + 4, ab_asio_swap32((q1 << 16) | ((q2 >> 8) & 0xFFFFu)));
+            ab_asio_store32(p + 8, ab_asio_swap32((q2 << 24) | (q3 & 0xFFFFFFu)));
+        } else {
+            ab_asio_store32(p, (q0 & 0xFFFFFFu) | (q1 << 24));
+            ab_asio_store32(p + 4, ((q1 >> 8) & 0xFFFFu) | (q2 << 16));
+            ab_asio_store32(p + 8, ((q2 >> 16) & 0xFFu) | (q3 << 8));
+        }
+    }
+
+    static void toFloat(const void* src, float* dst, long n)
+    {
+        const uint8_t* in = (const uint8_t*)src;
+        long i = 0;
+        int32_t t[4];
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+        for (; i + 4 <= n; i += 4) {
+            unpack4(in + i * 3, t);
+            __m128i s = _mm_set_epi32(t[3], t[2], t[1], t[0]);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+        }
+#else
+        for (; i + 4 <= n; i += 4) {
+            unpack4(in + i * 3, t);
+            for (int k = 0; k < 4; k++) {
+                dst[i + k] = t[k] / 2147483648.0f;
+            }
+        }
+#endif
+        for (; i < n; i++) {
+            const uint8_t* p = in + i * 3;
+            uint32_t v = Swap ? ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8)
+                              : ((uint32_t)p[2] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8);
+            dst[i] = (int32_t)v / 2147483648.0f;
+        }
+    }
+
+    template <bool Dither>
+    static void fromFloat(const float* src, void* dst, long n, AbAsioDither* dither)
+    {
+        const float full = 8388607.0f;                                      // 2^23 - 1
+        uint8_t* out = (uint8_t*)dst;
+        uint32_t* lanes = Dither ? dither->state : nullptr;
+        long i = 0;
+        int32_t q[4];
+#ifdef AB_SIMD_SSE2
+        const __m128 scale = _mm_set1_ps(full);
+        __m128i state = Dither ? _mm_loadu_si128((const __m128i*)lanes) : _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_si128((__m128i*)q, ab_asio_quantize_x4<Dither>(_mm_loadu_ps(src + i), scale, scale, &state));
+            pack4(q, out + i * 3);
+        }
+        if (Dither) _mm_storeu_si128((__m128i*)lanes, state);
+#else
+        for (; i + 4 <= n; i += 4) {
+            for (int k = 0; k < 4; k++) {
+                q[k] = ab_asio_quantize<Dither>(src[i + k], full, full, Dither ? &lanes[k] : nullptr);
+            }
+            pack4(q, out + i * 3);
+        }
+#endif
+        for (; i < n; i++) {
+            int32_t v = ab_asio_quantize<Dither>(src[i], full, full, Dither ? &lanes[i & 3] : nullptr);
+            uint8_t* p = out + i * 3;
+            p[Swap ? 2 : 0] = (uint8_t)(v & 0xFF);
+            p[1] = (uint8_t)((v >> 8) & 0xFF);
+            p[Swap ? 0 : 2] = (uint8_t)((v >> 16) & 0xFF);
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+//  Name:       AbAsioFloat32
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Float32LSB / Float32MSB; Clip limits output to -1.0 to +1.0
+//------------------------------------------------------------------------------
+template <bool Swap>
+struct AbAsioFloat32 {
+    static void toFloat(const void* src, float* dst, long n)
+    {
+        if (!Swap) {
+            memcpy(dst, src, n * sizeof(float));
+            return;
+        }
+        const uint32_t* in = (const uint32_t*)src;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = ab_asio_swap32_x4(_mm_loadu_si128((const __m128i*)(in + i)));
+            _mm_storeu_ps(dst + i, _mm_castsi128_ps(s));
+        }
+#endif
+        for (; i < n; i++) {
+            uint32_t v = ab_asio_swap32(in[i]);
+            memcpy(dst + i, &v, sizeof(float));
+        }
+    }
+
+    template <bool Clip>
+    static void fromFloat(const float* src, void* dst, long n, AbAsioDither*)
+    {
+        if (!Swap && !Clip) {
+            memcpy(dst, src, n * sizeof(float));
+            return;
+        }
+        uint32_t* out = (uint32_t*)dst;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_loadu_ps(src + i);
+            if (Clip) x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+            __m128i s = _mm_castps_si128(x);
+            if (Swap) s = ab_asio_swap32_x4(s);
+            _mm_storeu_si128((__m128i*)(out + i), s);
+        }
+#endif
+        for (; i < n; i++) {
+            float x = src[i];
+            if (Clip) {
+                if (x > 1.0f) x = 1.0f;
+                if (x < -1.0f) x = -1.0f;
+            }
+            uint32_t v;
+            memcpy(&v, &x, sizeof(v));
+            out[i] = Swap ? ab_asio_swap32(v) : v;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+//  Name:       AbAsioFloat64
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Float64LSB / Float64MSB; Clip limits output to -1.0 to +1.0
+//------------------------------------------------------------------------------
+template <bool Swap>
+struct AbAsioFloat64 {
+    static void toFloat(const void* src, float* dst, long n)
+    {
+        if (!Swap) {
+            ab_simd_narrow_f(dst, (const double*)src, (size_t)n);
+            return;
+        }
+        const uint64_t* in = (const uint64_t*)src;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        for (; i + 4 <= n; i += 4) {
+            __m128d a = _mm_castsi128_pd(ab_asio_swap64_x2(_mm_loadu_si128((const __m128i*)(in + i))));
+            __m128d b = _mm_castsi128_pd(ab_asio_swap64_x2(_mm_loadu_si128((const __m128i*)(in + i + 2))));
+            _mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b)));
+        }
+#endif
+        for (; i < n; i++) {
+            uint64_t v = ab_asio_swap64(in[i]);
+            double x;
+            memcpy(&x, &v, sizeof(x));
+            dst[i] = (float)x;
+        }
+    }
+
+    template <bool Clip>
+    static void fromFloat(const float* src, void* dst, long n, AbAsioDither*)
+    {
+        uint64_t* out = (uint64_t*)dst;
+        long i = 0;
+#ifdef AB_SIMD_SSE2
+        for (; i + 4 <= n; i += 4) {
+            __m128 x = _mm_loadu_ps(src + i);
+            if (Clip) x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+            __m128i a = _mm_castpd_si128(_mm_cvtps_pd(x));
+            __m128i b = _mm_castpd_si128(_mm_cvtps_pd(_mm_movehl_ps(x, x)));
+            if (Swap) {
+                a = ab_asio_swap64_x2(a);
+                b = ab_asio_swap64_x2(b);
+            }
+            _mm_storeu_si128((__m128i*)(out + i), a);
+            _mm_storeu_si128((__m128i*)(out + i + 2), b);
+        }
+#endif
+        for (; i < n; i++) {
+            float x = src[i];
+            if (Clip) {
+                if (x > 1.0f) x = 1.0f;
+                if (x < -1.0f) x = -1.0f;
+            }
+            double d = (double)x;
+            uint64_t v;
+            memcpy(&v, &d, sizeof(v));
+            out[i] = Swap ? ab_asio_swap64(v) : v;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Input fallback for unsupported types (DSD and anything newer). Only the
+// float side is written, so the driver's sample size does not matter. There
+// is no output fallback: the size of an unsupported driver sample is not
+// known, so callers must reject the type instead.
+//------------------------------------------------------------------------------
+
+static inline void ab_asio_silence_to_float(const void*, float* dst, long n)
+{
+    memset(dst, 0, n * sizeof(float));
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_sample_size
+//
+//  Returns:    bytes per sample of a supported type, 0 if unsupported
+//
+//------------------------------------------------------------------------------
+static inline size_t ab_asio_sample_size(ASIOSampleType type)
+{
+    switch (type) {
+        case ASIOSTInt16LSB:
+        case ASIOSTInt16MSB:
+            return 2;
+        case ASIOSTInt24LSB:
+        case ASIOSTInt24MSB:
+            return 3;
+        case ASIOSTInt32LSB:
+        case ASIOSTInt32MSB:
+        case ASIOSTInt32LSB16:
+        case ASIOSTInt32MSB16:
+        case ASIOSTInt32LSB18:
+        case ASIOSTInt32MSB18:
+        case ASIOSTInt32LSB20:
+        case ASIOSTInt32MSB20:
+        case ASIOSTInt32LSB24:
+        case ASIOSTInt32MSB24:
+        case ASIOSTFloat32LSB:
+        case ASIOSTFloat32MSB:
+            return 4;
+        case ASIOSTFloat64LSB:
+        case ASIOSTFloat64MSB:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_sample_type_supported
+//
+//  Returns:    true if the sample type has input and output kernels
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Check every channel before creating converters; output setup must
+//    fail on an unsupported type
+//------------------------------------------------------------------------------
+static inline bool ab_asio_sample_type_supported(ASIOSampleType type)
+{
+    return ab_asio_sample_size(type) != 0;
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_input_converter
+//
+//  Returns:    driver-to-float kernel for the sample type
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Call once per channel when the buffers are created and keep the
+//    pointer for the callback
+//  - Unsupported sample types get a kernel that produces silence
+//------------------------------------------------------------------------------
+static inline AbAsioToFloatFn ab_asio_input_converter(ASIOSampleType type)
+{
+    switch (type) {
+        case ASIOSTInt16LSB:    return AbAsioInt16<false>::toFloat;
+        case ASIOSTInt16MSB:    return AbAsioInt16<true>::toFloat;
+        case ASIOSTInt24LSB:    return AbAsioInt24<false>::toFloat;
+        case ASIOSTInt24MSB:    return AbAsioInt24<true>::toFloat;
+        case ASIOSTInt32LSB:    return AbAsioInt32<32, false>::toFloat;
+        case ASIOSTInt32MSB:    return AbAsioInt32<32, true>::toFloat;
+        case ASIOSTInt32LSB16:  return AbAsioInt32<16, false>::toFloat;
+        case ASIOSTInt32MSB16:  return AbAsioInt32<16, true>::toFloat;
+        case ASIOSTInt32LSB18:  return AbAsioInt32<18, false>::toFloat;
+        case ASIOSTInt32MSB18:  return AbAsioInt32<18, true>::toFloat;
+        case ASIOSTInt32LSB20:  return AbAsioInt32<20, false>::toFloat;
+        case ASIOSTInt32MSB20:  return AbAsioInt32<20, true>::toFloat;
+        case ASIOSTInt32LSB24:  return AbAsioInt32<24, false>::toFloat;
+        case ASIOSTInt32MSB24:  return AbAsioInt32<24, true>::toFloat;
+        case ASIOSTFloat32LSB:  return AbAsioFloat32<false>::toFloat;
+        case ASIOSTFloat32MSB:  return AbAsioFloat32<true>::toFloat;
+        case ASIOSTFloat64LSB:  return AbAsioFloat64<false>::toFloat;
+        case ASIOSTFloat64MSB:  return AbAsioFloat64<true>::toFloat;
+        default:                return ab_asio_silence_to_float;
+    }
+}
+
+// Integer kernel with or without dither
+template <typename Kernel>
+static inline AbAsioFromFloatFn ab_asio_pick_int(unsigned flags)
+{
+    return (flags & AB_ASIO_DITHER) ? Kernel::template fromFloat<true> : Kernel::template fromFloat<false>;
+}
+
+// Float kernel with or without clipping
+template <typename Kernel>
+static inline AbAsioFromFloatFn ab_asio_pick_float(unsigned flags)
+{
+    return (flags & AB_ASIO_CLIP) ? Kernel::template fromFloat<true> : Kernel::template fromFloat<false>;
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_output_converter
+//
+//  Returns:    float-to-driver kernel for the sample type and flags
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - flags: AB_ASIO_DITHER and / or AB_ASIO_CLIP (see the top of the file)
+//  - Dithering kernels need a per-channel AbAsioDither; the others
+//    accept nullptr
+//  - Returns nullptr for unsupported sample types
+//------------------------------------------------------------------------------
+static inline AbAsioFromFloatFn ab_asio_output_converter(ASIOSampleType type, unsigned flags)
+{
+    switch (type) {
+        case ASIOSTInt16LSB:    return ab_asio_pick_int<AbAsioInt16<false> >(flags);
+        case ASIOSTInt16MSB:    return ab_asio_pick_int<AbAsioInt16<true> >(flags);
+        case ASIOSTInt24LSB:    return ab_asio_pick_int<AbAsioInt24<false> >(flags);
+        case ASIOSTInt24MSB:    return ab_asio_pick_int<AbAsioInt24<true> >(flags);
+        case ASIOSTInt32LSB:    return AbAsioInt32<32, false>::fromFloat<false>;
+        case ASIOSTInt32MSB:    return AbAsioInt32<32, true>::fromFloat<false>;
+        case ASIOSTInt32LSB16:  return ab_asio_pick_int<AbAsioInt32<16, false> >(flags);
+        case ASIOSTInt32MSB16:  return ab_asio_pick_int<AbAsioInt32<16, true> >(flags);
+        case ASIOSTInt32LSB18:  return ab_asio_pick_int<AbAsioInt32<18, false> >(flags);
+        case ASIOSTInt32MSB18:  return ab_asio_pick_int<AbAsioInt32<18, true> >(flags);
+        case ASIOSTInt32LSB20:  return ab_asio_pick_int<AbAsioInt32<20, false> >(flags);
+        case ASIOSTInt32MSB20:  return ab_asio_pick_int<AbAsioInt32<20, true> >(flags);
+        case ASIOSTInt32LSB24:  return ab_asio_pick_int<AbAsioInt32<24, false> >(flags);
+        case ASIOSTInt32MSB24:  return ab_asio_pick_int<AbAsioInt32<24, true> >(flags);
+        case ASIOSTFloat32LSB:  return ab_asio_pick_float<AbAsioFloat32<false> >(flags);
+        case ASIOSTFloat32MSB:  return ab_asio_pick_float<AbAsioFloat32<true> >(flags);
+        case ASIOSTFloat64LSB:  return ab_asio_pick_float<AbAsioFloat64<false> >(flags);
+        case ASIOSTFloat64MSB:  return ab_asio_pick_float<AbAsioFloat64<true> >(flags);
+        default:                return nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_to_float
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Converts one channel's ASIO buffer to float, looking the kernel up
+//    on every call; callbacks should cache ab_asio_input_converter()
+//  - Unsupported sample types produce silence
+//------------------------------------------------------------------------------
+static inline void ab_asio_to_float(const void* src, ASIOSampleType type, float* dst, long n)
+{
+    ab_asio_input_converter(type)(src, dst, n);
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_from_float
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Converts float samples (clipped to -1.0 to +1.0) to one channel's
+//    ASIO buffer format, without dither
+//  - Unsupported sample types leave dst untouched; check
+//    ab_asio_sample_type_supported() when the buffers are sized
+//------------------------------------------------------------------------------
+static inline void ab_asio_from_float(const float* src, ASIOSampleType type, void* dst, long n)
+{
+    AbAsioFromFloatFn convert = ab_asio_output_converter(type, AB_ASIO_CLIP);
+    if (convert) {
+        convert(src, dst, n, nullptr);
+    }
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_interleave
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - dst[frame * channels + ch] = src[ch][frame]
+//  - Stereo uses SSE2 unpack; other counts use the scalar loop
+//------------------------------------------------------------------------------
+static inline void ab_asio_interleave(float* AB_RESTRICT dst, const float* const* src, int channels, long frames)
+{
+    long i = 0;
+#ifdef AB_SIMD_SSE2
+    if (channels == 2) {
+        const float* l = src[0];
+        const float* r = src[1];
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(l + i);
+            __m128 b = _mm_loadu_ps(r + i);
+            _mm_storeu_ps(dst + i*2, _mm_unpacklo_ps(a, b));
+            _mm_storeu_ps(dst + i*2 + 4, _mm_unpackhi_ps(a, b));
+        }
+    }
+#endif
+    for (; i < frames; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            dst[i * channels + ch] = src[ch][i];
+        }
+    }
+}
+
+#endif
@@ -27,8 +27,10 @@
  * ASIO Audio Loopback Tool for audio-bench
  *
  * Windows-only ASIO interface for professional audio hardware
- * Plays audio from a WAV file through ASIO output while simultaneously
- * recording ASIO input to a new WAV file
+ * Plays audio from a WAV file through one or more ASIO outputs while
+ * simultaneously recording one or more ASIO inputs to a new WAV file.
+ * Each input's round-trip latency is found by cross-correlating it with
+ * the stimulus, and the recordings are trimmed to line up with it.
  */
 
 #include <windows.h>
@@ -37,19 +39,27 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cstring>
+#include <atomic>
 #include <sndfile.h>
 #include <popt.h>
 #include "asiosys.h"
 #include "asio.h"
 #include "iasiodrv.h"
 #include "asiodrivers.h"
+#include "ab_asio_convert.h"
+#include "ab_asio_timing.h"
+#include "ab_fft_plan.h"
+
+#define MAX_CHANNELS        32                              // Per direction
+#define DEFAULT_TAIL_MS     250.0                           // Recorded past the stimulus, bounds the latency search
+#define MIN_CORRELATION     0.1                             // Below this an input is not aligned on its own
 
 //------------------------------------------------------------------------------
 // Global ASIO state
 //------------------------------------------------------------------------------
 static IASIO* asioDriver = nullptr;
 static ASIODriverInfo driverInfo;
-static ASIOBufferInfo bufferInfos[2];                       // Input and output channels
+static ASIOBufferInfo bufferInfos[2 * MAX_CHANNELS];       // Input channels, then output channels
 static ASIOCallbacks asioCallbacks;
 static long numInputChannels = 0;
 static long numOutputChannels = 0;
@@ -61,34 +71,40 @@ static ASIOSampleRate currentSampleRate = 48000.0;
 static bool loopbackActive = false;
 
 //------------------------------------------------------------------------------
-// Cached channel info (retrieved once during setup)
+// Selected channels
 //------------------------------------------------------------------------------
-static ASIOChannelInfo inputChannelInfo;
-static ASIOChannelInfo outputChannelInfo;
+static long inputChannels[MAX_CHANNELS];
+static long outputChannels[MAX_CHANNELS];
+static long numRecordChannels = 0;
+static long numPlayChannels = 0;
 
 //------------------------------------------------------------------------------
-// Cached sample sizes (calculated once during setup)
+// Cached channel info (retrieved once during setup)
 //------------------------------------------------------------------------------
-static size_t outputSampleSize = 0;
+static ASIOChannelInfo inputChannelInfo[MAX_CHANNELS];
+static ASIOChannelInfo outputChannelInfo[MAX_CHANNELS];
 
 //------------------------------------------------------------------------------
-// Pre-allocated conversion buffers (for real-time callback)
+// Cached sample sizes (calculated once during setup)
 //------------------------------------------------------------------------------
-static float* tempInBuffer = nullptr;
+static size_t outputSampleSize[MAX_CHANNELS];
+static AbAsioToFloatFn inputConverters[MAX_CHANNELS];   // Per input, see ab_asio_convert.h
 
 //------------------------------------------------------------------------------
-// Pre-converted playback signal in ASIO output format
+// Pre-converted playback signal in ASIO output format, one per output
 //------------------------------------------------------------------------------
-static void* playbackSignalASIO = nullptr;
+static void* playbackSignalASIO[MAX_CHANNELS];
 static size_t playbackSignalASIOSize = 0;
 
 //------------------------------------------------------------------------------
 // Audio data structure
 //------------------------------------------------------------------------------
 typedef struct {
-    float *playback_signal;                                 // Loaded from WAV file
-    float *recorded_signal;                                 // Recorded response
-    int total_frames;                                       // Total length (samples)
+    float *playback_signal[MAX_CHANNELS];                   // Loaded from WAV file, one per file channel
+    float *recorded_signal[MAX_CHANNELS];                   // Recorded response, one per input
+    int playback_channels;                                  // Channels in the WAV file (1 or numPlayChannels)
+    int total_frames;                                       // Stimulus length (samples)
+    int record_frames;                                      // Stimulus plus tail (samples)
     int current_frame;                                      // Current playback/record position
 } AudioData;
 
@@ -97,10 +113,13 @@ static AudioData audioData;
 //------------------------------------------------------------------------------
 // Output file parameters
 //------------------------------------------------------------------------------
-static SNDFILE* outputFile = nullptr;
 static SF_INFO outputFileInfo;
 static long outputBitDepth = 32;
 
+// Callback timing and missed buffers (see ab_asio_timing.h)
+static AbCbStats cbStats;
+static std::atomic<long> driverXruns(0);
+
 //------------------------------------------------------------------------------
 // Forward declarations
 //------------------------------------------------------------------------------
@@ -109,141 +128,6 @@ static void sampleRateChanged(ASIOSampleRate sRate);
 static long asioMessages(long selector, long value, void* message, double* opt);
 static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow);
 
-//------------------------------------------------------------------------------
-//  Name:       convertASIOToFloat
-//
-//  Returns:    none
-//
-//------------------------------------------------------------------------------
-//  Detailed description:
-//  - Converts ASIO sample format to float
-//  - Handles various ASIO sample types
-//  - Normalizes to -1.0 to +1.0 range
-//------------------------------------------------------------------------------
-static void convertASIOToFloat(void* asioBuffer, float* floatBuffer, long numSamples, ASIOSampleType sampleType)
-{
-    switch (sampleType) {
-        case ASIOSTInt16LSB:
-        {
-            short* samples = static_cast<short*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = samples[i] / 32768.0f;
-            }
-            break;
-        }
-        case ASIOSTInt24LSB:
-        {
-            unsigned char* samples = static_cast<unsigned char*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                // Reconstruct 24-bit signed integer from 3 bytes (LSB first)
-                int s24 = samples[i*3] | (samples[i*3+1] << 8) | (samples[i*3+2] << 16);
-                // Sign extend from 24-bit to 32-bit
-                if (s24 & 0x800000) {
-                    s24 |= 0xFF000000;
-                }
-                floatBuffer[i] = s24 / 8388608.0f;  // 2^23
-            }
-            break;
-        }
-        case ASIOSTInt32LSB:
-        {
-            int* samples = static_cast<int*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = samples[i] / 2147483648.0f;
-            }
-            break;
-        }
-        case ASIOSTFloat32LSB:
-        {
-            float* samples = static_cast<float*>(asioBuffer);
-            memcpy(floatBuffer, samples, numSamples * sizeof(float));
-            break;
-        }
-        case ASIOSTFloat64LSB:
-        {
-            double* samples = static_cast<double*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = static_cast<float>(samples[i]);
-            }
-            break;
-        }
-        default:
-            memset(floatBuffer, 0, numSamples * sizeof(float));
-            break;
-    }
-}
-
-//------------------------------------------------------------------------------
-//  Name:       convertFloatToASIO
-//
-//  Returns:    none
-//
-//------------------------------------------------------------------------------
-//  Detailed description:
-//  - Converts float samples to ASIO sample format
-//  - Handles various ASIO sample types
-//  - Assumes input is normalized -1.0 to +1.0
-//------------------------------------------------------------------------------
-static void convertFloatToASIO(float* floatBuffer, void* asioBuffer, long numSamples, ASIOSampleType sampleType)
-{
-    switch (sampleType) {
-        case ASIOSTInt16LSB:
-        {
-            short* samples = static_cast<short*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<short>(sample * 32767.0f);
-            }
-            break;
-        }
-        case ASIOSTInt24LSB:
-        {
-            unsigned char* samples = static_cast<unsigned char*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                int s24 = static_cast<int>(sample * 8388607.0f);  // 2^23 - 1
-                // Pack as 24-bit LSB (3 bytes, LSB first)
-                samples[i*3] = s24 & 0xFF;
-                samples[i*3+1] = (s24 >> 8) & 0xFF;
-                samples[i*3+2] = (s24 >> 16) & 0xFF;
-            }
-            break;
-        }
-        case ASIOSTInt32LSB:
-        {
-            int* samples = static_cast<int*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<int>(sample * 2147483647.0f);
-            }
-            break;
-        }
-        case ASIOSTFloat32LSB:
-        {
-            float* samples = static_cast<float*>(asioBuffer);
-            memcpy(samples, floatBuffer, numSamples * sizeof(float));
-            break;
-        }
-        case ASIOSTFloat64LSB:
-        {
-            double* samples = static_cast<double*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                samples[i] = static_cast<double>(floatBuffer[i]);
-            }
-            break;
-        }
-        default:
-            memset(asioBuffer, 0, numSamples * sizeof(float));
-            break;
-    }
-}
-
 //------------------------------------------------------------------------------
 // ASIO Callbacks
 //------------------------------------------------------------------------------
@@ -255,51 +139,52 @@ static void bufferSwitch(long index, ASIOBool processNow)
 
 static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow)
 {
-    if (!loopbackActive || !tempInBuffer || !playbackSignalASIO || !outputFile) {
+    if (!loopbackActive) {
         return nullptr;
     }
 
+    double start = ab_cbstats_now();
+
     long bufferSize = preferredBufferSize;
-    long samplesToProcess = bufferSize;
+    long samplesToPlay = audioData.total_frames - audioData.current_frame;
+    long samplesToRecord = audioData.record_frames - audioData.current_frame;
 
-    if (audioData.current_frame + samplesToProcess > audioData.total_frames) {
-        samplesToProcess = audioData.total_frames - audioData.current_frame;
+    if (samplesToPlay < 0) {
+        samplesToPlay = 0;
+    } else if (samplesToPlay > bufferSize) {
+        samplesToPlay = bufferSize;
+    }
+    if (samplesToRecord > bufferSize) {
+        samplesToRecord = bufferSize;
     }
 
-    // Prepare output buffer (playback from pre-converted ASIO format)
-    if (audioData.current_frame < audioData.total_frames && samplesToProcess > 0) {
-        // Direct copy of pre-converted playback signal to ASIO output buffer
-        size_t offsetBytes = audioData.current_frame * outputSampleSize;
-        memcpy(bufferInfos[1].buffers[index],
-               (char*)playbackSignalASIO + offsetBytes,
-               samplesToProcess * outputSampleSize);
-
-        // Zero out remaining samples if needed
-        if (samplesToProcess < bufferSize) {
-            size_t silenceOffset = samplesToProcess * outputSampleSize;
-            size_t silenceSize = (bufferSize - samplesToProcess) * outputSampleSize;
-            memset((char*)bufferInfos[1].buffers[index] + silenceOffset, 0, silenceSize);
+    // Prepare output buffers (playback from pre-converted ASIO format, then silence)
+    for (long ch = 0; ch < numPlayChannels; ch++) {
+        char* dst = (char*)bufferInfos[numRecordChannels + ch].buffers[index];
+        size_t sampleSize = outputSampleSize[ch];
+        if (samplesToPlay > 0) {
+            memcpy(dst, (char*)playbackSignalASIO[ch] + audioData.current_frame * sampleSize,
+                   samplesToPlay * sampleSize);
+        }
+        if (samplesToPlay < bufferSize) {
+            memset(dst + samplesToPlay * sampleSize, 0, (bufferSize - samplesToPlay) * sampleSize);
         }
-
-        audioData.current_frame += samplesToProcess;
-    } else {
-        // Playback complete, output silence
-        memset(bufferInfos[1].buffers[index], 0, bufferSize * outputSampleSize);
-        loopbackActive = false;
     }
 
-    // Convert input from ASIO format to float
-    convertASIOToFloat(bufferInfos[0].buffers[index], tempInBuffer, bufferSize, inputChannelInfo.type);
-
-    // Write recorded input to WAV file based on bit depth
-    if (audioData.current_frame <= audioData.total_frames && audioData.current_frame > 0) {
-        long copyFrame = audioData.current_frame - samplesToProcess;
-        if (copyFrame >= 0 && copyFrame + samplesToProcess <= audioData.total_frames) {
-            // Write to output file - libsndfile handles conversion to target bit depth
-            sf_write_float(outputFile, tempInBuffer, samplesToProcess);
+    // Convert inputs from ASIO format to float, straight into the recordings
+    if (samplesToRecord > 0) {
+        for (long ch = 0; ch < numRecordChannels; ch++) {
+            inputConverters[ch](bufferInfos[ch].buffers[index],
+                                audioData.recorded_signal[ch] + audioData.current_frame, samplesToRecord);
         }
+        audioData.current_frame += samplesToRecord;
+    }
+
+    if (audioData.current_frame >= audioData.record_frames) {
+        loopbackActive = false;
     }
 
+    ab_asio_record_timing(&cbStats, timeInfo, preferredBufferSize, start);
     return nullptr;
 }
 
@@ -319,7 +204,8 @@ static long asioMessages(long selector, long value, void* message, double* opt)
                 value == kAsioLatenciesChanged ||
                 value == kAsioSupportsTimeInfo ||
                 value == kAsioSupportsTimeCode ||
-                value == kAsioSupportsInputMonitor)
+                value == kAsioSupportsInputMonitor ||
+                value == kAsioOverload)
                 return 1;
             break;
 
@@ -328,6 +214,9 @@ static long asioMessages(long selector, long value, void* message, double* opt)
             return 1;
 
         case kAsioResyncRequest:
+        case kAsioOverload:
+            // Lost sync or a late buffer: counted with the callback stats
+            driverXruns.fetch_add(1, std::memory_order_relaxed);
             return 1;
 
         case kAsioLatenciesChanged:
@@ -409,7 +298,8 @@ static bool initASIO(const char* driverName)
     return true;
 }
 
-static bool setupASIOBuffers(long inputChannel, long outputChannel, double requestedSampleRate)
+
+static bool setupASIOBuffers(double requestedSampleRate)
 {
     // Set sample rate if requested
     if (requestedSampleRate > 0) {
@@ -428,59 +318,57 @@ static bool setupASIOBuffers(long inputChannel, long outputChannel, double reque
     asioCallbacks.asioMessage = asioMessages;
     asioCallbacks.bufferSwitchTimeInfo = bufferSwitchTimeInfo;
 
-    // Create buffer info for input and output channels
+    // Create buffer info for input channels followed by output channels
     memset(bufferInfos, 0, sizeof(bufferInfos));
 
-    // Input buffer
-    bufferInfos[0].isInput = ASIOTrue;
-    bufferInfos[0].channelNum = inputChannel;
-    bufferInfos[0].buffers[0] = bufferInfos[0].buffers[1] = nullptr;
-
-    // Output buffer
-    bufferInfos[1].isInput = ASIOFalse;
-    bufferInfos[1].channelNum = outputChannel;
-    bufferInfos[1].buffers[0] = bufferInfos[1].buffers[1] = nullptr;
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        bufferInfos[ch].isInput = ASIOTrue;
+        bufferInfos[ch].channelNum = inputChannels[ch];
+    }
+    for (long ch = 0; ch < numPlayChannels; ch++) {
+        bufferInfos[numRecordChannels + ch].isInput = ASIOFalse;
+        bufferInfos[numRecordChannels + ch].channelNum = outputChannels[ch];
+    }
 
     // Create buffers
-    ASIOError err = ASIOCreateBuffers(bufferInfos, 2, preferredBufferSize, &asioCallbacks);
+    ASIOError err = ASIOCreateBuffers(bufferInfos, numRecordChannels + numPlayChannels, preferredBufferSize, &asioCallbacks);
     if (err != ASE_OK) {
         printf("ASIOCreateBuffers failed with error: %ld\n", err);
         return false;
     }
 
     // Get and cache channel info
-    inputChannelInfo.channel = inputChannel;
-    inputChannelInfo.isInput = ASIOTrue;
-    err = ASIOGetChannelInfo(&inputChannelInfo);
-    if (err == ASE_OK) {
-        printf("Input Channel %ld: %s, Type: %ld\n",
-               inputChannel, inputChannelInfo.name, inputChannelInfo.type);
-    } else {
-        printf("Failed to get input channel info\n");
-        return false;
-    }
-
-    outputChannelInfo.channel = outputChannel;
-    outputChannelInfo.isInput = ASIOFalse;
-    err = ASIOGetChannelInfo(&outputChannelInfo);
-    if (err == ASE_OK) {
-        printf("Output Channel %ld: %s, Type: %ld\n",
-               outputChannel, outputChannelInfo.name, outputChannelInfo.type);
-    } else {
-        printf("Failed to get output channel info\n");
-        return false;
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        inputChannelInfo[ch].channel = inputChannels[ch];
+        inputChannelInfo[ch].isInput = ASIOTrue;
+        err = ASIOGetChannelInfo(&inputChannelInfo[ch]);
+        if (err == ASE_OK) {
+            printf("Input Channel %ld: %s, Type: %ld\n",
+                   inputChannels[ch], inputChannelInfo[ch].name, inputChannelInfo[ch].type);
+            if (!ab_asio_sample_type_supported(inputChannelInfo[ch].type)) {
+                printf("Error: Unsupported input sample type: %ld\n", inputChannelInfo[ch].type);
+                return false;
+            }
+            inputConverters[ch] = ab_asio_input_converter(inputChannelInfo[ch].type);
+        } else {
+            printf("Failed to get input channel info\n");
+            return false;
+        }
     }
 
-    // Allocate temporary input conversion buffer
-    tempInBuffer = new float[preferredBufferSize];
-
-    if (!tempInBuffer) {
-        printf("Failed to allocate input conversion buffer\n");
-        return false;
+    for (long ch = 0; ch < numPlayChannels; ch++) {
+        outputChannelInfo[ch].channel = outputChannels[ch];
+        outputChannelInfo[ch].isInput = ASIOFalse;
+        err = ASIOGetChannelInfo(&outputChannelInfo[ch]);
+        if (err == ASE_OK) {
+            printf("Output Channel %ld: %s, Type: %ld\n",
+                   outputChannels[ch], outputChannelInfo[ch].name, outputChannelInfo[ch].type);
+        } else {
+            printf("Failed to get output channel info\n");
+            return false;
+        }
     }
 
-    printf("Pre-allocated input conversion buffer: %ld samples\n", preferredBufferSize);
-
     return true;
 }
 
@@ -493,17 +381,21 @@ static void shutdownASIO()
         asioDriver = nullptr;
     }
 
-    // Clean up pre-allocated conversion buffer
-    if (tempInBuffer) {
-        delete[] tempInBuffer;
-        tempInBuffer = nullptr;
+    // Clean up pre-converted playback signals
+    for (long ch = 0; ch < MAX_CHANNELS; ch++) {
+        free(playbackSignalASIO[ch]);
+        playbackSignalASIO[ch] = nullptr;
     }
+    playbackSignalASIOSize = 0;
+}
 
-    // Clean up pre-converted playback signal
-    if (playbackSignalASIO) {
-        free(playbackSignalASIO);
-        playbackSignalASIO = nullptr;
-        playbackSignalASIOSize = 0;
+static void freeAudioData()
+{
+    for (long ch = 0; ch < MAX_CHANNELS; ch++) {
+        free(audioData.playback_signal[ch]);
+        free(audioData.recorded_signal[ch]);
+        audioData.playback_signal[ch] = nullptr;
+        audioData.recorded_signal[ch] = nullptr;
     }
 }
 
@@ -533,6 +425,52 @@ static void listASIODrivers()
     printf("\n");
 }
 
+// Parse a channel list such as "0", "0,1" or "0-3,6"; returns the number
+// of channels stored or -1 on a syntax/range error
+static long parseChannelList(const char* spec, long* list, long maxCount, long available)
+{
+    long count = 0;
+    const char* p = spec;
+
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+            p = end;
+        }
+        if (first < 0 || last < first || last >= available) {
+            return -1;
+        }
+        for (long ch = first; ch <= last; ch++) {
+            for (long i = 0; i < count; i++) {
+                if (list[i] == ch) {
+                    return -1;  // Duplicate channel
+                }
+            }
+            if (count >= maxCount) {
+                return -1;
+            }
+            list[count++] = ch;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    return count;
+}
+
 //------------------------------------------------------------------------------
 //  Name:       preconvertPlaybackSignal
 //
@@ -540,44 +478,238 @@ static void listASIODrivers()
 //
 //------------------------------------------------------------------------------
 //  Detailed description:
-//  - Pre-converts the playback signal from float to ASIO output format
+//  - Pre-converts the playback signal from float to each output's ASIO format
+//  - A mono file feeds every output; otherwise file channel N feeds output N
 //  - Called after loading WAV file but before starting audio stream
 //  - Eliminates conversion overhead in real-time callback
 //------------------------------------------------------------------------------
 static bool preconvertPlaybackSignal()
 {
-    if (!audioData.playback_signal || audioData.total_frames <= 0) {
+    if (audioData.total_frames <= 0) {
         printf("Error: Playback signal not initialized\n");
         return false;
     }
 
-    // Calculate and cache sample size for output format
-    switch (outputChannelInfo.type) {
-        case ASIOSTInt16LSB: outputSampleSize = 2; break;
-        case ASIOSTInt24LSB: outputSampleSize = 3; break;
-        case ASIOSTInt32LSB: outputSampleSize = 4; break;
-        case ASIOSTFloat32LSB: outputSampleSize = 4; break;
-        case ASIOSTFloat64LSB: outputSampleSize = 8; break;
-        default:
-            printf("Error: Unsupported output sample type: %ld\n", outputChannelInfo.type);
+    playbackSignalASIOSize = 0;
+    for (long ch = 0; ch < numPlayChannels; ch++) {
+        const float* source = audioData.playback_signal[audioData.playback_channels == 1 ? 0 : ch];
+
+        // Calculate and cache sample size for output format
+        outputSampleSize[ch] = ab_asio_sample_size(outputChannelInfo[ch].type);
+        if (outputSampleSize[ch] == 0) {
+            printf("Error: Unsupported output sample type: %ld\n", outputChannelInfo[ch].type);
             return false;
+        }
+
+        // Allocate buffer for pre-converted playback signal
+        size_t size = audioData.total_frames * outputSampleSize[ch];
+        playbackSignalASIO[ch] = malloc(size);
+
+        if (!playbackSignalASIO[ch]) {
+            printf("Error: Failed to allocate ASIO playback signal buffer (%zu bytes)\n", size);
+            return false;
+        }
+
+        // Convert entire playback signal to ASIO format
+        ab_asio_from_float(source, outputChannelInfo[ch].type, playbackSignalASIO[ch], audioData.total_frames);
+        playbackSignalASIOSize += size;
+    }
+
+    printf("Pre-converted playback signal to ASIO format: %d samples x %ld output(s), %zu bytes\n",
+           audioData.total_frames, numPlayChannels, playbackSignalASIOSize);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Latency measurement
+//------------------------------------------------------------------------------
+
+typedef struct {
+    long lag;                                               // Round-trip latency (samples)
+    double correlation;                                     // Normalized peak, -1.0 to +1.0
+    long reference;                                         // Output (list position) correlated against
+    bool borrowed;                                          // Too weak: lag taken from the best input
+} LatencyResult;
+
+//------------------------------------------------------------------------------
+//  Name:       measureLatencies
+//
+//  Returns:    true on success, false if the FFT buffers cannot be allocated
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Cross-correlates each recording with the stimulus it heard (file
+//    channel N for input N of a multi-channel file, else channel 0) by FFT
+//    and takes the lag of the largest |correlation| between 0 and the tail
+//  - The peak is normalized by the energy of the stimulus and of the
+//    recording under it, so 1.0 is a clean, undistorted path
+//  - Inputs under MIN_CORRELATION (crosstalk, unconnected) use the lag of
+//    the best-correlated input so the channels still line up
+//------------------------------------------------------------------------------
+static bool measureLatencies(LatencyResult* results)
+{
+    long maxLag = audioData.record_frames - audioData.total_frames;
+    int n = static_cast<int>(ab_fft_good_size(static_cast<size_t>(audioData.record_frames)));
+    int bins = n / 2 + 1;
+
+    double* signal = static_cast<double*>(fftw_malloc(sizeof(double) * n));
+    fftw_complex* stimulus = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * bins));
+    fftw_complex* recording = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * bins));
+    if (!signal || !stimulus || !recording) {
+        fftw_free(signal);
+        fftw_free(stimulus);
+        fftw_free(recording);
+        return false;
+    }
+
+    fftw_plan forward = fftw_plan_dft_r2c_1d(n, signal, recording, FFTW_ESTIMATE);
+    fftw_plan backward = fftw_plan_dft_c2r_1d(n, recording, signal, FFTW_ESTIMATE);
+    long stimulusChannel = -1;
+    double stimulusEnergy = 0.0;
+
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        long reference = (audioData.playback_channels > 1 && ch < audioData.playback_channels) ? ch : 0;
+        const float* rec = audioData.recorded_signal[ch];
+
+        // Stimulus spectrum, recomputed only when the reference changes
+        if (reference != stimulusChannel) {
+            const float* stim = audioData.playback_signal[reference];
+            stimulusEnergy = 0.0;
+            for (int i = 0; i < audioData.total_frames; i++) {
+                signal[i] = stim[i];
+                stimulusEnergy += signal[i] * signal[i];
+            }
+            for (int i = audioData.total_frames; i < n; i++) {
+                signal[i] = 0.0;
+            }
+            fftw_execute_dft_r2c(forward, signal, stimulus);
+            stimulusChannel = reference;
+        }
+
+        // R(f) * conj(S(f)) -> correlation at lag k in signal[k]
+        for (int i = 0; i < audioData.record_frames; i++) {
+            signal[i] = rec[i];
+        }
+        for (int i = audioData.record_frames; i < n; i++) {
+            signal[i] = 0.0;
+        }
+        fftw_execute_dft_r2c(forward, signal, recording);
+        for (int i = 0; i < bins; i++) {
+            double re = recording[i][0] * stimulus[i][0] + recording[i][1] * stimulus[i][1];
+            double im = recording[i][1] * stimulus[i][0] - recording[i][0] * stimulus[i][1];
+            recording[i][0] = re;
+            recording[i][1] = im;
+        }
+        fftw_execute(backward);
+
+        long best = 0;
+        for (long k = 1; k <= maxLag; k++) {
+            if (fabs(signal[k]) > fabs(signal[best])) {
+                best = k;
+            }
+        }
+
+        // Recording energy under the aligned stimulus
+        double recordingEnergy = 0.0;
+        for (long i = best; i < best + audioData.total_frames; i++) {
+            recordingEnergy += (double)rec[i] * rec[i];
+        }
+
+        double norm = sqrt(stimulusEnergy * recordingEnergy);
+        results[ch].lag = best;
+        results[ch].correlation = norm > 0.0 ? signal[best] / n / norm : 0.0;
+        results[ch].reference = reference;
+        results[ch].borrowed = false;
+    }
+
+    fftw_destroy_plan(forward);
+    fftw_destroy_plan(backward);
+    fftw_free(signal);
+    fftw_free(stimulus);
+    fftw_free(recording);
+
+    // Weak inputs follow the strongest one
+    long strongest = 0;
+    for (long ch = 1; ch < numRecordChannels; ch++) {
+        if (fabs(results[ch].correlation) > fabs(results[strongest].correlation)) {
+            strongest = ch;
+        }
+    }
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        if (fabs(results[ch].correlation) < MIN_CORRELATION && ch != strongest) {
+            results[ch].lag = results[strongest].lag;
+            results[ch].borrowed = true;
+        }
     }
+    return true;
+}
 
-    // Allocate buffer for pre-converted playback signal
-    playbackSignalASIOSize = audioData.total_frames * outputSampleSize;
-    playbackSignalASIO = malloc(playbackSignalASIOSize);
+static void printLatencies(const LatencyResult* results)
+{
+    printf("Round-trip latency (cross-correlation with the stimulus):\n");
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        const LatencyResult& r = results[ch];
+        printf("  Input %2ld <- output %2ld: %6ld samples (%7.3f ms), correlation %+.3f%s\n",
+               inputChannels[ch], outputChannels[r.reference], r.lag, 1000.0 * r.lag / currentSampleRate,
+               r.correlation, r.borrowed ? " (weak, aligned with the strongest input)" : "");
+    }
+    printf("\n");
+}
 
-    if (!playbackSignalASIO) {
-        printf("Error: Failed to allocate ASIO playback signal buffer (%zu bytes)\n", playbackSignalASIOSize);
+static bool writeLatencyCsv(const char* filename, const LatencyResult* results)
+{
+    FILE* file = fopen(filename, "w");
+    if (!file) {
         return false;
     }
+    fprintf(file, "input_channel,output_channel,latency_samples,latency_ms,correlation,aligned_by\n");
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        const LatencyResult& r = results[ch];
+        fprintf(file, "%ld,%ld,%ld,%.4f,%.6f,%s\n", inputChannels[ch], outputChannels[r.reference], r.lag,
+                1000.0 * r.lag / currentSampleRate, r.correlation, r.borrowed ? "strongest" : "self");
+    }
+    return fclose(file) == 0;
+}
 
-    // Convert entire playback signal to ASIO format
-    convertFloatToASIO(audioData.playback_signal, playbackSignalASIO, audioData.total_frames, outputChannelInfo.type);
+//------------------------------------------------------------------------------
+//  Name:       writeRecording
+//
+//  Returns:    true on success, false on failure
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Interleaves the inputs into one file, in --inchan order
+//  - With latencies, each input starts at its own lag and the file is
+//    exactly as long as the stimulus; without, the raw take is written
+//------------------------------------------------------------------------------
+static bool writeRecording(SNDFILE* file, const LatencyResult* latencies)
+{
+    const long block = 4096;
+    long frames = latencies ? audioData.total_frames : audioData.record_frames;
+    float* interleaved = static_cast<float*>(malloc(block * numRecordChannels * sizeof(float)));
+    const float* sources[MAX_CHANNELS];
 
-    printf("Pre-converted playback signal to ASIO format: %d samples, %zu bytes (sample size: %zu)\n",
-           audioData.total_frames, playbackSignalASIOSize, outputSampleSize);
+    if (!interleaved) {
+        return false;
+    }
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        sources[ch] = audioData.recorded_signal[ch] + (latencies ? latencies[ch].lag : 0);
+    }
 
+    for (long pos = 0; pos < frames; pos += block) {
+        long count = (frames - pos < block) ? frames - pos : block;
+        const float* chunk[MAX_CHANNELS];
+        for (long ch = 0; ch < numRecordChannels; ch++) {
+            chunk[ch] = sources[ch] + pos;
+        }
+        ab_asio_interleave(interleaved, chunk, (int)numRecordChannels, count);
+        if (sf_writef_float(file, interleaved, count) != count) {
+            free(interleaved);
+            return false;
+        }
+    }
+    free(interleaved);
     return true;
 }
 
@@ -586,13 +718,15 @@ static bool preconvertPlaybackSignal()
 //
 //  This application:
 //  - Loads audio from a WAV file
-//  - Plays audio through ASIO audio output
-//  - Records ASIO audio input simultaneously
-//  - Saves recorded audio to WAV file
+//  - Plays audio through one or more ASIO outputs
+//  - Records one or more ASIO inputs simultaneously
+//  - Measures each input's latency and aligns the recordings
+//  - Saves recorded audio to a (multi-channel) WAV file
 //
 //  Libraries:
 //  - ASIO SDK: Audio playback and recording
 //  - libsndfile: WAV file I/O
+//  - FFTW3: Cross-correlation
 //  - libpopt: Command-line parsing
 //------------------------------------------------------------------------------
 int main(int argc, const char **argv)
@@ -605,25 +739,33 @@ int main(int argc, const char **argv)
     int version_flag = 0;
     int list_flag = 0;
     int about_flag = 0;
+    int noAlignFlag = 0;
     char* driverName = nullptr;
     char* inputFilename = nullptr;
     char* outputFilename = nullptr;
-    long inputChannel = 0;
-    long outputChannel = 0;
+    char* inputSpec = nullptr;
+    char* outputSpec = nullptr;
+    char* latencyFilename = nullptr;
     double requestedSampleRate = 0.0;
+    double tailMs = DEFAULT_TAIL_MS;
     long bitDepth = 32;
+    char* statsFilename = nullptr;
 
     struct poptOption options[] = {
         {"version", 'v', POPT_ARG_NONE, &version_flag, 0, "Show version information", nullptr},
         {"about", 'a', POPT_ARG_NONE, &about_flag, 0, "Show about information", nullptr},
         {"list", 'l', POPT_ARG_NONE, &list_flag, 0, "List available ASIO drivers", nullptr},
         {"driver", 'd', POPT_ARG_STRING, &driverName, 0, "ASIO driver name", "NAME"},
-        {"play", 'p', POPT_ARG_STRING, &inputFilename, 0, "Input WAV file to play", "FILE"},
-        {"capture", 'o', POPT_ARG_STRING, &outputFilename, 0, "Output WAV file to record", "FILE"},
-        {"inchan", 'i', POPT_ARG_LONG, &inputChannel, 0, "Input channel (default: 0)", "N"},
-        {"outchan", 'C', POPT_ARG_LONG, &outputChannel, 0, "Output channel (default: 0)", "N"},
+        {"play", 'p', POPT_ARG_STRING, &inputFilename, 0, "Input WAV file to play (mono, or one channel per output)", "FILE"},
+        {"capture", 'o', POPT_ARG_STRING, &outputFilename, 0, "Output WAV file to record (one channel per input)", "FILE"},
+        {"inchan", 'i', POPT_ARG_STRING, &inputSpec, 0, "Input channels, e.g. 0 or 0-7 (default: 0)", "LIST"},
+        {"outchan", 'C', POPT_ARG_STRING, &outputSpec, 0, "Output channels, e.g. 0 or 0,2 (default: 0)", "LIST"},
         {"rate", 'r', POPT_ARG_DOUBLE, &requestedSampleRate, 0, "Sample rate (default: use input file rate)", "HZ"},
         {"bits", 'b', POPT_ARG_LONG, &bitDepth, 0, "Output bit depth: 16, 24, or 32 (default: 32)", "BITS"},
+        {"tail", 't', POPT_ARG_DOUBLE, &tailMs, 0, "Record this long past the stimulus; the longest latency found (default: 250)", "MS"},
+        {"no-align", 'A', POPT_ARG_NONE, &noAlignFlag, 0, "Write the raw recording without latency compensation", nullptr},
+        {"latency", 'L', POPT_ARG_STRING, &latencyFilename, 0, "Write the per-input latencies as CSV", "FILE"},
+        {"stats", 'j', POPT_ARG_STRING, &statsFilename, 0, "Write callback timing and xrun statistics as JSON", "FILE"},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -632,13 +774,15 @@ int main(int argc, const char **argv)
     poptSetOtherOptionHelp(popt_ctx,
         "[OPTIONS]\n\n"
         "ASIO Audio Loopback Tool for audio-bench.\n\n"
-        "This tool plays a mono WAV file through an ASIO output channel while\n"
-        "simultaneously recording from an ASIO input channel to a new WAV file.\n\n"
+        "This tool plays a WAV file through one or more ASIO output channels while\n"
+        "simultaneously recording one or more ASIO input channels to a new WAV file.\n"
+        "Each input is aligned to the stimulus by its measured round-trip latency.\n\n"
         "Examples:\n"
         "  ab_asio_loopback --list                                      # List ASIO drivers\n"
         "  ab_asio_loopback --about                                     # Show about information\n"
         "  ab_asio_loopback -d \"Driver\" -p in.wav -o out.wav          # Basic loopback\n"
         "  ab_asio_loopback -d \"Driver\" -p in.wav -o out.wav -i 0 -C 1  # Specify channels\n"
+        "  ab_asio_loopback -d \"Driver\" -p in.wav -o out.wav -i 0-7 -C 0-7 -L lat.csv  # 8x8 in one pass\n"
         "  ab_asio_loopback -d \"Driver\" -p in.wav -o out.wav -r 96000 -b 24  # Custom rate and bits\n");
 
     int rc = poptGetNextOpt(popt_ctx);
@@ -675,12 +819,13 @@ int main(int argc, const char **argv)
         printf("Copyright (c) 2025 Anthony Verbeck\n");
         printf("License: MIT\n\n");
         printf("Description:\n");
-        printf("  This tool plays a mono WAV file through an ASIO output channel while\n");
-        printf("  simultaneously recording from an ASIO input channel to a new WAV file.\n");
+        printf("  This tool plays a WAV file through one or more ASIO output channels while\n");
+        printf("  simultaneously recording one or more ASIO input channels to a new WAV file.\n");
         printf("  Designed for professional audio interfaces using the ASIO protocol.\n\n");
         printf("Features:\n");
         printf("  - Direct ASIO driver access for low-latency audio\n");
-        printf("  - Simultaneous playback and recording\n");
+        printf("  - Simultaneous playback and recording, up to %d x %d channels\n", MAX_CHANNELS, MAX_CHANNELS);
+        printf("  - Per-input round-trip latency by cross-correlation, recordings aligned\n");
         printf("  - Support for 16-bit, 24-bit, and 32-bit float formats\n");
         printf("  - Configurable sample rates and channel selection\n\n");
         printf("Platform: Windows only (ASIO SDK)\n");
@@ -732,9 +877,14 @@ int main(int argc, const char **argv)
         return 1;
     }
 
-    outputBitDepth = bitDepth;
+    if (tailMs < 0.0 || (tailMs == 0.0 && !noAlignFlag)) {
+        fprintf(stderr, "Error: --tail must be greater than 0 ms to measure latency (or use --no-align)\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
 
-    poptFreeContext(popt_ctx);
+    outputBitDepth = bitDepth;
 
     printf("ASIO Audio Loopback Tool\n");
     printf("==========================================\n\n");
@@ -751,21 +901,22 @@ int main(int argc, const char **argv)
     if (!inputFile) {
         fprintf(stderr, "Error: Cannot open input file: %s\n", inputFilename);
         fprintf(stderr, "libsndfile error: %s\n", sf_strerror(nullptr));
+        poptFreeContext(popt_ctx);
         CoUninitialize();
         return 1;
     }
 
-    // Verify mono file
-    if (inputFileInfo.channels != 1) {
-        fprintf(stderr, "Error: Input file must be mono (has %d channels)\n", inputFileInfo.channels);
+    if (inputFileInfo.channels > MAX_CHANNELS) {
+        fprintf(stderr, "Error: Input file has %d channels (at most %d)\n", inputFileInfo.channels, MAX_CHANNELS);
         sf_close(inputFile);
+        poptFreeContext(popt_ctx);
         CoUninitialize();
         return 1;
     }
 
     printf("Input file info:\n");
     printf("  Sample rate: %d Hz\n", inputFileInfo.samplerate);
-    printf("  Channels: %d (mono)\n", inputFileInfo.channels);
+    printf("  Channels: %d\n", inputFileInfo.channels);
     printf("  Frames: %lld\n", (long long)inputFileInfo.frames);
     printf("  Duration: %.3f seconds\n\n", (double)inputFileInfo.frames / inputFileInfo.samplerate);
 
@@ -781,31 +932,49 @@ int main(int argc, const char **argv)
         printf("         This may cause pitch/speed changes!\n\n");
     }
 
-    // Allocate memory and load audio data
+    // Allocate memory and load audio data, one buffer per file channel
+    memset(&audioData, 0, sizeof(audioData));
+    audioData.playback_channels = inputFileInfo.channels;
     audioData.total_frames = static_cast<int>(inputFileInfo.frames);
-    audioData.playback_signal = static_cast<float*>(malloc(audioData.total_frames * sizeof(float)));
-    audioData.recorded_signal = static_cast<float*>(calloc(audioData.total_frames, sizeof(float)));
-    audioData.current_frame = 0;
+    audioData.record_frames = audioData.total_frames + static_cast<int>(tailMs * requestedSampleRate / 1000.0);
+
+    float* interleaved = static_cast<float*>(malloc((size_t)audioData.total_frames * inputFileInfo.channels * sizeof(float)));
+    bool allocated = (interleaved != nullptr);
+    for (int ch = 0; ch < audioData.playback_channels && allocated; ch++) {
+        audioData.playback_signal[ch] = static_cast<float*>(malloc(audioData.total_frames * sizeof(float)));
+        allocated = (audioData.playback_signal[ch] != nullptr);
+    }
 
-    if (!audioData.playback_signal || !audioData.recorded_signal) {
+    if (!allocated) {
         fprintf(stderr, "Error: Failed to allocate memory for audio buffers\n");
+        free(interleaved);
+        freeAudioData();
         sf_close(inputFile);
+        poptFreeContext(popt_ctx);
         CoUninitialize();
         return 1;
     }
 
     // Read entire file
-    sf_count_t framesRead = sf_read_float(inputFile, audioData.playback_signal, audioData.total_frames);
+    sf_count_t framesRead = sf_readf_float(inputFile, interleaved, audioData.total_frames);
     sf_close(inputFile);
 
     if (framesRead != audioData.total_frames) {
         fprintf(stderr, "Error: Failed to read all frames from input file\n");
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        free(interleaved);
+        freeAudioData();
+        poptFreeContext(popt_ctx);
         CoUninitialize();
         return 1;
     }
 
+    for (int i = 0; i < audioData.total_frames; i++) {
+        for (int ch = 0; ch < audioData.playback_channels; ch++) {
+            audioData.playback_signal[ch][i] = interleaved[i * audioData.playback_channels + ch];
+        }
+    }
+    free(interleaved);
+
     printf("Loaded %d frames from input file\n\n", audioData.total_frames);
 
 //------------------------------------------------------------------------------
@@ -813,8 +982,8 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
     if (!initASIO(driverName)) {
         fprintf(stderr, "Failed to initialize ASIO driver\n");
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
+        poptFreeContext(popt_ctx);
         CoUninitialize();
         return 1;
     }
@@ -822,33 +991,54 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
 //  Validate channel selections
 //------------------------------------------------------------------------------
-    if (inputChannel >= numInputChannels) {
-        fprintf(stderr, "Error: Input channel %ld out of range (0-%ld)\n", inputChannel, numInputChannels - 1);
+    numRecordChannels = parseChannelList(inputSpec ? inputSpec : "0", inputChannels, MAX_CHANNELS, numInputChannels);
+    numPlayChannels = parseChannelList(outputSpec ? outputSpec : "0", outputChannels, MAX_CHANNELS, numOutputChannels);
+    poptFreeContext(popt_ctx);
+
+    if (numRecordChannels <= 0) {
+        fprintf(stderr, "Error: Invalid input channel list (channels 0-%ld)\n", numInputChannels - 1);
+        shutdownASIO();
+        freeAudioData();
+        CoUninitialize();
+        return 1;
+    }
+
+    if (numPlayChannels <= 0) {
+        fprintf(stderr, "Error: Invalid output channel list (channels 0-%ld)\n", numOutputChannels - 1);
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
 
-    if (outputChannel >= numOutputChannels) {
-        fprintf(stderr, "Error: Output channel %ld out of range (0-%ld)\n", outputChannel, numOutputChannels - 1);
+    if (audioData.playback_channels != 1 && audioData.playback_channels != numPlayChannels) {
+        fprintf(stderr, "Error: Input file has %d channels; it must be mono or have one per output (%ld)\n",
+                audioData.playback_channels, numPlayChannels);
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
 
+    for (long ch = 0; ch < numRecordChannels; ch++) {
+        audioData.recorded_signal[ch] = static_cast<float*>(calloc(audioData.record_frames, sizeof(float)));
+        if (!audioData.recorded_signal[ch]) {
+            fprintf(stderr, "Error: Failed to allocate memory for audio buffers\n");
+            shutdownASIO();
+            freeAudioData();
+            CoUninitialize();
+            return 1;
+        }
+    }
+
 //------------------------------------------------------------------------------
 //  Setup ASIO buffers
 //------------------------------------------------------------------------------
     printf("\n");
-    if (!setupASIOBuffers(inputChannel, outputChannel, requestedSampleRate)) {
+    if (!setupASIOBuffers(requestedSampleRate)) {
         fprintf(stderr, "Failed to setup ASIO buffers\n");
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
@@ -858,7 +1048,7 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
     memset(&outputFileInfo, 0, sizeof(outputFileInfo));
     outputFileInfo.samplerate = static_cast<int>(currentSampleRate);
-    outputFileInfo.channels = 1;  // Mono recording
+    outputFileInfo.channels = static_cast<int>(numRecordChannels);
 
     // Set format based on bit depth
     if (outputBitDepth == 16) {
@@ -869,24 +1059,23 @@ int main(int argc, const char **argv)
         outputFileInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
     }
 
-    outputFile = sf_open(outputFilename, SFM_WRITE, &outputFileInfo);
+    SNDFILE* outputFile = sf_open(outputFilename, SFM_WRITE, &outputFileInfo);
     if (!outputFile) {
         fprintf(stderr, "Error: Cannot open output file: %s\n", outputFilename);
         fprintf(stderr, "libsndfile error: %s\n", sf_strerror(nullptr));
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
 
     printf("\nOutput file: %s\n", outputFilename);
     if (outputBitDepth == 16) {
-        printf("Format: WAV file (16-bit PCM, mono, %.0f Hz)\n", currentSampleRate);
+        printf("Format: WAV file (16-bit PCM, %ld channel(s), %.0f Hz)\n", numRecordChannels, currentSampleRate);
     } else if (outputBitDepth == 24) {
-        printf("Format: WAV file (24-bit PCM, mono, %.0f Hz)\n", currentSampleRate);
+        printf("Format: WAV file (24-bit PCM, %ld channel(s), %.0f Hz)\n", numRecordChannels, currentSampleRate);
     } else {
-        printf("Format: WAV file (32-bit float, mono, %.0f Hz)\n", currentSampleRate);
+        printf("Format: WAV file (32-bit float, %ld channel(s), %.0f Hz)\n", numRecordChannels, currentSampleRate);
     }
 
 //------------------------------------------------------------------------------
@@ -896,8 +1085,7 @@ int main(int argc, const char **argv)
         fprintf(stderr, "Failed to pre-convert playback signal\n");
         sf_close(outputFile);
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
@@ -906,9 +1094,11 @@ int main(int argc, const char **argv)
 //  Start loopback
 //------------------------------------------------------------------------------
     printf("\nStarting loopback...\n");
-    printf("Playing: Input channel %ld -> Output channel %ld\n", outputChannel, inputChannel);
-    printf("Recording: Input channel %ld -> %s\n\n", inputChannel, outputFilename);
+    printf("Playing: %s -> %ld output channel(s)\n", inputFilename, numPlayChannels);
+    printf("Recording: %ld input channel(s) -> %s\n\n", numRecordChannels, outputFilename);
 
+    ab_cbstats_init(&cbStats, currentSampleRate);
+    driverXruns = 0;
     loopbackActive = true;
 
     ASIOError err = ASIOStart();
@@ -916,8 +1106,7 @@ int main(int argc, const char **argv)
         fprintf(stderr, "ASIOStart failed with error: %ld\n", err);
         sf_close(outputFile);
         shutdownASIO();
-        free(audioData.playback_signal);
-        free(audioData.recorded_signal);
+        freeAudioData();
         CoUninitialize();
         return 1;
     }
@@ -927,26 +1116,51 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
     while (loopbackActive) {
         Sleep(100);
-        printf("\rProgress: %d / %d frames", audioData.current_frame, audioData.total_frames);
+        printf("\rProgress: %d / %d frames", audioData.current_frame, audioData.record_frames);
         fflush(stdout);
     }
     printf("\n\n");
 
 //------------------------------------------------------------------------------
-//  Stop ASIO and close output file
+//  Stop ASIO, align the recordings and write the output file
 //------------------------------------------------------------------------------
+    ASIOStop();
+    ab_asio_write_timing(&cbStats, driverXruns.load(), "ab_asio_loopback", statsFilename);
     shutdownASIO();
+
+    LatencyResult latencies[MAX_CHANNELS];
+    bool aligned = false;
+    int status = 0;
+
+    if (!noAlignFlag) {
+        if (measureLatencies(latencies)) {
+            printLatencies(latencies);
+            aligned = true;
+            if (latencyFilename && !writeLatencyCsv(latencyFilename, latencies)) {
+                fprintf(stderr, "Error: Cannot write latency file: %s\n", latencyFilename);
+                status = 1;
+            }
+        } else {
+            fprintf(stderr, "Warning: Out of memory for cross-correlation, writing unaligned recording\n");
+        }
+    }
+
+    if (!writeRecording(outputFile, aligned ? latencies : nullptr)) {
+        fprintf(stderr, "Error: Failed to write output file: %s\n", outputFilename);
+        status = 1;
+    }
     sf_close(outputFile);
 
-    printf("Loopback complete!\n");
-    printf("Recorded audio saved to: %s\n", outputFilename);
+    if (status == 0) {
+        printf("Loopback complete!\n");
+        printf("Recorded audio saved to: %s%s\n", outputFilename, aligned ? " (latency compensated)" : "");
+    }
 
 //------------------------------------------------------------------------------
 //  Cleanup
 //------------------------------------------------------------------------------
-    free(audioData.playback_signal);
-    free(audioData.recorded_signal);
+    freeAudioData();
 
     CoUninitialize();
-    return 0;
+    return status;
 }
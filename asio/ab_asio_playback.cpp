@@ -28,6 +28,10 @@
  *
  * Windows-only ASIO interface for professional audio hardware
  * Plays WAV files through ASIO output with multi-channel support and seeking
+ *
+ * The whole file is converted to the driver's sample format before playback
+ * starts, or with --stream a reader thread converts it ahead into a bounded
+ * ring per channel; either way the callback only copies.
  */
 
 #include <windows.h>
@@ -36,12 +40,15 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cstring>
+#include <atomic>
 #include <sndfile.h>
 #include <popt.h>
 #include "asiosys.h"
 #include "asio.h"
 #include "iasiodrv.h"
 #include "asiodrivers.h"
+#include "ab_asio_convert.h"
+#include "ab_ring.h"
 
 //------------------------------------------------------------------------------
 // Version Information
@@ -72,9 +79,13 @@ static bool verbose = false;  // Global verbose flag
 static ASIOChannelInfo* channelInfos = nullptr;        // Dynamic array for N channels
 
 //------------------------------------------------------------------------------
-// Cached sample size (calculated once during setup)
+// Cached sample size and per-channel conversion kernels (chosen once during
+// setup, see ab_asio_convert.h)
 //------------------------------------------------------------------------------
 static size_t outputSampleSize = 0;
+static bool ditherMode = false;                        // --dither: TPDF dither on integer outputs
+static AbAsioFromFloatFn* outputConverters = nullptr;  // One per WAV channel
+static AbAsioDither* ditherStates = nullptr;           // One per WAV channel
 
 //------------------------------------------------------------------------------
 // Pre-converted playback signal in ASIO output format (per-channel buffers)
@@ -91,74 +102,35 @@ static long currentFrame = 0;                          // Current playback posit
 static long offsetFrames = 0;                          // Frames skipped due to --offset
 
 //------------------------------------------------------------------------------
-// Sample format conversion: Float to ASIO
+// Streaming playback (--stream): reader thread -> bufferSwitch
+//
+// One single-producer/single-consumer ring per channel (libaudiobench, see
+// ab_ring.h). A ring "frame" is one channel's whole ASIO buffer, already in
+// the driver's sample format and padded to whole floats: the ring only
+// copies the bytes, so the callback takes each buffer with one memcpy.
 //------------------------------------------------------------------------------
-static void convertFloatToASIO(float* floatBuffer, void* asioBuffer, long numSamples, ASIOSampleType sampleType)
-{
-    switch (sampleType) {
-        case ASIOSTInt16LSB:
-        {
-            short* samples = static_cast<short*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<short>(sample * 32767.0f);
-            }
-            break;
-        }
-        case ASIOSTInt24LSB:
-        {
-            unsigned char* samples = static_cast<unsigned char*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                int s24 = static_cast<int>(sample * 8388607.0f);  // 2^23 - 1
-                // Pack as 24-bit LSB (3 bytes, LSB first)
-                samples[i*3] = s24 & 0xFF;
-                samples[i*3+1] = (s24 >> 8) & 0xFF;
-                samples[i*3+2] = (s24 >> 16) & 0xFF;
-            }
-            break;
-        }
-        case ASIOSTInt32LSB:
-        {
-            int* samples = static_cast<int*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<int>(sample * 2147483647.0f);
-            }
-            break;
-        }
-        case ASIOSTFloat32LSB:
-        {
-            float* samples = static_cast<float*>(asioBuffer);
-            memcpy(samples, floatBuffer, numSamples * sizeof(float));
-            break;
-        }
-        case ASIOSTFloat64LSB:
-        {
-            double* samples = static_cast<double*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                samples[i] = static_cast<double>(floatBuffer[i]);
-            }
-            break;
-        }
-        default:
-            memset(asioBuffer, 0, numSamples * sizeof(float));
-            break;
-    }
-}
+#define STREAM_SECONDS      2       // Ring capacity in seconds of audio
+#define STREAM_READ_BLOCKS  16      // ASIO buffers decoded per sf_readf_float() call
+#define READER_POLL_MS      5       // Reader sleep when the rings are full
+static bool streamMode = false;
+static SNDFILE* streamFile = nullptr;
+static AbRing** streamRings = nullptr;                 // One ring per channel
+static AbRingSpans* streamSpans = nullptr;             // Callback scratch, one per channel
+static size_t blockFloats = 0;                         // Ring frame size: one ASIO buffer in floats
+static size_t streamBlocks = 0;                        // Ring capacity in ASIO buffers
+static float* readerInterleaved = nullptr;             // STREAM_READ_BLOCKS buffers of file frames
+static float* readerChannel = nullptr;                 // One de-interleaved buffer
+static float* readerBlocks = nullptr;                  // STREAM_READ_BLOCKS converted buffers
+static std::atomic<bool> readerDone(false);
+static std::atomic<bool> readerStop(false);
+static std::atomic<long> underruns(0);
 
 //------------------------------------------------------------------------------
 // ASIO Callbacks
 //------------------------------------------------------------------------------
 static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow)
 {
-    if (!playbackActive || !preconvertedChannels) {
+    if (!playbackActive || (!preconvertedChannels && !streamRings)) {
         // Zero all output buffers to prevent noise/buzz after playback ends
         if (bufferInfos && numWavChannels > 0 && outputSampleSize > 0) {
             for (long ch = 0; ch < numWavChannels; ch++) {
@@ -172,6 +144,36 @@ static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool p
     long bufferSize = preferredBufferSize;
     long framesToProcess = bufferSize;
 
+    if (streamMode) {
+        // Take a buffer only when every channel has one, so the channels
+        // stay aligned; the reader zero-pads the last one
+        bool ready = currentFrame < totalFrames;
+        for (long ch = 0; ready && ch < numWavChannels; ch++) {
+            ready = ab_ring_peek(streamRings[ch], &streamSpans[ch]) >= blockFloats;
+        }
+
+        if (ready) {
+            for (long ch = 0; ch < numWavChannels; ch++) {
+                memcpy(bufferInfos[ch].buffers[index], streamSpans[ch].data[0],
+                       bufferSize * outputSampleSize);
+                ab_ring_consume(streamRings[ch], blockFloats);
+            }
+            currentFrame += (totalFrames - currentFrame < bufferSize) ? totalFrames - currentFrame : bufferSize;
+            return nullptr;
+        }
+
+        // Nothing queued: silence, then either end of file or an underrun
+        for (long ch = 0; ch < numWavChannels; ch++) {
+            memset(bufferInfos[ch].buffers[index], 0, bufferSize * outputSampleSize);
+        }
+        if (currentFrame >= totalFrames || readerDone.load(std::memory_order_acquire)) {
+            playbackActive = false;
+        } else {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
     // Check if we're nearing end of playback
     if (currentFrame + framesToProcess > totalFrames) {
         framesToProcess = totalFrames - currentFrame;
@@ -387,14 +389,12 @@ static bool setupASIOBuffers(long startChannel, long numChannels)
             return false;
         }
 
-        // Verify all channels have same sample type (simplifies pre-conversion)
+        // Buffers and stream blocks are sized from channel 0's type, so every
+        // channel must use it
         if (i > 0 && channelInfos[i].type != channelInfos[0].type) {
-            if (verbose) {
-                printf("Warning: Output channels have different sample types!\n");
-                printf("  Channel %ld: type %ld\n", startChannel, channelInfos[0].type);
-                printf("  Channel %ld: type %ld\n", startChannel + i, channelInfos[i].type);
-            }
-            // Continue anyway - pre-conversion will handle per-channel
+            printf("Error: Output channel %ld uses sample type %ld, channel %ld uses %ld\n",
+                   startChannel + i, channelInfos[i].type, startChannel, channelInfos[0].type);
+            return false;
         }
     }
 
@@ -404,6 +404,160 @@ static bool setupASIOBuffers(long startChannel, long numChannels)
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Output sample size (setupASIOBuffers() has checked that all channels use
+// channel 0's type) and one conversion kernel plus dither generator per channel
+//------------------------------------------------------------------------------
+static bool setOutputFormat(long numChannels)
+{
+    for (long ch = 0; ch < numChannels; ch++) {
+        if (!ab_asio_sample_type_supported(channelInfos[ch].type) ||
+            channelInfos[ch].type != channelInfos[0].type) {
+            printf("Error: Unsupported output sample type on channel %ld: %ld\n",
+                   channelInfos[ch].channel, channelInfos[ch].type);
+            return false;
+        }
+    }
+    outputSampleSize = ab_asio_sample_size(channelInfos[0].type);
+
+    if (!outputConverters) {
+        outputConverters = new AbAsioFromFloatFn[numChannels];
+        ditherStates = new AbAsioDither[numChannels];
+    }
+    unsigned flags = AB_ASIO_CLIP | (ditherMode ? AB_ASIO_DITHER : 0);
+    for (long ch = 0; ch < numChannels; ch++) {
+        outputConverters[ch] = ab_asio_output_converter(channelInfos[ch].type, flags);
+        ab_asio_dither_init(&ditherStates[ch], (uint32_t)ch + 1);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Streaming playback
+//------------------------------------------------------------------------------
+static void freeStreamBuffers()
+{
+    if (streamRings) {
+        for (long ch = 0; ch < numWavChannels; ch++) {
+            ab_ring_destroy(streamRings[ch]);
+        }
+        free(streamRings);
+        streamRings = nullptr;
+    }
+    free(streamSpans);
+    free(readerInterleaved);
+    free(readerChannel);
+    free(readerBlocks);
+    streamSpans = nullptr;
+    readerInterleaved = nullptr;
+    readerChannel = nullptr;
+    readerBlocks = nullptr;
+}
+
+// Allocates the per-channel rings (STREAM_SECONDS of audio, whole ASIO
+// buffers) and the reader's conversion buffers. Nothing is allocated once
+// playback has started.
+static bool setupStreaming(SNDFILE* inputFile, long numChannels)
+{
+    if (!setOutputFormat(numChannels)) {
+        return false;
+    }
+
+    streamFile = inputFile;
+    blockFloats = (preferredBufferSize * outputSampleSize + sizeof(float) - 1) / sizeof(float);
+    streamBlocks = (size_t)(STREAM_SECONDS * currentSampleRate / preferredBufferSize) + 1;
+    if (streamBlocks < 2 * STREAM_READ_BLOCKS) {
+        streamBlocks = 2 * STREAM_READ_BLOCKS;
+    }
+
+    streamRings = (AbRing**)calloc(numChannels, sizeof(AbRing*));
+    streamSpans = (AbRingSpans*)calloc(numChannels, sizeof(AbRingSpans));
+    readerInterleaved = (float*)malloc((size_t)STREAM_READ_BLOCKS * preferredBufferSize * numChannels * sizeof(float));
+    readerChannel = (float*)malloc(preferredBufferSize * sizeof(float));
+    readerBlocks = (float*)calloc((size_t)STREAM_READ_BLOCKS * blockFloats, sizeof(float));
+    bool ok = streamRings && streamSpans && readerInterleaved && readerChannel && readerBlocks;
+    for (long ch = 0; ok && ch < numChannels; ch++) {
+        streamRings[ch] = ab_ring_create(streamBlocks, (int)blockFloats);
+        ok = streamRings[ch] != nullptr;
+    }
+    if (!ok) {
+        printf("Error: Failed to allocate streaming buffers\n");
+        freeStreamBuffers();
+        return false;
+    }
+
+    if (verbose) {
+        printf("Streaming: %zu buffers of %ld frames per channel (%.1f s), %zu bytes each\n",
+               streamBlocks, preferredBufferSize,
+               streamBlocks * preferredBufferSize / currentSampleRate, blockFloats * sizeof(float));
+    }
+    return true;
+}
+
+// Whole buffers that fit on every channel (the fullest ring decides)
+static size_t streamFreeBlocks()
+{
+    size_t used = 0;
+    for (long ch = 0; ch < numWavChannels; ch++) {
+        size_t fill = ab_ring_fill(streamRings[ch]) / blockFloats;
+        if (fill > used) {
+            used = fill;
+        }
+    }
+    return (used < streamBlocks) ? streamBlocks - used : 0;
+}
+
+// Producer side: decodes up to STREAM_READ_BLOCKS ASIO buffers at a time,
+// converts each channel to the driver format and queues it, until the end
+// of the file or readerStop. The last buffer is padded with silence.
+static DWORD WINAPI readerThread(LPVOID)
+{
+    long framesQueued = 0;
+
+    while (framesQueued < totalFrames && !readerStop.load(std::memory_order_acquire)) {
+        size_t blocks = streamFreeBlocks();
+        if (blocks == 0) {
+            Sleep(READER_POLL_MS);
+            continue;
+        }
+        if (blocks > STREAM_READ_BLOCKS) {
+            blocks = STREAM_READ_BLOCKS;
+        }
+
+        long want = (long)blocks * preferredBufferSize;
+        if (want > totalFrames - framesQueued) {
+            want = totalFrames - framesQueued;
+        }
+        sf_count_t got = sf_readf_float(streamFile, readerInterleaved, want);
+        if (got <= 0) {
+            break;
+        }
+
+        blocks = (size_t)((got + preferredBufferSize - 1) / preferredBufferSize);
+        memset(readerInterleaved + got * numWavChannels, 0,
+               (blocks * preferredBufferSize - got) * numWavChannels * sizeof(float));
+
+        for (long ch = 0; ch < numWavChannels; ch++) {
+            for (size_t b = 0; b < blocks; b++) {
+                const float* frames = readerInterleaved + b * preferredBufferSize * numWavChannels;
+                for (long i = 0; i < preferredBufferSize; i++) {
+                    readerChannel[i] = frames[i * numWavChannels + ch];
+                }
+                outputConverters[ch](readerChannel, readerBlocks + b * blockFloats,
+                                     preferredBufferSize, &ditherStates[ch]);
+            }
+            ab_ring_write(streamRings[ch], readerBlocks, blocks * blockFloats);
+        }
+        framesQueued += (long)got;
+        if (got < want) {
+            break;
+        }
+    }
+
+    readerDone.store(true, std::memory_order_release);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 // Pre-convert playback signal to ASIO format
 //------------------------------------------------------------------------------
@@ -417,16 +571,10 @@ static bool preconvertPlaybackSignal(SNDFILE* inputFile, long numChannels, long
     }
 
     // Determine sample size (assume all channels use same type as channel 0)
-    switch (channelInfos[0].type) {
-        case ASIOSTInt16LSB:   outputSampleSize = 2; break;
-        case ASIOSTInt24LSB:   outputSampleSize = 3; break;
-        case ASIOSTInt32LSB:   outputSampleSize = 4; break;
-        case ASIOSTFloat32LSB: outputSampleSize = 4; break;
-        case ASIOSTFloat64LSB: outputSampleSize = 8; break;
-        default:
-            printf("Error: Unsupported output sample type: %ld\n",
-                   channelInfos[0].type);
-            return false;
+    if (!setOutputFormat(numChannels)) {
+        free(preconvertedChannels);
+        preconvertedChannels = nullptr;
+        return false;
     }
 
     // Allocate ASIO-format buffer for each channel
@@ -497,10 +645,8 @@ static bool preconvertPlaybackSignal(SNDFILE* inputFile, long numChannels, long
             channelFloat[frame] = interleavedBuffer[frame * numChannels + ch];
         }
 
-        // Convert to ASIO format (use channel-specific type if needed)
-        ASIOSampleType sampleType = channelInfos[ch].type;
-        convertFloatToASIO(channelFloat, preconvertedChannels[ch],
-                          numFrames, sampleType);
+        // Convert to ASIO format (channel-specific kernel, see setOutputFormat)
+        outputConverters[ch](channelFloat, preconvertedChannels[ch], numFrames, &ditherStates[ch]);
 
         free(channelFloat);
 
@@ -543,6 +689,11 @@ static void shutdownASIO()
         channelInfos = nullptr;
     }
 
+    delete[] outputConverters;
+    delete[] ditherStates;
+    outputConverters = nullptr;
+    ditherStates = nullptr;
+
     // Clean up pre-converted channel data
     if (preconvertedChannels) {
         for (long ch = 0; ch < numWavChannels; ch++) {
@@ -554,6 +705,8 @@ static void shutdownASIO()
         free(preconvertedChannels);
         preconvertedChannels = nullptr;
     }
+
+    freeStreamBuffers();
 }
 
 //------------------------------------------------------------------------------
@@ -595,6 +748,8 @@ int main(int argc, const char* argv[])
     char* inputFilename = nullptr;
     long startChannel = 0;
     double offsetSeconds = 0.0;
+    int stream_flag = 0;
+    int dither_flag = 0;
 
     struct poptOption options[] = {
         {"version", 'v', POPT_ARG_NONE, &version_flag, 0,
@@ -613,6 +768,10 @@ int main(int argc, const char* argv[])
          "WAV file to play (required)", "FILE"},
         {"offset", 'o', POPT_ARG_DOUBLE, &offsetSeconds, 0,
          "Start playback from time position in seconds (default: 0.0)", "SECONDS"},
+        {"stream", 's', POPT_ARG_NONE, &stream_flag, 0,
+         "Stream from disk through a reader thread instead of pre-converting the whole file", nullptr},
+        {"dither", 'D', POPT_ARG_NONE, &dither_flag, 0,
+         "Add TPDF dither when the driver takes 24-bit or narrower integers", nullptr},
         {"verbose", 'V', POPT_ARG_NONE, &verbose_flag, 0,
          "Enable verbose output", nullptr},
         POPT_AUTOHELP
@@ -631,7 +790,9 @@ int main(int argc, const char* argv[])
         "  ab_asio_playback -d \"Driver\" -p -f mono.wav              # Play mono (quiet)\n"
         "  ab_asio_playback -d \"Driver\" -p -f stereo.wav -c 2 -V    # Play with verbose\n"
         "  ab_asio_playback -d \"Driver\" -p -f music.wav -o 30.5     # Start at 30.5s\n"
-        "  ab_asio_playback -d \"Driver\" -p -f 8ch.wav -c 0          # Play 8 channels\n");
+        "  ab_asio_playback -d \"Driver\" -p -f 8ch.wav -c 0          # Play 8 channels\n"
+        "  ab_asio_playback -d \"Driver\" -p -f long.wav -s           # Stream a long file\n"
+        "  ab_asio_playback -d \"Driver\" -p -f hires.wav -D          # Dither to a 16/24-bit driver\n");
 
     int rc;
     while ((rc = poptGetNextOpt(popt_ctx)) > 0) {
@@ -666,6 +827,7 @@ int main(int argc, const char* argv[])
         printf("  - Support for all ASIO sample formats (Int16/24/32, Float32/64)\n");
         printf("  - Seeking support (start playback from specific time)\n");
         printf("  - Pre-conversion optimization for glitch-free playback\n");
+        printf("  - Streaming mode for long files (bounded memory, constant startup)\n");
         printf("  - Configurable output channel routing\n\n");
         printf("Copyright (c) 2025 Anthony Verbeck\n");
         printf("Licensed under MIT License\n");
@@ -718,6 +880,8 @@ int main(int argc, const char* argv[])
 
     // Set global verbose flag
     verbose = (verbose_flag != 0);
+    streamMode = (stream_flag != 0);
+    ditherMode = (dither_flag != 0);
 
     // Load WAV file
     if (verbose) {
@@ -860,24 +1024,55 @@ int main(int argc, const char* argv[])
         printf("\n");
     }
 
-    // Pre-convert playback signal
-    if (verbose) {
-        printf("Pre-converting playback signal...\n");
-    }
-    if (!preconvertPlaybackSignal(inputFile, numWavChannels, totalFrames)) {
-        fprintf(stderr, "Error: Failed to pre-convert playback signal\n");
-        shutdownASIO();
+    HANDLE readerHandle = nullptr;
+    if (streamMode) {
+        // Start the reader and let it fill half the ring before ASIOStart,
+        // so startup costs the same however long the file is
+        if (verbose) {
+            printf("Starting reader thread...\n");
+        }
+        if (!setupStreaming(inputFile, numWavChannels)) {
+            fprintf(stderr, "Error: Failed to set up streaming playback\n");
+            shutdownASIO();
+            sf_close(inputFile);
+            CoUninitialize();
+            return 1;
+        }
+        readerDone = false;
+        readerStop = false;
+        underruns = 0;
+        readerHandle = CreateThread(nullptr, 0, readerThread, nullptr, 0, nullptr);
+        if (!readerHandle) {
+            fprintf(stderr, "Error: Failed to create reader thread\n");
+            shutdownASIO();
+            sf_close(inputFile);
+            CoUninitialize();
+            return 1;
+        }
+        while (!readerDone && ab_ring_fill(streamRings[numWavChannels - 1]) < streamBlocks / 2 * blockFloats) {
+            Sleep(READER_POLL_MS);
+        }
+    } else {
+        // Pre-convert playback signal
+        if (verbose) {
+            printf("Pre-converting playback signal...\n");
+        }
+        if (!preconvertPlaybackSignal(inputFile, numWavChannels, totalFrames)) {
+            fprintf(stderr, "Error: Failed to pre-convert playback signal\n");
+            shutdownASIO();
+            sf_close(inputFile);
+            CoUninitialize();
+            return 1;
+        }
+
+        // Close input file (no longer needed)
         sf_close(inputFile);
-        CoUninitialize();
-        return 1;
+        inputFile = nullptr;
     }
     if (verbose) {
         printf("\n");
     }
 
-    // Close input file (no longer needed)
-    sf_close(inputFile);
-
     // Start playback
     if (verbose) {
         printf("========================================\n");
@@ -890,6 +1085,7 @@ int main(int argc, const char* argv[])
         printf("Sample rate: %.0f Hz\n", currentSampleRate);
         printf("Frames: %ld (%.3f seconds)\n", totalFrames,
                (double)totalFrames / currentSampleRate);
+        printf("Mode: %s\n", streamMode ? "streaming" : "pre-converted");
         printf("========================================\n\n");
     }
 
@@ -899,7 +1095,16 @@ int main(int argc, const char* argv[])
     err = ASIOStart();
     if (err != ASE_OK) {
         fprintf(stderr, "Error: ASIOStart failed with error: %ld\n", err);
+        playbackActive = false;
+        if (readerHandle) {
+            readerStop = true;
+            WaitForSingleObject(readerHandle, INFINITE);
+            CloseHandle(readerHandle);
+        }
         shutdownASIO();
+        if (inputFile) {
+            sf_close(inputFile);
+        }
         CoUninitialize();
         return 1;
     }
@@ -920,6 +1125,19 @@ int main(int argc, const char* argv[])
         printf("Playback complete: %ld frames\n", currentFrame);
     }
 
+    // Stop the callbacks before the reader's rings go away
+    ASIOStop();
+    if (readerHandle) {
+        readerStop = true;
+        WaitForSingleObject(readerHandle, INFINITE);
+        CloseHandle(readerHandle);
+        sf_close(inputFile);
+        if (underruns > 0) {
+            fprintf(stderr, "Warning: %ld buffer underruns (reader fell behind; silence was output)\n",
+                    underruns.load());
+        }
+    }
+
     // Cleanup
     if (verbose) {
         printf("Shutting down ASIO...\n");
@@ -0,0 +1,1224 @@
+//------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2025 Anthony Verbeck
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//------------------------------------------------------------------------------
+
+/*
+ * ab_asio_server.cpp
+ * ASIO Measurement Server for audio-bench
+ *
+ * Windows-only ASIO interface for professional audio hardware
+ * Opens the driver, creates its buffers and starts it once, then runs
+ * measurement jobs (play, record, loopback, sweep) sent one line at a time
+ * over a local named pipe. The driver keeps running between jobs, playing
+ * silence, so a job costs its signal length rather than a driver load,
+ * buffer setup and clock relock. Stimuli are converted to the driver's
+ * output format once, when they are loaded.
+ *
+ * Protocol (one request per line, one reply line starting "ok" or "error"):
+ *   load NAME FILE                        Load a mono WAV file as stimulus NAME
+ *   sweep NAME F1 F2 SECONDS [DBFS [FILE]] Generate a log sweep stimulus
+ *   unload NAME                           Free a stimulus
+ *   play NAME OUTCH                       Play a stimulus
+ *   record INCH SECONDS FILE              Record one input to a WAV file
+ *   loopback NAME OUTCH INCH FILE [TAIL_MS] Play and record at once
+ *   status                                Driver, rate, buffer size, xruns
+ *   shutdown                              Stop the server
+ * Arguments containing spaces can be given in double quotes.
+ */
+
+#include <windows.h>
+#include <cstdio>
+#include <cstdlib>
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <sndfile.h>
+#include <popt.h>
+#include "asiosys.h"
+#include "asio.h"
+#include "iasiodrv.h"
+#include "asiodrivers.h"
+#include "ab_asio_convert.h"
+#include "ab_asio_timing.h"
+
+#define MAX_CHANNELS        32                                  // Per direction
+#define MAX_STIMULI         64
+#define MAX_ARGS            8
+#define LINE_SIZE           2048
+#define DEFAULT_PIPE        "ab_asio_server"
+
+//------------------------------------------------------------------------------
+// Global ASIO state
+//------------------------------------------------------------------------------
+static ASIODriverInfo driverInfo;
+static ASIOBufferInfo bufferInfos[2 * MAX_CHANNELS];       // Inputs first, then outputs
+static ASIOCallbacks asioCallbacks;
+static long numInputChannels = 0;
+static long numOutputChannels = 0;
+static long preferredBufferSize = 0;
+static long minBufferSize = 0;
+static long maxBufferSize = 0;
+static long bufferGranularity = 0;
+static ASIOSampleRate currentSampleRate = 48000.0;
+static std::atomic<bool> resetRequested(false);
+static bool buffersCreated = false;
+
+//------------------------------------------------------------------------------
+// Open channels (physical channel number, type and size per buffer slot)
+//------------------------------------------------------------------------------
+static long inputChannels[MAX_CHANNELS];
+static long outputChannels[MAX_CHANNELS];
+static long numOpenInputs = 0;
+static long numOpenOutputs = 0;
+static ASIOSampleType inputTypes[MAX_CHANNELS];
+static ASIOSampleType outputType = ASIOSTInt32LSB;         // Shared by every open output
+static size_t outputSampleSize = 0;
+
+//------------------------------------------------------------------------------
+// Stimuli, pre-converted to the output format when loaded
+//------------------------------------------------------------------------------
+typedef struct {
+    char name[64];
+    float* samples;                                         // Float copy, for "sweep ... FILE"
+    void* asio;                                             // ASIO output format
+    long frames;
+} Stimulus;
+
+static Stimulus stimuli[MAX_STIMULI];
+
+//------------------------------------------------------------------------------
+// Measurement job, handed to the callback through activeJob
+//------------------------------------------------------------------------------
+typedef struct {
+    const void* stimulus;                                   // nullptr: no playback
+    long stimulusFrames;
+    long outputSlot;                                        // Index into bufferInfos
+    float* capture;                                         // nullptr: no recording
+    long captureFrames;
+    long inputSlot;
+    ASIOSampleType inputType;
+    AbAsioToFloatFn inputConvert;                           // Picked for inputType (ab_asio_convert.h)
+    long length;                                            // Longer of the two
+    long position;                                          // Callback only
+} Job;
+
+static std::atomic<Job*> activeJob(nullptr);
+static std::atomic<bool> jobDone(false);
+
+// Callback timing and missed buffers since the server started (see ab_asio_timing.h).
+// cbStats has one writer, the callback, and is read only after ASIOStop()
+// (ab_cbstats.h); live replies use the copies the callback publishes below.
+static AbCbStats cbStats;
+static std::atomic<long> driverXruns(0);
+static std::atomic<unsigned long long> liveCallbacks(0);
+static std::atomic<unsigned long long> liveXruns(0);
+
+//------------------------------------------------------------------------------
+// Server state
+//------------------------------------------------------------------------------
+static char pipePath[256];
+static std::atomic<bool> serverRunning(true);
+static long outputBitDepth = 32;
+
+//------------------------------------------------------------------------------
+// Forward declarations
+//------------------------------------------------------------------------------
+static void bufferSwitch(long index, ASIOBool processNow);
+static void sampleRateChanged(ASIOSampleRate sRate);
+static long asioMessages(long selector, long value, void* message, double* opt);
+static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow);
+
+//------------------------------------------------------------------------------
+// ASIO Callbacks
+//------------------------------------------------------------------------------
+
+static void bufferSwitch(long index, ASIOBool processNow)
+{
+    bufferSwitchTimeInfo(nullptr, index, processNow);
+}
+
+// Runs for the life of the server: every output plays silence unless the
+// active job writes a stimulus over it
+static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool processNow)
+{
+    double start = ab_cbstats_now();
+    long bufferSize = preferredBufferSize;
+
+    for (long i = 0; i < numOpenOutputs; i++) {
+        memset(bufferInfos[numOpenInputs + i].buffers[index], 0, bufferSize * outputSampleSize);
+    }
+
+    Job* job = activeJob.load(std::memory_order_acquire);
+    if (job) {
+        long position = job->position;
+
+        if (job->stimulus && position < job->stimulusFrames) {
+            long frames = job->stimulusFrames - position;
+            if (frames > bufferSize) {
+                frames = bufferSize;
+            }
+            memcpy(bufferInfos[job->outputSlot].buffers[index],
+                   (const char*)job->stimulus + position * outputSampleSize,
+                   frames * outputSampleSize);
+        }
+
+        if (job->capture && position < job->captureFrames) {
+            long frames = job->captureFrames - position;
+            if (frames > bufferSize) {
+                frames = bufferSize;
+            }
+            job->inputConvert(bufferInfos[job->inputSlot].buffers[index], job->capture + position, frames);
+        }
+
+        job->position = position + bufferSize;
+        if (job->position >= job->length) {
+            activeJob.store(nullptr, std::memory_order_relaxed);
+            jobDone.store(true, std::memory_order_release);
+        }
+    }
+
+    ab_asio_record_timing(&cbStats, timeInfo, bufferSize, start);
+    liveCallbacks.store(cbStats.callbacks, std::memory_order_relaxed);
+    liveXruns.store(cbStats.xruns, std::memory_order_relaxed);
+    return nullptr;
+}
+
+static void sampleRateChanged(ASIOSampleRate sRate)
+{
+    currentSampleRate = sRate;
+    printf("Sample rate changed to: %.0f Hz\n", sRate);
+}
+
+static long asioMessages(long selector, long value, void* message, double* opt)
+{
+    switch (selector) {
+        case kAsioSelectorSupported:
+            if (value == kAsioResetRequest ||
+                value == kAsioEngineVersion ||
+                value == kAsioResyncRequest ||
+                value == kAsioLatenciesChanged ||
+                value == kAsioSupportsTimeInfo ||
+                value == kAsioSupportsTimeCode ||
+                value == kAsioSupportsInputMonitor ||
+                value == kAsioOverload)
+                return 1;
+            break;
+
+        case kAsioResetRequest:
+            // The buffers are no longer valid; jobs are refused until restart
+            printf("ASIO: Reset request\n");
+            resetRequested = true;
+            return 1;
+
+        case kAsioResyncRequest:
+        case kAsioOverload:
+            // Lost sync or a late buffer: counted with the callback stats
+            driverXruns.fetch_add(1, std::memory_order_relaxed);
+            return 1;
+
+        case kAsioLatenciesChanged:
+            printf("ASIO: Latencies changed\n");
+            return 1;
+
+        case kAsioEngineVersion:
+            return 2;
+
+        case kAsioSupportsTimeInfo:
+            return 1;
+
+        case kAsioSupportsTimeCode:
+            return 0;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// ASIO Driver Management
+//------------------------------------------------------------------------------
+
+static bool initASIO(const char* driverName)
+{
+    AsioDrivers* asioDrivers = new AsioDrivers();
+
+    // Load the driver
+    if (!asioDrivers->loadDriver(const_cast<char*>(driverName))) {
+        printf("Failed to load ASIO driver: %s\n", driverName);
+        delete asioDrivers;
+        return false;
+    }
+
+    // Initialize the driver
+    ASIOError err = ASIOInit(&driverInfo);
+    if (err != ASE_OK) {
+        printf("ASIOInit failed with error: %ld\n", err);
+        asioDrivers->removeCurrentDriver();
+        delete asioDrivers;
+        return false;
+    }
+
+    printf("ASIO Driver: %s\n", driverInfo.name);
+    printf("Version: %ld\n", driverInfo.asioVersion);
+    printf("Driver Version: 0x%08lx\n", driverInfo.driverVersion);
+
+    // Get channels
+    err = ASIOGetChannels(&numInputChannels, &numOutputChannels);
+    if (err != ASE_OK) {
+        printf("ASIOGetChannels failed\n");
+        ASIOExit();
+        delete asioDrivers;
+        return false;
+    }
+
+    printf("Input channels: %ld\n", numInputChannels);
+    printf("Output channels: %ld\n", numOutputChannels);
+
+    // Get buffer size range
+    err = ASIOGetBufferSize(&minBufferSize, &maxBufferSize, &preferredBufferSize, &bufferGranularity);
+    if (err != ASE_OK) {
+        printf("ASIOGetBufferSize failed\n");
+        ASIOExit();
+        delete asioDrivers;
+        return false;
+    }
+
+    printf("Buffer size range: min=%ld, max=%ld, preferred=%ld, granularity=%ld\n",
+           minBufferSize, maxBufferSize, preferredBufferSize, bufferGranularity);
+
+    // Get sample rate
+    err = ASIOGetSampleRate(&currentSampleRate);
+    if (err != ASE_OK) {
+        printf("ASIOGetSampleRate failed\n");
+    } else {
+        printf("Current sample rate: %.0f Hz\n", currentSampleRate);
+    }
+
+    return true;
+}
+
+// Creates buffers for every open channel; all outputs must share one sample
+// type so stimuli can be pre-converted once
+static bool setupASIOBuffers(double requestedSampleRate)
+{
+    // Set sample rate if requested
+    if (requestedSampleRate > 0) {
+        ASIOError err = ASIOSetSampleRate(requestedSampleRate);
+        if (err != ASE_OK) {
+            printf("Warning: Could not set sample rate to %.0f Hz\n", requestedSampleRate);
+        } else {
+            currentSampleRate = requestedSampleRate;
+            printf("Sample rate set to: %.0f Hz\n", currentSampleRate);
+        }
+    }
+
+    // Setup callbacks
+    asioCallbacks.bufferSwitch = bufferSwitch;
+    asioCallbacks.sampleRateDidChange = sampleRateChanged;
+    asioCallbacks.asioMessage = asioMessages;
+    asioCallbacks.bufferSwitchTimeInfo = bufferSwitchTimeInfo;
+
+    memset(bufferInfos, 0, sizeof(bufferInfos));
+    for (long i = 0; i < numOpenInputs; i++) {
+        bufferInfos[i].isInput = ASIOTrue;
+        bufferInfos[i].channelNum = inputChannels[i];
+    }
+    for (long i = 0; i < numOpenOutputs; i++) {
+        bufferInfos[numOpenInputs + i].isInput = ASIOFalse;
+        bufferInfos[numOpenInputs + i].channelNum = outputChannels[i];
+    }
+
+    // Create buffers
+    ASIOError err = ASIOCreateBuffers(bufferInfos, numOpenInputs + numOpenOutputs, preferredBufferSize, &asioCallbacks);
+    if (err != ASE_OK) {
+        printf("ASIOCreateBuffers failed with error: %ld\n", err);
+        return false;
+    }
+    buffersCreated = true;
+
+    // Get and cache channel info
+    for (long i = 0; i < numOpenInputs; i++) {
+        ASIOChannelInfo channelInfo;
+        channelInfo.channel = inputChannels[i];
+        channelInfo.isInput = ASIOTrue;
+        if (ASIOGetChannelInfo(&channelInfo) != ASE_OK) {
+            printf("Failed to get input channel info\n");
+            return false;
+        }
+        inputTypes[i] = channelInfo.type;
+        if (!ab_asio_sample_type_supported(channelInfo.type)) {
+            printf("Warning: Input channel %ld has unsupported sample type %ld\n",
+                   inputChannels[i], channelInfo.type);
+        }
+    }
+
+    for (long i = 0; i < numOpenOutputs; i++) {
+        ASIOChannelInfo channelInfo;
+        channelInfo.channel = outputChannels[i];
+        channelInfo.isInput = ASIOFalse;
+        if (ASIOGetChannelInfo(&channelInfo) != ASE_OK) {
+            printf("Failed to get output channel info\n");
+            return false;
+        }
+        if (i == 0) {
+            outputType = channelInfo.type;
+        } else if (channelInfo.type != outputType) {
+            printf("Error: Output channel %ld uses sample type %ld, channel %ld uses %ld\n",
+                   outputChannels[i], channelInfo.type, outputChannels[0], outputType);
+            return false;
+        }
+    }
+
+    outputSampleSize = ab_asio_sample_size(outputType);
+    if (numOpenOutputs > 0 && outputSampleSize == 0) {
+        printf("Error: Unsupported output sample type: %ld\n", outputType);
+        return false;
+    }
+
+    printf("Opened %ld input and %ld output channel(s), %ld frames per buffer\n",
+           numOpenInputs, numOpenOutputs, preferredBufferSize);
+    return true;
+}
+
+static void shutdownASIO()
+{
+    ASIOStop();
+    if (buffersCreated) {
+        ASIODisposeBuffers();
+        buffersCreated = false;
+    }
+    ASIOExit();
+}
+
+//------------------------------------------------------------------------------
+// Enumeration
+//------------------------------------------------------------------------------
+
+static void listASIODrivers()
+{
+    AsioDrivers asioDrivers;
+    char* driverNames[32];
+    char driverNameBuffer[32][256];
+
+    for (int i = 0; i < 32; i++) {
+        driverNames[i] = driverNameBuffer[i];
+    }
+
+    long numDrivers = asioDrivers.getDriverNames(driverNames, 32);
+
+    printf("Available ASIO Drivers (%ld):\n", numDrivers);
+    printf("----------------------------------------\n");
+
+    for (long i = 0; i < numDrivers; i++) {
+        printf("%2ld: %s\n", i, driverNames[i]);
+    }
+
+    printf("\n");
+}
+
+// Parse a channel list such as "0", "0,1" or "0-3,6"; returns the number
+// of channels stored or -1 on a syntax/range error
+static long parseChannelList(const char* spec, long* list, long maxCount, long available)
+{
+    long count = 0;
+    const char* p = spec;
+
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+            p = end;
+        }
+        if (first < 0 || last < first || last >= available) {
+            return -1;
+        }
+        for (long ch = first; ch <= last; ch++) {
+            for (long i = 0; i < count; i++) {
+                if (list[i] == ch) {
+                    return -1;  // Duplicate channel
+                }
+            }
+            if (count >= maxCount) {
+                return -1;
+            }
+            list[count++] = ch;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+// Opens every channel the driver has, up to MAX_CHANNELS per direction
+static long allChannels(long* list, long available)
+{
+    long count = (available < MAX_CHANNELS) ? available : MAX_CHANNELS;
+    for (long i = 0; i < count; i++) {
+        list[i] = i;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Stimuli
+//------------------------------------------------------------------------------
+
+static Stimulus* findStimulus(const char* name)
+{
+    for (int i = 0; i < MAX_STIMULI; i++) {
+        if (stimuli[i].asio && strcmp(stimuli[i].name, name) == 0) {
+            return &stimuli[i];
+        }
+    }
+    return nullptr;
+}
+
+static void freeStimulus(Stimulus* stim)
+{
+    free(stim->samples);
+    free(stim->asio);
+    memset(stim, 0, sizeof(*stim));
+}
+
+// Takes ownership of 'samples' (malloc'd) and converts it to the output
+// format; a stimulus with the same name is replaced
+static bool addStimulus(const char* name, float* samples, long frames, char* reply, size_t replySize)
+{
+    Stimulus* stim = findStimulus(name);
+    if (stim) {
+        freeStimulus(stim);
+    } else {
+        for (int i = 0; i < MAX_STIMULI && !stim; i++) {
+            if (!stimuli[i].asio) {
+                stim = &stimuli[i];
+            }
+        }
+    }
+    if (!stim) {
+        snprintf(reply, replySize, "error stimulus table full (%d)", MAX_STIMULI);
+        free(samples);
+        return false;
+    }
+
+    void* asio = malloc(frames * outputSampleSize);
+    if (!asio) {
+        snprintf(reply, replySize, "error out of memory for %ld frames", frames);
+        free(samples);
+        return false;
+    }
+    ab_asio_from_float(samples, outputType, asio, frames);
+
+    strncpy(stim->name, name, sizeof(stim->name) - 1);
+    stim->samples = samples;
+    stim->asio = asio;
+    stim->frames = frames;
+    snprintf(reply, replySize, "ok %s %ld frames %.3f s", name, frames, frames / currentSampleRate);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//  Name:       generate_log_sweep
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Same sweep as ab_freq_response_asio: exponential chirp from f1 to f2,
+//    50 ms cosine fades, scaled to 'gain'
+//------------------------------------------------------------------------------
+static void generate_log_sweep(float *buffer, long length, double fs, double f1, double f2, double gain)
+{
+    double duration = static_cast<double>(length) / fs;
+    double L = duration / log(f2 / f1);
+
+    long fade_samples = static_cast<long>(0.05 * fs);
+    if (fade_samples > length / 4) fade_samples = length / 4;
+
+    for (long i = 0; i < length; i++) {
+        double t = static_cast<double>(i) / fs;
+        double sample = sin(2.0 * M_PI * f1 * L * (exp(t / L) - 1.0));
+
+        if (i < fade_samples) {
+            sample *= 0.5 * (1.0 - cos(M_PI * i / fade_samples));
+        }
+        if (i >= length - fade_samples) {
+            sample *= 0.5 * (1.0 + cos(M_PI * (i - (length - fade_samples)) / fade_samples));
+        }
+        buffer[i] = static_cast<float>(sample * gain);
+    }
+}
+
+static bool writeWav(const char* filename, const float* samples, long frames, long bits)
+{
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.samplerate = static_cast<int>(currentSampleRate);
+    info.channels = 1;
+    if (bits == 16) {
+        info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    } else if (bits == 24) {
+        info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+    } else {
+        info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    }
+
+    SNDFILE* file = sf_open(filename, SFM_WRITE, &info);
+    if (!file) {
+        return false;
+    }
+    sf_count_t written = sf_write_float(file, samples, frames);
+    sf_close(file);
+    return written == frames;
+}
+
+//------------------------------------------------------------------------------
+// Jobs
+//------------------------------------------------------------------------------
+
+static long findSlot(const long* channels, long count, long channel)
+{
+    for (long i = 0; i < count; i++) {
+        if (channels[i] == channel) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Missed buffers so far, from any thread while the stream runs
+static long totalXruns()
+{
+    return (long)liveXruns.load(std::memory_order_relaxed) + driverXruns.load();
+}
+
+// Hands the job to the callback and waits for it; gives up if the driver
+// stops calling back for a second past the job's length
+static bool runJob(Job* job)
+{
+    double limit = ab_cbstats_now() + job->length / currentSampleRate + 1.0;
+
+    job->position = 0;
+    jobDone = false;
+    activeJob.store(job, std::memory_order_release);
+
+    while (!jobDone.load(std::memory_order_acquire)) {
+        if (ab_cbstats_now() > limit) {
+            Job* expected = job;
+            if (activeJob.compare_exchange_strong(expected, nullptr)) {
+                // A callback may still be using the job: let it finish
+                Sleep((DWORD)(2000.0 * preferredBufferSize / currentSampleRate) + 10);
+                return false;
+            }
+        }
+        Sleep(1);
+    }
+    return true;
+}
+
+// Fills a reply with the capture's level, the figures a production test
+// usually checks first
+static void captureSummary(char* reply, size_t replySize, const char* filename,
+                           const float* capture, long frames, long xruns)
+{
+    double peak = 0.0;
+    double squares = 0.0;
+    for (long i = 0; i < frames; i++) {
+        double s = fabs(capture[i]);
+        if (s > peak) peak = s;
+        squares += s * s;
+    }
+    double rms = frames > 0 ? sqrt(squares / frames) : 0.0;
+    snprintf(reply, replySize, "ok %s frames=%ld peak=%.2f rms=%.2f xruns=%ld", filename, frames,
+             peak > 0.0 ? 20.0 * log10(peak) : -999.0, rms > 0.0 ? 20.0 * log10(rms) : -999.0, xruns);
+}
+
+// Shared by play, record and loopback; stim or filename may be nullptr
+static void measure(const Stimulus* stim, long outputChannel, long inputChannel, long captureFrames,
+                    const char* filename, char* reply, size_t replySize)
+{
+    Job job;
+    memset(&job, 0, sizeof(job));
+
+    if (stim) {
+        job.outputSlot = findSlot(outputChannels, numOpenOutputs, outputChannel);
+        if (job.outputSlot < 0) {
+            snprintf(reply, replySize, "error output channel %ld is not open", outputChannel);
+            return;
+        }
+        job.outputSlot += numOpenInputs;
+        job.stimulus = stim->asio;
+        job.stimulusFrames = stim->frames;
+    }
+
+    if (filename) {
+        job.inputSlot = findSlot(inputChannels, numOpenInputs, inputChannel);
+        if (job.inputSlot < 0) {
+            snprintf(reply, replySize, "error input channel %ld is not open", inputChannel);
+            return;
+        }
+        job.inputType = inputTypes[job.inputSlot];
+        if (!ab_asio_sample_type_supported(job.inputType)) {
+            snprintf(reply, replySize, "error input channel %ld sample type %ld is not supported",
+                     inputChannel, job.inputType);
+            return;
+        }
+        job.inputConvert = ab_asio_input_converter(job.inputType);
+        if (captureFrames <= 0) {
+            snprintf(reply, replySize, "error nothing to record");
+            return;
+        }
+        job.capture = static_cast<float*>(calloc(captureFrames, sizeof(float)));
+        if (!job.capture) {
+            snprintf(reply, replySize, "error out of memory for %ld frames", captureFrames);
+            return;
+        }
+        job.captureFrames = captureFrames;
+    }
+
+    job.length = (job.stimulusFrames > job.captureFrames) ? job.stimulusFrames : job.captureFrames;
+
+    long xruns = totalXruns();
+    if (!runJob(&job)) {
+        snprintf(reply, replySize, "error driver stopped calling back");
+        free(job.capture);
+        return;
+    }
+    xruns = totalXruns() - xruns;
+
+    if (!filename) {
+        snprintf(reply, replySize, "ok frames=%ld xruns=%ld", job.stimulusFrames, xruns);
+    } else if (!writeWav(filename, job.capture, job.captureFrames, outputBitDepth)) {
+        snprintf(reply, replySize, "error cannot write %s: %s", filename, sf_strerror(nullptr));
+    } else {
+        captureSummary(reply, replySize, filename, job.capture, job.captureFrames, xruns);
+    }
+    free(job.capture);
+}
+
+//------------------------------------------------------------------------------
+// Requests
+//------------------------------------------------------------------------------
+
+// Splits a request into words in place; double quotes group words
+static int splitArgs(char* line, char** args, int maxArgs)
+{
+    int count = 0;
+    char* p = line;
+
+    while (*p && count < maxArgs) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        if (*p == '"') {
+            args[count++] = ++p;
+            while (*p && *p != '"') p++;
+        } else {
+            args[count++] = p;
+            while (*p && *p != ' ' && *p != '\t') p++;
+        }
+        if (*p) *p++ = '\0';
+    }
+    return count;
+}
+
+static bool parseLong(const char* text, long* value)
+{
+    char* end;
+    *value = strtol(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+static bool parseDouble(const char* text, double* value)
+{
+    char* end;
+    *value = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+static void handleRequest(char* line, char* reply, size_t replySize)
+{
+    char* args[MAX_ARGS];
+    int argc = splitArgs(line, args, MAX_ARGS);
+
+    if (argc == 0) {
+        snprintf(reply, replySize, "error empty request");
+        return;
+    }
+
+    const char* cmd = args[0];
+    if (strcmp(cmd, "status") == 0) {
+        int loaded = 0;
+        for (int i = 0; i < MAX_STIMULI; i++) {
+            if (stimuli[i].asio) loaded++;
+        }
+        snprintf(reply, replySize, "ok driver=\"%s\" rate=%.0f buffer=%ld inputs=%ld outputs=%ld "
+                 "stimuli=%d callbacks=%llu xruns=%ld%s",
+                 driverInfo.name, currentSampleRate, preferredBufferSize, numOpenInputs, numOpenOutputs,
+                 loaded, liveCallbacks.load(std::memory_order_relaxed), totalXruns(),
+                 resetRequested ? " reset=requested" : "");
+        return;
+    }
+
+    if (strcmp(cmd, "shutdown") == 0) {
+        serverRunning = false;
+        snprintf(reply, replySize, "ok shutting down");
+        return;
+    }
+
+    if (resetRequested) {
+        snprintf(reply, replySize, "error driver requested a reset, restart the server");
+        return;
+    }
+
+    if (strcmp(cmd, "load") == 0 && argc == 3) {
+        SF_INFO info;
+        memset(&info, 0, sizeof(info));
+        SNDFILE* file = sf_open(args[2], SFM_READ, &info);
+        if (!file) {
+            snprintf(reply, replySize, "error cannot open %s: %s", args[2], sf_strerror(nullptr));
+            return;
+        }
+        if (info.channels != 1 || info.samplerate != static_cast<int>(currentSampleRate)) {
+            snprintf(reply, replySize, "error %s must be mono at %.0f Hz (has %d channels, %d Hz)",
+                     args[2], currentSampleRate, info.channels, info.samplerate);
+            sf_close(file);
+            return;
+        }
+        float* samples = static_cast<float*>(malloc(info.frames * sizeof(float)));
+        if (!samples) {
+            snprintf(reply, replySize, "error out of memory for %lld frames", (long long)info.frames);
+            sf_close(file);
+            return;
+        }
+        sf_count_t frames = sf_read_float(file, samples, info.frames);
+        sf_close(file);
+        addStimulus(args[1], samples, static_cast<long>(frames), reply, replySize);
+        return;
+    }
+
+    if (strcmp(cmd, "sweep") == 0 && argc >= 5 && argc <= 7) {
+        double f1, f2, seconds;
+        double level = -6.0;
+        if (!parseDouble(args[2], &f1) || !parseDouble(args[3], &f2) || !parseDouble(args[4], &seconds) ||
+            (argc >= 6 && !parseDouble(args[5], &level)) ||
+            f1 <= 0.0 || f2 <= f1 || f2 > currentSampleRate / 2.0 || seconds <= 0.0 || level > 0.0) {
+            snprintf(reply, replySize, "error usage: sweep NAME F1 F2 SECONDS [DBFS [FILE]], "
+                     "0 < F1 < F2 <= %.0f, DBFS <= 0", currentSampleRate / 2.0);
+            return;
+        }
+        long frames = static_cast<long>(seconds * currentSampleRate);
+        float* samples = static_cast<float*>(malloc(frames * sizeof(float)));
+        if (!samples) {
+            snprintf(reply, replySize, "error out of memory for %ld frames", frames);
+            return;
+        }
+        generate_log_sweep(samples, frames, currentSampleRate, f1, f2, pow(10.0, level / 20.0));
+        if (argc == 7 && !writeWav(args[6], samples, frames, 32)) {
+            snprintf(reply, replySize, "error cannot write %s: %s", args[6], sf_strerror(nullptr));
+            free(samples);
+            return;
+        }
+        addStimulus(args[1], samples, frames, reply, replySize);
+        return;
+    }
+
+    if (strcmp(cmd, "unload") == 0 && argc == 2) {
+        Stimulus* stim = findStimulus(args[1]);
+        if (!stim) {
+            snprintf(reply, replySize, "error no stimulus '%s'", args[1]);
+            return;
+        }
+        freeStimulus(stim);
+        snprintf(reply, replySize, "ok");
+        return;
+    }
+
+    if (strcmp(cmd, "play") == 0 && argc == 3) {
+        long outputChannel;
+        Stimulus* stim = findStimulus(args[1]);
+        if (!stim || !parseLong(args[2], &outputChannel)) {
+            snprintf(reply, replySize, "error usage: play NAME OUTCH (stimulus loaded first)");
+            return;
+        }
+        measure(stim, outputChannel, 0, 0, nullptr, reply, replySize);
+        return;
+    }
+
+    if (strcmp(cmd, "record") == 0 && argc == 4) {
+        long inputChannel;
+        double seconds;
+        if (!parseLong(args[1], &inputChannel) || !parseDouble(args[2], &seconds) || seconds <= 0.0) {
+            snprintf(reply, replySize, "error usage: record INCH SECONDS FILE");
+            return;
+        }
+        measure(nullptr, 0, inputChannel, static_cast<long>(seconds * currentSampleRate), args[3],
+                reply, replySize);
+        return;
+    }
+
+    if (strcmp(cmd, "loopback") == 0 && (argc == 5 || argc == 6)) {
+        long outputChannel, inputChannel;
+        double tail = 0.0;
+        Stimulus* stim = findStimulus(args[1]);
+        if (!stim || !parseLong(args[2], &outputChannel) || !parseLong(args[3], &inputChannel) ||
+            (argc == 6 && (!parseDouble(args[5], &tail) || tail < 0.0))) {
+            snprintf(reply, replySize, "error usage: loopback NAME OUTCH INCH FILE [TAIL_MS] (stimulus loaded first)");
+            return;
+        }
+        long tailFrames = static_cast<long>(tail * currentSampleRate / 1000.0);
+        measure(stim, outputChannel, inputChannel, stim->frames + tailFrames, args[4], reply, replySize);
+        return;
+    }
+
+    snprintf(reply, replySize, "error unknown request or wrong arguments: %s", cmd);
+}
+
+//------------------------------------------------------------------------------
+// Named pipe
+//------------------------------------------------------------------------------
+
+static bool writeLine(HANDLE pipe, const char* text)
+{
+    DWORD written;
+    DWORD length = (DWORD)strlen(text);
+    return WriteFile(pipe, text, length, &written, nullptr) && written == length &&
+           WriteFile(pipe, "\n", 1, &written, nullptr);
+}
+
+// Serves one client until it disconnects or asks for shutdown
+static void serveClient(HANDLE pipe)
+{
+    char line[LINE_SIZE];
+    char reply[LINE_SIZE];
+    size_t used = 0;
+
+    while (serverRunning) {
+        DWORD got = 0;
+        if (!ReadFile(pipe, line + used, (DWORD)(sizeof(line) - 1 - used), &got, nullptr) || got == 0) {
+            return;                                     // Client closed the pipe
+        }
+        used += got;
+        line[used] = '\0';
+
+        char* start = line;
+        char* end;
+        while ((end = strchr(start, '\n')) != nullptr) {
+            *end = '\0';
+            if (end > start && end[-1] == '\r') {
+                end[-1] = '\0';
+            }
+            handleRequest(start, reply, sizeof(reply));
+            printf("> %s\n< %s\n", start, reply);
+            fflush(stdout);
+            if (!writeLine(pipe, reply)) {
+                return;
+            }
+            start = end + 1;
+        }
+
+        used = strlen(start);
+        if (used == sizeof(line) - 1) {
+            writeLine(pipe, "error request too long");
+            used = 0;
+        } else {
+            memmove(line, start, used);
+        }
+    }
+}
+
+// Ctrl+C: stop accepting clients; connecting to our own pipe wakes the
+// ConnectNamedPipe() call the main thread is blocked in
+static BOOL WINAPI consoleHandler(DWORD event)
+{
+    if (event == CTRL_C_EVENT || event == CTRL_BREAK_EVENT) {
+        serverRunning = false;
+        HANDLE wake = CreateFileA(pipePath, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (wake != INVALID_HANDLE_VALUE) {
+            CloseHandle(wake);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void runServer()
+{
+    while (serverRunning) {
+        HANDLE pipe = CreateNamedPipeA(pipePath, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                                       1, LINE_SIZE, LINE_SIZE, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            fprintf(stderr, "Error: Cannot create pipe %s (error %lu)\n", pipePath, GetLastError());
+            return;
+        }
+
+        if (ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED) {
+            serveClient(pipe);
+        }
+        DisconnectNamedPipe(pipe);
+        CloseHandle(pipe);
+    }
+}
+
+// Client mode (-x): send one request and print the reply
+static int sendRequest(const char* request)
+{
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+
+    for (int attempt = 0; attempt < 50 && pipe == INVALID_HANDLE_VALUE; attempt++) {
+        pipe = CreateFileA(pipePath, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            if (GetLastError() != ERROR_PIPE_BUSY) {
+                fprintf(stderr, "Error: No server on %s\n", pipePath);
+                return 1;
+            }
+            WaitNamedPipeA(pipePath, 200);              // Another client is being served
+        }
+    }
+    if (pipe == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Error: Server on %s is busy\n", pipePath);
+        return 1;
+    }
+
+    char reply[LINE_SIZE];
+    size_t used = 0;
+    DWORD got = 0;
+
+    if (!writeLine(pipe, request)) {
+        fprintf(stderr, "Error: Cannot send request to %s\n", pipePath);
+        CloseHandle(pipe);
+        return 1;
+    }
+    while (used < sizeof(reply) - 1 && !memchr(reply, '\n', used) &&
+           ReadFile(pipe, reply + used, (DWORD)(sizeof(reply) - 1 - used), &got, nullptr) && got > 0) {
+        used += got;
+    }
+    CloseHandle(pipe);
+    reply[used] = '\0';
+
+    printf("%s", reply);
+    return strncmp(reply, "ok", 2) == 0 ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+//  Main application
+//
+//  This application:
+//  - Opens an ASIO driver once and keeps it running
+//  - Pre-converts stimuli (WAV files or generated sweeps) on request
+//  - Runs play / record / loopback jobs sent over a named pipe
+//  - Writes captures to WAV files and replies with their path and level
+//
+//  Libraries:
+//  - ASIO SDK: Audio playback and recording
+//  - libsndfile: WAV file I/O
+//  - libpopt: Command-line parsing
+//------------------------------------------------------------------------------
+int main(int argc, const char **argv)
+{
+    CoInitialize(nullptr);
+
+//------------------------------------------------------------------------------
+//  Command-line options
+//------------------------------------------------------------------------------
+    int version_flag = 0;
+    int list_flag = 0;
+    char* driverName = nullptr;
+    char* inputSpec = nullptr;
+    char* outputSpec = nullptr;
+    char* pipeName = nullptr;
+    char* request = nullptr;
+    double requestedSampleRate = 0.0;
+    long bitDepth = 32;
+    char* statsFilename = nullptr;
+
+    struct poptOption options[] = {
+        {"version", 'v', POPT_ARG_NONE, &version_flag, 0, "Show version information", nullptr},
+        {"list", 'l', POPT_ARG_NONE, &list_flag, 0, "List available ASIO drivers", nullptr},
+        {"driver", 'd', POPT_ARG_STRING, &driverName, 0, "ASIO driver name", "NAME"},
+        {"inputs", 'i', POPT_ARG_STRING, &inputSpec, 0, "Input channels to open, e.g. 0-3 (default: all, up to 32)", "LIST"},
+        {"outputs", 'o', POPT_ARG_STRING, &outputSpec, 0, "Output channels to open (default: all, up to 32)", "LIST"},
+        {"rate", 'r', POPT_ARG_DOUBLE, &requestedSampleRate, 0, "Sample rate (default: driver's current rate)", "HZ"},
+        {"bits", 'b', POPT_ARG_LONG, &bitDepth, 0, "Capture bit depth: 16, 24, or 32 (default: 32)", "BITS"},
+        {"pipe", 'P', POPT_ARG_STRING, &pipeName, 0, "Pipe name (default: " DEFAULT_PIPE ")", "NAME"},
+        {"send", 'x', POPT_ARG_STRING, &request, 0, "Send one request to a running server and print the reply", "REQUEST"},
+        {"stats", 'j', POPT_ARG_STRING, &statsFilename, 0, "Write callback timing and xrun statistics as JSON at shutdown", "FILE"},
+        POPT_AUTOHELP
+        POPT_TABLEEND
+    };
+
+    poptContext popt_ctx = poptGetContext(nullptr, argc, argv, options, 0);
+    poptSetOtherOptionHelp(popt_ctx,
+        "[OPTIONS]\n\n"
+        "ASIO Measurement Server for audio-bench.\n\n"
+        "Keeps an ASIO driver open and running and executes measurement jobs sent\n"
+        "over the named pipe \\\\.\\pipe\\NAME, one request per line:\n"
+        "  load NAME FILE                          sweep NAME F1 F2 SECONDS [DBFS [FILE]]\n"
+        "  play NAME OUTCH                         record INCH SECONDS FILE\n"
+        "  loopback NAME OUTCH INCH FILE [TAIL_MS] unload NAME\n"
+        "  status                                  shutdown\n\n"
+        "Examples:\n"
+        "  ab_asio_server -d \"Driver\" -r 48000                    # Start the server\n"
+        "  ab_asio_server -x \"sweep s1 20 20000 2 -6 sweep.wav\"   # Generate a stimulus\n"
+        "  ab_asio_server -x \"loopback s1 0 0 dut01.wav 50\"       # Measure; analyze with ab_freq_response\n"
+        "  ab_asio_server -x shutdown                             # Stop the server\n");
+
+    int rc = poptGetNextOpt(popt_ctx);
+    if (rc < -1) {
+        fprintf(stderr, "Error: %s: %s\n",
+                poptBadOption(popt_ctx, POPT_BADOPTION_NOALIAS),
+                poptStrerror(rc));
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    snprintf(pipePath, sizeof(pipePath), "\\\\.\\pipe\\%s", pipeName ? pipeName : DEFAULT_PIPE);
+
+//------------------------------------------------------------------------------
+//  Handle version, list and client modes
+//------------------------------------------------------------------------------
+    if (version_flag) {
+        printf("ab_asio_server version 1.0.0\n");
+        printf("ASIO Measurement Server for audio-bench\n");
+        printf("Copyright (c) 2025 Anthony Verbeck\n");
+        printf("Built: %s %s\n", __DATE__, __TIME__);
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 0;
+    }
+
+    if (list_flag) {
+        listASIODrivers();
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 0;
+    }
+
+    if (request) {
+        int status = sendRequest(request);
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return status;
+    }
+
+//------------------------------------------------------------------------------
+//  Validate required arguments
+//------------------------------------------------------------------------------
+    if (!driverName) {
+        fprintf(stderr, "Error: ASIO driver name is required (use --list to see available drivers)\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    if (bitDepth != 16 && bitDepth != 24 && bitDepth != 32) {
+        fprintf(stderr, "Error: Bit depth must be 16, 24, or 32 (got %ld)\n", bitDepth);
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+    outputBitDepth = bitDepth;
+
+    printf("ASIO Measurement Server\n");
+    printf("==========================================\n\n");
+
+//------------------------------------------------------------------------------
+//  Initialize ASIO and open the channels
+//------------------------------------------------------------------------------
+    if (!initASIO(driverName)) {
+        fprintf(stderr, "Failed to initialize ASIO driver\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    numOpenInputs = inputSpec ? parseChannelList(inputSpec, inputChannels, MAX_CHANNELS, numInputChannels)
+                              : allChannels(inputChannels, numInputChannels);
+    numOpenOutputs = outputSpec ? parseChannelList(outputSpec, outputChannels, MAX_CHANNELS, numOutputChannels)
+                                : allChannels(outputChannels, numOutputChannels);
+    poptFreeContext(popt_ctx);
+
+    if (numOpenInputs < 0 || numOpenOutputs < 0 || numOpenInputs + numOpenOutputs == 0) {
+        fprintf(stderr, "Error: Invalid channel list (the driver has %ld inputs, %ld outputs)\n",
+                numInputChannels, numOutputChannels);
+        shutdownASIO();
+        CoUninitialize();
+        return 1;
+    }
+
+    printf("\n");
+    if (!setupASIOBuffers(requestedSampleRate)) {
+        fprintf(stderr, "Failed to setup ASIO buffers\n");
+        shutdownASIO();
+        CoUninitialize();
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//  Start the driver; it runs until shutdown
+//------------------------------------------------------------------------------
+    ab_cbstats_init(&cbStats, currentSampleRate);
+    driverXruns = 0;
+
+    ASIOError err = ASIOStart();
+    if (err != ASE_OK) {
+        fprintf(stderr, "ASIOStart failed with error: %ld\n", err);
+        shutdownASIO();
+        CoUninitialize();
+        return 1;
+    }
+
+    SetConsoleCtrlHandler(consoleHandler, TRUE);
+    printf("\nListening on %s (Ctrl+C or \"shutdown\" to stop)\n\n", pipePath);
+    fflush(stdout);
+
+    runServer();
+
+//------------------------------------------------------------------------------
+//  Stop ASIO and clean up
+//------------------------------------------------------------------------------
+    printf("\nShutting down...\n");
+    ASIOStop();
+    ab_asio_write_timing(&cbStats, driverXruns.load(), "ab_asio_server", statsFilename);
+    shutdownASIO();
+
+    for (int i = 0; i < MAX_STIMULI; i++) {
+        if (stimuli[i].asio) {
+            freeStimulus(&stimuli[i]);
+        }
+    }
+
+    CoUninitialize();
+    return 0;
+}
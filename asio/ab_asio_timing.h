@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2025 Anthony Verbeck
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//------------------------------------------------------------------------------
+
+/*
+ * ab_asio_timing.h
+ * Callback timing for the ASIO tools
+ *
+ * Feeds libaudiobench's callback statistics (src/ab_cbstats.h) from an
+ * ASIO buffer switch: the driver's system time drives the jitter figures
+ * and gaps in its sample position count as missed buffers. Drivers that
+ * call the plain bufferSwitch() get both from ASIOGetSamplePosition().
+ */
+
+#ifndef AB_ASIO_TIMING_H
+#define AB_ASIO_TIMING_H
+
+#include <stdio.h>
+#include "asio.h"
+#include "ab_cbstats.h"
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_64
+//
+//  Returns:    an ASIOSamples / ASIOTimeStamp value as a double
+//
+//------------------------------------------------------------------------------
+#if NATIVE_INT64
+#define ab_asio_64(a)   ((double)(a))
+#else
+#define ab_asio_64(a)   ((double)(a).lo + (double)(a).hi * 4294967296.0)
+#endif
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_record_timing
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Call at the end of bufferSwitchTimeInfo(); 'start' is the
+//    ab_cbstats_now() reading taken on entry
+//  - timeInfo may be nullptr (plain bufferSwitch)
+//------------------------------------------------------------------------------
+static inline void ab_asio_record_timing(AbCbStats* stats, const ASIOTime* timeInfo, long frames, double start)
+{
+    double timestamp = -1.0;
+
+    if (timeInfo) {
+        if (timeInfo->timeInfo.flags & kSystemTimeValid) {
+            timestamp = ab_asio_64(timeInfo->timeInfo.systemTime) * 1e-9;
+        }
+        if (timeInfo->timeInfo.flags & kSamplePositionValid) {
+            ab_cbstats_position(stats, (int64_t)ab_asio_64(timeInfo->timeInfo.samplePosition), (size_t)frames);
+        }
+    } else {
+        ASIOSamples position;
+        ASIOTimeStamp systemTime;
+        if (ASIOGetSamplePosition(&position, &systemTime) == ASE_OK) {
+            timestamp = ab_asio_64(systemTime) * 1e-9;
+            ab_cbstats_position(stats, (int64_t)ab_asio_64(position), (size_t)frames);
+        }
+    }
+    ab_cbstats_record(stats, (size_t)frames, timestamp, start, ab_cbstats_now());
+}
+
+//------------------------------------------------------------------------------
+//  Name:       ab_asio_write_timing
+//
+//  Returns:    true on success, or when no file was requested
+//
+//------------------------------------------------------------------------------
+//  Detailed description:
+//  - Call after ASIOStop(); driverXruns are overload / resync messages
+//    counted by the tool's asioMessage() handler
+//------------------------------------------------------------------------------
+static inline bool ab_asio_write_timing(AbCbStats* stats, long driverXruns, const char* tool, const char* filename)
+{
+    ab_cbstats_xrun(stats, (uint64_t)driverXruns);
+    if (stats->xruns > 0) {
+        fprintf(stderr, "Warning: %llu missed buffers (xruns) during the run\n",
+                (unsigned long long)stats->xruns);
+    }
+    if (!filename) {
+        return true;
+    }
+    if (ab_cbstats_write_json(stats, tool, filename) != 0) {
+        fprintf(stderr, "Error: Failed to write callback statistics to '%s'\n", filename);
+        return false;
+    }
+    printf("Callback statistics: %llu callbacks, written to %s\n",
+           (unsigned long long)stats->callbacks, filename);
+    return true;
+}
+
+#endif
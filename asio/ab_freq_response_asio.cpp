@@ -36,13 +36,17 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cstring>
+#include <atomic>
 #include <sndfile.h>
 #include <fftw3.h>
 #include <popt.h>
+#include "ab_fft_plan.h"
 #include "asiosys.h"
 #include "asio.h"
 #include "iasiodrv.h"
 #include "asiodrivers.h"
+#include "ab_asio_convert.h"
+#include "ab_asio_timing.h"
 
 //------------------------------------------------------------------------------
 // Configuration parameters
@@ -52,6 +56,9 @@
 #define END_FREQ				20000.0
 #define SWEEP_LEVEL_DB			-12.0									//	Output level in dB (negative = below 0dBFS)
 #define LEAD_IN_DURATION		0.2										//	Silence before sweep (seconds) - prevents startup pop
+#define FARINA_TAIL_DURATION	1.0										//	Silence after sweep (seconds) - decay and loopback delay
+#define DEFAULT_HARMONICS		5										//	Harmonic responses separated (H2-H6)
+#define MAX_HARMONICS			9										//	H2-H10
 
 //------------------------------------------------------------------------------
 // Global ASIO state
@@ -79,6 +86,7 @@ static ASIOChannelInfo outputChannelInfo;
 // Cached sample sizes (calculated once during setup)
 //------------------------------------------------------------------------------
 static size_t outputSampleSize = 0;
+static AbAsioToFloatFn inputConverter = nullptr;    // See ab_asio_convert.h
 
 //------------------------------------------------------------------------------
 // Pre-allocated conversion buffers (for real-time callback)
@@ -96,15 +104,22 @@ static size_t sweepSignalASIOSize = 0;
 //------------------------------------------------------------------------------
 typedef struct {
     float *sweep_signal;											//	Generated sweep signal (float format, includes lead-in)
-    float *recorded_signal;											//	Recorded response
+    float *recorded_signal;											//	Recorded response (average of the repeats)
+    double *recorded_sum;											//	Running sum of the repeats, one sweep long
     int sweep_length;												//	Total length including lead-in (samples)
     int sweep_only_length;											//	Length of just the sweep portion (samples)
     int lead_in_samples;											//	Lead-in silence samples
-    int current_frame;												//	Current playback position
+    int repeats;													//	Sweeps played back to back
+    long long total_frames;											//	sweep_length * repeats
+    long long current_frame;										//	Current playback position (all repeats)
 } AudioData;
 
 static AudioData audioData;
 
+// Callback timing and missed buffers (see ab_asio_timing.h)
+static AbCbStats cbStats;
+static std::atomic<long> driverXruns(0);
+
 //------------------------------------------------------------------------------
 // Forward declarations
 //------------------------------------------------------------------------------
@@ -191,135 +206,6 @@ void generate_log_sweep(float *buffer, int length, float fs, float f1, float f2)
     }
 }
 
-//------------------------------------------------------------------------------
-//	Name:		convertASIOToFloat
-//
-//	Returns:	none
-//
-//------------------------------------------------------------------------------
-//	Detailed description:
-//	- Converts ASIO sample format to float
-//	- Handles various ASIO sample types
-//	- Normalizes to -1.0 to +1.0 range
-//------------------------------------------------------------------------------
-static void convertASIOToFloat(void* asioBuffer, float* floatBuffer, long numSamples, ASIOSampleType sampleType)
-{
-    switch (sampleType) {
-        case ASIOSTInt16LSB:
-        {
-            short* samples = static_cast<short*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = samples[i] / 32768.0f;
-            }
-            break;
-        }
-        case ASIOSTInt24LSB:
-        {
-            unsigned char* samples = static_cast<unsigned char*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                int s24 = (samples[i*3] << 8) | (samples[i*3+1] << 16) | (samples[i*3+2] << 24);
-                floatBuffer[i] = s24 / 2147483648.0f;
-            }
-            break;
-        }
-        case ASIOSTInt32LSB:
-        {
-            int* samples = static_cast<int*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = samples[i] / 2147483648.0f;
-            }
-            break;
-        }
-        case ASIOSTFloat32LSB:
-        {
-            float* samples = static_cast<float*>(asioBuffer);
-            memcpy(floatBuffer, samples, numSamples * sizeof(float));
-            break;
-        }
-        case ASIOSTFloat64LSB:
-        {
-            double* samples = static_cast<double*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                floatBuffer[i] = static_cast<float>(samples[i]);
-            }
-            break;
-        }
-        default:
-            memset(floatBuffer, 0, numSamples * sizeof(float));
-            break;
-    }
-}
-
-//------------------------------------------------------------------------------
-//	Name:		convertFloatToASIO
-//
-//	Returns:	none
-//
-//------------------------------------------------------------------------------
-//	Detailed description:
-//	- Converts float samples to ASIO sample format
-//	- Handles various ASIO sample types
-//	- Assumes input is normalized -1.0 to +1.0
-//------------------------------------------------------------------------------
-static void convertFloatToASIO(float* floatBuffer, void* asioBuffer, long numSamples, ASIOSampleType sampleType)
-{
-    switch (sampleType) {
-        case ASIOSTInt16LSB:
-        {
-            short* samples = static_cast<short*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<short>(sample * 32767.0f);
-            }
-            break;
-        }
-        case ASIOSTInt24LSB:
-        {
-            unsigned char* samples = static_cast<unsigned char*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                int s32 = static_cast<int>(sample * 8388607.0f);
-                samples[i*3] = (s32 >> 8) & 0xFF;
-                samples[i*3+1] = (s32 >> 16) & 0xFF;
-                samples[i*3+2] = (s32 >> 24) & 0xFF;
-            }
-            break;
-        }
-        case ASIOSTInt32LSB:
-        {
-            int* samples = static_cast<int*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                float sample = floatBuffer[i];
-                if (sample > 1.0f) sample = 1.0f;
-                if (sample < -1.0f) sample = -1.0f;
-                samples[i] = static_cast<int>(sample * 2147483647.0f);
-            }
-            break;
-        }
-        case ASIOSTFloat32LSB:
-        {
-            float* samples = static_cast<float*>(asioBuffer);
-            memcpy(samples, floatBuffer, numSamples * sizeof(float));
-            break;
-        }
-        case ASIOSTFloat64LSB:
-        {
-            double* samples = static_cast<double*>(asioBuffer);
-            for (long i = 0; i < numSamples; i++) {
-                samples[i] = static_cast<double>(floatBuffer[i]);
-            }
-            break;
-        }
-        default:
-            memset(asioBuffer, 0, numSamples * sizeof(float));
-            break;
-    }
-}
-
 //------------------------------------------------------------------------------
 // ASIO Callbacks
 //------------------------------------------------------------------------------
@@ -335,47 +221,60 @@ static ASIOTime* bufferSwitchTimeInfo(ASIOTime* timeInfo, long index, ASIOBool p
         return nullptr;
     }
 
+    double start = ab_cbstats_now();
+
     // Use pre-allocated buffers and cached values (no allocation or calculation in callback!)
     long bufferSize = preferredBufferSize;
     long samplesToProcess = bufferSize;
 
-    if (audioData.current_frame + samplesToProcess > audioData.sweep_length) {
-        samplesToProcess = audioData.sweep_length - audioData.current_frame;
+    if (audioData.current_frame + samplesToProcess > audioData.total_frames) {
+        samplesToProcess = static_cast<long>(audioData.total_frames - audioData.current_frame);
     }
 
-    // Prepare output buffer (direct copy from pre-converted ASIO format - no conversion!)
-    if (audioData.current_frame < audioData.sweep_length && samplesToProcess > 0) {
-        // Direct copy of pre-converted sweep signal to ASIO output buffer
-        size_t offsetBytes = audioData.current_frame * outputSampleSize;
-        memcpy(bufferInfos[1].buffers[index],
-               (char*)sweepSignalASIO + offsetBytes,
-               samplesToProcess * outputSampleSize);
-
-        // Zero out remaining samples if needed
-        if (samplesToProcess < bufferSize) {
-            size_t silenceOffset = samplesToProcess * outputSampleSize;
-            size_t silenceSize = (bufferSize - samplesToProcess) * outputSampleSize;
-            memset((char*)bufferInfos[1].buffers[index] + silenceOffset, 0, silenceSize);
-        }
-
-        audioData.current_frame += samplesToProcess;
-    } else {
+    if (samplesToProcess <= 0) {
         // Playback complete, output silence
         memset(bufferInfos[1].buffers[index], 0, bufferSize * outputSampleSize);
         measurementActive = false;
+        ab_asio_record_timing(&cbStats, timeInfo, preferredBufferSize, start);
+        return nullptr;
     }
 
-    // Convert input from ASIO format to float (done after output for better timing)
-    convertASIOToFloat(bufferInfos[0].buffers[index], tempInBuffer, bufferSize, inputChannelInfo.type);
+    // Convert input from ASIO format to float
+    inputConverter(bufferInfos[0].buffers[index], tempInBuffer, bufferSize);
+
+    // Repeats run back to back, so a buffer can straddle two sweeps: copy
+    // the pre-converted sweep out and add the input to the running sum in
+    // up to two pieces, wrapping at the sweep length
+    long done = 0;
+    while (done < samplesToProcess) {
+        long position = static_cast<long>((audioData.current_frame + done) % audioData.sweep_length);
+        long count = audioData.sweep_length - position;
+        if (count > samplesToProcess - done) {
+            count = samplesToProcess - done;
+        }
+
+        memcpy((char*)bufferInfos[1].buffers[index] + done * outputSampleSize,
+               (char*)sweepSignalASIO + position * outputSampleSize,
+               count * outputSampleSize);
 
-    // Copy recorded input to buffer (after output processing)
-    if (audioData.current_frame <= audioData.sweep_length && audioData.current_frame > 0) {
-        long copyFrame = audioData.current_frame - samplesToProcess;
-        if (copyFrame >= 0 && copyFrame + samplesToProcess <= audioData.sweep_length) {
-            memcpy(&audioData.recorded_signal[copyFrame], tempInBuffer, samplesToProcess * sizeof(float));
+        double* sum = audioData.recorded_sum + position;
+        const float* in = tempInBuffer + done;
+        for (long i = 0; i < count; i++) {
+            sum[i] += in[i];
         }
+        done += count;
+    }
+
+    // Zero out remaining samples if needed
+    if (samplesToProcess < bufferSize) {
+        size_t silenceOffset = samplesToProcess * outputSampleSize;
+        size_t silenceSize = (bufferSize - samplesToProcess) * outputSampleSize;
+        memset((char*)bufferInfos[1].buffers[index] + silenceOffset, 0, silenceSize);
     }
 
+    audioData.current_frame += samplesToProcess;
+
+    ab_asio_record_timing(&cbStats, timeInfo, preferredBufferSize, start);
     return nullptr;
 }
 
@@ -395,7 +294,8 @@ static long asioMessages(long selector, long value, void* message, double* opt)
                 value == kAsioLatenciesChanged ||
                 value == kAsioSupportsTimeInfo ||
                 value == kAsioSupportsTimeCode ||
-                value == kAsioSupportsInputMonitor)
+                value == kAsioSupportsInputMonitor ||
+                value == kAsioOverload)
                 return 1;
             break;
 
@@ -404,6 +304,9 @@ static long asioMessages(long selector, long value, void* message, double* opt)
             return 1;
 
         case kAsioResyncRequest:
+        case kAsioOverload:
+            // Lost sync or a late buffer: counted with the callback stats
+            driverXruns.fetch_add(1, std::memory_order_relaxed);
             return 1;
 
         case kAsioLatenciesChanged:
@@ -563,6 +466,11 @@ static bool setupASIOBuffers(long inputChannel, long outputChannel, long request
     if (err == ASE_OK) {
         printf("Input Channel %ld: %s, Type: %ld\n",
                inputChannel, inputChannelInfo.name, inputChannelInfo.type);
+        if (!ab_asio_sample_type_supported(inputChannelInfo.type)) {
+            printf("Error: Unsupported input sample type: %ld\n", inputChannelInfo.type);
+            return false;
+        }
+        inputConverter = ab_asio_input_converter(inputChannelInfo.type);
     } else {
         printf("Failed to get input channel info\n");
         return false;
@@ -634,15 +542,10 @@ static bool preconvertSweepSignal()
     }
 
     // Calculate and cache sample size for output format (used in callback)
-    switch (outputChannelInfo.type) {
-        case ASIOSTInt16LSB: outputSampleSize = 2; break;
-        case ASIOSTInt24LSB: outputSampleSize = 3; break;
-        case ASIOSTInt32LSB: outputSampleSize = 4; break;
-        case ASIOSTFloat32LSB: outputSampleSize = 4; break;
-        case ASIOSTFloat64LSB: outputSampleSize = 8; break;
-        default:
-            printf("Error: Unsupported output sample type: %ld\n", outputChannelInfo.type);
-            return false;
+    outputSampleSize = ab_asio_sample_size(outputChannelInfo.type);
+    if (outputSampleSize == 0) {
+        printf("Error: Unsupported output sample type: %ld\n", outputChannelInfo.type);
+        return false;
     }
 
     // Allocate buffer for pre-converted sweep
@@ -655,7 +558,7 @@ static bool preconvertSweepSignal()
     }
 
     // Convert entire sweep signal to ASIO format
-    convertFloatToASIO(audioData.sweep_signal, sweepSignalASIO, audioData.sweep_length, outputChannelInfo.type);
+    ab_asio_from_float(audioData.sweep_signal, outputChannelInfo.type, sweepSignalASIO, audioData.sweep_length);
 
     printf("Pre-converted sweep signal to ASIO format: %d samples, %zu bytes (sample size: %zu)\n",
            audioData.sweep_length, sweepSignalASIOSize, outputSampleSize);
@@ -700,9 +603,11 @@ static void listASIODrivers()
 //	- Compares recorded signal to sweep signal
 //	- Outputs magnitude and phase response to CSV file
 //	- Frequency range limited to START_FREQ to END_FREQ
+//	- One plan serves both signals (new-array execute on the recorded buffer)
 //------------------------------------------------------------------------------
 void calculate_frequency_response(float *input_signal, float *output_signal,
-                                  int length, double sample_rate, const char* output_filename)
+                                  int length, double sample_rate, const char* output_filename,
+                                  unsigned int planner_flags)
 {
     int fft_size = length;
 
@@ -715,10 +620,10 @@ void calculate_frequency_response(float *input_signal, float *output_signal,
     fftw_complex *out_recorded = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * (fft_size/2 + 1)));
 
 //------------------------------------------------------------------------------
-//	Create FFTW plans
+//	Create FFTW plan (before copying data: measured planning overwrites it)
 //------------------------------------------------------------------------------
-    fftw_plan plan_sweep = fftw_plan_dft_r2c_1d(fft_size, in_sweep, out_sweep, FFTW_ESTIMATE);
-    fftw_plan plan_recorded = fftw_plan_dft_r2c_1d(fft_size, in_recorded, out_recorded, FFTW_ESTIMATE);
+    fftw_plan plan = fftw_plan_dft_r2c_1d(fft_size, in_sweep, out_sweep, planner_flags);
+    ab_fft_wisdom_save(planner_flags);
 
 //------------------------------------------------------------------------------
 //	Copy input data
@@ -739,8 +644,8 @@ void calculate_frequency_response(float *input_signal, float *output_signal,
 //------------------------------------------------------------------------------
 //	Execute FFTs
 //------------------------------------------------------------------------------
-    fftw_execute(plan_sweep);
-    fftw_execute(plan_recorded);
+    fftw_execute(plan);
+    fftw_execute_dft_r2c(plan, in_recorded, out_recorded);
 
 //------------------------------------------------------------------------------
 //	Calculate frequency response and write to CSV file
@@ -796,14 +701,346 @@ void calculate_frequency_response(float *input_signal, float *output_signal,
 //------------------------------------------------------------------------------
 //	Cleanup
 //------------------------------------------------------------------------------
-    fftw_destroy_plan(plan_sweep);
-    fftw_destroy_plan(plan_recorded);
+    fftw_destroy_plan(plan);
     fftw_free(in_sweep);
     fftw_free(in_recorded);
     fftw_free(out_sweep);
     fftw_free(out_recorded);
 }
 
+//------------------------------------------------------------------------------
+//	Name:		generate_inverse_filter
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Farina inverse filter for the exponential sweep: the sweep reversed
+//	  in time with an exp(-t/L) envelope (-6 dB/octave), which undoes the
+//	  sweep's pink spectrum so that sweep * inverse is a band-limited pulse
+//	- L = T / ln(f2/f1), as in generate_log_sweep()
+//------------------------------------------------------------------------------
+static void generate_inverse_filter(const float *sweep, int length, double fs,
+                                    double f1, double f2, double *inverse)
+{
+    double L = (static_cast<double>(length) / fs) / log(f2 / f1);
+
+    for (int i = 0; i < length; i++) {
+        double t = static_cast<double>(i) / fs;
+        inverse[i] = static_cast<double>(sweep[length - 1 - i]) * exp(-t / L);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		band_power
+//
+//	Returns:	Mean |H|^2 of the bins within 1/24 octave centred on fc
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Falls back to the nearest bin when the band is narrower than a bin
+//	- Returns 0 when fc is above the last bin
+//------------------------------------------------------------------------------
+static double band_power(const double *power, int bins, double bin_hz, double fc)
+{
+    int lo = static_cast<int>(ceil(fc * pow(2.0, -1.0 / 48.0) / bin_hz));
+    int hi = static_cast<int>(floor(fc * pow(2.0, 1.0 / 48.0) / bin_hz));
+
+    if (lo >= bins) {
+        return 0.0;
+    }
+    if (hi >= bins) {
+        hi = bins - 1;
+    }
+    if (hi < lo) {
+        int nearest = static_cast<int>(fc / bin_hz + 0.5);
+        return (nearest < bins) ? power[nearest] : 0.0;
+    }
+
+    double sum = 0.0;
+    for (int k = lo; k <= hi; k++) {
+        sum += power[k];
+    }
+    return sum / (hi - lo + 1);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		calculate_farina_response
+//
+//	Returns:	true on success
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- One convolution of the recording with the inverse filter (FFT of a
+//	  2^a*3^b*5^c size) gives the linear impulse response at the sweep
+//	  length plus the loopback delay, and the k-th harmonic's impulse
+//	  response L*fs*ln(k) samples before it
+//	- Scaled so a straight wire gives 0 dB: the mean |X*F| of the sweep
+//	  and inverse over the sweep band is divided out
+//	- Each response is cut out with a short fade-in before its start and
+//	  a fade-out into the next one, then transformed at the same size
+//	- Frequency response CSV: linear response, in the same format as the
+//	  plain spectral division, phase relative to the response peak
+//	- THD CSV: at each 1/24-octave fundamental f, H(k) is the k-th
+//	  harmonic response at k*f over the linear response at f (dBc), and
+//	  THD sums the harmonics that fall within the sweep band
+//------------------------------------------------------------------------------
+static bool calculate_farina_response(const float *sweep, int sweep_length,
+                                      const float *recorded, int recorded_length,
+                                      double fs, int harmonics,
+                                      const char *fr_filename, const char *thd_filename,
+                                      const char *ir_filename, unsigned int planner_flags)
+{
+    int n = static_cast<int>(ab_fft_good_size(static_cast<size_t>(recorded_length + sweep_length - 1)));
+    int bins = n / 2 + 1;
+    double L = (static_cast<double>(sweep_length) / fs) / log(END_FREQ / START_FREQ);
+    bool ok = false;
+
+    double *a = static_cast<double*>(fftw_malloc(sizeof(double) * n));
+    fftw_complex *spectrum = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * bins));
+    fftw_complex *inverse = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * bins));
+
+    if (!a || !spectrum || !inverse) {
+        fprintf(stderr, "Failed to allocate deconvolution buffers\n");
+        fftw_free(a);
+        fftw_free(spectrum);
+        fftw_free(inverse);
+        return false;
+    }
+
+    printf("Deconvolving with inverse filter (FFT size %d)...\n", n);
+
+//------------------------------------------------------------------------------
+//	Plans first: measured planning overwrites the buffers
+//------------------------------------------------------------------------------
+    fftw_plan forward = fftw_plan_dft_r2c_1d(n, a, spectrum, planner_flags);
+    fftw_plan backward = fftw_plan_dft_c2r_1d(n, spectrum, a, planner_flags);
+    ab_fft_wisdom_save(planner_flags);
+
+//------------------------------------------------------------------------------
+//	Inverse filter spectrum F
+//------------------------------------------------------------------------------
+    memset(a, 0, sizeof(double) * n);
+    generate_inverse_filter(sweep, sweep_length, fs, START_FREQ, END_FREQ, a);
+    fftw_execute(forward);
+    memcpy(inverse, spectrum, sizeof(fftw_complex) * bins);
+
+//------------------------------------------------------------------------------
+//	Normalization: mean |X*F| over the sweep band
+//------------------------------------------------------------------------------
+    memset(a, 0, sizeof(double) * n);
+    for (int i = 0; i < sweep_length; i++) {
+        a[i] = static_cast<double>(sweep[i]);
+    }
+    fftw_execute(forward);
+
+    double bin_hz_full = fs / n;
+    int band_lo = static_cast<int>(2.0 * START_FREQ / bin_hz_full) + 1;
+    int band_hi = static_cast<int>(0.5 * END_FREQ / bin_hz_full);
+    double norm = 0.0;
+    for (int k = band_lo; k <= band_hi; k++) {
+        double re = spectrum[k][0] * inverse[k][0] - spectrum[k][1] * inverse[k][1];
+        double im = spectrum[k][0] * inverse[k][1] + spectrum[k][1] * inverse[k][0];
+        norm += sqrt(re * re + im * im);
+    }
+    norm /= (band_hi - band_lo + 1);
+
+//------------------------------------------------------------------------------
+//	Impulse responses: IFFT(Y * F) / (norm * n)
+//------------------------------------------------------------------------------
+    memset(a, 0, sizeof(double) * n);
+    for (int i = 0; i < recorded_length; i++) {
+        a[i] = static_cast<double>(recorded[i]);
+    }
+    fftw_execute(forward);
+
+    double scale = 1.0 / (norm * n);
+    for (int k = 0; k < bins; k++) {
+        double re = spectrum[k][0] * inverse[k][0] - spectrum[k][1] * inverse[k][1];
+        double im = spectrum[k][0] * inverse[k][1] + spectrum[k][1] * inverse[k][0];
+        spectrum[k][0] = re * scale;
+        spectrum[k][1] = im * scale;
+    }
+    fftw_execute(backward);
+
+//------------------------------------------------------------------------------
+//	Linear response peak: at or after the sweep length (loopback delay)
+//------------------------------------------------------------------------------
+    int peak = sweep_length - 1;
+    for (int i = sweep_length - 1; i < n; i++) {
+        if (fabs(a[i]) > fabs(a[peak])) {
+            peak = i;
+        }
+    }
+
+    int pre = static_cast<int>(0.001 * fs);								//	1 ms fade-in before each response
+    int gap2 = static_cast<int>(L * fs * log(2.0));						//	Linear to H2 spacing
+    int lin_length = (gap2 < n - (peak - pre)) ? gap2 : n - (peak - pre);
+    int m = static_cast<int>(ab_fft_good_size(static_cast<size_t>(lin_length)));
+    int m_bins = m / 2 + 1;
+    double bin_hz = fs / m;
+
+    printf("Linear impulse response at sample %d (loopback delay %d samples)\n",
+           peak, peak - (sweep_length - 1));
+
+//------------------------------------------------------------------------------
+//	Harmonics that fit before the linear response
+//------------------------------------------------------------------------------
+    int available = 0;
+    for (int h = 2; h <= harmonics + 1; h++) {
+        if (peak - static_cast<int>(L * fs * log(static_cast<double>(h))) - pre < 0) {
+            break;
+        }
+        available = h - 1;
+    }
+    if (available < harmonics) {
+        printf("Warning: only %d harmonic response(s) fit in the recording\n", available);
+    }
+
+//------------------------------------------------------------------------------
+//	Window each response and transform it: index 0 = linear, h-1 = H(h)
+//------------------------------------------------------------------------------
+    double *segment = static_cast<double*>(fftw_malloc(sizeof(double) * m));
+    fftw_complex *seg_spectrum = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * m_bins));
+    double *power = static_cast<double*>(malloc(sizeof(double) * m_bins * (available + 1)));
+    fftw_complex *linear = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * m_bins));
+    fftw_plan seg_plan = nullptr;
+
+    if (!segment || !seg_spectrum || !power || !linear) {
+        fprintf(stderr, "Failed to allocate harmonic analysis buffers\n");
+        goto cleanup;
+    }
+
+    seg_plan = fftw_plan_dft_r2c_1d(m, segment, seg_spectrum, planner_flags);
+    ab_fft_wisdom_save(planner_flags);
+
+    for (int r = 0; r <= available; r++) {
+        int start, length;
+        if (r == 0) {
+            start = peak - pre;
+            length = lin_length;
+        } else {
+            int offset = static_cast<int>(L * fs * log(static_cast<double>(r + 1)));
+            int next = static_cast<int>(L * fs * log(static_cast<double>(r)));
+            start = peak - offset - pre;
+            length = offset - next;
+        }
+
+        int fade_out = length / 8;
+        memset(segment, 0, sizeof(double) * m);
+        for (int i = 0; i < length; i++) {
+            double w = 1.0;
+            if (i < pre) {
+                w = 0.5 * (1.0 - cos(M_PI * i / pre));
+            } else if (i >= length - fade_out) {
+                w = 0.5 * (1.0 + cos(M_PI * (i - (length - fade_out)) / fade_out));
+            }
+            segment[i] = a[start + i] * w;
+        }
+
+        if (r == 0 && ir_filename) {
+            SF_INFO irinfo;
+            memset(&irinfo, 0, sizeof(irinfo));
+            irinfo.samplerate = static_cast<int>(fs);
+            irinfo.channels = 1;
+            irinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+            SNDFILE *irfile = sf_open(ir_filename, SFM_WRITE, &irinfo);
+            if (irfile) {
+                sf_write_double(irfile, segment, length);
+                sf_close(irfile);
+                printf("Linear impulse response (%d samples) saved to %s\n", length, ir_filename);
+            } else {
+                printf("Warning: Could not save impulse response to %s\n", ir_filename);
+            }
+        }
+
+        fftw_execute(seg_plan);
+        for (int k = 0; k < m_bins; k++) {
+            power[r * m_bins + k] = seg_spectrum[k][0] * seg_spectrum[k][0] + seg_spectrum[k][1] * seg_spectrum[k][1];
+        }
+        if (r == 0) {
+            memcpy(linear, seg_spectrum, sizeof(fftw_complex) * m_bins);
+        }
+    }
+
+//------------------------------------------------------------------------------
+//	Frequency response CSV (linear response only)
+//------------------------------------------------------------------------------
+    {
+        FILE *fp = fopen(fr_filename, "w");
+        if (!fp) {
+            fprintf(stderr, "Error: Could not create %s\n", fr_filename);
+            goto cleanup;
+        }
+        fprintf(fp, "Frequency (Hz),Magnitude (dB),Phase (degrees)\n");
+        for (int k = 1; k < m_bins; k++) {
+            double freq = k * bin_hz;
+            if (freq < START_FREQ || freq > END_FREQ) continue;
+
+            double magnitude = sqrt(power[k]);
+            double phase = atan2(linear[k][1], linear[k][0]) * 180.0 / M_PI
+                         + 360.0 * freq * pre / fs;					//	Undo the fade-in offset
+            phase = fmod(phase + 180.0, 360.0);
+            if (phase < 0.0) phase += 360.0;
+            fprintf(fp, "%.2f,%.2f,%.2f\n", freq, 20.0 * log10(magnitude + 1e-10), phase - 180.0);
+        }
+        fclose(fp);
+        printf("Frequency response saved to %s\n", fr_filename);
+    }
+
+//------------------------------------------------------------------------------
+//	THD vs frequency CSV
+//------------------------------------------------------------------------------
+    {
+        FILE *fp = fopen(thd_filename, "w");
+        if (!fp) {
+            fprintf(stderr, "Error: Could not create %s\n", thd_filename);
+            goto cleanup;
+        }
+        fprintf(fp, "Frequency (Hz),H1 (dB)");
+        for (int h = 2; h <= available + 1; h++) {
+            fprintf(fp, ",H%d (dBc)", h);
+        }
+        fprintf(fp, ",THD (%%)\n");
+
+        double top = (END_FREQ < fs / 2.0) ? END_FREQ : fs / 2.0;
+        for (double f = START_FREQ; f * 2.0 <= top; f *= pow(2.0, 1.0 / 24.0)) {
+            double p1 = band_power(power, m_bins, bin_hz, f);
+            if (p1 <= 0.0) continue;
+
+            double harmonic_sum = 0.0;
+            fprintf(fp, "%.2f,%.2f", f, 10.0 * log10(p1 + 1e-20));
+            for (int h = 2; h <= available + 1; h++) {
+                if (h * f > top) {
+                    fprintf(fp, ",");										//	Harmonic outside the sweep
+                    continue;
+                }
+                double ph = band_power(power + (h - 1) * m_bins, m_bins, bin_hz, h * f);
+                harmonic_sum += ph;
+                fprintf(fp, ",%.2f", 10.0 * log10(ph / p1 + 1e-20));
+            }
+            fprintf(fp, ",%.4f\n", 100.0 * sqrt(harmonic_sum / p1));
+        }
+        fclose(fp);
+        printf("THD vs frequency (H2-H%d) saved to %s\n", available + 1, thd_filename);
+    }
+
+    ok = true;
+
+cleanup:
+    if (seg_plan) fftw_destroy_plan(seg_plan);
+    fftw_destroy_plan(forward);
+    fftw_destroy_plan(backward);
+    fftw_free(a);
+    fftw_free(spectrum);
+    fftw_free(inverse);
+    fftw_free(segment);
+    fftw_free(seg_spectrum);
+    fftw_free(linear);
+    free(power);
+    return ok;
+}
+
 //------------------------------------------------------------------------------
 //	Main application
 //
@@ -811,7 +1048,8 @@ void calculate_frequency_response(float *input_signal, float *output_signal,
 //	- Generates logarithmic sine sweep
 //	- Plays sweep through ASIO audio output
 //	- Records ASIO audio input
-//	- Calculates frequency response
+//	- Calculates frequency response, by spectral division or (--farina)
+//	  from the impulse response, together with THD vs frequency
 //	- Saves results to CSV file
 //
 //	Libraries:
@@ -834,6 +1072,15 @@ int main(int argc, const char **argv)
     long outputChannel = 0;
     long requestedBufferSize = 0;
     double requestedSampleRate = 48000.0;
+    char* plannerName = nullptr;
+    char* wisdomPath = nullptr;
+    int farina_flag = 0;
+    int harmonics = DEFAULT_HARMONICS;
+    double sweepDuration = DESIRED_SWEEP_DURATION;
+    int repeats = 1;
+    char* thdFilename = nullptr;
+    char* irFilename = nullptr;
+    char* statsFilename = nullptr;
 
     struct poptOption options[] = {
         {"version", 'v', POPT_ARG_NONE, &version_flag, 0, "Show version information", nullptr},
@@ -844,6 +1091,15 @@ int main(int argc, const char **argv)
         {"output", 'o', POPT_ARG_LONG, &outputChannel, 0, "Output channel (default: 0)", "N"},
         {"buffer", 'b', POPT_ARG_LONG, &requestedBufferSize, 0, "ASIO buffer size in samples (default: driver preferred, larger = more stable)", "N"},
         {"rate", 'r', POPT_ARG_DOUBLE, &requestedSampleRate, 0, "Sample rate (default: 48000)", "HZ"},
+        {"planner", 'P', POPT_ARG_STRING, &plannerName, 0, "FFTW planner: estimate, measure, patient, exhaustive (default: estimate)", "MODE"},
+        {"wisdom", 'W', POPT_ARG_STRING, &wisdomPath, 0, "FFTW wisdom file (default: $AB_FFTW_WISDOM or ~/.ab_fftw_wisdom)", "FILE"},
+        {"duration", 't', POPT_ARG_DOUBLE, &sweepDuration, 0, "Sweep duration in seconds, rounded to a power of 2 length (default: 5)", "SEC"},
+        {"repeats", 'R', POPT_ARG_INT, &repeats, 0, "Play the sweep N times back to back and analyze the average (default: 1)", "N"},
+        {"farina", 'F', POPT_ARG_NONE, &farina_flag, 0, "Inverse-filter analysis: impulse response, harmonic separation, THD vs frequency", nullptr},
+        {"harmonics", 'n', POPT_ARG_INT, &harmonics, 0, "Harmonic responses to separate with --farina (default: 5, H2-H6)", "N"},
+        {"thd-file", 'T', POPT_ARG_STRING, &thdFilename, 0, "THD vs frequency CSV with --farina (default: thd_vs_frequency.csv)", "FILE"},
+        {"ir-file", 'I', POPT_ARG_STRING, &irFilename, 0, "Save the linear impulse response WAV with --farina", "FILE"},
+        {"stats", 'j', POPT_ARG_STRING, &statsFilename, 0, "Write callback timing and xrun statistics as JSON", "FILE"},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -860,7 +1116,10 @@ int main(int argc, const char **argv)
         "  ab_freq_response_asio -d \"Driver Name\"             # Run measurement\n"
         "  ab_freq_response_asio -d \"Driver\" -i 0 -o 0       # Specify channels\n"
         "  ab_freq_response_asio -d \"Driver\" -f output.csv   # Custom output file\n"
-        "  ab_freq_response_asio -d \"Driver\" -b 2048         # Larger buffer (more stable)\n");
+        "  ab_freq_response_asio -d \"Driver\" -b 2048         # Larger buffer (more stable)\n"
+        "  ab_freq_response_asio -d \"Driver\" -P measure      # Measured FFT plan (cached as wisdom)\n"
+        "  ab_freq_response_asio -d \"Driver\" -F -t 10        # 10 s sweep: response + THD vs frequency\n"
+        "  ab_freq_response_asio -d \"Driver\" -R 16           # Average 16 sweeps (12 dB less noise)\n");
 
     int rc = poptGetNextOpt(popt_ctx);
     if (rc < -1) {
@@ -905,14 +1164,59 @@ int main(int argc, const char **argv)
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Validate FFTW planner mode
+//------------------------------------------------------------------------------
+    unsigned int plannerFlags;
+    if (ab_fft_parse_planner(plannerName, &plannerFlags) != 0) {
+        fprintf(stderr, "Error: Unknown planner '%s' (use estimate, measure, patient or exhaustive)\n", plannerName);
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate sweep and Farina options
+//------------------------------------------------------------------------------
+    if (sweepDuration <= 0.0) {
+        fprintf(stderr, "Error: Sweep duration must be positive\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    if (repeats < 1) {
+        fprintf(stderr, "Error: Repeats must be at least 1\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    if (harmonics < 1 || harmonics > MAX_HARMONICS) {
+        fprintf(stderr, "Error: Harmonics must be 1-%d\n", MAX_HARMONICS);
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
+    if (!farina_flag && (thdFilename || irFilename)) {
+        fprintf(stderr, "Error: --thd-file and --ir-file require --farina\n");
+        poptFreeContext(popt_ctx);
+        CoUninitialize();
+        return 1;
+    }
+
     poptFreeContext(popt_ctx);
 
 //------------------------------------------------------------------------------
-//	Set default output filename if not specified
+//	Set default output filenames if not specified
 //------------------------------------------------------------------------------
     if (!outputFilename) {
         outputFilename = const_cast<char*>("frequency_response.csv");
     }
+    if (!thdFilename) {
+        thdFilename = const_cast<char*>("thd_vs_frequency.csv");
+    }
 
     printf("ASIO Frequency Response Measurement Tool\n");
     printf("==========================================\n\n");
@@ -920,19 +1224,33 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
 //	Calculate power-of-2 sweep length
 //------------------------------------------------------------------------------
-    audioData.sweep_only_length = calculate_power_of_2_length(DESIRED_SWEEP_DURATION, static_cast<int>(requestedSampleRate));
+    audioData.sweep_only_length = calculate_power_of_2_length(sweepDuration, static_cast<int>(requestedSampleRate));
     audioData.lead_in_samples = static_cast<int>(LEAD_IN_DURATION * requestedSampleRate);
     audioData.sweep_length = audioData.lead_in_samples + audioData.sweep_only_length;
 
+    // The inverse filter needs the response after the sweep ends: record a
+    // silent tail so the loopback delay and the decay are not cut off
+    int tail_samples = farina_flag ? static_cast<int>(FARINA_TAIL_DURATION * requestedSampleRate) : 0;
+    audioData.sweep_length += tail_samples;
+
     double actual_duration = static_cast<double>(audioData.sweep_only_length) / requestedSampleRate;
-    double total_duration = static_cast<double>(audioData.sweep_length) / requestedSampleRate;
+    audioData.repeats = repeats;
+    audioData.total_frames = static_cast<long long>(audioData.sweep_length) * repeats;
+    double total_duration = static_cast<double>(audioData.total_frames) / requestedSampleRate;
 
     audioData.current_frame = 0;
 
     printf("Lead-in: %.3f seconds (%d samples)\n", LEAD_IN_DURATION, audioData.lead_in_samples);
+    if (tail_samples > 0) {
+        printf("Tail: %.3f seconds (%d samples)\n", FARINA_TAIL_DURATION, tail_samples);
+    }
     printf("Sweep length: %d samples (power of 2: 2^%d)\n",
            audioData.sweep_only_length, static_cast<int>(log2(audioData.sweep_only_length)));
     printf("Sweep duration: %.3f seconds\n", actual_duration);
+    if (repeats > 1) {
+        printf("Repeats: %d back to back (averaging lowers uncorrelated noise by %.1f dB)\n",
+               repeats, 10.0 * log10(static_cast<double>(repeats)));
+    }
     printf("Total duration: %.3f seconds\n", total_duration);
     printf("FFT frequency resolution: %.3f Hz\n\n",
            requestedSampleRate / audioData.sweep_only_length);
@@ -942,9 +1260,13 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
     audioData.sweep_signal = static_cast<float*>(calloc(audioData.sweep_length, sizeof(float)));  // calloc zeros memory
     audioData.recorded_signal = static_cast<float*>(calloc(audioData.sweep_length, sizeof(float)));
+    audioData.recorded_sum = static_cast<double*>(calloc(audioData.sweep_length, sizeof(double)));
 
-    if (!audioData.sweep_signal || !audioData.recorded_signal) {
+    if (!audioData.sweep_signal || !audioData.recorded_signal || !audioData.recorded_sum) {
         fprintf(stderr, "Failed to allocate memory\n");
+        free(audioData.sweep_signal);
+        free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1027,6 +1349,7 @@ int main(int argc, const char **argv)
         fprintf(stderr, "Failed to initialize ASIO driver\n");
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1039,6 +1362,7 @@ int main(int argc, const char **argv)
         shutdownASIO();
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1048,6 +1372,7 @@ int main(int argc, const char **argv)
         shutdownASIO();
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1061,6 +1386,7 @@ int main(int argc, const char **argv)
         shutdownASIO();
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1073,6 +1399,7 @@ int main(int argc, const char **argv)
         shutdownASIO();
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1083,6 +1410,8 @@ int main(int argc, const char **argv)
     printf("\nStarting measurement...\n");
     printf("Make sure your audio interface input is connected to the output!\n\n");
 
+    ab_cbstats_init(&cbStats, currentSampleRate);
+    driverXruns = 0;
     measurementActive = true;
 
     ASIOError err = ASIOStart();
@@ -1091,6 +1420,7 @@ int main(int argc, const char **argv)
         shutdownASIO();
         free(audioData.sweep_signal);
         free(audioData.recorded_signal);
+        free(audioData.recorded_sum);
         CoUninitialize();
         return 1;
     }
@@ -1100,7 +1430,13 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
     while (measurementActive) {
         Sleep(100);
-        printf("\rProgress: %d / %d frames", audioData.current_frame, audioData.sweep_length);
+        if (audioData.repeats > 1) {
+            long long sweep = audioData.current_frame / audioData.sweep_length + 1;
+            printf("\rProgress: %lld / %lld frames (sweep %lld of %d)", audioData.current_frame, audioData.total_frames,
+                   sweep < audioData.repeats ? sweep : audioData.repeats, audioData.repeats);
+        } else {
+            printf("\rProgress: %lld / %lld frames", audioData.current_frame, audioData.total_frames);
+        }
         fflush(stdout);
     }
     printf("\n\n");
@@ -1108,22 +1444,55 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
 //	Stop ASIO
 //------------------------------------------------------------------------------
+    ASIOStop();
+    ab_asio_write_timing(&cbStats, driverXruns.load(), "ab_freq_response_asio", statsFilename);
     shutdownASIO();
 
-    printf("Recording complete. Analyzing...\n");
+//------------------------------------------------------------------------------
+//	Average the repeats (sample-aligned: one continuous stream, fixed period)
+//------------------------------------------------------------------------------
+    for (int i = 0; i < audioData.sweep_length; i++) {
+        audioData.recorded_signal[i] = static_cast<float>(audioData.recorded_sum[i] / audioData.repeats);
+    }
+    if (audioData.repeats > 1) {
+        printf("Averaged %d sweeps\n", audioData.repeats);
+        if (cbStats.xruns > 0) {
+            fprintf(stderr, "Warning: Missed buffers shift the sweeps that follow them; the average is smeared\n");
+        }
+    }
+
+    printf("Recording complete. Analyzing (FFT planner: %s)...\n", ab_fft_planner_name(plannerFlags));
+    ab_fft_wisdom_load(wisdomPath);
 
 //------------------------------------------------------------------------------
-//	Calculate frequency response (skip lead-in, analyze only sweep portion)
+//	Calculate frequency response (skip lead-in; Farina also uses the tail)
 //------------------------------------------------------------------------------
-    calculate_frequency_response(audioData.sweep_signal + audioData.lead_in_samples,
-                                 audioData.recorded_signal + audioData.lead_in_samples,
-                                 audioData.sweep_only_length, currentSampleRate, outputFilename);
+    bool analyzed = true;
+    if (farina_flag) {
+        analyzed = calculate_farina_response(audioData.sweep_signal + audioData.lead_in_samples,
+                                             audioData.sweep_only_length,
+                                             audioData.recorded_signal + audioData.lead_in_samples,
+                                             audioData.sweep_length - audioData.lead_in_samples,
+                                             currentSampleRate, harmonics, outputFilename,
+                                             thdFilename, irFilename, plannerFlags);
+    } else {
+        calculate_frequency_response(audioData.sweep_signal + audioData.lead_in_samples,
+                                     audioData.recorded_signal + audioData.lead_in_samples,
+                                     audioData.sweep_only_length, currentSampleRate, outputFilename,
+                                     plannerFlags);
+    }
 
 //------------------------------------------------------------------------------
 //	Cleanup
 //------------------------------------------------------------------------------
     free(audioData.sweep_signal);
     free(audioData.recorded_signal);
+    free(audioData.recorded_sum);
+
+    if (!analyzed) {
+        CoUninitialize();
+        return 1;
+    }
 
     printf("\nDone! Check %s for results.\n", outputFilename);
     printf("You can plot this data with gnuplot, Python, or Excel.\n");
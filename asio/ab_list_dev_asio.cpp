@@ -28,17 +28,30 @@
  *
  * Lists all ASIO devices and their status
  * Shows channel counts, version info for attached devices
+ *
+ * Each driver is probed in its own child process (this program run with
+ * --probe=N), all at once: a slow driver no longer holds up the others and
+ * one that hangs or crashes only takes its own process down. The result is
+ * cached (see ab_devcache.h) and reused while the installed drivers - name,
+ * CLSID, DLL path, size and time - and the Windows audio endpoints with their
+ * attached / unplugged state are unchanged.
  */
 
 #include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <popt.h>
 #include "asiosys.h"
 #include "asio.h"
 #include "iasiodrv.h"
 #include "asiodrivers.h"
+#include "ab_devcache.h"
+
+#define MAX_DRIVERS         32
+#define PROBE_TIMEOUT_MS    15000       // Child probes still running after this are killed
+#define CACHE_FILE          ".ab_list_dev_asio"
 
 //------------------------------------------------------------------------------
 // ASIO Device Probe
@@ -49,6 +62,7 @@ static ASIODriverInfo g_driverInfo;
 
 struct DeviceInfo {
     bool isAttached;
+    bool timedOut;                      // Child probe killed after PROBE_TIMEOUT_MS
     long numInputChannels;
     long numOutputChannels;
     char driverName[256];
@@ -62,6 +76,7 @@ static bool probeASIODevice(const char* driverName, DeviceInfo* info)
 
     // Initialize structure
     info->isAttached = false;
+    info->timedOut = false;
     info->numInputChannels = 0;
     info->numOutputChannels = 0;
     info->asioVersion = 0;
@@ -111,6 +126,218 @@ static bool probeASIODevice(const char* driverName, DeviceInfo* info)
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Driver identity (cache key)
+//------------------------------------------------------------------------------
+
+// Hashes what the registry says about each installed driver, plus the DLL's
+// size and time so a driver update invalidates the cache, and the MMDevices
+// endpoint states so plugging or unplugging an interface does too (ASIO
+// interfaces also expose Windows endpoints). Reading this does not load any
+// driver.
+static uint64_t driverInventoryKey(AsioDrivers& drivers, char** driverNames, long numDrivers)
+{
+    uint64_t key = ab_devcache_hash_endpoints(AB_DEVCACHE_HASH_INIT);
+
+    for (long i = 0; i < numDrivers; i++) {
+        char path[MAX_PATH] = "";
+        CLSID clsid;
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+        key = ab_devcache_hash_str(key, driverNames[i]);
+        memset(&clsid, 0, sizeof(clsid));
+        drivers.asioGetDriverCLSID((int)i, &clsid);
+        key = ab_devcache_hash(key, &clsid, sizeof(clsid));
+        drivers.asioGetDriverPath((int)i, path, sizeof(path));
+        key = ab_devcache_hash_str(key, path);
+        if (GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) {
+            key = ab_devcache_hash(key, &attributes.nFileSizeLow, sizeof(attributes.nFileSizeLow));
+            key = ab_devcache_hash(key, &attributes.ftLastWriteTime, sizeof(attributes.ftLastWriteTime));
+        }
+    }
+    return key;
+}
+
+//------------------------------------------------------------------------------
+// Parallel probing
+//------------------------------------------------------------------------------
+
+// Child side (--probe=N): one result line on stdout for the parent
+static int probeChild(const char* driverName)
+{
+    DeviceInfo info;
+    if (probeASIODevice(driverName, &info)) {
+        printf("probe 1 %ld %ld %ld %ld\n", info.numInputChannels, info.numOutputChannels,
+               info.asioVersion, info.driverVersion);
+    } else {
+        printf("probe 0\n");
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static void parseProbeResult(const char* text, DeviceInfo* info)
+{
+    int attached = 0;
+    if (sscanf(text, "probe %d %ld %ld %ld %ld", &attached, &info->numInputChannels,
+               &info->numOutputChannels, &info->asioVersion, &info->driverVersion) >= 1) {
+        info->isAttached = (attached != 0);
+    }
+}
+
+// Starts one child per driver with its stdout on a pipe, waits for all of
+// them (at most PROBE_TIMEOUT_MS), then reads each result. Drivers whose
+// child cannot be started are probed in this process instead.
+static void probeAllDevices(char** driverNames, long numDrivers, DeviceInfo* infos, bool serial)
+{
+    HANDLE processes[MAX_DRIVERS];
+    HANDLE pipes[MAX_DRIVERS];
+    DWORD running = 0;
+    long index[MAX_DRIVERS];
+    char exePath[MAX_PATH];
+
+    for (long i = 0; i < numDrivers; i++) {
+        memset(&infos[i], 0, sizeof(infos[i]));
+        strncpy(infos[i].driverName, driverNames[i], sizeof(infos[i].driverName) - 1);
+    }
+
+    if (serial || GetModuleFileNameA(nullptr, exePath, sizeof(exePath)) == 0) {
+        for (long i = 0; i < numDrivers; i++) {
+            probeASIODevice(driverNames[i], &infos[i]);
+        }
+        return;
+    }
+
+    for (long i = 0; i < numDrivers; i++) {
+        SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+        HANDLE readEnd = nullptr;
+        HANDLE writeEnd = nullptr;
+        bool started = false;
+
+        if (CreatePipe(&readEnd, &writeEnd, &sa, 0)) {
+            SetHandleInformation(readEnd, HANDLE_FLAG_INHERIT, 0);
+
+            STARTUPINFOA si;
+            PROCESS_INFORMATION pi;
+            char commandLine[MAX_PATH + 32];
+            memset(&si, 0, sizeof(si));
+            si.cb = sizeof(si);
+            si.dwFlags = STARTF_USESTDHANDLES;
+            si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+            si.hStdOutput = writeEnd;
+            si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+            snprintf(commandLine, sizeof(commandLine), "\"%s\" --probe=%ld", exePath, i);
+
+            if (CreateProcessA(nullptr, commandLine, nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+                               nullptr, nullptr, &si, &pi)) {
+                CloseHandle(pi.hThread);
+                processes[running] = pi.hProcess;
+                pipes[running] = readEnd;
+                index[running] = i;
+                running++;
+                started = true;
+            }
+            CloseHandle(writeEnd);              // The child holds its own copy
+            if (!started) {
+                CloseHandle(readEnd);
+            }
+        }
+        if (!started) {
+            probeASIODevice(driverNames[i], &infos[i]);
+        }
+    }
+
+    if (running == 0) {
+        return;
+    }
+    WaitForMultipleObjects(running, processes, TRUE, PROBE_TIMEOUT_MS);
+
+    for (DWORD p = 0; p < running; p++) {
+        DeviceInfo* info = &infos[index[p]];
+
+        if (WaitForSingleObject(processes[p], 0) != WAIT_OBJECT_0) {
+            TerminateProcess(processes[p], 1);
+            info->timedOut = true;
+        } else {
+            char result[256];
+            DWORD total = 0;
+            DWORD got = 0;
+            while (total < sizeof(result) - 1 &&
+                   ReadFile(pipes[p], result + total, (DWORD)(sizeof(result) - 1 - total), &got, nullptr) && got > 0) {
+                total += got;
+            }
+            result[total] = '\0';
+            parseProbeResult(result, info);
+        }
+        CloseHandle(pipes[p]);
+        CloseHandle(processes[p]);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Inventory cache
+//------------------------------------------------------------------------------
+
+// Records: one "drv" line per driver, in driver order:
+// attached, inputs, outputs, ASIO version, driver version, name
+static bool loadCachedDevices(const char* path, uint64_t key, char** driverNames, long numDrivers,
+                              DeviceInfo* infos, time_t* saved)
+{
+    char* records = ab_devcache_load(path, key, saved);
+    char* line = records;
+    long count = 0;
+
+    if (!records) {
+        return false;
+    }
+    while (line && *line && count < numDrivers) {
+        char* next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+
+        DeviceInfo* info = &infos[count];
+        int attached = 0;
+        memset(info, 0, sizeof(*info));
+        if (sscanf(line, "drv\t%d\t%ld\t%ld\t%ld\t%ld\t%255[^\n]", &attached,
+                   &info->numInputChannels, &info->numOutputChannels,
+                   &info->asioVersion, &info->driverVersion, info->driverName) == 6) {
+            info->isAttached = (attached != 0);
+            if (strcmp(info->driverName, driverNames[count]) != 0) {
+                break;
+            }
+            count++;
+        }
+        line = next;
+    }
+    free(records);
+    return count == numDrivers;
+}
+
+static void saveCachedDevices(const char* path, uint64_t key, long numDrivers, const DeviceInfo* infos)
+{
+    // A probe that timed out is worth retrying next time
+    for (long i = 0; i < numDrivers; i++) {
+        if (infos[i].timedOut) {
+            return;
+        }
+    }
+
+    FILE* file = ab_devcache_begin(path, key);
+    if (file) {
+        for (long i = 0; i < numDrivers; i++) {
+            fprintf(file, "drv\t%d\t%ld\t%ld\t%ld\t%ld\t", infos[i].isAttached ? 1 : 0,
+                    infos[i].numInputChannels, infos[i].numOutputChannels,
+                    infos[i].asioVersion, infos[i].driverVersion);
+            ab_devcache_write_text(file, infos[i].driverName);
+            fputc('\n', file);
+        }
+    }
+    if (!file || ab_devcache_commit(file, path) != 0) {
+        fprintf(stderr, "Warning: Could not write device cache '%s'\n", path);
+    }
+}
+
 //------------------------------------------------------------------------------
 // Main Program
 //------------------------------------------------------------------------------
@@ -121,10 +348,25 @@ int main(int argc, const char** argv)
 
     // Command-line options
     int versionFlag = 0;
+    int refreshFlag = 0;
+    int noCacheFlag = 0;
+    int serialFlag = 0;
+    char* cacheFile = nullptr;
+    long probeIndex = -1;
 
     struct poptOption options[] = {
         {"version", 'v', POPT_ARG_NONE, &versionFlag, 0,
          "Show version information", nullptr},
+        {"refresh", 'r', POPT_ARG_NONE, &refreshFlag, 0,
+         "Re-probe every driver and rewrite the device cache", nullptr},
+        {"no-cache", 'n', POPT_ARG_NONE, &noCacheFlag, 0,
+         "Probe every driver without reading or writing the cache", nullptr},
+        {"cache", 'C', POPT_ARG_STRING, &cacheFile, 0,
+         "Device cache file (default: %USERPROFILE%\\.ab_list_dev_asio)", "FILE"},
+        {"serial", 's', POPT_ARG_NONE, &serialFlag, 0,
+         "Probe drivers one at a time in this process instead of in parallel", nullptr},
+        {"probe", '\0', POPT_ARG_LONG | POPT_ARGFLAG_DOC_HIDDEN, &probeIndex, 0,
+         "Probe one driver and print the result (used internally)", "N"},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -135,7 +377,11 @@ int main(int argc, const char** argv)
         "ASIO Device Lister - Lists all ASIO devices and their status\n\n"
         "Examples:\n"
         "  ab_list_dev_asio           # List all ASIO devices\n"
-        "  ab_list_dev_asio --version # Show version information\n");
+        "  ab_list_dev_asio --refresh # Re-probe after connecting or disconnecting hardware\n"
+        "  ab_list_dev_asio --version # Show version information\n\n"
+        "The result is cached and reused while the installed drivers and the Windows\n"
+        "audio endpoints are unchanged. An interface with no Windows endpoint is not\n"
+        "seen coming and going: use --refresh after plugging it in or out.\n");
 
     int rc = poptGetNextOpt(popt_ctx);
     if (rc < -1) {
@@ -157,27 +403,39 @@ int main(int argc, const char** argv)
         return 0;
     }
 
-    poptFreeContext(popt_ctx);
+    char cachePath[1024];
+    bool haveCache = !noCacheFlag && ab_devcache_path(cacheFile, CACHE_FILE, cachePath, sizeof(cachePath));
 
-    printf("ASIO Device List\n");
-    printf("================================================================================\n\n");
+    poptFreeContext(popt_ctx);
 
     // Get list of ASIO drivers
-    char* driverNames[32];
-    char driverNameBuffer[32][256];
+    char* driverNames[MAX_DRIVERS];
+    char driverNameBuffer[MAX_DRIVERS][256];
 
-    for (int i = 0; i < 32; i++) {
+    for (int i = 0; i < MAX_DRIVERS; i++) {
         driverNames[i] = driverNameBuffer[i];
     }
 
-    // Create AsioDrivers object just to get names, then destroy it
-    // before probing devices to avoid having multiple instances
+    // Create AsioDrivers object just to get names (and the cache key), then
+    // destroy it before probing devices to avoid having multiple instances
     long numDrivers;
+    uint64_t cacheKey;
     {
         AsioDrivers asioDrivers;
-        numDrivers = asioDrivers.getDriverNames(driverNames, 32);
+        numDrivers = asioDrivers.getDriverNames(driverNames, MAX_DRIVERS);
+        cacheKey = driverInventoryKey(asioDrivers, driverNames, numDrivers);
     } // asioDrivers destroyed here
 
+    // Child process: probe one driver for the parent and exit
+    if (probeIndex >= 0) {
+        int status = (probeIndex < numDrivers) ? probeChild(driverNames[probeIndex]) : 1;
+        CoUninitialize();
+        return status;
+    }
+
+    printf("ASIO Device List\n");
+    printf("================================================================================\n\n");
+
     if (numDrivers == 0) {
         printf("No ASIO drivers found.\n");
         printf("\nNote: ASIO drivers must be installed separately.\n");
@@ -187,17 +445,30 @@ int main(int argc, const char** argv)
 
     printf("Found %ld ASIO driver(s):\n\n", numDrivers);
 
-    // Probe each driver
+    // Probe the drivers, unless the cache still describes them
+    DeviceInfo infos[MAX_DRIVERS];
+    time_t probedAt = 0;
+    bool cached = haveCache && !refreshFlag &&
+                  loadCachedDevices(cachePath, cacheKey, driverNames, numDrivers, infos, &probedAt);
+    if (!cached) {
+        probeAllDevices(driverNames, numDrivers, infos, serialFlag != 0);
+        if (haveCache) {
+            saveCachedDevices(cachePath, cacheKey, numDrivers, infos);
+        }
+    }
+
     for (long i = 0; i < numDrivers; i++) {
+        const DeviceInfo& info = infos[i];
         printf("Device %2ld: %s\n", i, driverNames[i]);
 
-        DeviceInfo info;
-        if (probeASIODevice(driverNames[i], &info)) {
+        if (info.isAttached) {
             printf("           Status: ATTACHED\n");
             printf("           Input channels:  %ld\n", info.numInputChannels);
             printf("           Output channels: %ld\n", info.numOutputChannels);
             printf("           ASIO version:    %ld\n", info.asioVersion);
             printf("           Driver version:  0x%08lx\n", info.driverVersion);
+        } else if (info.timedOut) {
+            printf("           Status: NOT RESPONDING (probe timed out)\n");
         } else {
             printf("           Status: NOT ATTACHED\n");
         }
@@ -206,6 +477,15 @@ int main(int argc, const char** argv)
 
     printf("================================================================================\n");
     printf("Total devices: %ld\n", numDrivers);
+    if (cached) {
+        char when[32] = "unknown time";
+        struct tm* local = localtime(&probedAt);
+        if (local) {
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", local);
+        }
+        printf("Device list from cache '%s', probed %s\n", cachePath, when);
+        printf("Attached state is as of that probe (--refresh to re-probe)\n");
+    }
 
     CoUninitialize();
     return 0;
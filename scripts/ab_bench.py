@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""
+Benchmark the audio-bench analysis tools on reproducible synthetic signals.
+
+Test signals (sine, log sweep, pink noise) are written by ab_gen_signal into
+the work directory and reused on later runs, since the generator output only
+depends on its options. Each tool is then timed on each file; every run is
+appended to a JSON-lines results file with wall time, throughput in samples/s
+and the child's peak RSS, so two results files can be compared after an
+upgrade (--baseline).
+
+Usage (normally through `make bench`):
+    scripts/ab_bench.py --bin bin --dir bench
+    scripts/ab_bench.py --durations 60 3600 --rates 48000 --formats 24
+    scripts/ab_bench.py --baseline bench/results_v1.jsonl --tolerance 10
+"""
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+
+SIGNALS = {
+    'sine':  ['--type=sine', '--freq=1000'],
+    'sweep': ['--type=sweep', '--f-start=20', '--f-end=20000'],
+    'pink':  ['--type=pink', '--seed=1'],
+}
+
+# (tool, case, signal, arguments, files read): in the arguments {f} is the input file,
+# {out} a scratch path in the output directory
+CASES = [
+    ('ab_wav_fft', 'single', 'pink', ['-q', '-i', '{f}', '-o', '{out}.csv'], 1),
+    ('ab_wav_fft', 'average=16', 'pink', ['-q', '-i', '{f}', '-o', '{out}.csv', '-a', '16'], 1),
+    ('ab_wav_fft', 'average=256', 'pink', ['-q', '-i', '{f}', '-o', '{out}.csv', '-a', '256'], 1),
+    ('ab_wav_fft', 'interval=100', 'pink', ['-q', '-i', '{f}', '-t', '100', '-B', '{out}.bin'], 1),
+    ('ab_wav_fft', 'interval=10,stream', 'pink', ['-q', '-i', '{f}', '-t', '10', '-S', '-B', '{out}.bin'], 1),
+    ('ab_thd_calc', 'fft,all-frames', 'sine', ['-f', '{f}', '-N', '0'], 1),
+    ('ab_thd_calc', 'goertzel', 'sine', ['-f', '{f}', '-g', '-o', '{out}.csv'], 1),
+    ('ab_freq_response', 'sweep', 'sweep', ['{f}', '{f}', '{out}.csv'], 2),
+    ('ab_check_levels', 'compare', 'sine', ['{f}', '{f}'], 2),
+]
+
+
+def git_commit():
+    """Short commit of the tree being benchmarked, '' outside a checkout."""
+    try:
+        result = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'],
+                                capture_output=True, text=True)
+        return result.stdout.strip() if result.returncode == 0 else ''
+    except OSError:
+        return ''
+
+
+def run_timed(cmd, log_path):
+    """
+    Run cmd with stdout discarded and stderr in log_path.
+
+    Returns (exit code, wall seconds, peak RSS in KiB or None when the
+    platform cannot report a child's resource usage). Linux carries the
+    high-water mark across exec, so the RSS never reads below this
+    script's own footprint (about 10 MiB); compare it between runs, not
+    against zero.
+    """
+    with open(log_path, 'w') as log:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=log)
+        if hasattr(os, 'wait4'):
+            _, status, usage = os.wait4(proc.pid, 0)
+            wall = time.perf_counter() - start
+            proc.returncode = os.waitstatus_to_exitcode(status)
+            rss = usage.ru_maxrss
+            if sys.platform == 'darwin':
+                rss //= 1024                                # bytes on macOS
+            return proc.returncode, wall, rss
+        proc.wait()
+        return proc.returncode, time.perf_counter() - start, None
+
+
+def signal_path(work_dir, signal, rate, fmt, duration):
+    return work_dir / f'{signal}_{rate}_{fmt}_{duration:g}s.wav'
+
+
+def generate_signals(bin_dir, work_dir, signals, rates, formats, durations):
+    """Create any missing test file; existing ones are reused."""
+    for duration in durations:
+        for rate in rates:
+            for fmt in formats:
+                for signal in signals:
+                    path = signal_path(work_dir, signal, rate, fmt, duration)
+                    if path.exists():
+                        continue
+                    print(f'Generating {path.name}...')
+                    cmd = [str(bin_dir / 'ab_gen_signal'), '-o', str(path), f'--rate={rate}',
+                           f'--bits={fmt}', f'--time={duration:g}'] + SIGNALS[signal]
+                    if subprocess.run(cmd).returncode != 0:
+                        if path.exists():
+                            path.unlink()
+                        print(f'Error: ab_gen_signal failed for {path.name}', file=sys.stderr)
+                        return False
+    return True
+
+
+def case_key(row):
+    return (row['tool'], row['case'], row['signal'], row['rate'], row['format'], row['duration_s'])
+
+
+def best_runs(rows):
+    """Fastest successful run per case."""
+    best = {}
+    for row in rows:
+        if row['exit_code'] != 0:
+            continue
+        key = case_key(row)
+        if key not in best or row['wall_s'] < best[key]['wall_s']:
+            best[key] = row
+    return best
+
+
+def compare_baseline(baseline_path, current, tolerance):
+    """Print cases slower than the baseline by more than tolerance %; returns their count."""
+    with open(baseline_path) as f:
+        baseline = best_runs(json.loads(line) for line in f if line.strip())
+
+    regressions = 0
+    print(f'\nComparison with {baseline_path} (tolerance {tolerance:g}%):')
+    for key, row in sorted(current.items()):
+        if key not in baseline:
+            continue
+        ratio = row['wall_s'] / baseline[key]['wall_s']
+        if ratio > 1.0 + tolerance / 100.0:
+            regressions += 1
+            print(f'  SLOWER  {row["tool"]} {row["case"]} {row["signal"]} {row["rate"]} {row["format"]} '
+                  f'{row["duration_s"]:g}s: {ratio:.2f}x ({baseline[key]["wall_s"]:.3f}s -> {row["wall_s"]:.3f}s)')
+    if regressions == 0:
+        print('  No regressions')
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Time the audio-bench analysis tools on synthetic signals'
+    )
+    parser.add_argument('--bin', default='bin', help='Directory with the built tools (default: bin/)')
+    parser.add_argument('--dir', default='bench', help='Work directory for signals and results (default: bench/)')
+    parser.add_argument('--rates', type=int, nargs='+', default=[48000, 96000, 192000],
+                        help='Sample rates (default: 48000 96000 192000)')
+    parser.add_argument('--formats', nargs='+', default=['16', '24', '32f'],
+                        help='Sample formats: 16, 24, 32, 32f (default: 16 24 32f)')
+    parser.add_argument('--durations', type=float, nargs='+', default=[60.0],
+                        help='File durations in seconds (default: 60)')
+    parser.add_argument('--tools', nargs='+', help='Only benchmark these tools')
+    parser.add_argument('--repeat', type=int, default=3, help='Runs per case (default: 3)')
+    parser.add_argument('--output', '-o', help='Results file, appended (default: DIR/results.jsonl)')
+    parser.add_argument('--baseline', help='Earlier results file to compare against')
+    parser.add_argument('--tolerance', type=float, default=10.0,
+                        help='Allowed slowdown against --baseline in percent (default: 10)')
+
+    args = parser.parse_args()
+
+    bin_dir = Path(args.bin)
+    work_dir = Path(args.dir)
+    out_dir = work_dir / 'out'
+    results_path = Path(args.output) if args.output else work_dir / 'results.jsonl'
+
+    cases = [c for c in CASES if not args.tools or c[0] in args.tools]
+    if not cases:
+        print('Error: No benchmark cases selected', file=sys.stderr)
+        sys.exit(1)
+    for tool in sorted({c[0] for c in cases} | {'ab_gen_signal'}):
+        if not (bin_dir / tool).exists() and not (bin_dir / (tool + '.exe')).exists():
+            print(f'Error: {bin_dir / tool} not found (run make all first)', file=sys.stderr)
+            sys.exit(1)
+
+    os.makedirs(out_dir, exist_ok=True)
+    if not generate_signals(bin_dir, work_dir, sorted({c[2] for c in cases}),
+                            args.rates, args.formats, args.durations):
+        sys.exit(1)
+
+    # Run every case; one JSON object per run
+    meta = {
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'commit': git_commit(),
+        'host': platform.node(),
+        'platform': platform.platform(),
+    }
+    rows = []
+    failures = 0
+
+    with open(results_path, 'a') as results:
+        for duration in args.durations:
+            for rate in args.rates:
+                for fmt in args.formats:
+                    for tool, case, signal, arg_template, files_read in cases:
+                        path = signal_path(work_dir, signal, rate, fmt, duration)
+                        stem = f'{tool}_{case.replace(",", "_").replace("=", "")}_{rate}_{fmt}_{duration:g}s'
+                        cmd = [str(bin_dir / tool)] + [a.format(f=path, out=out_dir / stem) for a in arg_template]
+                        samples = int(duration * rate + 0.5) * files_read
+
+                        for run in range(1, args.repeat + 1):
+                            code, wall, rss = run_timed(cmd, out_dir / (stem + '.log'))
+                            row = dict(meta, tool=tool, case=case, signal=signal, rate=rate, format=fmt,
+                                       duration_s=duration, samples=samples, run=run,
+                                       wall_s=round(wall, 6),
+                                       samples_per_s=round(samples / wall) if wall > 0 else None,
+                                       peak_rss_kb=rss, exit_code=code)
+                            results.write(json.dumps(row) + '\n')
+                            results.flush()
+                            rows.append(row)
+
+                            if code != 0:
+                                failures += 1
+                                print(f'Warning: {tool} {case} exited with {code}, see {stem}.log',
+                                      file=sys.stderr)
+                                break
+
+    # Summary: best run per case
+    current = best_runs(rows)
+    print(f'\n{"Tool":<18} {"Case":<20} {"Rate":>6} {"Fmt":>4} {"Dur(s)":>7} '
+          f'{"Best(s)":>9} {"MSamples/s":>11} {"RSS(MiB)":>9}')
+    for key, row in sorted(current.items()):
+        rss = f'{row["peak_rss_kb"] / 1024:.1f}' if row['peak_rss_kb'] is not None else '-'
+        print(f'{row["tool"]:<18} {row["case"]:<20} {row["rate"]:>6} {row["format"]:>4} '
+              f'{row["duration_s"]:>7g} {row["wall_s"]:>9.3f} {row["samples_per_s"] / 1e6:>11.2f} {rss:>9}')
+    print(f'\nResults appended to {results_path}')
+
+    regressions = compare_baseline(args.baseline, current, args.tolerance) if args.baseline else 0
+    if failures or regressions:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
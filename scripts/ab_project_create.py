@@ -77,7 +77,12 @@ This is an audio-bench project directory.
 This project was created for {config['description'].lower()}.
 
 Use audio-bench tools to populate the data directory, then run analysis scripts
-to generate reports in the reports directory.
+to generate reports in the reports directory:
+
+    python generate_report.py --input data --output reports
+
+Results are cached in reports/.ab_cache, so after re-recording a file only its
+analyses and graphs are redone.
 
 For more information, see the audio-bench documentation.
 """
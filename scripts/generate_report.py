@@ -4,79 +4,390 @@ Generate audio performance report from WAV file analysis.
 
 This script coordinates the execution of various audio analysis tools
 and generates a comprehensive report with graphs.
+
+Every analysis and every gnuplot render is a job whose result is cached
+under a key hashed from the job's tool (binary contents), its parameters
+and the contents of its input files. A report run only executes the jobs
+whose key is not in the cache yet, and runs them in parallel, so after
+re-recording one take of a device_report project only that take's
+analyses and graphs are redone.
+
+Cache layout (default: <output>/.ab_cache):
+    files.json          path -> (size, mtime, sha256), so unchanged inputs
+                        are not re-hashed on every run
+    <kk>/<key>/         one directory per job result: the files the tool
+                        wrote, plus stdout.txt for tools that report there
 """
 
 import argparse
+import hashlib
+import json
 import os
+import re
+import shutil
+import struct
 import sys
 import subprocess
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 
 
+CACHE_VERSION = 1
+HASH_BLOCK = 1 << 20
+
+# Tone recordings are recognised by a frequency in the file name
+# (1kHz_48k24b.wav, sweep_997Hz.wav) and also get a THD analysis
+TONE_PATTERN = re.compile(r'(\d+(?:\.\d+)?)\s*(k?)hz', re.IGNORECASE)
+
+
+def audio_bench_root():
+    """Installed tree ($AUDIO_BENCH) or the checkout this script lives in."""
+    if os.environ.get('AUDIO_BENCH'):
+        return Path(os.environ['AUDIO_BENCH'])
+    return Path(__file__).resolve().parent.parent
+
+
+def find_tool(bin_dir, name):
+    """Absolute path of an ab_* tool in bin_dir, else on PATH, else None (jobs run in their own cwd)."""
+    for candidate in (bin_dir / name, bin_dir / (name + '.exe')):
+        if candidate.exists():
+            return candidate.resolve()
+    found = shutil.which(name)
+    return Path(found).resolve() if found else None
+
+
 def check_dependencies():
     """Check if required tools are available."""
     required = ['gnuplot']
     missing = []
-    
+
     for tool in required:
-        if subprocess.run(['which', tool], capture_output=True).returncode != 0:
+        if shutil.which(tool) is None:
             missing.append(tool)
-    
+
     if missing:
         print(f"Error: Missing required tools: {', '.join(missing)}", file=sys.stderr)
         return False
     return True
 
 
-def run_analysis(input_file, output_dir):
-    """Run audio analysis on the input file."""
-    print(f"Analyzing {input_file}...")
-    
+def wav_format(path):
+    """
+    Sample rate and bits per sample from a WAV/RF64 fmt chunk.
+
+    Returns (rate, bits), or (None, None) if the header cannot be read.
+    """
+    try:
+        with open(path, 'rb') as f:
+            riff = f.read(12)
+            if len(riff) < 12 or riff[:4] not in (b'RIFF', b'RF64') or riff[8:12] != b'WAVE':
+                return None, None
+            while True:
+                header = f.read(8)
+                if len(header) < 8:
+                    return None, None
+                chunk_id, size = header[:4], struct.unpack('<I', header[4:])[0]
+                if chunk_id == b'fmt ':
+                    fmt = f.read(16)
+                    _, _, rate, _, _, bits = struct.unpack('<HHIIHH', fmt)
+                    return rate, bits
+                f.seek(size + (size & 1), os.SEEK_CUR)
+    except (OSError, struct.error):
+        return None, None
+
+
+class ResultCache:
+    """Content-hashed job results; safe to use from worker threads."""
+
+    def __init__(self, cache_dir, enabled=True):
+        self.dir = Path(cache_dir).resolve()
+        self.enabled = enabled
+        self.lock = threading.Lock()
+        self.index_path = self.dir / 'files.json'
+        self.file_hashes = {}
+        self.dirty = False
+        self.dir.mkdir(parents=True, exist_ok=True)
+        try:
+            with open(self.index_path) as f:
+                index = json.load(f)
+            if index.get('version') == CACHE_VERSION:
+                self.file_hashes = index.get('files', {})
+        except (OSError, ValueError):
+            pass
+
+    def file_hash(self, path):
+        """sha256 of a file, reusing the stored one while size and mtime match."""
+        path = Path(path).resolve()
+        st = path.stat()
+        stamp = [st.st_size, st.st_mtime_ns]
+        with self.lock:
+            entry = self.file_hashes.get(str(path))
+        if entry and entry[:2] == stamp:
+            return entry[2]
+
+        digest = hashlib.sha256()
+        with open(path, 'rb') as f:
+            for block in iter(lambda: f.read(HASH_BLOCK), b''):
+                digest.update(block)
+        value = digest.hexdigest()
+        with self.lock:
+            self.file_hashes[str(path)] = stamp + [value]
+            self.dirty = True
+        return value
+
+    def save(self):
+        if not self.dirty:
+            return
+        tmp = self.index_path.with_suffix('.tmp')
+        with open(tmp, 'w') as f:
+            json.dump({'version': CACHE_VERSION, 'files': self.file_hashes}, f)
+        os.replace(tmp, self.index_path)
+
+    def entry(self, key):
+        return self.dir / key[:2] / key
+
+
+class Job:
+    """
+    One tool run: cmd may refer to '{in0}', '{in1}'... (input files) and
+    '{out}' (the job's result directory); outputs are the file names it
+    leaves there, copied to the report as dest/<prefix><name>.
+    """
+
+    def __init__(self, name, tool, cmd, inputs, outputs, dest, prefix, stdout=None):
+        self.name = name
+        self.tool = tool
+        self.cmd = cmd
+        self.inputs = [Path(p) for p in inputs]
+        self.outputs = outputs
+        self.dest = Path(dest)
+        self.prefix = prefix
+        self.stdout = stdout                                # Output name for captured stdout
+        self.key = None
+
+    def compute_key(self, cache):
+        digest = hashlib.sha256()
+        digest.update(f'v{CACHE_VERSION}\0{self.tool.name}\0{cache.file_hash(self.tool)}\0'.encode())
+        digest.update('\0'.join(self.cmd).encode())
+        for path in self.inputs:
+            digest.update(b'\0' + cache.file_hash(path).encode())
+        self.key = digest.hexdigest()
+        return self.key
+
+    def result_paths(self):
+        return [self.dest / (self.prefix + name) for name in self.outputs]
+
+
+def run_job(job, cache):
+    """
+    Fetch the job's result from the cache or run it into a fresh entry.
+
+    Returns 'cached', 'ran' or 'failed'.
+    """
+    entry = cache.entry(job.key)
+    status = 'cached'
+
+    if not (cache.enabled and all((entry / name).exists() for name in job.outputs)):
+        tmp = entry.with_name(entry.name + f'.tmp{os.getpid()}_{threading.get_ident()}')
+        shutil.rmtree(tmp, ignore_errors=True)
+        tmp.mkdir(parents=True)
+
+        subst = {f'in{i}': str(p.resolve()) for i, p in enumerate(job.inputs)}
+        subst['out'] = str(tmp)
+        cmd = [str(job.tool)] + [arg.format(**subst) for arg in job.cmd]
+        result = subprocess.run(cmd, cwd=tmp, capture_output=True, text=True)
+
+        if job.stdout:
+            (tmp / job.stdout).write_text(result.stdout)
+        if result.returncode != 0 or not all((tmp / name).exists() for name in job.outputs):
+            print(f"  Error: {job.name} failed (exit {result.returncode})", file=sys.stderr)
+            if result.stderr.strip():
+                print('    ' + result.stderr.strip().replace('\n', '\n    '), file=sys.stderr)
+            shutil.rmtree(tmp, ignore_errors=True)
+            # An earlier run's result must not be reported as this one's
+            for dest in job.result_paths():
+                dest.unlink(missing_ok=True)
+            return 'failed'
+
+        shutil.rmtree(entry, ignore_errors=True)
+        os.replace(tmp, entry)
+        status = 'ran'
+
+    job.dest.mkdir(parents=True, exist_ok=True)
+    for name, dest in zip(job.outputs, job.result_paths()):
+        shutil.copyfile(entry / name, dest)
+    return status
+
+
+def run_jobs(jobs, cache, workers, label):
+    """Run independent jobs on a thread pool; returns the number that failed."""
+    if not jobs:
+        return 0
+
+    # Hashing large WAVs is I/O bound and hashlib drops the GIL, so the
+    # keys are computed on the pool as well
+    with ThreadPoolExecutor(max_workers=workers) as pool:
+        list(pool.map(lambda job: job.compute_key(cache), jobs))
+        statuses = list(pool.map(lambda job: run_job(job, cache), jobs))
+
+    ran = statuses.count('ran')
+    failed = statuses.count('failed')
+    print(f"  {label}: {len(jobs)} jobs, {ran} run, {statuses.count('cached')} cached"
+          + (f", {failed} failed" if failed else ''))
+    return failed
+
+
+class Recording:
+    """
+    One input WAV. name is its path relative to the input directory without
+    the extension (dutA/1kHz_L); prefix, derived from it, names the file's
+    results in data/ and graphs/ so takes in different subdirectories with
+    the same file name do not overwrite each other.
+    """
+
+    def __init__(self, path, root):
+        self.path = path
+        self.name = path.relative_to(root).with_suffix('').as_posix() if root else path.stem
+        self.prefix = self.name.replace('/', '__') + '_'
+
+
+def collect_inputs(input_path):
+    """
+    Recordings to analyze: the file itself, or every .wav under a directory.
+
+    Returns None (after printing an error) if two files map to the same
+    result prefix.
+    """
+    path = Path(input_path)
+    if path.is_dir():
+        recordings = [Recording(p, path) for p in sorted(path.rglob('*')) if p.suffix.lower() == '.wav']
+    else:
+        recordings = [Recording(path, None)]
+
+    seen = {}
+    for rec in recordings:
+        key = rec.prefix.lower()                            # Case-insensitive file systems
+        if key in seen:
+            print(f"Error: {seen[key].path} and {rec.path} would share the result name "
+                  f"'{rec.prefix}'; rename one of them", file=sys.stderr)
+            return None
+        seen[key] = rec
+    return recordings
+
+
+def analysis_jobs(recordings, bin_dir, data_dir):
+    """Per-file analyses; results go under data_dir named by the recording's prefix."""
+    tools = {name: find_tool(bin_dir, name) for name in ('ab_check_levels', 'ab_wav_fft', 'ab_thd_calc')}
+    jobs = []
+
+    for rec in recordings:
+        wav = rec.path
+        stem = rec.prefix
+        if tools['ab_check_levels']:
+            jobs.append(Job(f'{rec.name}: levels', tools['ab_check_levels'], ['{in0}'],
+                            [wav], ['levels.txt'], data_dir, stem, stdout='levels.txt'))
+        if tools['ab_wav_fft']:
+            jobs.append(Job(f'{rec.name}: spectrum', tools['ab_wav_fft'],
+                            ['-q', '-i', '{in0}', '-o', '{out}/fft.csv', '-a', '16'],
+                            [wav], ['fft.csv'], data_dir, stem))
+        tone = TONE_PATTERN.search(wav.stem)
+        if tools['ab_thd_calc'] and tone:
+            freq = float(tone.group(1)) * (1000.0 if tone.group(2) else 1.0)
+            jobs.append(Job(f'{rec.name}: THD', tools['ab_thd_calc'],
+                            ['-f', '{in0}', '-F', f'{freq:g}', '-N', '0'],
+                            [wav], ['thd.txt'], data_dir, stem, stdout='thd.txt'))
+
+    missing = [name for name, path in tools.items() if path is None]
+    if missing:
+        print(f"Warning: {', '.join(missing)} not found in {bin_dir} or on PATH; skipped", file=sys.stderr)
+    return jobs
+
+
+def run_analysis(recordings, output_dir, bin_dir, cache, workers):
+    """Run audio analysis on the input files."""
+    print(f"Analyzing {len(recordings)} file(s)...")
+
     # Create output directory
-    os.makedirs(output_dir, exist_ok=True)
-    
-    # Here you would call your C programs for analysis
-    # Example:
-    # subprocess.run(['./bin/audio-analyze', input_file, 
-    #                 '-o', os.path.join(output_dir, 'analysis.dat')])
-    
-    print(f"Analysis complete. Results in {output_dir}")
+    data_dir = Path(output_dir) / 'data'
+    data_dir.mkdir(parents=True, exist_ok=True)
+
+    failed = run_jobs(analysis_jobs(recordings, bin_dir, data_dir), cache, workers, 'Analysis')
 
+    print(f"Analysis complete. Results in {data_dir}")
+    return failed
 
-def generate_graphs(data_dir, output_dir):
+
+def generate_graphs(recordings, output_dir, cache, workers):
     """Generate graphs using gnuplot."""
     print("Generating graphs...")
-    
-    gnuplot_scripts = Path('gnuplot').glob('*.gp')
-    
-    for script in gnuplot_scripts:
-        print(f"  Processing {script.name}...")
-        # subprocess.run(['gnuplot', str(script)])
-    
+
+    gnuplot = shutil.which('gnuplot')
+    script_dir = audio_bench_root() / 'gnuplot'
+    data_dir = Path(output_dir) / 'data'
+    graph_dir = Path(output_dir) / 'graphs'
+    jobs = []
+
+    for rec in recordings:
+        wav = rec.path
+        fft_csv = data_dir / (rec.prefix + 'fft.csv')
+        graph = graph_dir / (rec.prefix + 'fft.png')
+        if not fft_csv.exists():
+            graph.unlink(missing_ok=True)                   # No spectrum this run, so no graph either
+            continue
+
+        # Spectrum template for the recording's rate and depth
+        rate, bits = wav_format(wav)
+        rate_name = '96k' if rate and rate > 48000 else '48k'
+        bits_name = '16b' if bits and bits <= 16 else '24b'
+        script = script_dir / f'fft_display_{rate_name}{bits_name}.gp'
+        if not script.exists():
+            print(f"  Warning: {script} not found; no graph for {wav.name}", file=sys.stderr)
+            continue
+
+        jobs.append(Job(f'{rec.name}: spectrum graph', Path(gnuplot),
+                        ['-c', '{in0}', '{in1}', '{out}/fft.png', f'Spectrum: {rec.name}',
+                         'Frequency (Hz)', 'Level (dBFS)'],
+                        [script, fft_csv], ['fft.png'], graph_dir, rec.prefix))
+
+    failed = run_jobs(jobs, cache, workers, 'Graphs')
+
     print("Graphs generated.")
+    return failed
 
 
-def create_report(output_dir):
+def create_report(recordings, output_dir):
     """Create final report document."""
     print("Creating final report...")
-    
-    report_path = os.path.join(output_dir, 'report.md')
+
+    output_dir = Path(output_dir)
+    report_path = output_dir / 'report.md'
     with open(report_path, 'w') as f:
         f.write("# Audio Performance Report\n\n")
         f.write("## Summary\n\n")
-        f.write("Analysis results and graphs will appear here.\n\n")
-    
+        f.write(f"{len(recordings)} recording(s) analyzed.\n\n")
+
+        for rec in recordings:
+            f.write(f"## {rec.name}{rec.path.suffix}\n\n")
+            for suffix, title in (('levels.txt', 'Levels'), ('thd.txt', 'Harmonic distortion')):
+                path = output_dir / 'data' / (rec.prefix + suffix)
+                if path.exists():
+                    f.write(f"### {title}\n\n```\n{path.read_text().strip()}\n```\n\n")
+            graph = output_dir / 'graphs' / (rec.prefix + 'fft.png')
+            if graph.exists():
+                f.write(f"![Spectrum of {rec.name}](graphs/{graph.name})\n\n")
+
     print(f"Report created: {report_path}")
 
 
 def main():
     parser = argparse.ArgumentParser(
-        description='Generate audio performance report from WAV file'
+        description='Generate audio performance report from WAV file(s)'
     )
     parser.add_argument(
         '--input', '-i',
         required=True,
-        help='Input WAV file to analyze'
+        help='Input WAV file, or a directory (e.g. a project\'s data/) of them'
     )
     parser.add_argument(
         '--output', '-o',
@@ -88,26 +399,62 @@ def main():
         action='store_true',
         help='Skip analysis step (use existing data)'
     )
-    
+    parser.add_argument(
+        '--jobs', '-j',
+        type=int,
+        default=os.cpu_count() or 1,
+        help='Analysis and render jobs to run in parallel (default: CPU count)'
+    )
+    parser.add_argument(
+        '--cache',
+        help='Result cache directory (default: OUTPUT/.ab_cache)'
+    )
+    parser.add_argument(
+        '--no-cache',
+        action='store_true',
+        help='Rerun every job (results are still stored for the next run)'
+    )
+    parser.add_argument(
+        '--bin',
+        help='Directory of the ab_* tools (default: $AUDIO_BENCH/bin or the checkout\'s bin/)'
+    )
+
     args = parser.parse_args()
-    
+
     # Check dependencies
     if not check_dependencies():
         sys.exit(1)
-    
-    # Verify input file exists
-    if not os.path.isfile(args.input):
-        print(f"Error: Input file not found: {args.input}", file=sys.stderr)
+
+    # Verify input exists
+    if not os.path.exists(args.input):
+        print(f"Error: Input not found: {args.input}", file=sys.stderr)
+        sys.exit(1)
+
+    recordings = collect_inputs(args.input)
+    if recordings is None:
+        sys.exit(1)
+    if not recordings:
+        print(f"Error: No WAV files found in {args.input}", file=sys.stderr)
         sys.exit(1)
-    
+
+    bin_dir = Path(args.bin) if args.bin else audio_bench_root() / 'bin'
+    cache = ResultCache(args.cache or Path(args.output) / '.ab_cache', enabled=not args.no_cache)
+    workers = max(1, args.jobs)
+    failed = 0
+
     # Run analysis pipeline
-    if not args.skip_analysis:
-        run_analysis(args.input, args.output)
-    
-    generate_graphs(args.output, args.output)
-    create_report(args.output)
-    
+    try:
+        if not args.skip_analysis:
+            failed += run_analysis(recordings, args.output, bin_dir, cache, workers)
+
+        failed += generate_graphs(recordings, args.output, cache, workers)
+    finally:
+        cache.save()
+    create_report(recordings, args.output)
+
     print(f"\nReport generation complete! Check {args.output}/")
+    if failed:
+        sys.exit(1)
 
 
 if __name__ == '__main__':
@@ -24,9 +24,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include <portaudio.h>
 #include <sndfile.h>
 #include <popt.h>
+#include "ab_ring.h"
+#include "ab_cbstats.h"
+#include "ab_monitor.h"
+#include "ab_window.h"
 
 //------------------------------------------------------------------------------
 // Default configuration values
@@ -36,6 +43,15 @@
 #define DEFAULT_CHANNELS		2
 #define DEFAULT_DURATION		5.0
 #define FRAMES_PER_BUFFER		512
+#define RING_SECONDS			4										//	Streaming ring capacity in seconds of audio
+#define WRITE_CHUNK_FRAMES		16384									//	Largest single sf_writef_float() call
+#define WRITER_POLL_MS			10										//	Writer thread sleep when the ring is empty
+#define STATUS_INTERVAL_SEC		60										//	Progress line interval in streaming mode
+#define MONITOR_INTERVAL		0.5										//	Default seconds between monitor updates
+#define MONITOR_FUNDAMENTAL		1000.0									//	Default THD fundamental, Hz
+#define MONITOR_FRAME_SIZE		8192									//	Tone frame for the THD+N estimate
+#define MONITOR_HARMONICS		10
+#define MONITOR_TRACK_HZ		50.0									//	Fundamental tracking range, +/- Hz
 
 //------------------------------------------------------------------------------
 // Recording state structure
@@ -46,8 +62,223 @@ typedef struct {
     size_t buffer_index;										//	Current write position
     int channels;												//	Number of channels
     int finished;												//	Recording finished flag
+    AbCbStats stats;											//	Callback timing (see ab_cbstats.h)
 } RecordingData;
 
+//------------------------------------------------------------------------------
+// Streaming recording state
+//------------------------------------------------------------------------------
+typedef struct {
+    AbRing *ring;												//	Callback -> writer thread (see ab_ring.h)
+    int channels;
+    size_t frames_target;										//	Frames to capture (0 = until interrupted)
+    size_t frames_captured;										//	Callback thread only
+    atomic_int finished;										//	No more samples will be produced
+    atomic_ulong input_overflows;								//	paInputOverflow callbacks (driver lost data)
+    atomic_ulong input_underflows;								//	paInputUnderflow callbacks
+    atomic_ulong dropped_frames;								//	Frames lost because the ring was full
+    atomic_size_t ring_peak;									//	Highest ring fill seen, in samples
+    AbCbStats stats;											//	Callback timing (see ab_cbstats.h)
+    SNDFILE *sndfile;
+    _Atomic uint64_t frames_written;							//	Stored by the writer thread, polled by main
+    atomic_int write_error;
+} StreamingData;
+
+//------------------------------------------------------------------------------
+// Monitor mode output
+//------------------------------------------------------------------------------
+typedef struct {
+    StreamingData *data;
+    int json;													//	JSON lines instead of console lines
+} MonitorOutput;
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+//------------------------------------------------------------------------------
+//	Name:		handle_interrupt
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void handle_interrupt(int sig)
+{
+    (void)sig;
+    g_interrupted = 1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		record_timing
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Adds one callback that started at 'start' to the timing block, using
+//	  PortAudio's stream time for the jitter (currentTime is 0 on host
+//	  APIs that do not provide it)
+//	- Input overflow / underflow flags count as xruns
+//------------------------------------------------------------------------------
+static void record_timing(AbCbStats *stats, unsigned long frames,
+                          const PaStreamCallbackTimeInfo *timeInfo,
+                          PaStreamCallbackFlags statusFlags, double start)
+{
+    double timestamp = (timeInfo && timeInfo->currentTime > 0.0) ? timeInfo->currentTime : -1.0;
+
+    if (statusFlags & (paInputOverflow | paInputUnderflow)) {
+        ab_cbstats_xrun(stats, 1);
+    }
+    ab_cbstats_record(stats, frames, timestamp, start, ab_cbstats_now());
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_timing
+//
+//	Returns:	0 on success (or no file requested), -1 on error
+//
+//------------------------------------------------------------------------------
+static int write_timing(const AbCbStats *stats, const char *stats_file)
+{
+    if (stats_file == NULL) {
+        return 0;
+    }
+    if (ab_cbstats_write_json(stats, "ab_acq", stats_file) != 0) {
+        fprintf(stderr, "Error: Failed to write callback statistics to '%s'\n", stats_file);
+        return -1;
+    }
+    printf("Callback statistics: %llu callbacks, %llu xruns, written to '%s'\n",
+           (unsigned long long)stats->callbacks, (unsigned long long)stats->xruns, stats_file);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		streamCallback
+//
+//	Returns:	PaStreamCallbackResult
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- PortAudio callback for streaming mode: pushes input into the ring
+//	- Counts driver overflow/underflow flags and frames dropped because the
+//	  disk thread fell behind; never waits, allocates or prints
+//	- Returns paComplete once frames_target frames have been captured
+//------------------------------------------------------------------------------
+static int streamCallback(const void *inputBuffer, void *outputBuffer,
+                          unsigned long framesPerBuffer,
+                          const PaStreamCallbackTimeInfo *timeInfo,
+                          PaStreamCallbackFlags statusFlags,
+                          void *userData)
+{
+    StreamingData *data = (StreamingData*)userData;
+    const float *input = (const float*)inputBuffer;
+    size_t frames = framesPerBuffer;
+    double start = ab_cbstats_now();
+    int result = paContinue;
+
+    (void) outputBuffer;												//	Prevent unused variable warning
+
+    if (statusFlags & paInputOverflow) {
+        atomic_fetch_add_explicit(&data->input_overflows, 1, memory_order_relaxed);
+    }
+    if (statusFlags & paInputUnderflow) {
+        atomic_fetch_add_explicit(&data->input_underflows, 1, memory_order_relaxed);
+    }
+    if (input == NULL) {
+        record_timing(&data->stats, framesPerBuffer, timeInfo, statusFlags, start);
+        return paContinue;
+    }
+
+//------------------------------------------------------------------------------
+//	Limit to the requested length
+//------------------------------------------------------------------------------
+    if (data->frames_target > 0 && frames > data->frames_target - data->frames_captured) {
+        frames = data->frames_target - data->frames_captured;
+    }
+
+//------------------------------------------------------------------------------
+//	Push into the ring; whatever does not fit is counted, not waited for
+//------------------------------------------------------------------------------
+    size_t samples = frames * data->channels;
+    size_t stored = ab_ring_write(data->ring, input, samples);
+    if (stored < samples) {
+        atomic_fetch_add_explicit(&data->dropped_frames, (samples - stored) / data->channels,
+                                  memory_order_relaxed);
+    }
+    data->frames_captured += frames;
+
+    size_t fill = ab_ring_fill(data->ring);
+    if (fill > atomic_load_explicit(&data->ring_peak, memory_order_relaxed)) {
+        atomic_store_explicit(&data->ring_peak, fill, memory_order_relaxed);
+    }
+
+    if (data->frames_target > 0 && data->frames_captured >= data->frames_target) {
+        atomic_store_explicit(&data->finished, 1, memory_order_release);
+        result = paComplete;
+    }
+    record_timing(&data->stats, framesPerBuffer, timeInfo, statusFlags, start);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		writer_thread
+//
+//	Returns:	NULL
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Drains the ring to libsndfile in chunks of up to WRITE_CHUNK_FRAMES,
+//	  straight from the ring's spans (both halves when it wraps)
+//	- Exits once the producer has finished and the ring is empty, or on a
+//	  write error (the main thread then stops the stream)
+//------------------------------------------------------------------------------
+static void *writer_thread(void *arg)
+{
+    StreamingData *data = (StreamingData*)arg;
+    size_t max_samples = (size_t)WRITE_CHUNK_FRAMES * data->channels;
+    uint64_t frames_written = 0;
+    int write_error = 0;
+
+    for (;;) {
+//------------------------------------------------------------------------------
+//	Read 'finished' before the ring so the final samples are never missed
+//------------------------------------------------------------------------------
+        int finished = atomic_load_explicit(&data->finished, memory_order_acquire);
+        AbRingSpans spans;
+
+        if (ab_ring_peek(data->ring, &spans) == 0) {
+            if (finished) {
+                break;
+            }
+            Pa_Sleep(WRITER_POLL_MS);
+            continue;
+        }
+
+        size_t budget = max_samples;
+        for (int s = 0; s < 2 && budget > 0 && !write_error; s++) {
+            size_t count = (spans.count[s] < budget) ? spans.count[s] : budget;
+            if (count == 0) {
+                continue;
+            }
+
+            sf_count_t frames = (sf_count_t)(count / data->channels);
+            sf_count_t written = sf_writef_float(data->sndfile, spans.data[s], frames);
+            ab_ring_consume(data->ring, count);
+            budget -= count;
+            if (written > 0) {
+                frames_written += (uint64_t)written;
+                atomic_store_explicit(&data->frames_written, frames_written, memory_order_release);
+            }
+            if (written != frames) {
+                write_error = 1;
+                atomic_store_explicit(&data->write_error, 1, memory_order_release);
+            }
+        }
+        if (write_error) {
+            break;
+        }
+    }
+    return NULL;
+}
+
 //------------------------------------------------------------------------------
 //	Name:		recordCallback
 //
@@ -69,13 +300,13 @@ static int recordCallback(const void *inputBuffer, void *outputBuffer,
     const float *input = (const float*)inputBuffer;
     size_t samples_to_copy = framesPerBuffer * data->channels;
     size_t remaining_space = data->buffer_size - data->buffer_index;
+    double start = ab_cbstats_now();
 
     (void) outputBuffer;												//	Prevent unused variable warning
-    (void) timeInfo;
-    (void) statusFlags;
 
     if (input == NULL) {
         fprintf(stderr, "Warning: Input buffer is NULL\n");
+        record_timing(&data->stats, framesPerBuffer, timeInfo, statusFlags, start);
         return paContinue;
     }
 
@@ -96,48 +327,57 @@ static int recordCallback(const void *inputBuffer, void *outputBuffer,
 //------------------------------------------------------------------------------
 //	Check if buffer is full
 //------------------------------------------------------------------------------
+    int result = paContinue;
     if (data->buffer_index >= data->buffer_size) {
         data->finished = 1;
-        return paComplete;
+        result = paComplete;
     }
 
-    return paContinue;
+    record_timing(&data->stats, framesPerBuffer, timeInfo, statusFlags, start);
+    return result;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		record_audio
+//	Name:		pcm_subtype
 //
-//	Returns:	0 on success, -1 on error
+//	Returns:	libsndfile PCM subtype for the bit depth, 0 if unsupported
+//
+//------------------------------------------------------------------------------
+static int pcm_subtype(int bit_depth)
+{
+    switch (bit_depth) {
+    case 16:
+        return SF_FORMAT_PCM_16;
+    case 24:
+        return SF_FORMAT_PCM_24;
+    case 32:
+        return SF_FORMAT_PCM_32;
+    default:
+        return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		open_input_device
+//
+//	Returns:	device info on success, NULL on error (PortAudio terminated)
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Records audio from specified device
-//	- Validates device capabilities
-//	- Allocates recording buffer
-//	- Opens and starts audio stream
-//	- Writes recorded data to WAV file
+//	- Initializes PortAudio and validates the device index
+//	- Limits *channels to the device's input channel count
 //------------------------------------------------------------------------------
-static int record_audio(int device_index, const char *output_file,
-                       int sample_rate, int bit_depth, int channels,
-                       double duration)
+static const PaDeviceInfo *open_input_device(int device_index, int *channels)
 {
     PaError err;
-    PaStream *stream;
-    PaStreamParameters input_params;
     const PaDeviceInfo *device_info;
-    RecordingData recording_data;
-    SNDFILE *sndfile;
-    SF_INFO sf_info;
     int num_devices;
 
-//------------------------------------------------------------------------------
-//	Validate device index
-//------------------------------------------------------------------------------
     err = Pa_Initialize();
     if (err != paNoError) {
         fprintf(stderr, "Error: Failed to initialize PortAudio: %s\n",
                 Pa_GetErrorText(err));
-        return -1;
+        return NULL;
     }
 
     num_devices = Pa_GetDeviceCount();
@@ -146,25 +386,61 @@ static int record_audio(int device_index, const char *output_file,
                 device_index, num_devices - 1);
         fprintf(stderr, "Use 'ab_list_dev' to see available devices.\n");
         Pa_Terminate();
-        return -1;
+        return NULL;
     }
 
     device_info = Pa_GetDeviceInfo(device_index);
     if (device_info->maxInputChannels == 0) {
         fprintf(stderr, "Error: Device %d has no input channels\n", device_index);
         Pa_Terminate();
-        return -1;
+        return NULL;
     }
 
 //------------------------------------------------------------------------------
 //	Limit channels to device capability
 //------------------------------------------------------------------------------
-    if (channels > device_info->maxInputChannels) {
+    if (*channels > device_info->maxInputChannels) {
         fprintf(stderr, "Warning: Requested %d channels, but device only supports %d. "
                 "Using %d channels.\n",
-                channels, device_info->maxInputChannels,
+                *channels, device_info->maxInputChannels,
                 device_info->maxInputChannels);
-        channels = device_info->maxInputChannels;
+        *channels = device_info->maxInputChannels;
+    }
+
+    return device_info;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		record_audio
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Records audio from specified device
+//	- Validates device capabilities
+//	- Allocates recording buffer
+//	- Opens and starts audio stream
+//	- Writes recorded data to WAV file
+//------------------------------------------------------------------------------
+static int record_audio(int device_index, const char *output_file,
+                       int sample_rate, int bit_depth, int channels,
+                       double duration, const char *stats_file)
+{
+    PaError err;
+    PaStream *stream;
+    PaStreamParameters input_params;
+    const PaDeviceInfo *device_info;
+    RecordingData recording_data;
+    SNDFILE *sndfile;
+    SF_INFO sf_info;
+
+//------------------------------------------------------------------------------
+//	Validate device index
+//------------------------------------------------------------------------------
+    device_info = open_input_device(device_index, &channels);
+    if (device_info == NULL) {
+        return -1;
     }
 
     printf("Recording from device %d: %s\n", device_index, device_info->name);
@@ -235,6 +511,7 @@ static int record_audio(int device_index, const char *output_file,
                 sample_rate, actual_sample_rate);
         printf("Actual recording rate: %d Hz\n", actual_sample_rate);
     }
+    ab_cbstats_init(&recording_data.stats, actual_sample_rate);
 
 //------------------------------------------------------------------------------
 //	Start recording
@@ -283,17 +560,8 @@ static int record_audio(int device_index, const char *output_file,
 //------------------------------------------------------------------------------
 //	Set format based on bit depth
 //------------------------------------------------------------------------------
-    switch (bit_depth) {
-    case 16:
-    	sf_info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
-        break;
-    case 24:
-        sf_info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
-        break;
-    case 32:
-        sf_info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_32;
-        break;
-    default:
+    sf_info.format = SF_FORMAT_WAV | pcm_subtype(bit_depth);
+    if (pcm_subtype(bit_depth) == 0) {
         fprintf(stderr, "Error: Unsupported bit depth %d (use 16, 24, or 32)\n",
                 bit_depth);
         free(recording_data.buffer);
@@ -322,7 +590,465 @@ static int record_audio(int device_index, const char *output_file,
     free(recording_data.buffer);
 
     printf("Saved %lld frames to '%s'\n", (long long)frames_written, output_file);
-    return 0;
+    return write_timing(&recording_data.stats, stats_file);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		record_audio_streaming
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Records for 'duration' seconds, or until Ctrl+C when duration is 0
+//	- The callback pushes into a lock-free ring sized for RING_SECONDS;
+//	  a writer thread drains it to disk while recording
+//	- Output is RF64 with header updates after every write, so a killed
+//	  process still leaves a readable file; libsndfile falls back to a
+//	  plain WAV header when the take stays under 4 GB
+//	- Reports driver overflows/underflows and frames dropped because the
+//	  disk could not keep up
+//------------------------------------------------------------------------------
+static int record_audio_streaming(int device_index, const char *output_file,
+                                  int sample_rate, int bit_depth, int channels,
+                                  double duration, const char *stats_file)
+{
+    PaError err;
+    PaStream *stream;
+    PaStreamParameters input_params;
+    const PaDeviceInfo *device_info;
+    StreamingData streaming_data;
+    SF_INFO sf_info;
+    pthread_t writer;
+    int result = 0;
+
+    if (pcm_subtype(bit_depth) == 0) {
+        fprintf(stderr, "Error: Unsupported bit depth %d (use 16, 24, or 32)\n",
+                bit_depth);
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate device index
+//------------------------------------------------------------------------------
+    device_info = open_input_device(device_index, &channels);
+    if (device_info == NULL) {
+        return -1;
+    }
+
+    printf("Recording from device %d: %s\n", device_index, device_info->name);
+    if (duration > 0) {
+        printf("Sample rate: %d Hz, Bit depth: %d, Channels: %d, Duration: %.1f seconds (streaming)\n",
+               sample_rate, bit_depth, channels, duration);
+    } else {
+        printf("Sample rate: %d Hz, Bit depth: %d, Channels: %d, Duration: until Ctrl+C (streaming)\n",
+               sample_rate, bit_depth, channels);
+    }
+
+//------------------------------------------------------------------------------
+//	Allocate ring buffer (power-of-two frame count)
+//------------------------------------------------------------------------------
+    size_t ring_frames = 1;
+    while (ring_frames < (size_t)(sample_rate * RING_SECONDS)) {
+        ring_frames <<= 1;
+    }
+
+    memset(&streaming_data, 0, sizeof(streaming_data));
+    streaming_data.ring = ab_ring_create(ring_frames, channels);
+    if (!streaming_data.ring) {
+        fprintf(stderr, "Error: Failed to allocate ring buffer\n");
+        Pa_Terminate();
+        return -1;
+    }
+    streaming_data.channels = channels;
+    atomic_init(&streaming_data.finished, 0);
+    atomic_init(&streaming_data.input_overflows, 0);
+    atomic_init(&streaming_data.input_underflows, 0);
+    atomic_init(&streaming_data.dropped_frames, 0);
+    atomic_init(&streaming_data.ring_peak, 0);
+    atomic_init(&streaming_data.frames_written, 0);
+    atomic_init(&streaming_data.write_error, 0);
+
+//------------------------------------------------------------------------------
+//	Configure input parameters
+//------------------------------------------------------------------------------
+    memset(&input_params, 0, sizeof(input_params));
+    input_params.device = device_index;
+    input_params.channelCount = channels;
+    input_params.sampleFormat = paFloat32;
+    input_params.suggestedLatency = device_info->defaultLowInputLatency;
+    input_params.hostApiSpecificStreamInfo = NULL;
+
+//------------------------------------------------------------------------------
+//	Open audio stream
+//------------------------------------------------------------------------------
+    err = Pa_OpenStream(&stream,
+                       &input_params,
+                       NULL,													//	No output
+                       sample_rate,
+                       FRAMES_PER_BUFFER,
+                       paClipOff,
+                       streamCallback,
+                       &streaming_data);
+
+    if (err != paNoError) {
+        fprintf(stderr, "Error: Failed to open stream: %s\n",
+                Pa_GetErrorText(err));
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Get actual stream sample rate (may differ from requested)
+//------------------------------------------------------------------------------
+    const PaStreamInfo *stream_info = Pa_GetStreamInfo(stream);
+    if (stream_info == NULL) {
+        fprintf(stderr, "Error: Failed to get stream info\n");
+        Pa_CloseStream(stream);
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+
+    int actual_sample_rate = (int)stream_info->sampleRate;
+    if (actual_sample_rate != sample_rate) {
+        fprintf(stderr, "Warning: Requested sample rate %d Hz, but device is using %d Hz\n",
+                sample_rate, actual_sample_rate);
+        printf("Actual recording rate: %d Hz\n", actual_sample_rate);
+    }
+    streaming_data.frames_target = (size_t)(actual_sample_rate * duration);
+    ab_cbstats_init(&streaming_data.stats, actual_sample_rate);
+
+//------------------------------------------------------------------------------
+//	Open the output file before recording starts
+//------------------------------------------------------------------------------
+    memset(&sf_info, 0, sizeof(sf_info));
+    sf_info.samplerate = actual_sample_rate;
+    sf_info.channels = channels;
+    sf_info.format = SF_FORMAT_RF64 | pcm_subtype(bit_depth);
+
+    streaming_data.sndfile = sf_open(output_file, SFM_WRITE, &sf_info);
+    if (streaming_data.sndfile == NULL) {
+        fprintf(stderr, "Error: Failed to open output file '%s': %s\n",
+                output_file, sf_strerror(NULL));
+        Pa_CloseStream(stream);
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+    sf_command(streaming_data.sndfile, SFC_RF64_AUTO_DOWNGRADE, NULL, SF_TRUE);
+    sf_command(streaming_data.sndfile, SFC_SET_UPDATE_HEADER_AUTO, NULL, SF_TRUE);
+
+//------------------------------------------------------------------------------
+//	Start writer thread, then recording
+//------------------------------------------------------------------------------
+    if (pthread_create(&writer, NULL, writer_thread, &streaming_data) != 0) {
+        fprintf(stderr, "Error: Failed to start writer thread\n");
+        sf_close(streaming_data.sndfile);
+        Pa_CloseStream(stream);
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+
+    signal(SIGINT, handle_interrupt);
+
+    err = Pa_StartStream(stream);
+    if (err != paNoError) {
+        fprintf(stderr, "Error: Failed to start stream: %s\n",
+                Pa_GetErrorText(err));
+        result = -1;
+    } else {
+        printf("Recording... (Ctrl+C to stop)\n");
+        fflush(stdout);
+
+//------------------------------------------------------------------------------
+//	Wait for recording to complete, printing progress periodically
+//------------------------------------------------------------------------------
+        int ticks = 0;
+        while (Pa_IsStreamActive(stream) == 1 && !g_interrupted &&
+               !atomic_load(&streaming_data.finished) &&
+               !atomic_load_explicit(&streaming_data.write_error, memory_order_acquire)) {
+            Pa_Sleep(100);
+            if (++ticks % (STATUS_INTERVAL_SEC * 10) == 0) {
+                uint64_t written = atomic_load_explicit(&streaming_data.frames_written, memory_order_acquire);
+                printf("  %d s: %lld frames written, %lu dropped, %lu overflows\n",
+                       ticks / 10, (long long)written,
+                       atomic_load(&streaming_data.dropped_frames),
+                       atomic_load(&streaming_data.input_overflows));
+                fflush(stdout);
+            }
+        }
+
+        err = Pa_StopStream(stream);
+        if (err != paNoError) {
+            fprintf(stderr, "Warning: Error stopping stream: %s\n",
+                    Pa_GetErrorText(err));
+        }
+    }
+    signal(SIGINT, SIG_DFL);
+
+//------------------------------------------------------------------------------
+//	Callback has stopped: let the writer drain the ring and exit
+//------------------------------------------------------------------------------
+    atomic_store_explicit(&streaming_data.finished, 1, memory_order_release);
+    pthread_join(writer, NULL);
+
+    Pa_CloseStream(stream);
+    Pa_Terminate();
+
+    if (atomic_load_explicit(&streaming_data.write_error, memory_order_acquire)) {
+        fprintf(stderr, "Error: Write to '%s' failed: %s\n",
+                output_file, sf_strerror(streaming_data.sndfile));
+        result = -1;
+    }
+    sf_close(streaming_data.sndfile);
+    size_t ring_capacity = ab_ring_capacity(streaming_data.ring);
+    ab_ring_destroy(streaming_data.ring);
+
+    printf("Done.\n");
+    printf("Saved %lld frames to '%s'\n", (long long)atomic_load_explicit(&streaming_data.frames_written, memory_order_acquire), output_file);
+    printf("Input overflows: %lu, Input underflows: %lu, Dropped frames: %lu\n",
+           atomic_load(&streaming_data.input_overflows),
+           atomic_load(&streaming_data.input_underflows),
+           atomic_load(&streaming_data.dropped_frames));
+    printf("Peak ring fill: %.1f%% of %.1f s\n",
+           100.0 * atomic_load(&streaming_data.ring_peak) / ring_capacity,
+           (double)ring_frames / actual_sample_rate);
+    if (write_timing(&streaming_data.stats, stats_file) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		monitor_update
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- AbMonitor update callback: prints the update to stdout
+//------------------------------------------------------------------------------
+static void monitor_update(const AbMonitor *mon, void *user)
+{
+    MonitorOutput *output = (MonitorOutput *)user;
+    uint64_t dropped = atomic_load_explicit(&output->data->dropped_frames, memory_order_relaxed);
+
+    if (output->json) {
+        ab_monitor_write_json(mon, stdout, dropped);
+    } else {
+        ab_monitor_print(mon, stdout, dropped);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		drain_monitor
+//
+//	Returns:	samples taken from the ring
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Feeds everything queued in the ring to the monitor, straight from
+//	  the ring's spans (both halves when it wraps)
+//------------------------------------------------------------------------------
+static size_t drain_monitor(StreamingData *data, AbMonitor *mon, MonitorOutput *output)
+{
+    AbRingSpans spans;
+    size_t total = ab_ring_peek(data->ring, &spans);
+
+    for (int s = 0; s < 2; s++) {
+        if (spans.count[s] > 0) {
+            ab_monitor_push(mon, spans.data[s], spans.count[s] / data->channels, monitor_update, output);
+        }
+    }
+    ab_ring_consume(data->ring, total);
+    return total;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		monitor_audio
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Live level and THD+N monitor: the streaming callback fills the ring,
+//	  this thread drains it into an AbMonitor (see ab_monitor.h) and
+//	  prints an update every interval seconds; nothing is written to disk
+//	- duration 0 runs until Ctrl+C
+//	- With json set, stdout only carries the JSON lines; everything else
+//	  goes to stderr
+//------------------------------------------------------------------------------
+static int monitor_audio(int device_index, int sample_rate, int channels, double duration,
+                         double interval, double fundamental, int json, const char *stats_file)
+{
+    PaError err;
+    PaStream *stream;
+    PaStreamParameters input_params;
+    const PaDeviceInfo *device_info;
+    StreamingData streaming_data;
+    MonitorOutput output;
+    AbMonitor monitor;
+    FILE *info = json ? stderr : stdout;
+    int result = 0;
+
+//------------------------------------------------------------------------------
+//	Validate device index
+//------------------------------------------------------------------------------
+    device_info = open_input_device(device_index, &channels);
+    if (device_info == NULL) {
+        return -1;
+    }
+
+    fprintf(info, "Monitoring device %d: %s\n", device_index, device_info->name);
+
+//------------------------------------------------------------------------------
+//	Allocate ring buffer (power-of-two frame count)
+//------------------------------------------------------------------------------
+    size_t ring_frames = 1;
+    while (ring_frames < (size_t)(sample_rate * RING_SECONDS)) {
+        ring_frames <<= 1;
+    }
+
+    memset(&streaming_data, 0, sizeof(streaming_data));
+    streaming_data.ring = ab_ring_create(ring_frames, channels);
+    if (!streaming_data.ring) {
+        fprintf(stderr, "Error: Failed to allocate ring buffer\n");
+        Pa_Terminate();
+        return -1;
+    }
+    streaming_data.channels = channels;
+    atomic_init(&streaming_data.finished, 0);
+    atomic_init(&streaming_data.input_overflows, 0);
+    atomic_init(&streaming_data.input_underflows, 0);
+    atomic_init(&streaming_data.dropped_frames, 0);
+    atomic_init(&streaming_data.ring_peak, 0);
+    atomic_init(&streaming_data.frames_written, 0);
+    atomic_init(&streaming_data.write_error, 0);
+
+//------------------------------------------------------------------------------
+//	Configure input parameters and open the stream
+//------------------------------------------------------------------------------
+    memset(&input_params, 0, sizeof(input_params));
+    input_params.device = device_index;
+    input_params.channelCount = channels;
+    input_params.sampleFormat = paFloat32;
+    input_params.suggestedLatency = device_info->defaultLowInputLatency;
+    input_params.hostApiSpecificStreamInfo = NULL;
+
+    err = Pa_OpenStream(&stream,
+                       &input_params,
+                       NULL,													//	No output
+                       sample_rate,
+                       FRAMES_PER_BUFFER,
+                       paClipOff,
+                       streamCallback,
+                       &streaming_data);
+
+    if (err != paNoError) {
+        fprintf(stderr, "Error: Failed to open stream: %s\n",
+                Pa_GetErrorText(err));
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Size the monitor for the rate the device actually runs at
+//------------------------------------------------------------------------------
+    const PaStreamInfo *stream_info = Pa_GetStreamInfo(stream);
+    int actual_sample_rate = stream_info ? (int)stream_info->sampleRate : sample_rate;
+    if (actual_sample_rate != sample_rate) {
+        fprintf(stderr, "Warning: Requested sample rate %d Hz, but device is using %d Hz\n",
+                sample_rate, actual_sample_rate);
+    }
+    if (fundamental >= actual_sample_rate / 2.0) {
+        fprintf(stderr, "Error: Fundamental %.1f Hz is not below Nyquist (%.1f Hz)\n",
+                fundamental, actual_sample_rate / 2.0);
+        Pa_CloseStream(stream);
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+    streaming_data.frames_target = (size_t)(actual_sample_rate * duration);
+    ab_cbstats_init(&streaming_data.stats, actual_sample_rate);
+
+    const AbWindow *window = ab_window_get(AB_WINDOW_HANN, MONITOR_FRAME_SIZE, 0.0);
+    if (window == NULL ||
+        ab_monitor_init(&monitor, actual_sample_rate, channels, interval, fundamental,
+                        MONITOR_HARMONICS, MONITOR_FRAME_SIZE, window->coeffs, MONITOR_TRACK_HZ) != 0) {
+        fprintf(stderr, "Error: Failed to allocate monitor state\n");
+        ab_window_cache_free();
+        Pa_CloseStream(stream);
+        ab_ring_destroy(streaming_data.ring);
+        Pa_Terminate();
+        return -1;
+    }
+    output.data = &streaming_data;
+    output.json = json;
+
+    fprintf(info, "Sample rate: %d Hz, Channels: %d, Update: %.2f s, Fundamental: %.1f Hz (+/- %.0f Hz)\n",
+            actual_sample_rate, channels, interval, fundamental, MONITOR_TRACK_HZ);
+    fprintf(info, "Levels in dBFS; THD marked '*' while the tone tracker settles\n");
+
+//------------------------------------------------------------------------------
+//	Run until the duration elapses or Ctrl+C, analysing on this thread
+//------------------------------------------------------------------------------
+    signal(SIGINT, handle_interrupt);
+
+    err = Pa_StartStream(stream);
+    if (err != paNoError) {
+        fprintf(stderr, "Error: Failed to start stream: %s\n",
+                Pa_GetErrorText(err));
+        result = -1;
+    } else {
+        fprintf(info, "Monitoring... (Ctrl+C to stop)\n");
+        fflush(info);
+
+        while (Pa_IsStreamActive(stream) == 1 && !g_interrupted) {
+            int finished = atomic_load_explicit(&streaming_data.finished, memory_order_acquire);
+            if (drain_monitor(&streaming_data, &monitor, &output) == 0) {
+                if (finished) {
+                    break;
+                }
+                Pa_Sleep(WRITER_POLL_MS);
+            }
+        }
+
+        err = Pa_StopStream(stream);
+        if (err != paNoError) {
+            fprintf(stderr, "Warning: Error stopping stream: %s\n",
+                    Pa_GetErrorText(err));
+        }
+    }
+    signal(SIGINT, SIG_DFL);
+
+//------------------------------------------------------------------------------
+//	Callback has stopped: analyse what is left, then report
+//------------------------------------------------------------------------------
+    drain_monitor(&streaming_data, &monitor, &output);
+
+    Pa_CloseStream(stream);
+    Pa_Terminate();
+
+    fprintf(info, "Done: %.1f s monitored, %llu updates\n",
+            (double)monitor.frames / actual_sample_rate, (unsigned long long)monitor.updates);
+    fprintf(info, "Input overflows: %lu, Input underflows: %lu, Dropped frames: %lu\n",
+            atomic_load(&streaming_data.input_overflows),
+            atomic_load(&streaming_data.input_underflows),
+            atomic_load(&streaming_data.dropped_frames));
+
+    ab_monitor_free(&monitor);
+    ab_window_cache_free();
+    ab_ring_destroy(streaming_data.ring);
+
+    if (stats_file != NULL && ab_cbstats_write_json(&streaming_data.stats, "ab_acq", stats_file) != 0) {
+        fprintf(stderr, "Error: Failed to write callback statistics to '%s'\n", stats_file);
+        result = -1;
+    }
+    return result;
 }
 
 //------------------------------------------------------------------------------
@@ -332,7 +1058,7 @@ static int record_audio(int device_index, const char *output_file,
 //	- Parses command-line options using popt
 //	- Validates recording parameters
 //	- Records audio from specified device
-//	- Saves recording to WAV file
+//	- Saves recording to WAV file, or monitors levels and THD+N live
 //
 //	Libraries:
 //	- PortAudio: Audio device access and recording
@@ -351,6 +1077,12 @@ int main(int argc, const char **argv)
     int bit_depth = DEFAULT_BIT_DEPTH;
     int channels = DEFAULT_CHANNELS;
     double duration = DEFAULT_DURATION;
+    int stream_flag = 0;
+    char *stats_file = NULL;
+    int monitor_flag = 0;
+    double interval = MONITOR_INTERVAL;
+    double fundamental = MONITOR_FUNDAMENTAL;
+    int json_flag = 0;
 
     struct poptOption options[] = {
         {"version",		'v', POPT_ARG_NONE,		&version_flag,	0,	"Show version information",											NULL		},
@@ -360,6 +1092,12 @@ int main(int argc, const char **argv)
         {"bit-depth",	'b', POPT_ARG_INT,		&bit_depth,		0,	"Bit depth: 16, 24, or 32 (default: 16)",							"DEPTH"		},
         {"channels",	'c', POPT_ARG_INT,		&channels,		0,	"Number of channels: 1 (mono) or 2 (stereo) (default: 2)",			"COUNT"		},
         {"duration",	't', POPT_ARG_DOUBLE,	&duration,		0,	"Recording duration in seconds (default: 5.0)",						"SECONDS"	},
+        {"stream",		'S', POPT_ARG_NONE,		&stream_flag,	0,	"Stream to disk while recording (-t 0 records until Ctrl+C)",		NULL		},
+        {"stats",		'j', POPT_ARG_STRING,	&stats_file,	0,	"Write callback timing and xrun statistics as JSON",				"FILE"		},
+        {"monitor",		'm', POPT_ARG_NONE,		&monitor_flag,	0,	"Monitor levels and THD+N live instead of recording",				NULL		},
+        {"update",		'u', POPT_ARG_DOUBLE,	&interval,		0,	"Monitor update interval in seconds (default: 0.5)",				"SECONDS"	},
+        {"freq",		'F', POPT_ARG_DOUBLE,	&fundamental,	0,	"Monitor THD fundamental in Hz, tracked +/- 50 Hz (default: 1000)",	"HZ"		},
+        {"json",		'J', POPT_ARG_NONE,		&json_flag,		0,	"Monitor output as JSON lines on stdout",							NULL		},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -372,7 +1110,12 @@ int main(int argc, const char **argv)
         "Examples:\n"
         "  ab_acq -d 0 -o test.wav                 # Record 5s from device 0\n"
         "  ab_acq -d 1 -o out.wav -t 10 -r 48000   # Record 10s at 48kHz\n"
-        "  ab_acq -d 0 -o mono.wav -c 1 -b 24      # Record mono 24-bit audio\n");
+        "  ab_acq -d 0 -o mono.wav -c 1 -b 24      # Record mono 24-bit audio\n"
+        "  ab_acq -d 0 -o noise.wav -S -t 86400    # Stream a 24-hour capture to disk\n"
+        "  ab_acq -d 0 -o long.wav -S -t 0         # Stream until Ctrl+C\n"
+        "  ab_acq -d 0 -o take.wav -j timing.json  # Record with callback statistics\n"
+        "  ab_acq -d 0 -m -t 0                     # Live levels and THD+N until Ctrl+C\n"
+        "  ab_acq -d 0 -m -c 1 -F 997 -u 0.2 -J    # 997 Hz THD+N, 5 JSON lines per second\n");
 
     int rc = poptGetNextOpt(popt_ctx);
     if (rc < -1) {
@@ -404,7 +1147,7 @@ int main(int argc, const char **argv)
         return 1;
     }
 
-    if (output_file == NULL) {
+    if (output_file == NULL && !monitor_flag) {
         fprintf(stderr, "Error: Output file required for recording (use -o/--output)\n");
         poptFreeContext(popt_ctx);
         return 1;
@@ -416,8 +1159,20 @@ int main(int argc, const char **argv)
         return 1;
     }
 
-    if (duration <= 0) {
-        fprintf(stderr, "Error: Duration must be positive\n");
+    if (duration < 0 || (duration == 0 && !stream_flag && !monitor_flag)) {
+        fprintf(stderr, "Error: Duration must be positive (0 is allowed with --stream and --monitor)\n");
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
+    if (monitor_flag && (output_file != NULL || stream_flag)) {
+        fprintf(stderr, "Error: --monitor writes nothing to disk (drop -o/--output and -S/--stream)\n");
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
+    if (monitor_flag && (interval <= 0 || fundamental <= 0)) {
+        fprintf(stderr, "Error: Update interval and fundamental must be positive\n");
         poptFreeContext(popt_ctx);
         return 1;
     }
@@ -425,7 +1180,14 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
 //	Perform recording
 //------------------------------------------------------------------------------
-    int result = record_audio(device_index, output_file, sample_rate, bit_depth, channels, duration);
+    int result;
+    if (monitor_flag) {
+        result = monitor_audio(device_index, sample_rate, channels, duration, interval, fundamental, json_flag, stats_file);
+    } else if (stream_flag) {
+        result = record_audio_streaming(device_index, output_file, sample_rate, bit_depth, channels, duration, stats_file);
+    } else {
+        result = record_audio(device_index, output_file, sample_rate, bit_depth, channels, duration, stats_file);
+    }
 
     poptFreeContext(popt_ctx);
     return result;																//	Exit: status from record_audio
@@ -27,7 +27,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <portaudio.h>
+#include <fftw3.h>
+#include "ab_fft_plan.h"
+#include "ab_window.h"
+#include "ab_simd.h"
+#include "ab_ring.h"
 
 //------------------------------------------------------------------------------
 // Application constants
@@ -41,6 +47,20 @@
 #define DEFAULT_SAMPLE_RATE 48000
 #define FRAMES_PER_BUFFER   512
 #define DEFAULT_TIME_WINDOW 0.5     // seconds
+#define MAX_TIME_WINDOW     10.0        // seconds
+#define RING_HEADROOM       1.0         // seconds the UI may lag before drops
+#define SCRATCH_FRAMES      1024        // callback mono mix block
+#define DEFAULT_FFT_INDEX   2           // 16384 points
+#define DEFAULT_AVERAGING   2           // Medium
+#define DEFAULT_RATE_INDEX  1           // 48000 Hz
+#define SPECTRUM_MIN_FREQ   20.0
+#define SPECTRUM_MIN_DB     -160.0
+#define SPECTRUM_NOISE_FLOOR 1e-9f
+#define SPECTRUM_AXIS_WIDTH 50
+#define PYRAMID_LEVELS      7           // 8 to 32768 frames per bucket
+#define PYRAMID_BASE        8           // frames per level-0 bucket
+#define PYRAMID_FACTOR      4           // buckets merged per level
+#define MAX_TRACES          3           // left (or mono), right, combined
 
 //------------------------------------------------------------------------------
 // Control IDs
@@ -51,6 +71,10 @@
 #define ID_CHANNEL_SELECT   1004
 #define ID_TIME_WINDOW      1005
 #define ID_TIMER            1006
+#define ID_VIEW_MODE        1007
+#define ID_FFT_SIZE         1008
+#define ID_AVERAGING        1009
+#define ID_SAMPLE_RATE      1010
 
 //------------------------------------------------------------------------------
 // Channel display modes
@@ -63,22 +87,100 @@ typedef enum {
 } ChannelMode;
 
 //------------------------------------------------------------------------------
-// Circular buffer for audio samples
+// Graph views
+//------------------------------------------------------------------------------
+typedef enum {
+    VIEW_WAVEFORM,
+    VIEW_SPECTRUM
+} ViewMode;
+
+//------------------------------------------------------------------------------
+// Spectrum shared between the analyzer thread and the paint code
 //------------------------------------------------------------------------------
 typedef struct {
-    float *data;
-    size_t size;
-    size_t write_pos;
-    size_t read_pos;
     CRITICAL_SECTION lock;
-} CircularBuffer;
+    float *db;                      // Averaged level per bin, dBFS
+    int bins;                       // 0 until the first FFT completes
+    int fft_size;
+    int sample_rate;
+    unsigned long spectra;          // FFTs averaged so far
+    unsigned long long skipped;     // Samples dropped to keep up
+} SpectrumView;
+
+//------------------------------------------------------------------------------
+// Spectrum analyzer state
+//------------------------------------------------------------------------------
+typedef struct {
+    AbRing *ring;                   // Callback -> analyzer thread, mono
+    HANDLE thread;
+    atomic_int stop;
+    atomic_int fft_size;            // Requested by the UI
+    atomic_int averaging;           // Index into g_averaging_alpha
+    atomic_int channel_mode;        // ChannelMode mixed into the ring
+    atomic_ullong dropped;          // Samples lost because the ring was full
+    float scratch[SCRATCH_FRAMES];  // Callback mono mix
+    SpectrumView view;
+} Analyzer;
+
+static const int g_fft_sizes[] = { 4096, 8192, 16384, 32768, 65536 };
+static const char *g_averaging_names[] = { "None", "Light", "Medium", "Heavy" };
+static const float g_averaging_alpha[] = { 0.0f, 0.5f, 0.8f, 0.95f };
+static const int g_sample_rates[] = { 44100, 48000, 96000, 192000 };
+
+//------------------------------------------------------------------------------
+// Min/max decimation pyramid for the waveform view
+//
+// Level 0 holds the min and max of every PYRAMID_BASE frames; each higher
+// level merges PYRAMID_FACTOR buckets of the level below. The UI thread
+// folds new samples in as they arrive (UpdateWaveform), so drawing a column
+// only merges a handful of buckets from the level closest to the column
+// width. Only the UI thread touches it, so it needs no lock.
+//------------------------------------------------------------------------------
+typedef struct {
+    float *min[MAX_TRACES];
+    float *max[MAX_TRACES];
+    size_t buckets;                 // Ring length
+    size_t frames;                  // Frames per bucket
+} PyramidLevel;
+
+typedef struct {
+    PyramidLevel level[PYRAMID_LEVELS];
+    int traces;                     // 1 (mono) or 3 (left, right, combined)
+    size_t head;                    // Level-0 buckets ever completed
+    int fill;                       // Frames in the partial level-0 bucket
+    float acc_min[MAX_TRACES];
+    float acc_max[MAX_TRACES];
+} WaveformPyramid;
+
+//------------------------------------------------------------------------------
+// GDI objects and paint buffers kept for the life of the window
+//------------------------------------------------------------------------------
+typedef struct {
+    HDC back_dc;
+    HBITMAP back_bitmap;
+    HBITMAP old_bitmap;
+    int width;
+    int height;
+    HBRUSH bg_brush;
+    HPEN grid_pen;
+    HPEN center_pen;
+    HPEN wave_pen;
+    HPEN trace_pen;
+    POINT *points;                  // Two per column (span endpoints)
+    DWORD *counts;                  // PolyPolyline segment lengths
+    int max_columns;
+} GraphResources;
 
 //------------------------------------------------------------------------------
 // Audio capture state
 //------------------------------------------------------------------------------
 typedef struct {
     PaStream *stream;
-    CircularBuffer buffer;
+    AbRing *ring;                   // Callback -> UI thread, interleaved frames
+    size_t folded;                  // Unconsumed samples already in the pyramid
+    atomic_ulong dropped;           // Frames lost because the UI fell behind
+    WaveformPyramid pyramid;
+    Analyzer analyzer;
     int is_recording;
     int sample_rate;
     int channels;
@@ -95,109 +197,400 @@ static struct {
     HWND output_combo;
     HWND channel_combo;
     HWND time_window_edit;
+    HWND view_combo;
+    HWND fft_combo;
+    HWND averaging_combo;
+    HWND rate_combo;
     HWND graph_area;
     AudioCapture audio;
+    GraphResources gfx;
     ChannelMode channel_mode;
+    ViewMode view_mode;
     float time_window;
     int num_devices;
 } g_app = {0};
 
 //------------------------------------------------------------------------------
-//	Name:		CircularBuffer_Init
+//	Name:		Pyramid_Free
 //
-//	Returns:	1 on success, 0 on failure
+//	Returns:	none
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Initializes circular buffer with specified size
-//	- Allocates memory for buffer data
-//	- Initializes critical section for thread safety
+//	- Frees the level buffers
 //------------------------------------------------------------------------------
-static int CircularBuffer_Init(CircularBuffer *buf, size_t size)
+static void Pyramid_Free(WaveformPyramid *p)
 {
-    buf->data = (float*)calloc(size, sizeof(float));
-    if (!buf->data) {
-        return 0;
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        for (int t = 0; t < MAX_TRACES; t++) {
+            free(p->level[l].min[t]);
+            free(p->level[l].max[t]);
+            p->level[l].min[t] = NULL;
+            p->level[l].max[t] = NULL;
+        }
+        p->level[l].buckets = 0;
     }
-    buf->size = size;
-    buf->write_pos = 0;
-    buf->read_pos = 0;
-    InitializeCriticalSection(&buf->lock);
-    return 1;
+    p->traces = 0;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		CircularBuffer_Destroy
+//	Name:		Pyramid_Configure
 //
-//	Returns:	none
+//	Returns:	1 on success, 0 on failure
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Frees circular buffer resources
-//	- Deletes critical section
+//	- Sizes every level to hold capacity_frames of history and clears it
+//	- Stereo input keeps left, right and combined traces so switching the
+//	  channel mode does not lose history
 //------------------------------------------------------------------------------
-static void CircularBuffer_Destroy(CircularBuffer *buf)
+static int Pyramid_Configure(WaveformPyramid *p, size_t capacity_frames, int channels)
 {
-    if (buf->data) {
-        free(buf->data);
-        buf->data = NULL;
+    int ok = 1;
+
+    Pyramid_Free(p);
+
+    int traces = (channels == 2) ? MAX_TRACES : 1;
+    size_t frames = PYRAMID_BASE;
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        PyramidLevel *level = &p->level[l];
+        level->frames = frames;
+        level->buckets = capacity_frames / frames + PYRAMID_FACTOR + 1;   // keep children for merging
+        for (int t = 0; t < traces; t++) {
+            level->min[t] = (float*)calloc(level->buckets, sizeof(float));
+            level->max[t] = (float*)calloc(level->buckets, sizeof(float));
+            if (!level->min[t] || !level->max[t]) {
+                ok = 0;
+            }
+        }
+        frames *= PYRAMID_FACTOR;
+    }
+
+    if (ok) {
+        p->traces = traces;
+    } else {
+        Pyramid_Free(p);
     }
-    DeleteCriticalSection(&buf->lock);
+    p->head = 0;
+    p->fill = 0;
+    return ok;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		CircularBuffer_Write
+//	Name:		Pyramid_Write
 //
 //	Returns:	none
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Writes samples to circular buffer
-//	- Thread-safe with critical section
-//	- Overwrites old data when buffer is full
+//	- Folds interleaved frames into the partial level-0 bucket; each
+//	  completed bucket cascades upward whenever it completes a group of
+//	  PYRAMID_FACTOR at the next level
+//	- O(1) amortized per frame, no allocation
 //------------------------------------------------------------------------------
-static void CircularBuffer_Write(CircularBuffer *buf, const float *samples, size_t count)
+static void Pyramid_Write(WaveformPyramid *p, const float *samples, size_t frames, int channels)
 {
-    EnterCriticalSection(&buf->lock);
+    if (p->traces == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        float value[MAX_TRACES];
+        if (p->traces == MAX_TRACES) {
+            value[0] = samples[i * channels];
+            value[1] = samples[i * channels + 1];
+            value[2] = (value[0] + value[1]) * 0.5f;
+        } else {
+            value[0] = samples[i * channels];
+        }
+
+        for (int t = 0; t < p->traces; t++) {
+            if (p->fill == 0 || value[t] < p->acc_min[t]) p->acc_min[t] = value[t];
+            if (p->fill == 0 || value[t] > p->acc_max[t]) p->acc_max[t] = value[t];
+        }
+
+        if (++p->fill < PYRAMID_BASE) {
+            continue;
+        }
+
+        // Level-0 bucket complete
+        PyramidLevel *level = &p->level[0];
+        size_t slot = p->head % level->buckets;
+        for (int t = 0; t < p->traces; t++) {
+            level->min[t][slot] = p->acc_min[t];
+            level->max[t][slot] = p->acc_max[t];
+        }
+        p->head++;
+        p->fill = 0;
+
+        // Cascade: level l gains a bucket every PYRAMID_FACTOR^l level-0 buckets
+        size_t count = p->head;
+        for (int l = 1; l < PYRAMID_LEVELS && count % PYRAMID_FACTOR == 0; l++) {
+            PyramidLevel *child = &p->level[l - 1];
+            level = &p->level[l];
+            count /= PYRAMID_FACTOR;
+
+            size_t bucket = count - 1;
+            size_t first = bucket * PYRAMID_FACTOR;
+            slot = bucket % level->buckets;
+            for (int t = 0; t < p->traces; t++) {
+                float lo = child->min[t][first % child->buckets];
+                float hi = child->max[t][first % child->buckets];
+                for (size_t c = 1; c < PYRAMID_FACTOR; c++) {
+                    size_t s = (first + c) % child->buckets;
+                    if (child->min[t][s] < lo) lo = child->min[t][s];
+                    if (child->max[t][s] > hi) hi = child->max[t][s];
+                }
+                level->min[t][slot] = lo;
+                level->max[t][slot] = hi;
+            }
+        }
+    }
+}
 
-    for (size_t i = 0; i < count; i++) {
-        buf->data[buf->write_pos] = samples[i];
-        buf->write_pos = (buf->write_pos + 1) % buf->size;
+//------------------------------------------------------------------------------
+//	Name:		Pyramid_Range
+//
+//	Returns:	1 if any bucket in the range is still held, 0 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Min and max of trace over frames [f0, f1) using level l; partially
+//	  covered buckets at either end are included
+//------------------------------------------------------------------------------
+static int Pyramid_Range(const WaveformPyramid *p, int l, int trace,
+                         size_t f0, size_t f1, float *lo, float *hi)
+{
+    const PyramidLevel *level = &p->level[l];
+    size_t head = p->head / (level->frames / PYRAMID_BASE);   // completed buckets at this level
+    size_t oldest = (head > level->buckets) ? head - level->buckets : 0;
+    size_t b0 = f0 / level->frames;
+    size_t b1 = (f1 + level->frames - 1) / level->frames;
+
+    if (b0 < oldest) b0 = oldest;
+    if (b1 > head) b1 = head;
+    if (b0 >= b1) {
+        return 0;
     }
 
-    LeaveCriticalSection(&buf->lock);
+    *lo = level->min[trace][b0 % level->buckets];
+    *hi = level->max[trace][b0 % level->buckets];
+    for (size_t b = b0 + 1; b < b1; b++) {
+        size_t s = b % level->buckets;
+        if (level->min[trace][s] < *lo) *lo = level->min[trace][s];
+        if (level->max[trace][s] > *hi) *hi = level->max[trace][s];
+    }
+    return 1;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		CircularBuffer_Read
+//	Name:		AnalyzerThread
 //
-//	Returns:	Number of samples actually read
+//	Returns:	0
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Reads samples from circular buffer
-//	- Thread-safe with critical section
-//	- Returns most recent samples
+//	- Consumer of the spectrum ring: collects hops of fft_size / 2 samples,
+//	  slides them into the analysis frame and runs a Blackman-Harris
+//	  windowed single precision FFT through a plan made once per size
+//	- Exponential averaging (avg = alpha * avg + (1 - alpha) * |X|^2) is
+//	  done in place; the result is converted to dBFS (full-scale sine at
+//	  0 dB) and copied to the shared view under its lock
+//	- If more than half the ring is waiting (display thread stalled, or
+//	  the machine cannot keep up) the oldest samples are skipped, so the
+//	  view stays live instead of lagging
+//	- A change of FFT size from the UI rebuilds the plan and buffers and
+//	  restarts the average
 //------------------------------------------------------------------------------
-static size_t CircularBuffer_Read(CircularBuffer *buf, float *output, size_t count)
+static DWORD WINAPI AnalyzerThread(LPVOID param)
 {
-    EnterCriticalSection(&buf->lock);
+    Analyzer *an = (Analyzer*)param;
+    int fft_size = 0;
+    int bins = 0;
+    int hop = 0;
+    int pending = 0;
+    int spectra = 0;
+    float *in = NULL;
+    fftwf_complex *out = NULL;
+    float *frame = NULL;
+    float *avg = NULL;
+    float *db = NULL;
+    const AbWindow *window = NULL;
+    fftwf_plan plan = NULL;
+
+    ab_fftwf_wisdom_load(NULL);
+
+    while (!atomic_load(&an->stop)) {
+        // (Re)build the plan and buffers when the FFT size changes
+        int requested = atomic_load(&an->fft_size);
+        if (requested != fft_size) {
+            if (plan) fftwf_destroy_plan(plan);
+            fftwf_free(in);
+            fftwf_free(out);
+            free(frame);
+            free(avg);
+            free(db);
+
+            fft_size = requested;
+            bins = fft_size / 2 + 1;
+            hop = fft_size / 2;
+            pending = 0;
+            spectra = 0;
+            in = fftwf_alloc_real(fft_size);
+            out = fftwf_alloc_complex(bins);
+            frame = (float*)calloc(fft_size, sizeof(float));
+            avg = (float*)calloc(bins, sizeof(float));
+            db = (float*)malloc(bins * sizeof(float));
+            window = ab_window_get(AB_WINDOW_BLACKMAN_HARRIS, fft_size, 0.0);
+            plan = NULL;
+
+            if (!in || !out || !frame || !avg || !db || !window) {
+                fft_size = 0;
+                Sleep(100);
+                continue;
+            }
+            plan = fftwf_plan_dft_r2c_1d(fft_size, in, out, FFTW_MEASURE);
+            ab_fftwf_wisdom_save(FFTW_MEASURE);
+
+            EnterCriticalSection(&an->view.lock);
+            free(an->view.db);
+            an->view.db = (float*)malloc(bins * sizeof(float));
+            an->view.bins = 0;
+            an->view.fft_size = fft_size;
+            an->view.spectra = 0;
+            LeaveCriticalSection(&an->view.lock);
+        }
+
+        // Skip ahead if the backlog exceeds half the ring
+        AbRingSpans spans;
+        size_t available = ab_ring_peek(an->ring, &spans);
+        size_t count = spans.count[0];
+
+        if (available > ab_ring_capacity(an->ring) / 2) {
+            size_t skip = available - (size_t)hop;
+            ab_ring_consume(an->ring, skip);
+            EnterCriticalSection(&an->view.lock);
+            an->view.skipped += skip;
+            LeaveCriticalSection(&an->view.lock);
+            continue;
+        }
 
-    size_t available = buf->size;
-    size_t to_read = (count < available) ? count : available;
+        if (count == 0) {
+            Sleep(5);
+            continue;
+        }
+
+        // Append to the newest hop at the end of the frame
+        size_t take = (size_t)(hop - pending);
+        if (take > count) {
+            take = count;
+        }
+        memcpy(frame + (fft_size - hop) + pending, spans.data[0], take * sizeof(float));
+        ab_ring_consume(an->ring, take);
+        pending += (int)take;
+
+        if (pending < hop) {
+            continue;
+        }
+
+        // Window, transform, average in place, convert to dBFS
+        for (int i = 0; i < fft_size; i++) {
+            in[i] = frame[i] * window->coeffs_f[i];
+        }
+        fftwf_execute(plan);
+
+        float alpha = (spectra == 0) ? 0.0f : g_averaging_alpha[atomic_load(&an->averaging)];
+        for (int k = 0; k < bins; k++) {
+            float p = out[k][0] * out[k][0] + out[k][1] * out[k][1];
+            avg[k] = alpha * avg[k] + (1.0f - alpha) * p;
+        }
+        spectra++;
+
+        ab_simd_power_db_f(db, avg, bins, 1.0f,
+                           (float)ab_window_amplitude_scale(window), SPECTRUM_NOISE_FLOOR);
 
-    // Calculate starting position (most recent samples)
-    size_t start_pos = (buf->write_pos >= to_read) ?
-                       (buf->write_pos - to_read) :
-                       (buf->size - (to_read - buf->write_pos));
+        EnterCriticalSection(&an->view.lock);
+        if (an->view.db) {
+            memcpy(an->view.db, db, bins * sizeof(float));
+            an->view.bins = bins;
+            an->view.spectra = (unsigned long)spectra;
+        }
+        LeaveCriticalSection(&an->view.lock);
+
+        // Slide by one hop (50% overlap)
+        memmove(frame, frame + hop, (fft_size - hop) * sizeof(float));
+        pending = 0;
+    }
+
+    if (plan) fftwf_destroy_plan(plan);
+    fftwf_free(in);
+    fftwf_free(out);
+    free(frame);
+    free(avg);
+    free(db);
+    ab_window_cache_free();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		StartAnalyzer
+//
+//	Returns:	1 on success, 0 on failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Sizes the ring for one second of audio (at least four of the largest
+//	  hops) and starts the analyzer thread
+//------------------------------------------------------------------------------
+static int StartAnalyzer(Analyzer *an, int sample_rate)
+{
+    size_t capacity = (size_t)sample_rate;
+    if (capacity < 4 * 32768) {
+        capacity = 4 * 32768;
+    }
+    an->ring = ab_ring_create(capacity, 1);
+    if (!an->ring) {
+        return 0;
+    }
 
-    // Read samples
-    for (size_t i = 0; i < to_read; i++) {
-        output[i] = buf->data[(start_pos + i) % buf->size];
+    atomic_store(&an->stop, 0);
+    atomic_store(&an->dropped, 0);
+    EnterCriticalSection(&an->view.lock);
+    an->view.bins = 0;
+    an->view.spectra = 0;
+    an->view.skipped = 0;
+    an->view.sample_rate = sample_rate;
+    LeaveCriticalSection(&an->view.lock);
+
+    an->thread = CreateThread(NULL, 0, AnalyzerThread, an, 0, NULL);
+    if (!an->thread) {
+        ab_ring_destroy(an->ring);
+        an->ring = NULL;
+        return 0;
     }
+    return 1;
+}
 
-    LeaveCriticalSection(&buf->lock);
-    return to_read;
+//------------------------------------------------------------------------------
+//	Name:		StopAnalyzer
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Call after the audio stream has stopped (the callback is the ring's
+//	  producer)
+//------------------------------------------------------------------------------
+static void StopAnalyzer(Analyzer *an)
+{
+    if (an->thread) {
+        atomic_store(&an->stop, 1);
+        WaitForSingleObject(an->thread, INFINITE);
+        CloseHandle(an->thread);
+        an->thread = NULL;
+    }
+    ab_ring_destroy(an->ring);
+    an->ring = NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -208,8 +601,10 @@ static size_t CircularBuffer_Read(CircularBuffer *buf, float *output, size_t cou
 //------------------------------------------------------------------------------
 //	Detailed description:
 //	- PortAudio callback for capturing audio samples
-//	- Writes incoming samples to circular buffer
-//	- Processes based on channel mode
+//	- Pushes incoming frames to the waveform ring for the UI thread
+//	- Mixes the selected channel(s) to mono for the spectrum analyzer and
+//	  pushes them to its lock-free ring; samples that do not fit are
+//	  counted and dropped rather than waiting on the analyzer thread
 //------------------------------------------------------------------------------
 static int AudioCallback(const void *inputBuffer, void *outputBuffer,
                         unsigned long framesPerBuffer,
@@ -228,8 +623,43 @@ static int AudioCallback(const void *inputBuffer, void *outputBuffer,
         return paContinue;
     }
 
-    // Write samples to circular buffer (interleaved for stereo)
-    CircularBuffer_Write(&capture->buffer, input, framesPerBuffer * capture->channels);
+    // Hand interleaved frames to the UI thread; never waits on it
+    size_t samples = framesPerBuffer * capture->channels;
+    size_t stored = ab_ring_write(capture->ring, input, samples);
+    if (stored < samples) {
+        atomic_fetch_add_explicit(&capture->dropped, (samples - stored) / capture->channels,
+                                  memory_order_relaxed);
+    }
+
+    // Feed the spectrum analyzer
+    Analyzer *an = &capture->analyzer;
+    int channels = capture->channels;
+    int mode = atomic_load_explicit(&an->channel_mode, memory_order_relaxed);
+
+    for (unsigned long done = 0; done < framesPerBuffer; ) {
+        unsigned long count = framesPerBuffer - done;
+        if (count > SCRATCH_FRAMES) {
+            count = SCRATCH_FRAMES;
+        }
+
+        const float *frames = input + done * channels;
+        for (unsigned long i = 0; i < count; i++) {
+            if (channels == 2) {
+                float left = frames[i * 2];
+                float right = frames[i * 2 + 1];
+                an->scratch[i] = (mode == CHANNEL_RIGHT) ? right :
+                                 (mode == CHANNEL_COMBINED) ? (left + right) * 0.5f : left;
+            } else {
+                an->scratch[i] = frames[i];
+            }
+        }
+
+        size_t written = ab_ring_write(an->ring, an->scratch, count);
+        if (written < count) {
+            atomic_fetch_add_explicit(&an->dropped, count - written, memory_order_relaxed);
+        }
+        done += count;
+    }
 
     return paContinue;
 }
@@ -242,10 +672,11 @@ static int AudioCallback(const void *inputBuffer, void *outputBuffer,
 //------------------------------------------------------------------------------
 //	Detailed description:
 //	- Starts PortAudio stream for audio capture
-//	- Configures input parameters
+//	- Configures input parameters at the selected sample rate
+//	- Starts the spectrum analyzer thread
 //	- Opens and starts audio stream
 //------------------------------------------------------------------------------
-static int StartAudioCapture(int device_index)
+static int StartAudioCapture(int device_index, int sample_rate)
 {
     PaError err;
     PaStreamParameters input_params;
@@ -261,7 +692,23 @@ static int StartAudioCapture(int device_index)
 
     // Configure input parameters
     g_app.audio.channels = (device_info->maxInputChannels >= 2) ? 2 : 1;
-    g_app.audio.sample_rate = DEFAULT_SAMPLE_RATE;
+    g_app.audio.sample_rate = sample_rate;
+
+    // Waveform ring holds the longest time window plus headroom, so the
+    // window can change while the callback is writing
+    ab_ring_destroy(g_app.audio.ring);
+    g_app.audio.ring = ab_ring_create((size_t)(sample_rate * (MAX_TIME_WINDOW + RING_HEADROOM)),
+                                      g_app.audio.channels);
+    g_app.audio.folded = 0;
+    atomic_store(&g_app.audio.dropped, 0);
+
+    if (!g_app.audio.ring ||
+        !Pyramid_Configure(&g_app.audio.pyramid,
+                           (size_t)(sample_rate * g_app.time_window), g_app.audio.channels)) {
+        MessageBox(g_app.main_window, "Failed to allocate waveform buffers",
+                   "Error", MB_OK | MB_ICONERROR);
+        return 0;
+    }
 
     memset(&input_params, 0, sizeof(input_params));
     input_params.device = device_index;
@@ -288,6 +735,15 @@ static int StartAudioCapture(int device_index)
         return 0;
     }
 
+    // Start spectrum analyzer before the callback can feed it
+    if (!StartAnalyzer(&g_app.audio.analyzer, g_app.audio.sample_rate)) {
+        MessageBox(g_app.main_window, "Failed to start spectrum analyzer",
+                   "Error", MB_OK | MB_ICONERROR);
+        Pa_CloseStream(g_app.audio.stream);
+        g_app.audio.stream = NULL;
+        return 0;
+    }
+
     // Start stream
     err = Pa_StartStream(g_app.audio.stream);
     if (err != paNoError) {
@@ -297,6 +753,7 @@ static int StartAudioCapture(int device_index)
         MessageBox(g_app.main_window, msg, "Error", MB_OK | MB_ICONERROR);
         Pa_CloseStream(g_app.audio.stream);
         g_app.audio.stream = NULL;
+        StopAnalyzer(&g_app.audio.analyzer);
         return 0;
     }
 
@@ -315,6 +772,8 @@ static int StartAudioCapture(int device_index)
 //	Detailed description:
 //	- Stops PortAudio stream
 //	- Closes and cleans up audio resources
+//	- Stops the spectrum analyzer and frees the waveform ring once the
+//	  callback can no longer run
 //------------------------------------------------------------------------------
 static void StopAudioCapture(void)
 {
@@ -325,6 +784,10 @@ static void StopAudioCapture(void)
         Pa_CloseStream(g_app.audio.stream);
         g_app.audio.stream = NULL;
     }
+
+    StopAnalyzer(&g_app.audio.analyzer);
+    ab_ring_destroy(g_app.audio.ring);
+    g_app.audio.ring = NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -371,6 +834,168 @@ static void PopulateDeviceList(void)
     SendMessage(g_app.output_combo, CB_SETCURSEL, 0, 0);
 }
 
+//------------------------------------------------------------------------------
+//	Name:		Graph_Init
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Creates the brushes and pens used by every paint
+//------------------------------------------------------------------------------
+static void Graph_Init(GraphResources *gfx)
+{
+    gfx->bg_brush = CreateSolidBrush(RGB(20, 20, 30));
+    gfx->grid_pen = CreatePen(PS_SOLID, 1, RGB(50, 50, 60));
+    gfx->center_pen = CreatePen(PS_SOLID, 1, RGB(100, 100, 120));
+    gfx->wave_pen = CreatePen(PS_SOLID, 2, RGB(0, 255, 100));
+    gfx->trace_pen = CreatePen(PS_SOLID, 1, RGB(0, 255, 100));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		Graph_Destroy
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Releases the back buffer, GDI objects and paint buffers
+//------------------------------------------------------------------------------
+static void Graph_Destroy(GraphResources *gfx)
+{
+    if (gfx->back_dc) {
+        SelectObject(gfx->back_dc, gfx->old_bitmap);
+        DeleteObject(gfx->back_bitmap);
+        DeleteDC(gfx->back_dc);
+    }
+    DeleteObject(gfx->bg_brush);
+    DeleteObject(gfx->grid_pen);
+    DeleteObject(gfx->center_pen);
+    DeleteObject(gfx->wave_pen);
+    DeleteObject(gfx->trace_pen);
+    free(gfx->points);
+    free(gfx->counts);
+    memset(gfx, 0, sizeof(*gfx));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		Graph_Prepare
+//
+//	Returns:	back buffer DC, or NULL on failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reuses the back buffer while the graph size is unchanged; the bitmap
+//	  is only recreated on resize
+//	- Grows the per-column point arrays to the graph width
+//------------------------------------------------------------------------------
+static HDC Graph_Prepare(GraphResources *gfx, HDC hdc, int width, int height)
+{
+    if (width > gfx->max_columns) {
+        POINT *points = (POINT*)realloc(gfx->points, 2 * width * sizeof(POINT));
+        if (!points) {
+            return NULL;
+        }
+        gfx->points = points;
+
+        DWORD *counts = (DWORD*)realloc(gfx->counts, width * sizeof(DWORD));
+        if (!counts) {
+            return NULL;
+        }
+        gfx->counts = counts;
+
+        for (int i = 0; i < width; i++) {
+            gfx->counts[i] = 2;
+        }
+        gfx->max_columns = width;
+    }
+
+    if (gfx->back_dc && gfx->width == width && gfx->height == height) {
+        return gfx->back_dc;
+    }
+
+    if (!gfx->back_dc) {
+        gfx->back_dc = CreateCompatibleDC(hdc);
+        if (!gfx->back_dc) {
+            return NULL;
+        }
+    }
+
+    HBITMAP bitmap = CreateCompatibleBitmap(hdc, width, height);
+    if (!bitmap) {
+        return NULL;
+    }
+
+    HBITMAP previous = SelectObject(gfx->back_dc, bitmap);
+    if (gfx->back_bitmap) {
+        DeleteObject(gfx->back_bitmap);
+    } else {
+        gfx->old_bitmap = previous;
+    }
+    gfx->back_bitmap = bitmap;
+    gfx->width = width;
+    gfx->height = height;
+    return gfx->back_dc;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		RingFrame
+//
+//	Returns:	pointer to the frame starting at sample offset in spans
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- The ring holds whole frames, so a frame never straddles the spans
+//------------------------------------------------------------------------------
+static const float *RingFrame(const AbRingSpans *spans, size_t offset)
+{
+    if (offset < spans->count[0]) {
+        return spans->data[0] + offset;
+    }
+    return spans->data[1] + (offset - spans->count[0]);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		UpdateWaveform
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- UI thread side of the waveform ring, called from the display timer
+//	- Folds frames that arrived since the last call into the pyramid,
+//	  reading them in place from the ring's spans
+//	- Consumes everything older than the time window, so the ring always
+//	  has at least RING_HEADROOM seconds free for the callback
+//------------------------------------------------------------------------------
+static void UpdateWaveform(void)
+{
+    AudioCapture *audio = &g_app.audio;
+    AbRingSpans spans;
+
+    if (!audio->is_recording || !audio->ring) {
+        return;
+    }
+
+    size_t available = ab_ring_peek(audio->ring, &spans);
+    size_t skip = audio->folded;
+
+    for (int s = 0; s < 2; s++) {
+        if (skip >= spans.count[s]) {
+            skip -= spans.count[s];
+            continue;
+        }
+        Pyramid_Write(&audio->pyramid, spans.data[s] + skip,
+                      (spans.count[s] - skip) / audio->channels, audio->channels);
+        skip = 0;
+    }
+
+    size_t keep = (size_t)(audio->sample_rate * g_app.time_window) * audio->channels;
+    size_t consume = (available > keep) ? available - keep : 0;
+    ab_ring_consume(audio->ring, consume);
+    audio->folded = available - consume;
+}
+
 //------------------------------------------------------------------------------
 //	Name:		DrawWaveform
 //
@@ -378,28 +1003,21 @@ static void PopulateDeviceList(void)
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Renders waveform to device context
+//	- Renders waveform into the back buffer
 //	- Draws grid, axes, and audio waveform
 //	- Handles different channel modes
+//	- One vertical min/max span per pixel column, drawn with a single
+//	  PolyPolyline; spans come from the decimation pyramid (or the ring's
+//	  spans when a column holds fewer than PYRAMID_BASE frames), so the
+//	  cost depends on the graph width, not the sample rate
 //------------------------------------------------------------------------------
-static void DrawWaveform(HDC hdc, RECT *rect)
+static void DrawWaveform(HDC memDC, int width, int height)
 {
-    int width = rect->right - rect->left;
-    int height = rect->bottom - rect->top;
-
-    // Create double buffer
-    HDC memDC = CreateCompatibleDC(hdc);
-    HBITMAP memBitmap = CreateCompatibleBitmap(hdc, width, height);
-    HBITMAP oldBitmap = SelectObject(memDC, memBitmap);
-
-    // Clear background
-    HBRUSH bgBrush = CreateSolidBrush(RGB(20, 20, 30));
-    FillRect(memDC, rect, bgBrush);
-    DeleteObject(bgBrush);
+    GraphResources *gfx = &g_app.gfx;
+    WaveformPyramid *pyramid = &g_app.audio.pyramid;
 
     // Draw grid
-    HPEN gridPen = CreatePen(PS_SOLID, 1, RGB(50, 50, 60));
-    HPEN oldPen = SelectObject(memDC, gridPen);
+    HPEN oldPen = SelectObject(memDC, gfx->grid_pen);
 
     // Horizontal grid lines
     for (int i = 0; i <= 4; i++) {
@@ -415,107 +1033,334 @@ static void DrawWaveform(HDC hdc, RECT *rect)
         LineTo(memDC, x, height);
     }
 
-    SelectObject(memDC, oldPen);
-    DeleteObject(gridPen);
-
     // Draw center line
-    HPEN centerPen = CreatePen(PS_SOLID, 1, RGB(100, 100, 120));
-    SelectObject(memDC, centerPen);
+    SelectObject(memDC, gfx->center_pen);
     MoveToEx(memDC, GRAPH_MARGIN, height / 2, NULL);
     LineTo(memDC, width - GRAPH_MARGIN, height / 2);
-    DeleteObject(centerPen);
-
-    // Get samples from circular buffer
-    size_t samples_to_display = (size_t)(g_app.audio.sample_rate * g_app.time_window);
-    float *samples = (float*)malloc(samples_to_display * g_app.audio.channels * sizeof(float));
-
-    if (samples && g_app.audio.is_recording) {
-        size_t samples_read = CircularBuffer_Read(&g_app.audio.buffer, samples,
-                                                  samples_to_display * g_app.audio.channels);
-
-        if (samples_read > 0) {
-            // Draw waveform based on channel mode
-            HPEN wavePen = CreatePen(PS_SOLID, 2, RGB(0, 255, 100));
-            SelectObject(memDC, wavePen);
-
-            int graph_width = width - 2 * GRAPH_MARGIN;
-            int center_y = height / 2;
-            int max_amplitude = height / 2 - 10;
-
-            size_t num_frames = samples_read / g_app.audio.channels;
-
-            for (size_t i = 0; i < num_frames; i++) {
-                float value = 0.0f;
-
-                // Extract sample based on channel mode
-                if (g_app.audio.channels == 2) {
-                    float left = samples[i * 2];
-                    float right = samples[i * 2 + 1];
-
-                    switch (g_app.channel_mode) {
-                    case CHANNEL_LEFT:
-                        value = left;
-                        break;
-                    case CHANNEL_RIGHT:
-                        value = right;
-                        break;
-                    case CHANNEL_COMBINED:
-                        value = (left + right) / 2.0f;
-                        break;
-                    case CHANNEL_STEREO:
-                        // For stereo mode, we'll draw left channel
-                        // (future enhancement: draw both channels)
-                        value = left;
-                        break;
+
+    int graph_width = width - 2 * GRAPH_MARGIN;
+    int channels = g_app.audio.channels;
+
+    if (g_app.audio.is_recording && g_app.audio.ring && graph_width > 0 && channels > 0) {
+        size_t frames = (size_t)(g_app.audio.sample_rate * g_app.time_window);
+        double frames_per_column = (double)frames / graph_width;
+        int center_y = height / 2;
+        int max_amplitude = height / 2 - 10;
+        int columns = 0;
+        float prev_lo = 0.0f;
+        float prev_hi = 0.0f;
+
+        // Trace for the channel mode (stereo mode draws the left channel)
+        int trace = 0;
+        if (channels == 2 && g_app.channel_mode == CHANNEL_RIGHT) trace = 1;
+        if (channels == 2 && g_app.channel_mode == CHANNEL_COMBINED) trace = 2;
+
+        if (frames_per_column >= PYRAMID_BASE) {
+            // Coarsest level whose buckets still fit within one column
+            int l = 0;
+            while (l + 1 < PYRAMID_LEVELS && pyramid->level[l + 1].frames <= frames_per_column) {
+                l++;
+            }
+
+            if (pyramid->traces > trace) {
+                long long end = (long long)pyramid->head * PYRAMID_BASE;
+                long long start = end - (long long)frames;
+
+                for (int x = 0; x < graph_width; x++) {
+                    long long f0 = start + (long long)(x * frames_per_column);
+                    long long f1 = start + (long long)((x + 1) * frames_per_column);
+                    float lo, hi;
+
+                    if (f1 <= 0) {
+                        continue;
+                    }
+                    if (f0 < 0) {
+                        f0 = 0;
+                    }
+                    if (!Pyramid_Range(pyramid, l, trace, (size_t)f0, (size_t)f1, &lo, &hi)) {
+                        continue;
                     }
-                } else {
-                    value = samples[i];
-                }
 
-                // Clamp value
-                if (value > 1.0f) value = 1.0f;
-                if (value < -1.0f) value = -1.0f;
+                    // Join to the previous column so the trace stays continuous
+                    if (columns > 0) {
+                        if (lo > prev_hi) lo = prev_hi;
+                        if (hi < prev_lo) hi = prev_lo;
+                    }
+                    prev_lo = lo;
+                    prev_hi = hi;
 
-                int x = GRAPH_MARGIN + (int)((float)i * graph_width / num_frames);
-                int y = center_y - (int)(value * max_amplitude);
+                    if (hi > 1.0f) hi = 1.0f;
+                    if (lo < -1.0f) lo = -1.0f;
 
-                if (i == 0) {
-                    MoveToEx(memDC, x, y, NULL);
-                } else {
-                    LineTo(memDC, x, y);
+                    gfx->points[columns * 2].x = GRAPH_MARGIN + x;
+                    gfx->points[columns * 2].y = center_y - (int)(hi * max_amplitude);
+                    gfx->points[columns * 2 + 1].x = GRAPH_MARGIN + x;
+                    gfx->points[columns * 2 + 1].y = center_y - (int)(lo * max_amplitude) + 1;
+                    columns++;
                 }
             }
+        } else {
+            // Short window: fewer than PYRAMID_BASE frames per column, read
+            // straight from the ring (UpdateWaveform keeps the newest window)
+            AbRingSpans spans;
+            size_t held = ab_ring_peek(g_app.audio.ring, &spans) / channels;
+            long long missing = (long long)frames - (long long)held;   // right-align newest frame
+
+            for (int x = 0; x < graph_width && held > 0; x++) {
+                long long i0 = (long long)(x * frames_per_column) - missing;
+                long long i1 = (long long)((x + 1) * frames_per_column) - missing;
+                float lo = 0.0f, hi = 0.0f;
+
+                if (i1 <= i0) i1 = i0 + 1;
+                if (i0 < 0) i0 = 0;
+                if (i1 > (long long)held) i1 = (long long)held;
+                if (i0 >= i1) {
+                    continue;
+                }
 
-            DeleteObject(wavePen);
+                for (long long i = i0; i < i1; i++) {
+                    const float *frame = RingFrame(&spans, (size_t)i * channels);
+                    float value = frame[0];
+                    if (channels == 2 && g_app.channel_mode == CHANNEL_RIGHT) {
+                        value = frame[1];
+                    } else if (channels == 2 && g_app.channel_mode == CHANNEL_COMBINED) {
+                        value = (frame[0] + frame[1]) / 2.0f;
+                    }
+                    if (i == i0 || value < lo) lo = value;
+                    if (i == i0 || value > hi) hi = value;
+                }
+
+                if (columns > 0) {
+                    if (lo > prev_hi) lo = prev_hi;
+                    if (hi < prev_lo) hi = prev_lo;
+                }
+                prev_lo = lo;
+                prev_hi = hi;
+
+                if (hi > 1.0f) hi = 1.0f;
+                if (lo < -1.0f) lo = -1.0f;
+
+                gfx->points[columns * 2].x = GRAPH_MARGIN + x;
+                gfx->points[columns * 2].y = center_y - (int)(hi * max_amplitude);
+                gfx->points[columns * 2 + 1].x = GRAPH_MARGIN + x;
+                gfx->points[columns * 2 + 1].y = center_y - (int)(lo * max_amplitude) + 1;
+                columns++;
+            }
         }
-    }
 
-    if (samples) {
-        free(samples);
+        if (columns > 0) {
+            SelectObject(memDC, gfx->wave_pen);
+            PolyPolyline(memDC, gfx->points, gfx->counts, columns);
+        }
     }
 
-    // Draw status text
-    SetBkMode(memDC, TRANSPARENT);
-    SetTextColor(memDC, RGB(200, 200, 200));
+    SelectObject(memDC, oldPen);
 
+    // Draw status text
     char status[256];
     if (g_app.audio.is_recording) {
-        snprintf(status, sizeof(status), "Recording: %d Hz, %d ch, %.2f sec window",
-                g_app.audio.sample_rate, g_app.audio.channels, g_app.time_window);
+        snprintf(status, sizeof(status), "Recording: %d Hz, %d ch, %.2f sec window, %lu dropped",
+                g_app.audio.sample_rate, g_app.audio.channels, g_app.time_window,
+                atomic_load(&g_app.audio.dropped));
     } else {
         snprintf(status, sizeof(status), "Stopped - Press Start to begin recording");
     }
 
     RECT textRect = {GRAPH_MARGIN, 10, width - GRAPH_MARGIN, 30};
     DrawText(memDC, status, -1, &textRect, DT_LEFT | DT_VCENTER);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		SpectrumPixelDb
+//
+//	Returns:	level in dBFS for one pixel column
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Column covers bins k0..k1 (fractional); when it spans at least one
+//	  bin the highest bin wins, so narrow peaks stay visible at high
+//	  frequencies on the log axis
+//	- Below one bin per column the level is interpolated between the two
+//	  neighbouring bins
+//------------------------------------------------------------------------------
+static float SpectrumPixelDb(const float *db, int bins, double k0, double k1)
+{
+    if (k1 - k0 >= 1.0) {
+        int first = (int)ceil(k0);
+        int last = (int)floor(k1);
+        if (last >= bins) last = bins - 1;
+
+        float peak = db[first];
+        for (int k = first + 1; k <= last; k++) {
+            if (db[k] > peak) peak = db[k];
+        }
+        return peak;
+    }
+
+    int k = (int)k0;
+    if (k >= bins - 1) {
+        return db[bins - 1];
+    }
+    float frac = (float)(k0 - k);
+    return db[k] + (db[k + 1] - db[k]) * frac;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		DrawSpectrum
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Renders the averaged spectrum from the analyzer thread
+//	- Log frequency axis from 20 Hz to Nyquist, 0 to -160 dBFS
+//	- One Polyline for the trace; the spectrum lock is held only while
+//	  the points are computed
+//------------------------------------------------------------------------------
+static void DrawSpectrum(HDC memDC, int width, int height)
+{
+    GraphResources *gfx = &g_app.gfx;
+    int plot_left = SPECTRUM_AXIS_WIDTH;
+    int plot_right = width - GRAPH_MARGIN;
+    int plot_top = 40;
+    int plot_bottom = height - 25;
+    int plot_width = plot_right - plot_left;
+    int plot_height = plot_bottom - plot_top;
+    Analyzer *an = &g_app.audio.analyzer;
+
+    int sample_rate = g_app.audio.sample_rate;
+    double f_max = sample_rate / 2.0;
+    double log_span = log10(f_max / SPECTRUM_MIN_FREQ);
+
+    if (plot_width > 0 && plot_height > 0) {
+        HPEN oldPen = SelectObject(memDC, gfx->grid_pen);
+        char label[32];
+
+        // Level grid every 20 dB
+        for (int level = 0; level >= (int)SPECTRUM_MIN_DB; level -= 20) {
+            int y = plot_top + (int)(plot_height * level / SPECTRUM_MIN_DB);
+            MoveToEx(memDC, plot_left, y, NULL);
+            LineTo(memDC, plot_right, y);
+            snprintf(label, sizeof(label), "%d", level);
+            TextOut(memDC, 5, y - 7, label, (int)strlen(label));
+        }
+
+        // Frequency grid at 1-2-5 steps
+        static const double grid_freqs[] = {
+            20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000
+        };
+        for (size_t i = 0; i < sizeof(grid_freqs) / sizeof(grid_freqs[0]); i++) {
+            if (grid_freqs[i] > f_max) break;
+            int x = plot_left + (int)(plot_width * log10(grid_freqs[i] / SPECTRUM_MIN_FREQ) / log_span);
+            MoveToEx(memDC, x, plot_top, NULL);
+            LineTo(memDC, x, plot_bottom);
+            if (grid_freqs[i] >= 1000) {
+                snprintf(label, sizeof(label), "%gk", grid_freqs[i] / 1000);
+            } else {
+                snprintf(label, sizeof(label), "%g", grid_freqs[i]);
+            }
+            TextOut(memDC, x - 8, plot_bottom + 5, label, (int)strlen(label));
+        }
+
+        SelectObject(memDC, oldPen);
+    }
+
+    // Trace
+    POINT *points = gfx->points;
+    int bins = 0;
+    int fft_size = 0;
+    unsigned long spectra = 0;
+    unsigned long long skipped = 0;
+
+    if (plot_width > 0 && g_app.audio.is_recording) {
+        EnterCriticalSection(&an->view.lock);
+        bins = an->view.bins;
+        fft_size = an->view.fft_size;
+        spectra = an->view.spectra;
+        skipped = an->view.skipped;
+
+        if (bins > 0) {
+            double bins_per_hz = (double)fft_size / sample_rate;
+            for (int x = 0; x < plot_width; x++) {
+                double f0 = SPECTRUM_MIN_FREQ * pow(10.0, log_span * x / plot_width);
+                double f1 = SPECTRUM_MIN_FREQ * pow(10.0, log_span * (x + 1) / plot_width);
+                float level = SpectrumPixelDb(an->view.db, bins, f0 * bins_per_hz, f1 * bins_per_hz);
+
+                if (level > 0.0f) level = 0.0f;
+                if (level < SPECTRUM_MIN_DB) level = (float)SPECTRUM_MIN_DB;
+
+                points[x].x = plot_left + x;
+                points[x].y = plot_top + (int)(plot_height * level / SPECTRUM_MIN_DB);
+            }
+        }
+        LeaveCriticalSection(&an->view.lock);
+
+        if (bins > 0) {
+            HPEN oldPen = SelectObject(memDC, gfx->trace_pen);
+            Polyline(memDC, points, plot_width);
+            SelectObject(memDC, oldPen);
+        }
+    }
+
+    // Draw status text
+    char status[256];
+    if (g_app.audio.is_recording && bins > 0) {
+        int avg = atomic_load(&an->averaging);
+        snprintf(status, sizeof(status),
+                 "Spectrum: %d Hz, FFT %d (%.2f Hz/bin), averaging %s, %lu spectra, "
+                 "%lu skipped, %lu dropped",
+                 sample_rate, fft_size, (double)sample_rate / fft_size,
+                 g_averaging_names[avg], spectra, (unsigned long)skipped,
+                 (unsigned long)atomic_load(&an->dropped));
+    } else if (g_app.audio.is_recording) {
+        snprintf(status, sizeof(status), "Spectrum: waiting for first FFT...");
+    } else {
+        snprintf(status, sizeof(status), "Stopped - Press Start to begin recording");
+    }
+
+    RECT textRect = {GRAPH_MARGIN, 10, width - GRAPH_MARGIN, 30};
+    DrawText(memDC, status, -1, &textRect, DT_LEFT | DT_VCENTER);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		DrawGraph
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Draws the currently selected view into the persistent back buffer
+//	  and copies it to the screen
+//------------------------------------------------------------------------------
+static void DrawGraph(HDC hdc, RECT *rect)
+{
+    int width = rect->right - rect->left;
+    int height = rect->bottom - rect->top;
+
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    HDC memDC = Graph_Prepare(&g_app.gfx, hdc, width, height);
+    if (!memDC) {
+        return;
+    }
+
+    // Clear background
+    RECT area = {0, 0, width, height};
+    FillRect(memDC, &area, g_app.gfx.bg_brush);
+
+    SetBkMode(memDC, TRANSPARENT);
+    SetTextColor(memDC, RGB(200, 200, 200));
+
+    if (g_app.view_mode == VIEW_SPECTRUM) {
+        DrawSpectrum(memDC, width, height);
+    } else {
+        DrawWaveform(memDC, width, height);
+    }
 
     // Copy to screen
     BitBlt(hdc, 0, 0, width, height, memDC, 0, 0, SRCCOPY);
-
-    // Cleanup
-    SelectObject(memDC, oldBitmap);
-    DeleteObject(memBitmap);
-    DeleteDC(memDC);
 }
 
 //------------------------------------------------------------------------------
@@ -527,7 +1372,7 @@ static void DrawWaveform(HDC hdc, RECT *rect)
 //	Detailed description:
 //	- Updates time window from edit control
 //	- Validates and clamps value
-//	- Reallocates circular buffer if needed
+//	- Resizes the waveform pyramid if needed
 //------------------------------------------------------------------------------
 static void UpdateTimeWindow(void)
 {
@@ -536,17 +1381,18 @@ static void UpdateTimeWindow(void)
 
     float new_window = (float)atof(text);
     if (new_window < 0.1f) new_window = 0.1f;
-    if (new_window > 10.0f) new_window = 10.0f;
+    if (new_window > MAX_TIME_WINDOW) new_window = (float)MAX_TIME_WINDOW;
 
     if (fabs(new_window - g_app.time_window) > 0.01f) {
         g_app.time_window = new_window;
 
-        // Update buffer size
-        size_t new_size = (size_t)(g_app.audio.sample_rate * new_window * 2); // stereo
-        if (g_app.audio.buffer.data) {
-            CircularBuffer_Destroy(&g_app.audio.buffer);
+        // The ring already covers MAX_TIME_WINDOW; resize the pyramid and
+        // refold what the ring still holds
+        if (g_app.audio.is_recording) {
+            Pyramid_Configure(&g_app.audio.pyramid,
+                              (size_t)(g_app.audio.sample_rate * new_window), g_app.audio.channels);
+            g_app.audio.folded = 0;
         }
-        CircularBuffer_Init(&g_app.audio.buffer, new_size);
     }
 }
 
@@ -574,6 +1420,16 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
             g_app.input_combo = CreateWindow("COMBOBOX", "",
                                             WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST | WS_VSCROLL,
                                             120, y_pos, 400, 200, hwnd, (HMENU)ID_INPUT_DEVICE, NULL, NULL);
+
+            // View selection
+            CreateWindow("STATIC", "View:", WS_VISIBLE | WS_CHILD,
+                        540, y_pos, 90, 20, hwnd, NULL, NULL, NULL);
+            g_app.view_combo = CreateWindow("COMBOBOX", "",
+                                           WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST,
+                                           640, y_pos, 120, 200, hwnd, (HMENU)ID_VIEW_MODE, NULL, NULL);
+            SendMessage(g_app.view_combo, CB_ADDSTRING, 0, (LPARAM)"Waveform");
+            SendMessage(g_app.view_combo, CB_ADDSTRING, 0, (LPARAM)"Spectrum");
+            SendMessage(g_app.view_combo, CB_SETCURSEL, VIEW_WAVEFORM, 0);
             y_pos += 30;
 
             // Output device label and combo
@@ -582,6 +1438,19 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
             g_app.output_combo = CreateWindow("COMBOBOX", "",
                                              WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST | WS_VSCROLL,
                                              120, y_pos, 400, 200, hwnd, (HMENU)ID_OUTPUT_DEVICE, NULL, NULL);
+
+            // Sample rate (applied on Start)
+            CreateWindow("STATIC", "Sample Rate:", WS_VISIBLE | WS_CHILD,
+                        540, y_pos, 90, 20, hwnd, NULL, NULL, NULL);
+            g_app.rate_combo = CreateWindow("COMBOBOX", "",
+                                           WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST,
+                                           640, y_pos, 120, 200, hwnd, (HMENU)ID_SAMPLE_RATE, NULL, NULL);
+            for (size_t i = 0; i < sizeof(g_sample_rates) / sizeof(g_sample_rates[0]); i++) {
+                char rate_str[16];
+                snprintf(rate_str, sizeof(rate_str), "%d Hz", g_sample_rates[i]);
+                SendMessage(g_app.rate_combo, CB_ADDSTRING, 0, (LPARAM)rate_str);
+            }
+            SendMessage(g_app.rate_combo, CB_SETCURSEL, DEFAULT_RATE_INDEX, 0);
             y_pos += 30;
 
             // Channel selection
@@ -602,12 +1471,36 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
             g_app.time_window_edit = CreateWindow("EDIT", "0.5",
                                                   WS_VISIBLE | WS_CHILD | WS_BORDER | ES_LEFT,
                                                   420, y_pos, 100, 20, hwnd, (HMENU)ID_TIME_WINDOW, NULL, NULL);
+
+            // FFT size
+            CreateWindow("STATIC", "FFT Size:", WS_VISIBLE | WS_CHILD,
+                        540, y_pos, 90, 20, hwnd, NULL, NULL, NULL);
+            g_app.fft_combo = CreateWindow("COMBOBOX", "",
+                                          WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST,
+                                          640, y_pos, 120, 200, hwnd, (HMENU)ID_FFT_SIZE, NULL, NULL);
+            for (size_t i = 0; i < sizeof(g_fft_sizes) / sizeof(g_fft_sizes[0]); i++) {
+                char size_str[16];
+                snprintf(size_str, sizeof(size_str), "%d", g_fft_sizes[i]);
+                SendMessage(g_app.fft_combo, CB_ADDSTRING, 0, (LPARAM)size_str);
+            }
+            SendMessage(g_app.fft_combo, CB_SETCURSEL, DEFAULT_FFT_INDEX, 0);
             y_pos += 30;
 
             // Start/Stop button
             g_app.start_button = CreateWindow("BUTTON", "Start",
                                              WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
                                              10, y_pos, 100, 30, hwnd, (HMENU)ID_START_STOP, NULL, NULL);
+
+            // Spectrum averaging
+            CreateWindow("STATIC", "Averaging:", WS_VISIBLE | WS_CHILD,
+                        540, y_pos, 90, 20, hwnd, NULL, NULL, NULL);
+            g_app.averaging_combo = CreateWindow("COMBOBOX", "",
+                                                WS_VISIBLE | WS_CHILD | CBS_DROPDOWNLIST,
+                                                640, y_pos, 120, 200, hwnd, (HMENU)ID_AVERAGING, NULL, NULL);
+            for (size_t i = 0; i < sizeof(g_averaging_names) / sizeof(g_averaging_names[0]); i++) {
+                SendMessage(g_app.averaging_combo, CB_ADDSTRING, 0, (LPARAM)g_averaging_names[i]);
+            }
+            SendMessage(g_app.averaging_combo, CB_SETCURSEL, DEFAULT_AVERAGING, 0);
             y_pos += 40;
 
             // Graph area (custom painting)
@@ -626,10 +1519,17 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
             // Populate device lists
             PopulateDeviceList();
 
-            // Initialize circular buffer
+            // Waveform ring and pyramid are sized when capture starts
             g_app.audio.sample_rate = DEFAULT_SAMPLE_RATE;
-            size_t buffer_size = (size_t)(DEFAULT_SAMPLE_RATE * DEFAULT_TIME_WINDOW * 2); // stereo
-            CircularBuffer_Init(&g_app.audio.buffer, buffer_size);
+
+            // Pens, brushes and back buffer are kept for the life of the window
+            Graph_Init(&g_app.gfx);
+
+            // Initialize spectrum analyzer settings (thread starts with capture)
+            InitializeCriticalSection(&g_app.audio.analyzer.view.lock);
+            atomic_init(&g_app.audio.analyzer.fft_size, g_fft_sizes[DEFAULT_FFT_INDEX]);
+            atomic_init(&g_app.audio.analyzer.averaging, DEFAULT_AVERAGING);
+            atomic_init(&g_app.audio.analyzer.channel_mode, CHANNEL_LEFT);
 
             // Set timer for updating display
             SetTimer(hwnd, ID_TIMER, 33, NULL); // ~30 FPS
@@ -644,7 +1544,9 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
                 int sel = SendMessage(g_app.input_combo, CB_GETCURSEL, 0, 0);
                 if (sel != CB_ERR) {
                     int device_index = SendMessage(g_app.input_combo, CB_GETITEMDATA, sel, 0);
-                    if (StartAudioCapture(device_index)) {
+                    int rate_sel = SendMessage(g_app.rate_combo, CB_GETCURSEL, 0, 0);
+                    int sample_rate = g_sample_rates[(rate_sel == CB_ERR) ? DEFAULT_RATE_INDEX : rate_sel];
+                    if (StartAudioCapture(device_index, sample_rate)) {
                         SetWindowText(g_app.start_button, "Stop");
                     }
                 }
@@ -658,6 +1560,33 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
             if (HIWORD(wParam) == CBN_SELCHANGE) {
                 int sel = SendMessage(g_app.channel_combo, CB_GETCURSEL, 0, 0);
                 g_app.channel_mode = (ChannelMode)sel;
+                atomic_store(&g_app.audio.analyzer.channel_mode, sel);
+            }
+            break;
+
+        case ID_VIEW_MODE:
+            if (HIWORD(wParam) == CBN_SELCHANGE) {
+                int sel = SendMessage(g_app.view_combo, CB_GETCURSEL, 0, 0);
+                g_app.view_mode = (ViewMode)sel;
+                InvalidateRect(g_app.graph_area, NULL, FALSE);
+            }
+            break;
+
+        case ID_FFT_SIZE:
+            if (HIWORD(wParam) == CBN_SELCHANGE) {
+                int sel = SendMessage(g_app.fft_combo, CB_GETCURSEL, 0, 0);
+                if (sel != CB_ERR) {
+                    atomic_store(&g_app.audio.analyzer.fft_size, g_fft_sizes[sel]);
+                }
+            }
+            break;
+
+        case ID_AVERAGING:
+            if (HIWORD(wParam) == CBN_SELCHANGE) {
+                int sel = SendMessage(g_app.averaging_combo, CB_GETCURSEL, 0, 0);
+                if (sel != CB_ERR) {
+                    atomic_store(&g_app.audio.analyzer.averaging, sel);
+                }
             }
             break;
 
@@ -671,7 +1600,8 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
 
     case WM_TIMER:
         if (wParam == ID_TIMER) {
-            // Redraw graph area
+            // Take new samples from the callback, then redraw graph area
+            UpdateWaveform();
             InvalidateRect(g_app.graph_area, NULL, FALSE);
         }
         return 0;
@@ -680,7 +1610,7 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
         {
             LPDRAWITEMSTRUCT pDIS = (LPDRAWITEMSTRUCT)lParam;
             if (pDIS->hwndItem == g_app.graph_area) {
-                DrawWaveform(pDIS->hDC, &pDIS->rcItem);
+                DrawGraph(pDIS->hDC, &pDIS->rcItem);
             }
         }
         return TRUE;
@@ -697,7 +1627,7 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
                 MapWindowPoints(g_app.graph_area, hwnd, (POINT*)&rect, 2);
 
                 HDC graphDC = GetDC(g_app.graph_area);
-                DrawWaveform(graphDC, &rect);
+                DrawGraph(graphDC, &rect);
                 ReleaseDC(g_app.graph_area, graphDC);
             }
 
@@ -708,7 +1638,11 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
     case WM_DESTROY:
         KillTimer(hwnd, ID_TIMER);
         StopAudioCapture();
-        CircularBuffer_Destroy(&g_app.audio.buffer);
+        ab_ring_destroy(g_app.audio.ring);
+        Pyramid_Free(&g_app.audio.pyramid);
+        Graph_Destroy(&g_app.gfx);
+        free(g_app.audio.analyzer.view.db);
+        DeleteCriticalSection(&g_app.audio.analyzer.view.lock);
         Pa_Terminate();
         PostQuitMessage(0);
         return 0;
@@ -724,10 +1658,14 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
 //	- Creates Windows GUI for real-time audio visualization
 //	- Captures audio from selected input device using PortAudio
 //	- Displays waveform with configurable time window
+//	- Displays a real-time spectrum (RTA): windowed FFTs of 4K-64K points
+//	  computed on a worker thread fed by a lock-free ring, exponentially
+//	  averaged, plotted on a log frequency axis
 //	- Supports channel selection (Left, Right, Stereo, Combined)
 //
 //	Libraries:
 //	- PortAudio: Audio device access and recording
+//	- FFTW3 (single precision): Spectrum analysis
 //	- Win32 API: GUI and graphics
 //------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_cbstats.c
+//
+//	Audio callback instrumentation; see ab_cbstats.h.
+//------------------------------------------------------------------------------
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "ab_cbstats.h"
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_now
+//
+//	Returns:	monotonic time in seconds (arbitrary origin)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere; both
+//	  are cheap enough to call twice per callback
+//------------------------------------------------------------------------------
+double ab_cbstats_now(void)
+{
+#ifdef _WIN32
+    static double period = 0.0;
+    LARGE_INTEGER count;
+
+    if (period == 0.0) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        period = 1.0 / (double)frequency.QuadPart;
+    }
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * period;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_init
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_cbstats_init(AbCbStats *stats, double sample_rate)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->sample_rate = sample_rate;
+    stats->last_time = -1.0;
+    stats->next_position = -1;
+    ab_cbstats_now();											//	Latch the Windows counter period outside the callback
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_record
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Records one callback of 'frames' frames that ran from 'start' to
+//	  'end' (ab_cbstats_now() readings)
+//	- 'timestamp' is the driver's time for this buffer in seconds (ASIO
+//	  system time, PortAudio currentTime); pass a negative value when the
+//	  driver gives none and 'start' is used instead
+//------------------------------------------------------------------------------
+void ab_cbstats_record(AbCbStats *stats, size_t frames, double timestamp, double start, double end)
+{
+    double duration = end - start;
+    double budget = (double)frames / stats->sample_rate;
+
+    if (timestamp < 0.0) {
+        timestamp = start;
+    }
+
+    if (stats->callbacks == 0 || duration < stats->duration_min) {
+        stats->duration_min = duration;
+    }
+    if (duration > stats->duration_max) {
+        stats->duration_max = duration;
+    }
+    stats->duration_sum += duration;
+    stats->callbacks++;
+    stats->frames += frames;
+
+    if (budget > 0.0) {
+        double load = duration / budget;
+        int bin = (int)(load * 100.0 / AB_CBSTATS_STEP_PCT);
+        if (bin >= AB_CBSTATS_BINS - 1) {
+            bin = AB_CBSTATS_BINS - 1;
+        }
+        if (bin < 0) {
+            bin = 0;
+        }
+        stats->histogram[bin]++;
+        if (load >= 1.0) {
+            stats->over_budget++;
+        }
+        if (load > stats->load_max) {
+            stats->load_max = load;
+        }
+    }
+
+//------------------------------------------------------------------------------
+//	Arrival jitter against the previous buffer's length
+//------------------------------------------------------------------------------
+    if (stats->last_time >= 0.0) {
+        double jitter = fabs(timestamp - stats->last_time - stats->last_budget);
+        stats->jitter_sum += jitter;
+        stats->jitter_squares += jitter * jitter;
+        if (jitter > stats->jitter_max) {
+            stats->jitter_max = jitter;
+        }
+        stats->intervals++;
+    }
+    stats->last_time = timestamp;
+    stats->last_budget = budget;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_position
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Compares the driver's sample position for this buffer with the one
+//	  the previous buffer predicted; every whole buffer skipped counts as
+//	  an xrun
+//------------------------------------------------------------------------------
+void ab_cbstats_position(AbCbStats *stats, int64_t position, size_t frames)
+{
+    if (stats->next_position >= 0 && frames > 0 && position > stats->next_position) {
+        stats->xruns += (uint64_t)(position - stats->next_position) / frames;
+    }
+    stats->next_position = position + (int64_t)frames;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_xrun
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_cbstats_xrun(AbCbStats *stats, uint64_t count)
+{
+    stats->xruns += count;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_cbstats_write_json
+//
+//	Returns:	0 on success, -1 if the file cannot be written
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes one JSON object; times are in milliseconds, the histogram
+//	  holds AB_CBSTATS_BINS counts of AB_CBSTATS_STEP_PCT % of the budget
+//	  each, the last one counting every callback at or over budget
+//	- Nothing is printed, the caller reports the error
+//------------------------------------------------------------------------------
+int ab_cbstats_write_json(const AbCbStats *stats, const char *tool, const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    double calls = (stats->callbacks > 0) ? (double)stats->callbacks : 1.0;
+    double intervals = (stats->intervals > 0) ? (double)stats->intervals : 1.0;
+    double budget = (stats->frames > 0) ? (double)stats->frames / calls / stats->sample_rate : 0.0;
+    double mean = stats->duration_sum / calls;
+
+    if (!file) {
+        return -1;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"tool\": \"%s\",\n", tool);
+    fprintf(file, "  \"sample_rate\": %.0f,\n", stats->sample_rate);
+    fprintf(file, "  \"callbacks\": %llu,\n", (unsigned long long)stats->callbacks);
+    fprintf(file, "  \"frames\": %llu,\n", (unsigned long long)stats->frames);
+    fprintf(file, "  \"xruns\": %llu,\n", (unsigned long long)stats->xruns);
+    fprintf(file, "  \"budget_ms\": %.6f,\n", budget * 1e3);
+    fprintf(file, "  \"duration_ms\": {\"min\": %.6f, \"mean\": %.6f, \"max\": %.6f},\n",
+            stats->duration_min * 1e3, mean * 1e3, stats->duration_max * 1e3);
+    fprintf(file, "  \"load\": {\"mean\": %.4f, \"max\": %.4f},\n",
+            (budget > 0.0) ? mean / budget : 0.0, stats->load_max);
+    fprintf(file, "  \"over_budget\": %llu,\n", (unsigned long long)stats->over_budget);
+    fprintf(file, "  \"jitter_ms\": {\"mean\": %.6f, \"rms\": %.6f, \"max\": %.6f},\n",
+            stats->jitter_sum / intervals * 1e3,
+            sqrt(stats->jitter_squares / intervals) * 1e3, stats->jitter_max * 1e3);
+    fprintf(file, "  \"histogram_step_pct\": %d,\n", AB_CBSTATS_STEP_PCT);
+    fprintf(file, "  \"histogram\": [");
+    for (int i = 0; i < AB_CBSTATS_BINS; i++) {
+        fprintf(file, "%s%llu", (i > 0) ? ", " : "", (unsigned long long)stats->histogram[i]);
+    }
+    fprintf(file, "]\n}\n");
+
+    if (ferror(file)) {
+        fclose(file);
+        return -1;
+    }
+    return (fclose(file) == 0) ? 0 : -1;
+}
@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_cbstats.h
+//
+//	libaudiobench: audio callback instrumentation shared by the capture
+//	tools (ab_acq, ab_acq_asio, ab_asio_loopback, ab_freq_response_asio):
+//	- Callback duration against the buffer's time budget (frames / rate):
+//	  min / mean / max and a histogram in 5 % steps of the budget
+//	- Jitter: how far each callback's arrival strays from the previous
+//	  callback's time plus its buffer length, from the driver's timestamps
+//	- Xruns: buffers the host missed, from gaps in the driver's sample
+//	  position and from driver overflow / underflow reports
+//
+//	The block has a single writer, the callback, which only does integer
+//	and floating-point updates on it: no locks, no allocation, no I/O.
+//	Read it (ab_cbstats_write_json) once the stream has stopped. Events
+//	reported on other driver threads should be counted by the tool and
+//	added with ab_cbstats_xrun() after the stop.
+//------------------------------------------------------------------------------
+#ifndef AB_CBSTATS_H
+#define AB_CBSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AB_CBSTATS_STEP_PCT		5										//	Histogram bin width, % of the budget
+#define AB_CBSTATS_BINS			21										//	20 bins below the budget, the last at or over it
+
+typedef struct {
+    double sample_rate;
+    uint64_t callbacks;
+    uint64_t frames;
+    uint64_t xruns;												//	Missed buffers and driver over/underflows
+    uint64_t over_budget;										//	Callbacks that took longer than their buffer
+    double duration_min;										//	Seconds
+    double duration_max;
+    double duration_sum;
+    double load_max;											//	Largest duration / budget
+    uint64_t histogram[AB_CBSTATS_BINS];
+    double last_time;											//	Previous callback timestamp, < 0 before the first
+    double last_budget;											//	Previous callback's buffer length in seconds
+    uint64_t intervals;
+    double jitter_sum;											//	|interval - expected|, seconds
+    double jitter_squares;
+    double jitter_max;
+    int64_t next_position;										//	Expected driver sample position, < 0 unknown
+} AbCbStats;
+
+double ab_cbstats_now(void);
+void ab_cbstats_init(AbCbStats *stats, double sample_rate);
+
+//	Callback thread
+void ab_cbstats_record(AbCbStats *stats, size_t frames, double timestamp, double start, double end);
+void ab_cbstats_position(AbCbStats *stats, int64_t position, size_t frames);
+void ab_cbstats_xrun(AbCbStats *stats, uint64_t count);
+
+//	After the stream has stopped
+int ab_cbstats_write_json(const AbCbStats *stats, const char *tool, const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,6 +3,8 @@
  * 
  * Simple utility to measure and compare levels of two audio files.
  * Useful for characterizing audio interface input/output levels.
+ * Files are read in fixed-size blocks, so multi-GB captures need no more
+ * memory than short ones.
  *
  * Compile: gcc -o check_levels check_levels.c -lsndfile -lm
  */
@@ -12,6 +14,18 @@
 #include <string.h>
 #include <math.h>
 #include <sndfile.h>
+#include "ab_simd.h"
+
+#define BUFFER_FRAMES 16384   // Frames per sf_readf_double() call
+
+typedef struct {
+    double peak_pos;      // Maximum positive sample
+    double peak_neg;      // Maximum negative sample (absolute value)
+    double peak_dbfs;     // Peak level in dBFS
+    double rms;           // RMS level (linear)
+    double rms_dbfs;      // RMS level in dBFS
+    double crest_factor;  // Peak/RMS ratio in dB
+} ChannelStats;
 
 typedef struct {
     double peak_pos;      // Maximum positive sample
@@ -23,12 +37,22 @@ typedef struct {
     size_t samples;
     int sample_rate;
     int channels;
+    ChannelStats *channel; // Per-channel statistics [channels]
 } LevelStats;
 
+// Free per-channel statistics
+void free_stats(LevelStats *stats) {
+    free(stats->channel);
+    stats->channel = NULL;
+}
+
 // Calculate statistics for an audio file
+// Reads the file in BUFFER_FRAMES blocks, so memory use does not depend on
+// the file length; statistics are kept per channel and combined at the end
 int calculate_levels(const char *filename, LevelStats *stats) {
     SF_INFO sf_info;
     memset(&sf_info, 0, sizeof(SF_INFO));
+    memset(stats, 0, sizeof(LevelStats));
     
     SNDFILE *sf = sf_open(filename, SFM_READ, &sf_info);
     if (!sf) {
@@ -36,51 +60,68 @@ int calculate_levels(const char *filename, LevelStats *stats) {
         return -1;
     }
     
-    stats->samples = sf_info.frames;
     stats->sample_rate = sf_info.samplerate;
     stats->channels = sf_info.channels;
     
-    // Read all samples
-    size_t total_samples = sf_info.frames * sf_info.channels;
-    double *buffer = (double *)malloc(total_samples * sizeof(double));
-    if (!buffer) {
+    // One block buffer plus per-channel accumulators
+    double *buffer = (double *)malloc((size_t)BUFFER_FRAMES * sf_info.channels * sizeof(double));
+    double *ch_max = (double *)calloc(sf_info.channels, sizeof(double));
+    double *ch_min = (double *)calloc(sf_info.channels, sizeof(double));
+    double *ch_sum_sq = (double *)calloc(sf_info.channels, sizeof(double));
+    stats->channel = (ChannelStats *)calloc(sf_info.channels, sizeof(ChannelStats));
+    if (!buffer || !ch_max || !ch_min || !ch_sum_sq || !stats->channel) {
         fprintf(stderr, "Memory allocation failed\n");
+        free(buffer);
+        free(ch_max);
+        free(ch_min);
+        free(ch_sum_sq);
+        free_stats(stats);
         sf_close(sf);
         return -1;
     }
     
-    sf_read_double(sf, buffer, total_samples);
+    // Stream through the file
+    sf_count_t frames_read;
+    while ((frames_read = sf_readf_double(sf, buffer, BUFFER_FRAMES)) > 0) {
+        ab_simd_level_stats(buffer, (size_t)frames_read, sf_info.channels, ch_max, ch_min, ch_sum_sq);
+        stats->samples += (size_t)frames_read;
+    }
     sf_close(sf);
+    free(buffer);
     
-    // Calculate statistics
+    // Per-channel and overall statistics
+    double sum_sq = 0.0;
     stats->peak_pos = 0.0;
     stats->peak_neg = 0.0;
-    double sum_sq = 0.0;
     
-    for (size_t i = 0; i < total_samples; i++) {
-        double sample = buffer[i];
+    for (int ch = 0; ch < sf_info.channels; ch++) {
+        ChannelStats *c = &stats->channel[ch];
+        c->peak_pos = ch_max[ch];
+        c->peak_neg = fabs(ch_min[ch]);
+        double peak = (c->peak_pos > c->peak_neg) ? c->peak_pos : c->peak_neg;
+        c->peak_dbfs = 20.0 * log10(peak);
+        c->rms = sqrt(ch_sum_sq[ch] / stats->samples);
+        c->rms_dbfs = 20.0 * log10(c->rms);
+        c->crest_factor = c->peak_dbfs - c->rms_dbfs;
         
-        if (sample > stats->peak_pos) {
-            stats->peak_pos = sample;
+        if (c->peak_pos > stats->peak_pos) {
+            stats->peak_pos = c->peak_pos;
         }
-        if (sample < stats->peak_neg) {
-            stats->peak_neg = sample;
+        if (c->peak_neg > stats->peak_neg) {
+            stats->peak_neg = c->peak_neg;
         }
-        
-        sum_sq += sample * sample;
+        sum_sq += ch_sum_sq[ch];
     }
-    
-    free(buffer);
-    
-    // Convert to absolute value for negative peak
-    stats->peak_neg = fabs(stats->peak_neg);
+    free(ch_max);
+    free(ch_min);
+    free(ch_sum_sq);
     
     // Overall peak
     double peak = (stats->peak_pos > stats->peak_neg) ? stats->peak_pos : stats->peak_neg;
     stats->peak_dbfs = 20.0 * log10(peak);
     
-    // RMS
-    stats->rms = sqrt(sum_sq / total_samples);
+    // RMS over all channels
+    stats->rms = sqrt(sum_sq / ((double)stats->samples * stats->channels));
     stats->rms_dbfs = 20.0 * log10(stats->rms);
     
     // Crest factor
@@ -100,6 +141,15 @@ void print_stats(const char *label, LevelStats *stats) {
     printf("RMS level:     %.2f dBFS (%.6f linear)\n", 
            stats->rms_dbfs, stats->rms);
     printf("Crest factor:  %.2f dB\n", stats->crest_factor);
+    
+    if (stats->channels > 1) {
+        printf("\n  Channel  Peak (dBFS)  RMS (dBFS)  Crest (dB)\n");
+        for (int ch = 0; ch < stats->channels; ch++) {
+            ChannelStats *c = &stats->channel[ch];
+            printf("  %7d  %11.2f  %10.2f  %10.2f\n",
+                   ch + 1, c->peak_dbfs, c->rms_dbfs, c->crest_factor);
+        }
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -112,6 +162,7 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         print_stats(argv[1], &stats);
+        free_stats(&stats);
         
     } else if (argc == 3) {
         // Comparison mode (reference vs recorded)
@@ -121,11 +172,14 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         if (calculate_levels(argv[2], &rec_stats) != 0) {
+            free_stats(&ref_stats);
             return 1;
         }
         
         print_stats("Reference (Output)", &ref_stats);
         print_stats("Recorded (Input)", &rec_stats);
+        free_stats(&ref_stats);
+        free_stats(&rec_stats);
         
         // Calculate differences
         double peak_diff = rec_stats.peak_dbfs - ref_stats.peak_dbfs;
@@ -0,0 +1,399 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_core.c
+//
+//	libaudiobench kernels; see ab_core.h. The downmix and integer-to-float
+//	paths give the same results as the scalar loops they replace (sums are
+//	taken in channel order and the scale factors are powers of two).
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_core.h"
+#include "ab_simd.h"
+
+#define READ_BLOCK_SAMPLES		8192									//	Stack block used by ab_read_mono()
+
+//------------------------------------------------------------------------------
+//	Name:		ab_downmix_mono
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- mono[i] = average of the channels of frame i
+//	- mono may be the same array as interleaved (in-place downmix): frame i
+//	  is read before mono[i] is written and i <= i * channels
+//------------------------------------------------------------------------------
+void ab_downmix_mono(const double *interleaved, size_t frames, int channels, double *mono)
+{
+    size_t i = 0;
+
+    if (channels == 1) {
+        if (mono != interleaved) {
+            memmove(mono, interleaved, frames * sizeof(double));
+        }
+        return;
+    }
+
+#ifdef AB_SIMD_SSE2
+    if (channels == 2) {
+        const __m128d half = _mm_set1_pd(0.5);
+        for (; i + 2 <= frames; i += 2) {
+            __m128d f0 = _mm_loadu_pd(interleaved + 2 * i);					//	l0 r0
+            __m128d f1 = _mm_loadu_pd(interleaved + 2 * i + 2);				//	l1 r1
+            __m128d sum = _mm_add_pd(_mm_unpacklo_pd(f0, f1), _mm_unpackhi_pd(f0, f1));
+            _mm_storeu_pd(mono + i, _mm_mul_pd(sum, half));
+        }
+    }
+#endif
+    for (; i < frames; i++) {
+        const double *frame = interleaved + i * channels;
+        double sum = 0.0;
+        for (int ch = 0; ch < channels; ch++) {
+            sum += frame[ch];
+        }
+        mono[i] = sum / channels;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_sum_squares
+//
+//	Returns:	sum of samples[i]^2
+//
+//------------------------------------------------------------------------------
+double ab_sum_squares(const double *samples, size_t count)
+{
+    double sum = 0.0;
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m128d a = _mm_loadu_pd(samples + i);
+        __m128d b = _mm_loadu_pd(samples + i + 2);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(a, a));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(b, b));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < count; i++) {
+        sum += samples[i] * samples[i];
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_rms
+//
+//	Returns:	RMS of the samples (0 for an empty array)
+//
+//------------------------------------------------------------------------------
+double ab_rms(const double *samples, size_t count)
+{
+    return (count > 0) ? sqrt(ab_sum_squares(samples, count) / count) : 0.0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_int16_to_float
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_int16_to_float(const int16_t *src, float *dst, size_t count)
+{
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);			//	Sign extend
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = src[i] / 32768.0f;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_int24_to_float
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Packed 3-byte little-endian samples; each is placed in the top of a
+//	  32-bit word so the sign comes for free
+//------------------------------------------------------------------------------
+void ab_int24_to_float(const uint8_t *src, float *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        int32_t s32 = (int32_t)(((uint32_t)src[i*3] << 8) | ((uint32_t)src[i*3+1] << 16) |
+                                ((uint32_t)src[i*3+2] << 24));
+        dst[i] = (s32 >> 8) / 8388608.0f;										//	2^23
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_int32_to_float
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_int32_to_float(const int32_t *src, float *dst, size_t count)
+{
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = src[i] / 2147483648.0f;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_float_to_int16
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Clips to [-1, 1], scales by 32767 and truncates toward zero
+//------------------------------------------------------------------------------
+void ab_float_to_int16(const float *src, int16_t *dst, size_t count)
+{
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), one), minus_one);
+        __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 4), one), minus_one);
+        __m128i ia = _mm_cvttps_epi32(_mm_mul_ps(a, scale));
+        __m128i ib = _mm_cvttps_epi32(_mm_mul_ps(b, scale));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(ia, ib));
+    }
+#endif
+    for (; i < count; i++) {
+        float sample = src[i];
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        dst[i] = (int16_t)(sample * 32767.0f);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_float_to_int24
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Clips to [-1, 1], scales by 2^23 - 1 and packs 3 bytes, LSB first
+//------------------------------------------------------------------------------
+void ab_float_to_int24(const float *src, uint8_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        float sample = src[i];
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        int32_t s24 = (int32_t)(sample * 8388607.0f);
+        dst[i*3] = (uint8_t)(s24 & 0xFF);
+        dst[i*3+1] = (uint8_t)((s24 >> 8) & 0xFF);
+        dst[i*3+2] = (uint8_t)((s24 >> 16) & 0xFF);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_float_to_int32
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Clips to [-1, 1] and scales by 2^31 - 1. In float that product rounds
+//	  to 2^31, which does not fit, so full scale is capped at the largest
+//	  float below 2^31
+//------------------------------------------------------------------------------
+#define INT32_FLOAT_MAX		2147483520.0f
+
+void ab_float_to_int32(const float *src, int32_t *dst, size_t count)
+{
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(2147483647.0f);
+    const __m128 top = _mm_set1_ps(INT32_FLOAT_MAX);
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), one), minus_one);
+        a = _mm_min_ps(_mm_mul_ps(a, scale), top);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_cvttps_epi32(a));
+    }
+#endif
+    for (; i < count; i++) {
+        float sample = src[i];
+        if (sample > 1.0f) sample = 1.0f;
+        if (sample < -1.0f) sample = -1.0f;
+        sample *= 2147483647.0f;
+        if (sample > INT32_FLOAT_MAX) sample = INT32_FLOAT_MAX;
+        dst[i] = (int32_t)sample;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_bit_depth
+//
+//	Returns:	bit depth of a libsndfile format (32 for float, 64 for
+//				double), 0 if unknown
+//
+//------------------------------------------------------------------------------
+int ab_bit_depth(int format)
+{
+    switch (format & SF_FORMAT_SUBMASK) {
+    case SF_FORMAT_PCM_S8:
+    case SF_FORMAT_PCM_U8:
+        return 8;
+    case SF_FORMAT_PCM_16:
+        return 16;
+    case SF_FORMAT_PCM_24:
+        return 24;
+    case SF_FORMAT_PCM_32:
+        return 32;
+    case SF_FORMAT_FLOAT:
+        return 32;
+    case SF_FORMAT_DOUBLE:
+        return 64;
+    default:
+        return 0;																//	Unknown
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_read_mono
+//
+//	Returns:	number of frames read into dst
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reads up to 'frames' frames from the current position, averaging the
+//	  channels to mono
+//	- Mono files are read straight into dst; multi-channel files go
+//	  through a fixed stack block, so no heap temporaries are needed
+//------------------------------------------------------------------------------
+sf_count_t ab_read_mono(SNDFILE *file, int channels, double *dst, sf_count_t frames)
+{
+    if (channels == 1) {
+        sf_count_t got = sf_readf_double(file, dst, frames);
+        return (got > 0) ? got : 0;
+    }
+
+    double block[READ_BLOCK_SAMPLES];
+    sf_count_t block_frames = READ_BLOCK_SAMPLES / channels;
+    sf_count_t total = 0;
+
+    if (block_frames < 1) {
+        return 0;																//	More channels than the block holds
+    }
+
+    while (total < frames) {
+        sf_count_t want = frames - total;
+        if (want > block_frames) {
+            want = block_frames;
+        }
+        sf_count_t got = sf_readf_double(file, block, want);
+        if (got <= 0) {
+            break;
+        }
+        ab_downmix_mono(block, (size_t)got, channels, dst + total);
+        total += got;
+        if (got < want) {
+            break;
+        }
+    }
+    return total;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_audio_load
+//
+//	Returns:	0 on success, -1 on error (message printed to stderr)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Loads a whole file as mono doubles; free with ab_audio_free()
+//------------------------------------------------------------------------------
+int ab_audio_load(const char *filename, AbAudio *audio)
+{
+    SF_INFO sf_info;
+    memset(&sf_info, 0, sizeof(sf_info));
+    memset(audio, 0, sizeof(*audio));
+
+    SNDFILE *sf = sf_open(filename, SFM_READ, &sf_info);
+    if (!sf) {
+        fprintf(stderr, "Error opening %s: %s\n", filename, sf_strerror(NULL));
+        return -1;
+    }
+
+    audio->sample_rate = sf_info.samplerate;
+    audio->channels = sf_info.channels;
+    audio->bit_depth = ab_bit_depth(sf_info.format);
+    audio->data = (double *)malloc((sf_info.frames > 0 ? sf_info.frames : 1) * sizeof(double));
+    if (!audio->data) {
+        fprintf(stderr, "Memory allocation failed\n");
+        sf_close(sf);
+        return -1;
+    }
+
+    audio->frames = (size_t)ab_read_mono(sf, sf_info.channels, audio->data, sf_info.frames);
+    sf_close(sf);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_audio_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_audio_free(AbAudio *audio)
+{
+    free(audio->data);
+    audio->data = NULL;
+    audio->frames = 0;
+}
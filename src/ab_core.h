@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_core.h
+//
+//	libaudiobench: sample kernels and file helpers shared by the command-line
+//	tools, the ASIO tools and anything that links lib/libaudiobench.a:
+//	- Mono downmix of interleaved frames (in place or into a separate buffer)
+//	- Sum of squares / RMS
+//	- Integer PCM <-> float conversion (16-bit, packed 24-bit, 32-bit)
+//	- Reading a file (or a range of it) as mono doubles
+//
+//	None of the kernels allocate; ab_read_mono() streams through a fixed
+//	stack block. Only ab_audio_load() allocates, once, for the result.
+//------------------------------------------------------------------------------
+#ifndef AB_CORE_H
+#define AB_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sndfile.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------------------------------------------------------
+//	Whole-file mono audio (ab_audio_load)
+//------------------------------------------------------------------------------
+typedef struct {
+    double *data;												//	Mono samples (channels averaged)
+    size_t frames;
+    int sample_rate;
+    int channels;												//	Channel count of the source file
+    int bit_depth;												//	Source depth, see ab_bit_depth()
+} AbAudio;
+
+//------------------------------------------------------------------------------
+//	Sample kernels
+//------------------------------------------------------------------------------
+void ab_downmix_mono(const double *interleaved, size_t frames, int channels, double *mono);
+double ab_sum_squares(const double *samples, size_t count);
+double ab_rms(const double *samples, size_t count);
+
+void ab_int16_to_float(const int16_t *src, float *dst, size_t count);
+void ab_int24_to_float(const uint8_t *src, float *dst, size_t count);
+void ab_int32_to_float(const int32_t *src, float *dst, size_t count);
+void ab_float_to_int16(const float *src, int16_t *dst, size_t count);
+void ab_float_to_int24(const float *src, uint8_t *dst, size_t count);
+void ab_float_to_int32(const float *src, int32_t *dst, size_t count);
+
+//------------------------------------------------------------------------------
+//	File helpers
+//------------------------------------------------------------------------------
+int ab_bit_depth(int format);
+sf_count_t ab_read_mono(SNDFILE *file, int channels, double *dst, sf_count_t frames);
+int ab_audio_load(const char *filename, AbAudio *audio);
+void ab_audio_free(AbAudio *audio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,289 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_devcache.c
+//
+//	Cached device inventory; see ab_devcache.h. The file is written to
+//	<path>.tmp and renamed over the old one, so a reader never sees half
+//	an inventory.
+//------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "ab_devcache.h"
+
+#define CACHE_MAGIC			"# audio-bench device inventory"
+#define CACHE_MAX_BYTES		(1 << 20)									//	Anything larger is not ours
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_hash
+//
+//	Returns:	hash extended with 'size' bytes of 'data' (FNV-1a 64-bit)
+//
+//------------------------------------------------------------------------------
+uint64_t ab_devcache_hash(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_hash_str
+//
+//	Returns:	hash extended with the string and its terminator
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- The terminator keeps ("ab", "c") and ("a", "bc") apart
+//	- NULL hashes like the empty string
+//------------------------------------------------------------------------------
+uint64_t ab_devcache_hash_str(uint64_t hash, const char *str)
+{
+    if (!str) {
+        str = "";
+    }
+    return ab_devcache_hash(hash, str, strlen(str) + 1);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_hash_registry
+//
+//	Returns:	hash extended with the subkey names under HKLM\path and, if
+//				'value' is given, each subkey's DWORD of that name
+//
+//------------------------------------------------------------------------------
+#ifdef _WIN32
+uint64_t ab_devcache_hash_registry(uint64_t hash, const char *path, const char *value)
+{
+    HKEY root;
+    char name[256];
+
+    if (RegOpenKeyExA(HKEY_LOCAL_MACHINE, path, 0, KEY_READ, &root) != ERROR_SUCCESS) {
+        return ab_devcache_hash_str(hash, path);
+    }
+    for (DWORD i = 0; ; i++) {
+        DWORD length = sizeof(name);
+        if (RegEnumKeyExA(root, i, name, &length, NULL, NULL, NULL, NULL) != ERROR_SUCCESS) {
+            break;
+        }
+        hash = ab_devcache_hash_str(hash, name);
+
+        HKEY sub;
+        DWORD state = 0;
+        DWORD size = sizeof(state);
+        if (value && RegOpenKeyExA(root, name, 0, KEY_READ, &sub) == ERROR_SUCCESS) {
+            RegQueryValueExA(sub, value, NULL, NULL, (BYTE *)&state, &size);
+            RegCloseKey(sub);
+            hash = ab_devcache_hash(hash, &state, sizeof(state));
+        }
+    }
+    RegCloseKey(root);
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_hash_endpoints
+//
+//	Returns:	hash extended with the MMDevices render and capture endpoints
+//				and each endpoint's DeviceState
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- DeviceState changes when an interface is plugged in or unplugged, so
+//	  a key that includes it goes stale with the hardware, not only with
+//	  the installed drivers
+//------------------------------------------------------------------------------
+uint64_t ab_devcache_hash_endpoints(uint64_t hash)
+{
+    hash = ab_devcache_hash_registry(hash, "SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\MMDevices\\Audio\\Render", "DeviceState");
+    return ab_devcache_hash_registry(hash, "SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\MMDevices\\Audio\\Capture", "DeviceState");
+}
+#endif
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_path
+//
+//	Returns:	1 if a cache path is known, 0 otherwise
+//
+//------------------------------------------------------------------------------
+int ab_devcache_path(const char *path, const char *file, char *dst, size_t size)
+{
+    if (path && *path) {
+        snprintf(dst, size, "%s", path);
+        return 1;
+    }
+
+#ifdef _WIN32
+    const char *home = getenv("USERPROFILE");
+    const char *sep = "\\";
+#else
+    const char *home = getenv("HOME");
+    const char *sep = "/";
+#endif
+    if (!home || !*home) {
+        dst[0] = '\0';
+        return 0;
+    }
+    snprintf(dst, size, "%s%s%s", home, sep, file);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_load
+//
+//	Returns:	the records (malloc'd, caller frees) if the cache exists and
+//				its key matches, NULL otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- *saved receives the time the cache was written
+//	- A missing, foreign or stale file is not an error: the caller probes
+//------------------------------------------------------------------------------
+char *ab_devcache_load(const char *path, uint64_t key, time_t *saved)
+{
+    FILE *file = fopen(path, "rb");
+    char line[256];
+    unsigned long long file_key = 0;
+    long long stamp = 0;
+
+    if (!file) {
+        return NULL;
+    }
+
+    if (!fgets(line, sizeof(line), file) || strncmp(line, CACHE_MAGIC, strlen(CACHE_MAGIC)) != 0 ||
+        !fgets(line, sizeof(line), file) || sscanf(line, "key %llx", &file_key) != 1 ||
+        !fgets(line, sizeof(line), file) || sscanf(line, "time %lld", &stamp) != 1 ||
+        (uint64_t)file_key != key) {
+        fclose(file);
+        return NULL;
+    }
+
+//------------------------------------------------------------------------------
+//	The rest of the file is the tool's records
+//------------------------------------------------------------------------------
+    long start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    if (start < 0 || end < start || end - start > CACHE_MAX_BYTES) {
+        fclose(file);
+        return NULL;
+    }
+    fseek(file, start, SEEK_SET);
+
+    size_t length = (size_t)(end - start);
+    char *records = (char *)malloc(length + 1);
+    if (!records || fread(records, 1, length, file) != length) {
+        free(records);
+        fclose(file);
+        return NULL;
+    }
+    records[length] = '\0';
+    fclose(file);
+
+    if (saved) {
+        *saved = (time_t)stamp;
+    }
+    return records;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_begin
+//
+//	Returns:	a stream for the records, NULL if <path>.tmp cannot be created
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes the header; the caller adds its records and then calls
+//	  ab_devcache_commit(), which closes the stream
+//------------------------------------------------------------------------------
+FILE *ab_devcache_begin(const char *path, uint64_t key)
+{
+    char temp[1100];
+    FILE *file;
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    file = fopen(temp, "wb");
+    if (!file) {
+        return NULL;
+    }
+    fprintf(file, "%s\nkey %016llx\ntime %lld\n", CACHE_MAGIC,
+            (unsigned long long)key, (long long)time(NULL));
+    return file;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_write_text
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes a free-text field (device or host API name) with tabs and line
+//	  breaks replaced by spaces, so records stay one tab-separated line
+//------------------------------------------------------------------------------
+void ab_devcache_write_text(FILE *file, const char *text)
+{
+    for (const char *p = text ? text : ""; *p; p++) {
+        fputc((*p == '\t' || *p == '\n' || *p == '\r') ? ' ' : *p, file);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_devcache_commit
+//
+//	Returns:	0 on success, -1 on error (the temporary file is removed)
+//
+//------------------------------------------------------------------------------
+int ab_devcache_commit(FILE *file, const char *path)
+{
+    char temp[1100];
+    int failed = ferror(file);
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    if (fclose(file) != 0) {
+        failed = 1;
+    }
+#ifdef _WIN32
+    if (!failed && !MoveFileExA(temp, path, MOVEFILE_REPLACE_EXISTING)) {
+        failed = 1;
+    }
+#else
+    if (!failed && rename(temp, path) != 0) {
+        failed = 1;
+    }
+#endif
+    if (failed) {
+        remove(temp);
+        return -1;
+    }
+    return 0;
+}
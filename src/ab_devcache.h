@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_devcache.h
+//
+//	libaudiobench: cached device inventory for ab_list_dev and
+//	ab_list_dev_asio, so scripts that resolve device indices before every
+//	measurement do not pay for a full driver / host-API scan each time.
+//
+//	The cache is a small text file:
+//		# audio-bench device inventory
+//		key <16 hex digits>
+//		time <seconds since 1970>
+//		<tool-defined records, one per line, tab-separated>
+//
+//	The key is a hash of whatever the tool can read cheaply that identifies
+//	the installed drivers / host APIs (driver names, CLSIDs, DLL paths and
+//	times) and the attached hardware (endpoint lists and their state): the
+//	cache is used only while the key matches, and the tool re-probes and
+//	rewrites it otherwise.
+//
+//	Path resolution, first match wins:
+//	- Path given with the tool's --cache option
+//	- Per-user file: $HOME/<file> (%USERPROFILE% on Windows)
+//------------------------------------------------------------------------------
+#ifndef AB_DEVCACHE_H
+#define AB_DEVCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AB_DEVCACHE_HASH_INIT	1469598103934665603ULL					//	FNV-1a 64-bit offset basis
+
+//	Identity key
+uint64_t ab_devcache_hash(uint64_t hash, const void *data, size_t size);
+uint64_t ab_devcache_hash_str(uint64_t hash, const char *str);
+#ifdef _WIN32
+uint64_t ab_devcache_hash_registry(uint64_t hash, const char *path, const char *value);
+uint64_t ab_devcache_hash_endpoints(uint64_t hash);
+#endif
+
+//	Cache file
+int ab_devcache_path(const char *path, const char *file, char *dst, size_t size);
+char *ab_devcache_load(const char *path, uint64_t key, time_t *saved);
+FILE *ab_devcache_begin(const char *path, uint64_t key);
+void ab_devcache_write_text(FILE *file, const char *text);
+int ab_devcache_commit(FILE *file, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_fft_plan.h
+//
+//	FFTW planner helpers shared by the FFT-based tools (C and C++):
+//	- Planner effort selection: estimate, measure, patient, exhaustive
+//	- Persistent FFTW wisdom, so plans measured once are reused on later runs
+//	- Precision selection (auto, float, double) for tools with an fftwf path
+//	- Transform sizes with only 2, 3 and 5 as factors (ab_fft_good_size)
+//
+//	Wisdom file location (first match wins):
+//	- Path given with the tool's --wisdom option
+//	- AB_FFTW_WISDOM environment variable (e.g. a per-install file)
+//	- Per-user file: $HOME/.ab_fftw_wisdom (%USERPROFILE% on Windows)
+//	Single precision (fftwf) wisdom is kept next to it with an 'f' appended,
+//	following FFTW's own wisdom/wisdomf convention.
+//
+//	Typical use:
+//		ab_fft_wisdom_load(wisdom_path);
+//		plan = fftw_plan_dft_r2c_1d(n, in, out, planner_flags);
+//		...
+//		ab_fft_wisdom_save(planner_flags);
+//
+//	The ab_fftwf_* variants do the same for fftwf plans; a tool that only
+//	calls the double versions does not need to link libfftw3f.
+//
+//	All functions are static inline so the header can be included by any
+//	single-file tool without an extra object to link.
+//------------------------------------------------------------------------------
+#ifndef AB_FFT_PLAN_H
+#define AB_FFT_PLAN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fftw3.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#define AB_GETPID()		_getpid()
+#else
+#include <unistd.h>
+#define AB_GETPID()		getpid()
+#endif
+
+#define AB_FFTW_WISDOM_ENV		"AB_FFTW_WISDOM"
+#define AB_FFTW_WISDOM_FILE		".ab_fftw_wisdom"
+
+#define AB_FFT_PRECISION_AUTO	0
+#define AB_FFT_PRECISION_FLOAT	1
+#define AB_FFT_PRECISION_DOUBLE	2
+
+static char ab_fft_wisdom_file[1024] = "";
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_parse_planner
+//
+//	Returns:	0 on success, -1 if the name is not recognised
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Maps "estimate", "measure", "patient" or "exhaustive" to FFTW flags
+//	- NULL selects FFTW_ESTIMATE (the historical default)
+//------------------------------------------------------------------------------
+static inline int ab_fft_parse_planner(const char *name, unsigned int *flags)
+{
+    if (!name || strcmp(name, "estimate") == 0) {
+        *flags = FFTW_ESTIMATE;
+    } else if (strcmp(name, "measure") == 0) {
+        *flags = FFTW_MEASURE;
+    } else if (strcmp(name, "patient") == 0) {
+        *flags = FFTW_PATIENT;
+    } else if (strcmp(name, "exhaustive") == 0) {
+        *flags = FFTW_EXHAUSTIVE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_planner_name
+//
+//	Returns:	printable name of the planner effort in flags
+//
+//------------------------------------------------------------------------------
+static inline const char *ab_fft_planner_name(unsigned int flags)
+{
+    if (flags & FFTW_ESTIMATE) return "estimate";
+    if (flags & FFTW_EXHAUSTIVE) return "exhaustive";
+    if (flags & FFTW_PATIENT) return "patient";
+    return "measure";
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_parse_precision
+//
+//	Returns:	0 on success, -1 if the name is not recognised
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Maps "auto", "float" or "double" to AB_FFT_PRECISION_*
+//	- NULL selects auto
+//------------------------------------------------------------------------------
+static inline int ab_fft_parse_precision(const char *name, int *precision)
+{
+    if (!name || strcmp(name, "auto") == 0) {
+        *precision = AB_FFT_PRECISION_AUTO;
+    } else if (strcmp(name, "float") == 0) {
+        *precision = AB_FFT_PRECISION_FLOAT;
+    } else if (strcmp(name, "double") == 0) {
+        *precision = AB_FFT_PRECISION_DOUBLE;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_use_float
+//
+//	Returns:	1 if the single precision path should be used, 0 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Auto picks float for 8, 16 and 24-bit integer sources: per-bin rounding
+//	  noise of a float FFT stays under the -48/-96/-144 dB floor the tools
+//	  already apply for those depths, at half the memory traffic
+//	- 32-bit integer and floating point sources (bit_depth 32 or 64) keep
+//	  double precision
+//------------------------------------------------------------------------------
+static inline int ab_fft_use_float(int precision, int bit_depth)
+{
+    if (precision != AB_FFT_PRECISION_AUTO) {
+        return precision == AB_FFT_PRECISION_FLOAT;
+    }
+    return bit_depth > 0 && bit_depth <= 24;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_good_size
+//
+//	Returns:	smallest n' >= n of the form 2^a * 3^b * 5^c
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- FFTW is about as fast on these sizes as on powers of two, and they are
+//	  dense enough that padding stays within a few percent, where rounding
+//	  up to a power of two can nearly double the buffers
+//------------------------------------------------------------------------------
+static inline size_t ab_fft_good_size(size_t n)
+{
+    if (n <= 1) {
+        return 1;
+    }
+    for (size_t m = n; ; m++) {
+        size_t r = m;
+        while (r % 2 == 0) r /= 2;
+        while (r % 3 == 0) r /= 3;
+        while (r % 5 == 0) r /= 5;
+        if (r == 1) {
+            return m;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_wisdom_resolve
+//
+//	Returns:	1 if a wisdom file path is known, 0 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Resolves the wisdom file path (see header comment) and remembers it for
+//	  ab_fft_wisdom_save()
+//------------------------------------------------------------------------------
+static inline int ab_fft_wisdom_resolve(const char *path)
+{
+    if (!path || !*path) {
+        path = getenv(AB_FFTW_WISDOM_ENV);
+    }
+
+    if (path && *path) {
+        snprintf(ab_fft_wisdom_file, sizeof(ab_fft_wisdom_file), "%s", path);
+    } else {
+#ifdef _WIN32
+        const char *home = getenv("USERPROFILE");
+        const char *sep = "\\";
+#else
+        const char *home = getenv("HOME");
+        const char *sep = "/";
+#endif
+        if (!home || !*home) {
+            ab_fft_wisdom_file[0] = '\0';
+            return 0;
+        }
+        snprintf(ab_fft_wisdom_file, sizeof(ab_fft_wisdom_file), "%s%s%s", home, sep, AB_FFTW_WISDOM_FILE);
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_wisdom_load
+//
+//	Returns:	1 if wisdom was imported, 0 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- A missing file is not an error; the first measured run creates it
+//	- FFTW uses wisdom for any plan of equal or lower planner effort, so even
+//	  the default estimate runs pick up plans measured earlier
+//------------------------------------------------------------------------------
+static inline int ab_fft_wisdom_load(const char *path)
+{
+    if (!ab_fft_wisdom_resolve(path)) {
+        return 0;
+    }
+    return fftw_import_wisdom_from_filename(ab_fft_wisdom_file) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fftwf_wisdom_load
+//
+//	Returns:	1 if single precision wisdom was imported, 0 otherwise
+//
+//------------------------------------------------------------------------------
+static inline int ab_fftwf_wisdom_load(const char *path)
+{
+    char float_file[1100];
+
+    if (!ab_fft_wisdom_resolve(path)) {
+        return 0;
+    }
+    snprintf(float_file, sizeof(float_file), "%sf", ab_fft_wisdom_file);
+    return fftwf_import_wisdom_from_filename(float_file) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_wisdom_write
+//
+//	Returns:	0 on success, -1 on write failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Re-imports the file first, so plans another process saved since this
+//	  one loaded are merged in rather than overwritten (concurrent report
+//	  jobs or --threads runs would otherwise keep only the last writer's)
+//	- Writes to a per-process temporary file and replaces the wisdom file
+//	  in one step (rename, or MoveFileEx on Windows), so concurrent batch
+//	  runs never see a half-written or missing wisdom file
+//	- import_wisdom / export_wisdom are fftw_import_wisdom_from_filename /
+//	  fftw_export_wisdom_to_filename or their fftwf twins
+//------------------------------------------------------------------------------
+static inline int ab_fft_wisdom_write(const char *wisdom_file, int (*import_wisdom)(const char *),
+                                      int (*export_wisdom)(const char *))
+{
+    char temp_file[1200];
+    snprintf(temp_file, sizeof(temp_file), "%s.%d.tmp", wisdom_file, (int)AB_GETPID());
+
+    import_wisdom(wisdom_file);												//	Missing file: nothing to merge
+    if (!export_wisdom(temp_file)) {
+        fprintf(stderr, "Warning: Could not write FFTW wisdom to '%s'\n", temp_file);
+        return -1;
+    }
+
+#ifdef _WIN32
+    if (!MoveFileExA(temp_file, wisdom_file, MOVEFILE_REPLACE_EXISTING)) {
+#else
+    if (rename(temp_file, wisdom_file) != 0) {
+#endif
+        fprintf(stderr, "Warning: Could not update FFTW wisdom file '%s'\n", wisdom_file);
+        remove(temp_file);
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fft_wisdom_save
+//
+//	Returns:	0 on success (or nothing to save), -1 on write failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Only saves after measured planning; estimate plans add no wisdom
+//------------------------------------------------------------------------------
+static inline int ab_fft_wisdom_save(unsigned int flags)
+{
+    if ((flags & FFTW_ESTIMATE) || !ab_fft_wisdom_file[0]) {
+        return 0;
+    }
+    return ab_fft_wisdom_write(ab_fft_wisdom_file, fftw_import_wisdom_from_filename,
+                               fftw_export_wisdom_to_filename);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_fftwf_wisdom_save
+//
+//	Returns:	0 on success (or nothing to save), -1 on write failure
+//
+//------------------------------------------------------------------------------
+static inline int ab_fftwf_wisdom_save(unsigned int flags)
+{
+    char float_file[1100];
+
+    if ((flags & FFTW_ESTIMATE) || !ab_fft_wisdom_file[0]) {
+        return 0;
+    }
+    snprintf(float_file, sizeof(float_file), "%sf", ab_fft_wisdom_file);
+    return ab_fft_wisdom_write(float_file, fftwf_import_wisdom_from_filename,
+                               fftwf_export_wisdom_to_filename);
+}
+
+#endif
@@ -28,90 +28,45 @@
 #include <complex.h>
 #include <sndfile.h>
 #include <fftw3.h>
+#include "ab_fft_plan.h"
+#include "ab_simd.h"
+#include "ab_core.h"
+#include "ab_window.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 #define MIN_MAG_DB -120.0
+#define MIN_BLOCK_SIZE 256
 
-typedef struct {
-    double *data;
-    size_t length;
-    int sample_rate;
-    int channels;
-} AudioBuffer;
+typedef AbAudio AudioBuffer;
 
-// Load audio file into buffer
+// Load audio file into buffer (mixed down to mono)
 int load_audio_file(const char *filename, AudioBuffer *buf) {
-    SF_INFO sf_info;
-    memset(&sf_info, 0, sizeof(SF_INFO));
-    
-    SNDFILE *sf = sf_open(filename, SFM_READ, &sf_info);
-    if (!sf) {
-        fprintf(stderr, "Error opening %s: %s\n", filename, sf_strerror(NULL));
+    if (ab_audio_load(filename, buf) != 0) {
         return -1;
     }
-    
-    buf->length = sf_info.frames;
-    buf->sample_rate = sf_info.samplerate;
-    buf->channels = sf_info.channels;
-    
-    // Allocate buffer for mono (we'll mix down if stereo)
-    buf->data = (double *)malloc(buf->length * sizeof(double));
-    if (!buf->data) {
-        fprintf(stderr, "Memory allocation failed\n");
-        sf_close(sf);
-        return -1;
+    if (buf->bit_depth == 0) {
+        buf->bit_depth = 32;    // Unknown subtypes are treated as 32-bit
     }
-    
-    if (sf_info.channels == 1) {
-        // Mono - read directly
-        sf_read_double(sf, buf->data, buf->length);
-    } else {
-        // Multi-channel - mix to mono
-        double *temp = (double *)malloc(buf->length * sf_info.channels * sizeof(double));
-        sf_read_double(sf, temp, buf->length * sf_info.channels);
-        
-        for (size_t i = 0; i < buf->length; i++) {
-            buf->data[i] = 0.0;
-            for (int ch = 0; ch < sf_info.channels; ch++) {
-                buf->data[i] += temp[i * sf_info.channels + ch];
-            }
-            buf->data[i] /= sf_info.channels;
-        }
-        free(temp);
-    }
-    
-    sf_close(sf);
     printf("Loaded %s: %zu samples, %d Hz, %d channel(s)\n", 
-           filename, buf->length, buf->sample_rate, sf_info.channels);
+           filename, buf->frames, buf->sample_rate, buf->channels);
     
     return 0;
 }
 
 // Free audio buffer
 void free_audio_buffer(AudioBuffer *buf) {
-    if (buf->data) {
-        free(buf->data);
-        buf->data = NULL;
-    }
-}
-
-// Calculate RMS level of a signal
-double calculate_rms(double *data, size_t length) {
-    double sum_sq = 0.0;
-    for (size_t i = 0; i < length; i++) {
-        sum_sq += data[i] * data[i];
-    }
-    return sqrt(sum_sq / length);
+    ab_audio_free(buf);
 }
 
 // Compute frequency response via deconvolution: H(f) = Y(f) / X(f)
 int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
                                double **freq_axis, double **magnitude_db, 
                                double **phase_deg, size_t *num_bins,
-                               int normalize_levels) {
+                               int normalize_levels, unsigned int planner_flags,
+                               int use_float, int pow2_size) {
     
     // Verify compatibility
     if (reference->sample_rate != recorded->sample_rate) {
@@ -121,8 +76,8 @@ int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
     }
     
     // Calculate and report RMS levels
-    double ref_rms = calculate_rms(reference->data, reference->length);
-    double rec_rms = calculate_rms(recorded->data, recorded->length);
+    double ref_rms = ab_rms(reference->data, reference->frames);
+    double rec_rms = ab_rms(recorded->data, recorded->frames);
     
     double ref_db = 20.0 * log10(ref_rms);
     double rec_db = 20.0 * log10(rec_rms);
@@ -137,7 +92,7 @@ int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
         // Normalize recorded signal to match reference level
         double gain_factor = ref_rms / rec_rms;
         printf("Applying gain compensation: %.2f dB\n", 20.0 * log10(gain_factor));
-        for (size_t i = 0; i < recorded->length; i++) {
+        for (size_t i = 0; i < recorded->frames; i++) {
             recorded->data[i] *= gain_factor;
         }
     } else {
@@ -145,44 +100,93 @@ int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
     }
     
     // Use the longer length and zero-pad both to same size
-    size_t fft_size = (reference->length > recorded->length) ? 
-                      reference->length : recorded->length;
-    
-    // Make FFT size a power of 2 for efficiency
-    size_t fft_size_pow2 = 1;
-    while (fft_size_pow2 < fft_size) {
-        fft_size_pow2 <<= 1;
+    size_t fft_size = (reference->frames > recorded->frames) ? 
+                      reference->frames : recorded->frames;
+    
+    // Round up to a size FFTW handles efficiently: 2^a * 3^b * 5^c by
+    // default, or the next power of 2 (up to twice the memory) with --pow2
+    if (pow2_size) {
+        size_t fft_size_pow2 = 1;
+        while (fft_size_pow2 < fft_size) {
+            fft_size_pow2 <<= 1;
+        }
+        fft_size = fft_size_pow2;
+    } else {
+        fft_size = ab_fft_good_size(fft_size);
     }
-    fft_size = fft_size_pow2;
     
-    printf("FFT size: %zu\n", fft_size);
-    
-    // Allocate padded buffers
-    double *ref_padded = (double *)fftw_malloc(fft_size * sizeof(double));
-    double *rec_padded = (double *)fftw_malloc(fft_size * sizeof(double));
-    fftw_complex *ref_fft = (fftw_complex *)fftw_malloc((fft_size/2 + 1) * sizeof(fftw_complex));
-    fftw_complex *rec_fft = (fftw_complex *)fftw_malloc((fft_size/2 + 1) * sizeof(fftw_complex));
-    
-    if (!ref_padded || !rec_padded || !ref_fft || !rec_fft) {
-        fprintf(stderr, "Memory allocation failed\n");
-        return -1;
+    printf("FFT size: %zu (%s precision)\n", fft_size, use_float ? "float" : "double");
+    
+    // Allocate padded buffers. Only one precision is allocated: the float
+    // path halves the footprint of these, the largest buffers in the tool.
+    double *ref_padded = NULL, *rec_padded = NULL;
+    fftw_complex *ref_fft = NULL, *rec_fft = NULL;
+    float *ref_padded_f = NULL, *rec_padded_f = NULL;
+    fftwf_complex *ref_fft_f = NULL, *rec_fft_f = NULL;
+    
+    if (use_float) {
+        ref_padded_f = fftwf_alloc_real(fft_size);
+        rec_padded_f = fftwf_alloc_real(fft_size);
+        ref_fft_f = fftwf_alloc_complex(fft_size/2 + 1);
+        rec_fft_f = fftwf_alloc_complex(fft_size/2 + 1);
+        if (!ref_padded_f || !rec_padded_f || !ref_fft_f || !rec_fft_f) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return -1;
+        }
+    } else {
+        ref_padded = (double *)fftw_malloc(fft_size * sizeof(double));
+        rec_padded = (double *)fftw_malloc(fft_size * sizeof(double));
+        ref_fft = (fftw_complex *)fftw_malloc((fft_size/2 + 1) * sizeof(fftw_complex));
+        rec_fft = (fftw_complex *)fftw_malloc((fft_size/2 + 1) * sizeof(fftw_complex));
+        if (!ref_padded || !rec_padded || !ref_fft || !rec_fft) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return -1;
+        }
     }
     
-    // Copy and zero-pad
-    memcpy(ref_padded, reference->data, reference->length * sizeof(double));
-    memset(ref_padded + reference->length, 0, (fft_size - reference->length) * sizeof(double));
-    
-    memcpy(rec_padded, recorded->data, recorded->length * sizeof(double));
-    memset(rec_padded + recorded->length, 0, (fft_size - recorded->length) * sizeof(double));
+    // Create one FFT plan for both signals (before filling the buffers, since
+    // measured planning overwrites them). The recorded signal is transformed
+    // through the same plan with new-array execute; both buffers come from
+    // the FFTW allocator so they share the alignment the plan was made for.
+    fftw_plan plan = NULL;
+    fftwf_plan plan_f = NULL;
+    if (use_float) {
+        plan_f = fftwf_plan_dft_r2c_1d(fft_size, ref_padded_f, ref_fft_f, planner_flags);
+        ab_fftwf_wisdom_save(planner_flags);
+    } else {
+        plan = fftw_plan_dft_r2c_1d(fft_size, ref_padded, ref_fft, planner_flags);
+        ab_fft_wisdom_save(planner_flags);
+    }
     
-    // Create FFT plans
-    fftw_plan ref_plan = fftw_plan_dft_r2c_1d(fft_size, ref_padded, ref_fft, FFTW_ESTIMATE);
-    fftw_plan rec_plan = fftw_plan_dft_r2c_1d(fft_size, rec_padded, rec_fft, FFTW_ESTIMATE);
+    // Copy and zero-pad, then execute FFTs
+    if (use_float) {
+        ab_simd_narrow_f(ref_padded_f, reference->data, reference->frames);
+        memset(ref_padded_f + reference->frames, 0, (fft_size - reference->frames) * sizeof(float));
+        
+        ab_simd_narrow_f(rec_padded_f, recorded->data, recorded->frames);
+        memset(rec_padded_f + recorded->frames, 0, (fft_size - recorded->frames) * sizeof(float));
+        
+        printf("Computing FFTs...\n");
+        fftwf_execute(plan_f);
+        fftwf_execute_dft_r2c(plan_f, rec_padded_f, rec_fft_f);
+    } else {
+        memcpy(ref_padded, reference->data, reference->frames * sizeof(double));
+        memset(ref_padded + reference->frames, 0, (fft_size - reference->frames) * sizeof(double));
+        
+        memcpy(rec_padded, recorded->data, recorded->frames * sizeof(double));
+        memset(rec_padded + recorded->frames, 0, (fft_size - recorded->frames) * sizeof(double));
+        
+        printf("Computing FFTs...\n");
+        fftw_execute(plan);
+        fftw_execute_dft_r2c(plan, rec_padded, rec_fft);
+    }
     
-    // Execute FFTs
-    printf("Computing FFTs...\n");
-    fftw_execute(ref_plan);
-    fftw_execute(rec_plan);
+    // The padded time-domain buffers are no longer needed; free them before
+    // the per-bin output arrays are allocated to keep the peak footprint down
+    fftw_free(ref_padded);
+    fftw_free(rec_padded);
+    fftwf_free(ref_padded_f);
+    fftwf_free(rec_padded_f);
     
     // Compute frequency response H(f) = Y(f) / X(f)
     *num_bins = fft_size / 2 + 1;
@@ -197,23 +201,30 @@ int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
     
     double freq_resolution = (double)reference->sample_rate / fft_size;
     
+    // Spectra viewed as [real, imag] pairs in either precision
+    const double *ref_bins = (const double *)ref_fft;
+    const double *rec_bins = (const double *)rec_fft;
+    const float *ref_bins_f = (const float *)ref_fft_f;
+    const float *rec_bins_f = (const float *)rec_fft_f;
+    double DC_real = use_float ? rec_bins_f[0] : rec_bins[0];
+    double DC_imag = use_float ? rec_bins_f[1] : rec_bins[1];
+    
     printf("Computing frequency response...\n");
     for (size_t i = 0; i < *num_bins; i++) {
         (*freq_axis)[i] = i * freq_resolution;
 
         // Get complex values (accessing FFTW complex as [real, imag] pairs)
-        double X_real = ((double*)ref_fft)[2*i];
-        double X_imag = ((double*)ref_fft)[2*i + 1];
-        double Y_real = ((double*)rec_fft)[2*i];
-        double Y_imag = ((double*)rec_fft)[2*i + 1];
+        double X_real = use_float ? ref_bins_f[2*i]     : ref_bins[2*i];
+        double X_imag = use_float ? ref_bins_f[2*i + 1] : ref_bins[2*i + 1];
+        double Y_real = use_float ? rec_bins_f[2*i]     : rec_bins[2*i];
+        double Y_imag = use_float ? rec_bins_f[2*i + 1] : rec_bins[2*i + 1];
 
         double complex X = X_real + I * X_imag;
         double complex Y = Y_real + I * Y_imag;
 
         // Compute H = Y / X with regularization to avoid division by near-zero
         double X_mag = cabs(X);
-        double DC_mag = sqrt(((double*)rec_fft)[0] * ((double*)rec_fft)[0] +
-                            ((double*)rec_fft)[1] * ((double*)rec_fft)[1]);
+        double DC_mag = sqrt(DC_real * DC_real + DC_imag * DC_imag);
         double regularization = 1e-10 * DC_mag; // Small fraction of DC
         
         double complex H;
@@ -242,16 +253,271 @@ int compute_frequency_response(AudioBuffer *reference, AudioBuffer *recorded,
     }
     
     // Cleanup
-    fftw_destroy_plan(ref_plan);
-    fftw_destroy_plan(rec_plan);
-    fftw_free(ref_padded);
-    fftw_free(rec_padded);
+    if (plan) {
+        fftw_destroy_plan(plan);
+    }
+    if (plan_f) {
+        fftwf_destroy_plan(plan_f);
+    }
     fftw_free(ref_fft);
     fftw_free(rec_fft);
+    fftwf_free(ref_fft_f);
+    fftwf_free(rec_fft_f);
     
     return 0;
 }
 
+// Write an impulse response as a mono 32-bit float WAV file
+int write_impulse_response(const char *filename, const double *ir, size_t length, int sample_rate) {
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.samplerate = sample_rate;
+    info.channels = 1;
+    info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+    SNDFILE *file = sf_open(filename, SFM_WRITE, &info);
+    if (!file) {
+        fprintf(stderr, "Error opening impulse response file %s: %s\n", filename, sf_strerror(NULL));
+        return -1;
+    }
+    sf_count_t written = sf_write_double(file, ir, (sf_count_t)length);
+    sf_close(file);
+
+    if (written != (sf_count_t)length) {
+        fprintf(stderr, "Error writing impulse response file %s\n", filename);
+        return -1;
+    }
+    printf("Impulse response (%zu samples) written to %s\n", length, filename);
+    return 0;
+}
+
+// Read up to count mono samples into dst, zero-filling past the end of the
+// file, and add the energy of the samples actually read to *sum_squares
+static size_t read_block(SNDFILE *file, int channels, double *dst, size_t count,
+                         double *sum_squares) {
+    sf_count_t got = ab_read_mono(file, channels, dst, (sf_count_t)count);
+    if (got < 0) {
+        got = 0;
+    }
+    *sum_squares += ab_sum_squares(dst, (size_t)got);
+    memset(dst + got, 0, (count - (size_t)got) * sizeof(double));
+    return (size_t)got;
+}
+
+// Averaged transfer-function estimate: H(f) = Sxy(f) / Sxx(f)
+//
+// This is not a deconvolution of the whole sweep. Both files are streamed
+// in Hann-windowed blocks with 50% overlap; the cross spectrum conj(X)Y and
+// the reference power |X|^2 are summed over all blocks and divided once at
+// the end (the Welch H1 estimator). Memory is a few block-sized buffers
+// regardless of file length. The impulse response is IFFT(H)/N, a single
+// circular block: it is only valid while the system's impulse response plus
+// the loopback delay is shorter than the block. Anything longer wraps around
+// into the start of the block and smears the magnitude and phase.
+int compute_frequency_response_averaged(const char *ref_filename, const char *rec_filename,
+                                        size_t block_request, const char *ir_filename,
+                                        double **freq_axis, double **magnitude_db,
+                                        double **phase_deg, size_t *num_bins,
+                                        int *sample_rate, int normalize_levels,
+                                        unsigned int planner_flags) {
+    SF_INFO ref_info, rec_info;
+    memset(&ref_info, 0, sizeof(ref_info));
+    memset(&rec_info, 0, sizeof(rec_info));
+
+    SNDFILE *ref_file = sf_open(ref_filename, SFM_READ, &ref_info);
+    if (!ref_file) {
+        fprintf(stderr, "Error opening %s: %s\n", ref_filename, sf_strerror(NULL));
+        return -1;
+    }
+    SNDFILE *rec_file = sf_open(rec_filename, SFM_READ, &rec_info);
+    if (!rec_file) {
+        fprintf(stderr, "Error opening %s: %s\n", rec_filename, sf_strerror(NULL));
+        sf_close(ref_file);
+        return -1;
+    }
+
+    printf("Streaming %s: %ld samples, %d Hz, %d channel(s)\n",
+           ref_filename, (long)ref_info.frames, ref_info.samplerate, ref_info.channels);
+    printf("Streaming %s: %ld samples, %d Hz, %d channel(s)\n",
+           rec_filename, (long)rec_info.frames, rec_info.samplerate, rec_info.channels);
+
+    if (ref_info.samplerate != rec_info.samplerate) {
+        fprintf(stderr, "Sample rate mismatch: ref=%d, rec=%d\n",
+                ref_info.samplerate, rec_info.samplerate);
+        sf_close(ref_file);
+        sf_close(rec_file);
+        return -1;
+    }
+    *sample_rate = ref_info.samplerate;
+
+    // Even block length with only 2, 3 and 5 as factors, half-block hop
+    size_t block = 2 * ab_fft_good_size((block_request + 1) / 2);
+    size_t hop = block / 2;
+    size_t bins = block / 2 + 1;
+    printf("Block size: %zu (%.1f ms, hop %zu)\n", block, 1000.0 * block / ref_info.samplerate, hop);
+
+    const AbWindow *window = ab_window_get(AB_WINDOW_HANN, (int)block, 0.0);
+    double *x = (double *)fftw_malloc(block * sizeof(double));
+    double *y = (double *)fftw_malloc(block * sizeof(double));
+    double *xw = (double *)fftw_malloc(block * sizeof(double));
+    double *yw = (double *)fftw_malloc(block * sizeof(double));
+    fftw_complex *X = (fftw_complex *)fftw_malloc(bins * sizeof(fftw_complex));
+    fftw_complex *Y = (fftw_complex *)fftw_malloc(bins * sizeof(fftw_complex));
+    double *Sxy = (double *)calloc(2 * bins, sizeof(double));
+    double *Sxx = (double *)calloc(bins, sizeof(double));
+    *freq_axis = (double *)malloc(bins * sizeof(double));
+    *magnitude_db = (double *)malloc(bins * sizeof(double));
+    *phase_deg = (double *)malloc(bins * sizeof(double));
+
+    int status = -1;
+    fftw_plan plan = NULL;
+    if (!window || !x || !y || !xw || !yw || !X || !Y || !Sxy || !Sxx ||
+        !*freq_axis || !*magnitude_db || !*phase_deg) {
+        fprintf(stderr, "Memory allocation failed\n");
+        goto cleanup;
+    }
+
+    // One plan for both signals, created before the buffers are filled
+    plan = fftw_plan_dft_r2c_1d((int)block, xw, X, planner_flags);
+    ab_fft_wisdom_save(planner_flags);
+
+    // Accumulate over blocks. The buffers start with a hop of zeros so the
+    // first samples get a full window, and one extra block flushes the tail.
+    memset(x, 0, block * sizeof(double));
+    memset(y, 0, block * sizeof(double));
+    double ref_energy = 0.0, rec_energy = 0.0;
+    size_t ref_frames = 0, rec_frames = 0, blocks = 0;
+    int flushing = 0;
+
+    printf("Accumulating cross spectrum...\n");
+    for (;;) {
+        memmove(x, x + hop, (block - hop) * sizeof(double));
+        memmove(y, y + hop, (block - hop) * sizeof(double));
+        size_t got_x = read_block(ref_file, ref_info.channels, x + block - hop, hop, &ref_energy);
+        size_t got_y = read_block(rec_file, rec_info.channels, y + block - hop, hop, &rec_energy);
+        ref_frames += got_x;
+        rec_frames += got_y;
+
+        if (got_x == 0 && got_y == 0) {
+            if (flushing) {
+                break;
+            }
+            flushing = 1;
+        }
+
+        ab_simd_window_d(xw, x, window->coeffs, block);
+        ab_simd_window_d(yw, y, window->coeffs, block);
+        fftw_execute(plan);
+        fftw_execute_dft_r2c(plan, yw, Y);
+
+        for (size_t k = 0; k < bins; k++) {
+            double xr = X[k][0], xi = X[k][1];
+            double yr = Y[k][0], yi = Y[k][1];
+            Sxy[2*k]     += xr * yr + xi * yi;		// conj(X) * Y
+            Sxy[2*k + 1] += xr * yi - xi * yr;
+            Sxx[k]       += xr * xr + xi * xi;
+        }
+        blocks++;
+    }
+    printf("Averaged %zu blocks\n", blocks);
+
+    if (ref_frames == 0 || rec_frames == 0) {
+        fprintf(stderr, "Empty input file\n");
+        goto cleanup;
+    }
+
+    // Levels, reported as in the whole-file mode. Normalizing the recorded
+    // signal is a scalar gain, so it is applied to H instead.
+    double ref_rms = sqrt(ref_energy / ref_frames);
+    double rec_rms = sqrt(rec_energy / rec_frames);
+    double ref_db = 20.0 * log10(ref_rms);
+    double rec_db = 20.0 * log10(rec_rms);
+    double level_diff = rec_db - ref_db;
+    double gain_factor = 1.0;
+
+    printf("\n=== Signal Levels ===\n");
+    printf("Reference RMS: %.6f (%.2f dBFS)\n", ref_rms, ref_db);
+    printf("Recorded RMS:  %.6f (%.2f dBFS)\n", rec_rms, rec_db);
+    printf("Level difference: %.2f dB\n", level_diff);
+
+    if (normalize_levels) {
+        gain_factor = ref_rms / rec_rms;
+        printf("Applying gain compensation: %.2f dB\n", 20.0 * log10(gain_factor));
+    } else {
+        printf("No gain compensation applied (frequency response includes %.2f dB offset)\n", level_diff);
+    }
+
+    // H = Sxy / Sxx, zero where the reference has no energy (relative to
+    // its strongest bin, the same -200 dB cut-off as the whole-file mode)
+    double Sxx_max = 0.0;
+    for (size_t k = 0; k < bins; k++) {
+        if (Sxx[k] > Sxx_max) Sxx_max = Sxx[k];
+    }
+    double threshold = 1e-20 * Sxx_max;
+    double freq_resolution = (double)ref_info.samplerate / block;
+
+    printf("Computing frequency response...\n");
+    for (size_t k = 0; k < bins; k++) {
+        double H_real = 0.0, H_imag = 0.0;
+        if (Sxx[k] > threshold) {
+            H_real = gain_factor * Sxy[2*k] / Sxx[k];
+            H_imag = gain_factor * Sxy[2*k + 1] / Sxx[k];
+        }
+        // Keep H for the impulse response (X is free after the last block)
+        X[k][0] = H_real;
+        X[k][1] = H_imag;
+
+        double mag = sqrt(H_real * H_real + H_imag * H_imag);
+        (*freq_axis)[k] = k * freq_resolution;
+        (*magnitude_db)[k] = (mag > 0.0) ? 20.0 * log10(mag) : MIN_MAG_DB;
+        if ((*magnitude_db)[k] < MIN_MAG_DB) {
+            (*magnitude_db)[k] = MIN_MAG_DB;
+        }
+        (*phase_deg)[k] = atan2(H_imag, H_real) * 180.0 / M_PI;
+    }
+    *num_bins = bins;
+
+    // Impulse response h = IFFT(H) / N, circular at the block length (the
+    // c2r plan overwrites X, which is why FFTW_ESTIMATE is used: it leaves
+    // the input alone while planning)
+    if (ir_filename) {
+        fftw_plan inverse = fftw_plan_dft_c2r_1d((int)block, X, xw, FFTW_ESTIMATE);
+        fftw_execute(inverse);
+        fftw_destroy_plan(inverse);
+        for (size_t i = 0; i < block; i++) {
+            xw[i] /= (double)block;
+        }
+        if (write_impulse_response(ir_filename, xw, block, ref_info.samplerate) != 0) {
+            goto cleanup;
+        }
+    }
+
+    status = 0;
+
+cleanup:
+    if (plan) {
+        fftw_destroy_plan(plan);
+    }
+    fftw_free(x);
+    fftw_free(y);
+    fftw_free(xw);
+    fftw_free(yw);
+    fftw_free(X);
+    fftw_free(Y);
+    free(Sxy);
+    free(Sxx);
+    ab_window_cache_free();
+    if (status != 0) {
+        free(*freq_axis);
+        free(*magnitude_db);
+        free(*phase_deg);
+        *freq_axis = *magnitude_db = *phase_deg = NULL;
+    }
+    sf_close(ref_file);
+    sf_close(rec_file);
+    return status;
+}
+
 // Write results to CSV file
 int write_csv(const char *filename, double *freq, double *mag_db, 
               double *phase_deg, size_t num_bins) {
@@ -313,12 +579,28 @@ void print_summary(double *freq, double *mag_db, size_t num_bins, int sample_rat
 }
 
 void print_usage(const char *prog_name) {
-    printf("Usage: %s <reference.wav> <recorded.wav> [output.csv] [--no-normalize]\n\n", prog_name);
+    printf("Usage: %s <reference.wav> <recorded.wav> [output.csv] [--no-normalize]\n", prog_name);
+    printf("       [--planner=MODE] [--wisdom=FILE] [--precision=MODE] [--pow2]\n");
+    printf("       [--average=N [--ir=FILE]]\n\n");
     printf("Measures frequency response by deconvolving recorded signal with reference.\n");
     printf("  reference.wav - Original stimulus signal\n");
     printf("  recorded.wav  - Recorded response (after passing through system)\n");
     printf("  output.csv    - Output file (default: freq_response.csv)\n");
-    printf("  --no-normalize - Don't compensate for level differences (default: auto-compensate)\n\n");
+    printf("  --no-normalize - Don't compensate for level differences (default: auto-compensate)\n");
+    printf("  --planner=MODE - FFTW planner: estimate, measure, patient, exhaustive (default: estimate)\n");
+    printf("  --wisdom=FILE  - FFTW wisdom file (default: $AB_FFTW_WISDOM or ~/.ab_fftw_wisdom)\n");
+    printf("  --precision=MODE - FFT precision: auto, float, double (default: auto, float\n");
+    printf("                   when both files are 8-24 bit PCM)\n");
+    printf("  --pow2         - Pad to a power of 2 (default: next 2^a*3^b*5^c size)\n");
+    printf("  --average=N    - Averaged transfer-function estimate instead of deconvolution:\n");
+    printf("                   stream both files in Hann-windowed N-sample blocks (rounded\n");
+    printf("                   up to a 2^a*3^b*5^c size, 50%% overlap) and average\n");
+    printf("                   H = Sxy/Sxx. Bounded memory, resolution fs/N, always double\n");
+    printf("                   precision (--precision and --pow2 are rejected).\n");
+    printf("                   LIMIT: impulse response + loopback delay must be shorter\n");
+    printf("                   than N samples; a longer response wraps around silently.\n");
+    printf("  --ir=FILE      - With --average, also write the N-sample circular impulse\n");
+    printf("                   response IFFT(H) (float WAV)\n\n");
     printf("By default, the program compensates for any level difference between reference\n");
     printf("and recorded signals, making the frequency response show only the frequency-\n");
     printf("dependent characteristics. Use --no-normalize to see the absolute gain/loss.\n");
@@ -334,19 +616,91 @@ int main(int argc, char *argv[]) {
     const char *rec_filename = argv[2];
     const char *out_filename = "freq_response.csv";
     int normalize_levels = 1; // Default: normalize levels
+    const char *planner_name = NULL;
+    const char *wisdom_path = NULL;
+    const char *precision_name = NULL;
+    const char *ir_filename = NULL;
+    size_t block_size = 0;
+    int pow2_size = 0;
     
     // Parse remaining arguments
     for (int i = 3; i < argc; i++) {
         if (strcmp(argv[i], "--no-normalize") == 0) {
             normalize_levels = 0;
+        } else if (strncmp(argv[i], "--planner=", 10) == 0) {
+            planner_name = argv[i] + 10;
+        } else if (strncmp(argv[i], "--wisdom=", 9) == 0) {
+            wisdom_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--precision=", 12) == 0) {
+            precision_name = argv[i] + 12;
+        } else if (strcmp(argv[i], "--pow2") == 0) {
+            pow2_size = 1;
+        } else if (strncmp(argv[i], "--average=", 10) == 0) {
+            char *end;
+            long value = strtol(argv[i] + 10, &end, 10);
+            if (*end != '\0' || value < MIN_BLOCK_SIZE) {
+                fprintf(stderr, "Invalid block size '%s' (minimum %d)\n", argv[i] + 10, MIN_BLOCK_SIZE);
+                return 1;
+            }
+            block_size = (size_t)value;
+        } else if (strncmp(argv[i], "--ir=", 5) == 0) {
+            ir_filename = argv[i] + 5;
         } else {
             // Assume it's the output filename
             out_filename = argv[i];
         }
     }
     
+    unsigned int planner_flags;
+    if (ab_fft_parse_planner(planner_name, &planner_flags) != 0) {
+        fprintf(stderr, "Unknown planner '%s' (use estimate, measure, patient or exhaustive)\n", planner_name);
+        return 1;
+    }
+    int precision;
+    if (ab_fft_parse_precision(precision_name, &precision) != 0) {
+        fprintf(stderr, "Unknown precision '%s' (use auto, float or double)\n", precision_name);
+        return 1;
+    }
+    
+    if (ir_filename && block_size == 0) {
+        fprintf(stderr, "--ir requires --average\n");
+        return 1;
+    }
+    if (block_size > 0 && (precision_name || pow2_size)) {
+        fprintf(stderr, "--average is always double precision on its own block grid; "
+                        "--precision and --pow2 apply only to the whole-file mode\n");
+        return 1;
+    }
+    
     printf("=== Frequency Response Measurement via Deconvolution ===\n");
-    printf("Level normalization: %s\n\n", normalize_levels ? "ENABLED" : "DISABLED");
+    printf("Level normalization: %s\n", normalize_levels ? "ENABLED" : "DISABLED");
+    printf("FFT planner: %s\n\n", ab_fft_planner_name(planner_flags));
+    
+    double *freq_axis = NULL;
+    double *magnitude_db = NULL;
+    double *phase_deg = NULL;
+    size_t num_bins = 0;
+    
+    // The averaged estimate streams the files itself instead of loading them
+    if (block_size > 0) {
+        int sample_rate = 0;
+        printf("Mode: averaged transfer-function estimate (H1), not deconvolution\n");
+        ab_fft_wisdom_load(wisdom_path);
+        if (compute_frequency_response_averaged(ref_filename, rec_filename, block_size, ir_filename,
+                                                &freq_axis, &magnitude_db, &phase_deg, &num_bins,
+                                                &sample_rate, normalize_levels, planner_flags) != 0) {
+            return 1;
+        }
+        int rc = write_csv(out_filename, freq_axis, magnitude_db, phase_deg, num_bins);
+        if (rc == 0) {
+            print_summary(freq_axis, magnitude_db, num_bins, sample_rate);
+            printf("\nDone!\n");
+        }
+        free(freq_axis);
+        free(magnitude_db);
+        free(phase_deg);
+        return rc == 0 ? 0 : 1;
+    }
     
     // Load audio files
     AudioBuffer reference = {0};
@@ -361,15 +715,21 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    // Compute frequency response
-    double *freq_axis = NULL;
-    double *magnitude_db = NULL;
-    double *phase_deg = NULL;
-    size_t num_bins = 0;
+    // Pick the FFT precision from the deeper of the two files and load the
+    // matching wisdom
+    int deeper = (reference.bit_depth > recorded.bit_depth) ? reference.bit_depth : recorded.bit_depth;
+    int use_float = ab_fft_use_float(precision, deeper);
+    if (use_float) {
+        ab_fftwf_wisdom_load(wisdom_path);
+    } else {
+        ab_fft_wisdom_load(wisdom_path);
+    }
     
+    // Compute frequency response
     if (compute_frequency_response(&reference, &recorded, 
                                    &freq_axis, &magnitude_db, 
-                                   &phase_deg, &num_bins, normalize_levels) != 0) {
+                                   &phase_deg, &num_bins, normalize_levels,
+                                   planner_flags, use_float, pow2_size) != 0) {
         free_audio_buffer(&reference);
         free_audio_buffer(&recorded);
         return 1;
@@ -27,8 +27,13 @@
 #include <math.h>
 #include <sndfile.h>
 #include <popt.h>
+#include "ab_core.h"
+#include "ab_window.h"
+#include "ab_goertzel.h"
 
 #define BUFFER_SIZE 4096
+#define TONE_FRAME_SECONDS	0.1												//	10 Hz resolution, hum at 50/60 Hz is rejected
+#define TONE_TRACK_HZ		20.0											//	Tone may drift this far from --freq
 
 //------------------------------------------------------------------------------
 //	Name:		calculate_rms
@@ -88,15 +93,10 @@ int calculate_rms(const char *filename, double duration, double *rms_out)
                                          (frames_remaining < BUFFER_SIZE / info.channels) ?
                                          frames_remaining : BUFFER_SIZE / info.channels)) > 0) {
 
-        for (sf_count_t i = 0; i < frames_read; i++) {
 //------------------------------------------------------------------------------
 //	Sum all channels together for overall RMS
 //------------------------------------------------------------------------------
-            for (int ch = 0; ch < info.channels; ch++) {
-                double sample = buffer[i * info.channels + ch];
-                sum_squares += sample * sample;
-            }
-        }
+        sum_squares += ab_sum_squares(buffer, (size_t)(frames_read * info.channels));
 
         total_samples += frames_read * info.channels;
         frames_remaining -= frames_read;
@@ -115,12 +115,129 @@ int calculate_rms(const char *filename, double duration, double *rms_out)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+//	Name:		tone_frame
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- AbTone frame callback: sums the tone's power and counts frames,
+//	  locked frames in sum[0..1], all frames in sum[2..3]
+//------------------------------------------------------------------------------
+void tone_frame(const AbTone *tone, void *user)
+{
+    double *sum = (double *)user;
+    double power = tone->level[0] * tone->level[0];
+
+    if (tone->locked) {
+        sum[0] += power;
+        sum[1] += 1.0;
+    }
+    sum[2] += power;
+    sum[3] += 1.0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		calculate_tone_rms
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Frequency-selective alternative to calculate_rms(): the RMS of the
+//	  tone at freq alone, so hum, noise and distortion do not count
+//	- Channels are averaged to mono, then read in TONE_FRAME_SECONDS Hann
+//	  frames by a single Goertzel resonator (ab_goertzel.h) that follows
+//	  the tone within +/- TONE_TRACK_HZ
+//	- The result is amplitude / sqrt(2), averaged in power over the
+//	  frames read once the tracker locked (every frame if it never did),
+//	  so it compares directly with the broadband RMS of a clean sine
+//------------------------------------------------------------------------------
+int calculate_tone_rms(const char *filename, double duration, double freq, double *rms_out)
+{
+    SF_INFO info;
+    SNDFILE *file;
+
+    memset(&info, 0, sizeof(info));
+
+//------------------------------------------------------------------------------
+//	Open the audio file
+//------------------------------------------------------------------------------
+    file = sf_open(filename, SFM_READ, &info);
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+        fprintf(stderr, "%s\n", sf_strerror(NULL));
+        return -1;
+    }
+
+    if (freq >= info.samplerate / 2.0) {
+        fprintf(stderr, "Error: %.1f Hz is above the Nyquist frequency of '%s'\n", freq, filename);
+        sf_close(file);
+        return -1;
+    }
+
+    sf_count_t frames_to_read = (sf_count_t)(duration * info.samplerate);
+    if (frames_to_read > info.frames) {
+        frames_to_read = info.frames;
+        fprintf(stderr, "Warning: File '%s' is shorter than %.2f seconds (%.2f seconds available)\n",
+                filename, duration, (double)info.frames / info.samplerate);
+    }
+
+//------------------------------------------------------------------------------
+//	One Hann frame of TONE_FRAME_SECONDS (shorter if the duration is)
+//------------------------------------------------------------------------------
+    int frame_size = (int)(TONE_FRAME_SECONDS * info.samplerate);
+    if (frame_size > frames_to_read && frames_to_read > 0) {
+        frame_size = (int)frames_to_read;
+    }
+
+    const AbWindow *window = ab_window_get(AB_WINDOW_HANN, frame_size, 0.0);
+    double *buffer = (double *)malloc(frame_size * sizeof(double));
+    AbTone tone;
+
+    if (!window || !buffer ||
+        ab_tone_init(&tone, info.samplerate, freq, 1, frame_size, window->coeffs, TONE_TRACK_HZ) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(buffer);
+        sf_close(file);
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Process audio a frame at a time
+//------------------------------------------------------------------------------
+    double sum[4] = { 0.0, 0.0, 0.0, 0.0 };						//	Locked power, frames; all power, frames
+    sf_count_t frames_remaining = frames_to_read;
+    sf_count_t frames_read;
+
+    while (frames_remaining > 0 &&
+           (frames_read = ab_read_mono(file, info.channels, buffer,
+                                       frames_remaining < frame_size ? frames_remaining : frame_size)) > 0) {
+        ab_tone_process(&tone, buffer, (size_t)frames_read, tone_frame, sum);
+        frames_remaining -= frames_read;
+    }
+    ab_tone_finish(&tone, tone_frame, sum);
+
+    if (sum[1] > 0.0) {
+        *rms_out = sqrt(sum[0] / sum[1] / 2.0);
+    } else {
+        *rms_out = sum[3] > 0.0 ? sqrt(sum[2] / sum[3] / 2.0) : 0.0;
+    }
+
+    ab_tone_free(&tone);
+    free(buffer);
+    sf_close(file);
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 //	Main application
 //
 //	This application:
 //	- Parses command-line options
-//	- Calculates RMS for both input files
+//	- Calculates RMS for both input files (broadband, or of one tone
+//	  with --freq)
 //	- Computes gain difference in dB
 //	- Displays results
 //
@@ -136,12 +253,15 @@ int main(int argc, char *argv[])
     char *file1 = NULL;
     char *file2 = NULL;
     double duration = 1.0;												//	Default: 1 second
+    double tone_freq = 0.0;												//	0 = broadband RMS
     int verbose = 0;
     int version_flag = 0;
 
     struct poptOption options[] = {
         {"time", 't', POPT_ARG_DOUBLE, &duration, 0,
          "Duration in seconds to analyze (default: 1.0)", "SECONDS"},
+        {"freq", 'F', POPT_ARG_DOUBLE, &tone_freq, 0,
+         "Measure only the tone at FREQ Hz (Goertzel, rejects hum and noise)", "FREQ"},
         {"verbose", 'V', POPT_ARG_NONE, &verbose, 0,
          "Verbose output", NULL},
         {"version", 'v', POPT_ARG_NONE, &version_flag, 0,
@@ -158,6 +278,7 @@ int main(int argc, char *argv[])
         "Examples:\n"
         "  ab_gain_calc input1.wav input2.wav           # Compare first second\n"
         "  ab_gain_calc input1.wav input2.wav -t 2.5    # Compare first 2.5 seconds\n"
+        "  ab_gain_calc input1.wav input2.wav -F 1000   # Compare the 1 kHz tone only\n"
         "  ab_gain_calc input1.wav input2.wav -V        # Verbose output\n");
 
     int rc = poptGetNextOpt(popt_ctx);
@@ -219,10 +340,25 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Validate tone frequency
+//------------------------------------------------------------------------------
+    if (tone_freq < 0.0) {
+        fprintf(stderr, "Error: Frequency must be positive\n");
+        free(file1);
+        free(file2);
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
     poptFreeContext(popt_ctx);
 
     if (verbose) {
         printf("Calculating RMS for %.2f seconds of audio...\n", duration);
+        if (tone_freq > 0.0) {
+            printf("Tone only: %.1f Hz (%.0f ms Hann frames, tracked +/- %.0f Hz)\n",
+                   tone_freq, TONE_FRAME_SECONDS * 1000.0, TONE_TRACK_HZ);
+        }
         printf("File 1: %s\n", file1);
         printf("File 2: %s\n", file2);
         printf("\n");
@@ -232,14 +368,18 @@ int main(int argc, char *argv[])
 //	Calculate RMS for both files
 //------------------------------------------------------------------------------
     double rms1, rms2;
+    int failed;
 
-    if (calculate_rms(file1, duration, &rms1) != 0) {
-        free(file1);
-        free(file2);
-        return 1;
+    if (tone_freq > 0.0) {
+        failed = calculate_tone_rms(file1, duration, tone_freq, &rms1) != 0 ||
+                 calculate_tone_rms(file2, duration, tone_freq, &rms2) != 0;
+        ab_window_cache_free();
+    } else {
+        failed = calculate_rms(file1, duration, &rms1) != 0 ||
+                 calculate_rms(file2, duration, &rms2) != 0;
     }
 
-    if (calculate_rms(file2, duration, &rms2) != 0) {
+    if (failed) {
         free(file1);
         free(file2);
         return 1;
@@ -257,6 +397,9 @@ int main(int argc, char *argv[])
 //------------------------------------------------------------------------------
     printf("Gain Calculation Results:\n");
     printf("  Analysis Duration: %.2f seconds\n", duration);
+    if (tone_freq > 0.0) {
+        printf("  Measured: %.1f Hz tone only\n", tone_freq);
+    }
     printf("\n");
     printf("  File 1: %s\n", file1);
     printf("    RMS Level: %.2f dB (%.6f)\n", rms1_db, rms1);
@@ -0,0 +1,411 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <sndfile.h>
+#include <popt.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//------------------------------------------------------------------------------
+//	Defaults
+//------------------------------------------------------------------------------
+#define BLOCK_FRAMES		4096
+#define DEFAULT_RATE		48000
+#define DEFAULT_DURATION	10.0											//	Seconds
+#define DEFAULT_AMP_DB		-12.0											//	Same level as waves/Makefile
+#define DEFAULT_FREQ		1000.0
+#define DEFAULT_F_START		20.0
+#define DEFAULT_F_END		20000.0
+#define DEFAULT_SEED		1
+#define PINK_RMS			1.759427										//	RMS of the pinking filter for uniform [-1, 1) input
+#define PINK_CREST_DB		14.0											//	Noise RMS sits this far below --amp
+#define PINK_WARMUP			8192											//	Samples discarded while the filter settles
+
+#define SIGNAL_SINE			0
+#define SIGNAL_SWEEP		1
+#define SIGNAL_PINK			2
+
+//------------------------------------------------------------------------------
+//	Generator state
+//------------------------------------------------------------------------------
+typedef struct {
+    int type;
+    double sample_rate;
+    double amplitude;													//	Linear peak (tones) or RMS (noise)
+    double freq;
+    double f_start;
+    double f_end;
+    double sweep_rate;													//	Sweep: duration / ln(f_end / f_start)
+    uint64_t position;													//	Frames generated
+    uint64_t rng;														//	xorshift64* state
+    double pink[7];														//	Pinking filter state
+} Generator;
+
+//------------------------------------------------------------------------------
+//	Name:		parse_type
+//
+//	Returns:	SIGNAL_* constant, -1 if unknown
+//
+//------------------------------------------------------------------------------
+int parse_type(const char *name)
+{
+    if (!name || strcmp(name, "sine") == 0) {
+        return SIGNAL_SINE;
+    }
+    if (strcmp(name, "sweep") == 0) {
+        return SIGNAL_SWEEP;
+    }
+    if (strcmp(name, "pink") == 0) {
+        return SIGNAL_PINK;
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		parse_format
+//
+//	Returns:	libsndfile subtype for "16", "24", "32" or "32f", 0 if unknown
+//
+//------------------------------------------------------------------------------
+int parse_format(const char *name)
+{
+    if (!name || strcmp(name, "24") == 0) {
+        return SF_FORMAT_PCM_24;
+    }
+    if (strcmp(name, "16") == 0) {
+        return SF_FORMAT_PCM_16;
+    }
+    if (strcmp(name, "32") == 0) {
+        return SF_FORMAT_PCM_32;
+    }
+    if (strcmp(name, "32f") == 0) {
+        return SF_FORMAT_FLOAT;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		white_sample
+//
+//	Returns:	uniform sample in [-1, 1)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- xorshift64*: the same seed gives the same file on every platform,
+//	  which rand() does not
+//------------------------------------------------------------------------------
+double white_sample(Generator *gen)
+{
+    gen->rng ^= gen->rng >> 12;
+    gen->rng ^= gen->rng << 25;
+    gen->rng ^= gen->rng >> 27;
+    uint64_t r = gen->rng * 0x2545F4914F6CDD1DULL;
+    return (double)(r >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		pink_sample
+//
+//	Returns:	pink noise sample, unit RMS
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Paul Kellet's refined pinking filter (+/- 0.05 dB of -3 dB/octave
+//	  from 9 Hz at 44.1 kHz; the corners scale with the sample rate)
+//------------------------------------------------------------------------------
+double pink_sample(Generator *gen)
+{
+    double white = white_sample(gen);
+    double *b = gen->pink;
+
+    b[0] = 0.99886 * b[0] + white * 0.0555179;
+    b[1] = 0.99332 * b[1] + white * 0.0750759;
+    b[2] = 0.96900 * b[2] + white * 0.1538520;
+    b[3] = 0.86650 * b[3] + white * 0.3104856;
+    b[4] = 0.55000 * b[4] + white * 0.5329522;
+    b[5] = -0.7616 * b[5] - white * 0.0168980;
+    double pink = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362;
+    b[6] = white * 0.115926;
+
+    return pink / PINK_RMS;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		generator_init
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void generator_init(Generator *gen, int type, double sample_rate, double duration, double amp_db,
+                    double freq, double f_start, double f_end, unsigned int seed)
+{
+    memset(gen, 0, sizeof(*gen));
+    gen->type = type;
+    gen->sample_rate = sample_rate;
+    gen->amplitude = pow(10.0, amp_db / 20.0);
+    gen->freq = freq;
+    gen->f_start = f_start;
+    gen->f_end = f_end;
+    gen->sweep_rate = duration / log(f_end / f_start);
+    gen->rng = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)seed * 0xD1B54A32D192ED03ULL);
+    if (gen->rng == 0) {
+        gen->rng = 1;
+    }
+
+    if (type == SIGNAL_PINK) {
+        gen->amplitude = pow(10.0, (amp_db - PINK_CREST_DB) / 20.0);
+        for (int i = 0; i < PINK_WARMUP; i++) {
+            pink_sample(gen);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		generate_block
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Fills frames interleaved frames, the same signal on every channel
+//	- Phases are computed from the absolute frame number rather than
+//	  accumulated, so hour-long files do not drift
+//	- Log sweep: phase = 2 pi f_start L (e^(t / L) - 1), L = T / ln(f_end / f_start)
+//------------------------------------------------------------------------------
+void generate_block(Generator *gen, double *buffer, int frames, int channels)
+{
+    for (int i = 0; i < frames; i++) {
+        double t = (double)(gen->position + i) / gen->sample_rate;
+        double x;
+
+        switch (gen->type) {
+        case SIGNAL_SWEEP:
+            x = sin(2.0 * M_PI * gen->f_start * gen->sweep_rate * (exp(t / gen->sweep_rate) - 1.0));
+            break;
+        case SIGNAL_PINK:
+            x = pink_sample(gen);
+            break;
+        default:
+            x = sin(2.0 * M_PI * gen->freq * t);
+            break;
+        }
+
+        x *= gen->amplitude;
+        for (int ch = 0; ch < channels; ch++) {
+            buffer[i * channels + ch] = x;
+        }
+    }
+    gen->position += frames;
+}
+
+//------------------------------------------------------------------------------
+//	Main application
+//
+//	This application:
+//	- Generates a sine, logarithmic sweep or pink noise test signal
+//	- Writes it as 16/24/32-bit PCM or 32-bit float, in blocks so any
+//	  length fits in constant memory; RF64 is used only past 4 GB
+//	- Output is bit-for-bit reproducible for a given set of options,
+//	  which is what the benchmark suite (scripts/ab_bench.py) relies on
+//
+//	Libraries:
+//	- libsndfile: Audio file I/O
+//	- libpopt: Command-line parsing
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+//------------------------------------------------------------------------------
+//	Command-line option variables
+//------------------------------------------------------------------------------
+    char *output_file = NULL;
+    char *type_name = NULL;
+    char *format_name = NULL;
+    int sample_rate = DEFAULT_RATE;
+    int channels = 1;
+    double duration = DEFAULT_DURATION;
+    double amp_db = DEFAULT_AMP_DB;
+    double freq = DEFAULT_FREQ;
+    double f_start = DEFAULT_F_START;
+    double f_end = DEFAULT_F_END;
+    int seed = DEFAULT_SEED;
+    int verbose = 0;
+    int version_flag = 0;
+
+//------------------------------------------------------------------------------
+//	Define popt options table
+//------------------------------------------------------------------------------
+    struct poptOption options[] = {
+        {"version",		'v',	POPT_ARG_NONE,		&version_flag,	0,	"Show version information",						NULL		},
+        {"output",		'o',	POPT_ARG_STRING,	&output_file,	0,	"Output WAV file",								"FILE"		},
+        {"type",		'T',	POPT_ARG_STRING,	&type_name,		0,	"Signal: sine, sweep, pink (default: sine)",	"TYPE"		},
+        {"rate",		'r',	POPT_ARG_INT,		&sample_rate,	0,	"Sample rate in Hz (default: 48000)",			"RATE"		},
+        {"bits",		'b',	POPT_ARG_STRING,	&format_name,	0,	"Sample format: 16, 24, 32, 32f (default: 24)",	"FORMAT"	},
+        {"channels",	'c',	POPT_ARG_INT,		&channels,		0,	"Channels, all carrying the signal (default: 1)",	"COUNT"	},
+        {"time",		't',	POPT_ARG_DOUBLE,	&duration,		0,	"Duration in seconds (default: 10)",			"SECONDS"	},
+        {"amp",			'a',	POPT_ARG_DOUBLE,	&amp_db,		0,	"Peak level in dBFS; noise RMS sits 14 dB below (default: -12)",	"DB"	},
+        {"freq",		'F',	POPT_ARG_DOUBLE,	&freq,			0,	"Sine frequency in Hz (default: 1000)",			"FREQ"		},
+        {"f-start",		's',	POPT_ARG_DOUBLE,	&f_start,		0,	"Sweep start frequency in Hz (default: 20)",	"FREQ"		},
+        {"f-end",		'e',	POPT_ARG_DOUBLE,	&f_end,			0,	"Sweep end frequency in Hz (default: 20000)",	"FREQ"		},
+        {"seed",		'S',	POPT_ARG_INT,		&seed,			0,	"Noise seed (default: 1)",						"N"			},
+        {"verbose",		'V',	POPT_ARG_NONE,		&verbose,		0,	"Verbose output",								NULL		},
+        POPT_AUTOHELP
+        POPT_TABLEEND
+    };
+
+//------------------------------------------------------------------------------
+//	Parse command-line options
+//------------------------------------------------------------------------------
+    poptContext popt_ctx = poptGetContext(NULL, argc, (const char **)argv, options, 0);
+    poptSetOtherOptionHelp(popt_ctx,
+        "[OPTIONS]\n\n"
+        "Generate reproducible test signals: sine, log sweep or pink noise.\n\n"
+        "Examples:\n"
+        "  ab_gen_signal -o 1kHz.wav                          # 10 s 1 kHz sine, 48 kHz 24-bit\n"
+        "  ab_gen_signal -o sweep.wav -T sweep -r 96000 -t 60 # 60 s 20 Hz - 20 kHz log sweep\n"
+        "  ab_gen_signal -o pink.wav -T pink -b 32f -t 3600   # 1 h pink noise, 32-bit float\n"
+        "  ab_gen_signal -o tone.wav -F 997 -a -1 -c 2        # Stereo 997 Hz at -1 dBFS\n");
+
+    int rc = poptGetNextOpt(popt_ctx);
+    if (rc < -1) {
+        fprintf(stderr, "Error: %s: %s\n",
+                poptBadOption(popt_ctx, POPT_BADOPTION_NOALIAS),
+                poptStrerror(rc));
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Handle version mode
+//------------------------------------------------------------------------------
+    if (version_flag) {
+        printf("ab_gen_signal version 1.0.0\n");
+        printf("Test signal generator for audio-bench\n");
+        printf("Copyright (c) 2025 A.C. Verbeck\n");
+        poptFreeContext(popt_ctx);
+        return 0;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate parameters
+//------------------------------------------------------------------------------
+    int type = parse_type(type_name);
+    int subtype = parse_format(format_name);
+    const char *error = NULL;
+
+    if (!output_file) {
+        error = "Output file is required (use -o)";
+    } else if (type < 0) {
+        error = "Unknown signal type (use sine, sweep or pink)";
+    } else if (subtype == 0) {
+        error = "Unknown sample format (use 16, 24, 32 or 32f)";
+    } else if (sample_rate <= 0) {
+        error = "Sample rate must be positive";
+    } else if (channels < 1) {
+        error = "Channel count must be at least 1";
+    } else if (duration <= 0.0) {
+        error = "Duration must be positive";
+    } else if (amp_db > 0.0) {
+        error = "Level must be at most 0 dBFS";
+    } else if (type == SIGNAL_SINE && (freq <= 0.0 || freq >= sample_rate / 2.0)) {
+        error = "Sine frequency must be between 0 and the Nyquist frequency";
+    } else if (type == SIGNAL_SWEEP && (f_start <= 0.0 || f_end <= f_start || f_end >= sample_rate / 2.0)) {
+        error = "Sweep needs 0 < f-start < f-end < Nyquist frequency";
+    }
+
+    if (error) {
+        fprintf(stderr, "Error: %s\n", error);
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Open the output file (RF64 downgrades to plain WAV below 4 GB)
+//------------------------------------------------------------------------------
+    SF_INFO sf_info;
+    memset(&sf_info, 0, sizeof(sf_info));
+    sf_info.samplerate = sample_rate;
+    sf_info.channels = channels;
+    sf_info.format = SF_FORMAT_RF64 | subtype;
+
+    SNDFILE *outfile = sf_open(output_file, SFM_WRITE, &sf_info);
+    if (!outfile) {
+        fprintf(stderr, "Error: Could not create output file '%s': %s\n", output_file, sf_strerror(NULL));
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+    sf_command(outfile, SFC_RF64_AUTO_DOWNGRADE, NULL, SF_TRUE);
+    sf_command(outfile, SFC_SET_CLIPPING, NULL, SF_TRUE);
+
+    double *buffer = (double *)malloc((size_t)BLOCK_FRAMES * channels * sizeof(double));
+    if (!buffer) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        sf_close(outfile);
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Generate and write block by block
+//------------------------------------------------------------------------------
+    Generator gen;
+    generator_init(&gen, type, sample_rate, duration, amp_db, freq, f_start, f_end, (unsigned int)seed);
+
+    sf_count_t total_frames = (sf_count_t)(duration * sample_rate + 0.5);
+    sf_count_t remaining = total_frames;
+    int status = 0;
+
+    while (remaining > 0) {
+        int frames = remaining < BLOCK_FRAMES ? (int)remaining : BLOCK_FRAMES;
+        generate_block(&gen, buffer, frames, channels);
+        if (sf_writef_double(outfile, buffer, frames) != frames) {
+            fprintf(stderr, "Error: Write failed on '%s': %s\n", output_file, sf_strerror(outfile));
+            status = 1;
+            break;
+        }
+        remaining -= frames;
+    }
+
+    if (verbose && status == 0) {
+        static const char *type_names[] = { "sine", "sweep", "pink" };
+        printf("Wrote %s: %s, %d Hz, %s, %d channel(s), %ld frames (%.2f seconds)\n",
+               output_file, type_names[type], sample_rate, format_name ? format_name : "24",
+               channels, (long)total_frames, (double)total_frames / sample_rate);
+    }
+
+//------------------------------------------------------------------------------
+//	Cleanup
+//------------------------------------------------------------------------------
+    free(buffer);
+    sf_close(outfile);
+    poptFreeContext(popt_ctx);
+
+    return status;															//	Exit: 0 (no error), 1 on write failure
+}
@@ -0,0 +1,301 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_goertzel.c
+//
+//	Targeted-bin tone analysis; see ab_goertzel.h.
+//------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_goertzel.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//------------------------------------------------------------------------------
+//	Name:		set_frequencies
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Places the probes one bin either side of the fundamental and the
+//	  tones at its multiples; tones at or above Nyquist are dropped from
+//	  the active range (harmonics only go up, so they are always the tail)
+//------------------------------------------------------------------------------
+static void set_frequencies(AbTone *tone)
+{
+    double bin = tone->sample_rate / tone->frame_size;
+    double nyquist = tone->sample_rate / 2.0;
+    double f = tone->fundamental;
+
+    tone->coeff[0] = 2.0 * cos(2.0 * M_PI * (f - bin) / tone->sample_rate);
+    tone->coeff[1] = 2.0 * cos(2.0 * M_PI * (f + bin) / tone->sample_rate);
+
+    tone->active = 0;
+    for (int h = 0; h < tone->tones; h++) {
+        double hf = f * (h + 1);
+        if (hf >= nyquist) {
+            break;
+        }
+        tone->coeff[h + 2] = 2.0 * cos(2.0 * M_PI * hf / tone->sample_rate);
+        tone->active++;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_tone_init
+//
+//	Returns:	0 on success, -1 on bad arguments or allocation failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- tones counts the fundamental: 11 = H1..H11
+//	- window is borrowed, not copied, and must outlive the tracker
+//	- track_hz > 0 lets the fundamental follow the signal within
+//	  +/- track_hz of fundamental; 0 reads the fixed frequencies
+//------------------------------------------------------------------------------
+int ab_tone_init(AbTone *tone, double sample_rate, double fundamental, int tones,
+                 int frame_size, const double *window, double track_hz)
+{
+    memset(tone, 0, sizeof(*tone));
+    if (sample_rate <= 0.0 || fundamental <= 0.0 || tones < 1 || frame_size < 1) {
+        return -1;
+    }
+
+    tone->sample_rate = sample_rate;
+    tone->frame_size = frame_size;
+    tone->tones = tones;
+    tone->window = window;
+    tone->nominal = fundamental;
+    tone->fundamental = fundamental;
+    tone->track_hz = track_hz > 0.0 ? track_hz : 0.0;
+
+    tone->coeff = (double *)calloc(tones + 2, sizeof(double));
+    tone->s1 = (double *)calloc(tones + 2, sizeof(double));
+    tone->s2 = (double *)calloc(tones + 2, sizeof(double));
+    tone->level = (double *)calloc(tones, sizeof(double));
+    tone->freq = (double *)calloc(tones, sizeof(double));
+    if (!tone->coeff || !tone->s1 || !tone->s2 || !tone->level || !tone->freq) {
+        ab_tone_free(tone);
+        return -1;
+    }
+
+    if (window) {
+        for (int i = 0; i < frame_size; i++) {
+            tone->window_sum += window[i];
+        }
+    } else {
+        tone->window_sum = frame_size;
+    }
+
+    set_frequencies(tone);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		end_frame
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reads every resonator, estimates the fundamental for the next frame,
+//	  reports the frame, then retunes: Gaussian (log-parabolic)
+//	  interpolation over the probes and the fundamental, or a one-bin step
+//	  towards the larger probe when the fundamental is not the peak
+//	- |X|^2 = s1^2 + s2^2 - coeff * s1 * s2 holds for any frequency, so
+//	  the magnitude needs no final complex rotation
+//	- The frame is locked when the estimate moved less than
+//	  AB_TONE_LOCK_BINS, i.e. its levels were read on the tone
+//------------------------------------------------------------------------------
+static void end_frame(AbTone *tone, AbToneFrameFn fn, void *user)
+{
+    double mag[2];
+    double scale = tone->window_sum > 0.0 ? 2.0 / tone->window_sum : 0.0;
+
+    for (int i = 0; i < tone->active + 2; i++) {
+        double power = tone->s1[i] * tone->s1[i] + tone->s2[i] * tone->s2[i]
+                     - tone->coeff[i] * tone->s1[i] * tone->s2[i];
+        double m = sqrt(power > 0.0 ? power : 0.0);
+
+        if (i < 2) {
+            mag[i] = m;
+        } else {
+            tone->level[i - 2] = m * scale;
+            tone->freq[i - 2] = tone->fundamental * (i - 1);
+        }
+    }
+    for (int h = tone->active; h < tone->tones; h++) {
+        tone->level[h] = 0.0;
+        tone->freq[h] = 0.0;
+    }
+
+    double mean = tone->sum / tone->weight_sum;
+    tone->ac_power = tone->sum_squares / tone->weight_sum - mean * mean;
+    if (tone->ac_power < 0.0) {
+        tone->ac_power = 0.0;
+    }
+    tone->frames++;
+
+//------------------------------------------------------------------------------
+//	Estimate the fundamental
+//------------------------------------------------------------------------------
+    double estimate = tone->fundamental;
+    tone->locked = 1;
+
+    if (tone->track_hz > 0.0 && tone->active > 0 && tone->level[0] > AB_TONE_TRACK_FLOOR) {
+        double bin = tone->sample_rate / tone->frame_size;
+        double a = log(mag[0] + 1e-300);
+        double b = log(tone->level[0] / scale);
+        double c = log(mag[1] + 1e-300);
+        double offset;
+
+        if (b >= a && b >= c) {
+            double denom = a - 2.0 * b + c;
+            offset = denom < 0.0 ? 0.5 * (a - c) / denom : 0.0;
+        } else {
+            offset = c > a ? 1.0 : -1.0;
+        }
+
+        estimate += offset * bin;
+        if (estimate < tone->nominal - tone->track_hz) estimate = tone->nominal - tone->track_hz;
+        if (estimate > tone->nominal + tone->track_hz) estimate = tone->nominal + tone->track_hz;
+        if (estimate <= bin) {
+            estimate = tone->fundamental;
+        }
+        tone->locked = fabs(estimate - tone->fundamental) < AB_TONE_LOCK_BINS * bin;
+    }
+
+    if (fn) {
+        fn(tone, user);
+    }
+
+    if (estimate != tone->fundamental) {
+        tone->fundamental = estimate;
+        set_frequencies(tone);
+    }
+
+    memset(tone->s1, 0, (tone->tones + 2) * sizeof(double));
+    memset(tone->s2, 0, (tone->tones + 2) * sizeof(double));
+    tone->pos = 0;
+    tone->sum = 0.0;
+    tone->sum_squares = 0.0;
+    tone->weight_sum = 0.0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		run_resonators
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- One windowed sample into every active resonator; the probes only
+//	  run while tracking
+//------------------------------------------------------------------------------
+static void run_resonators(AbTone *tone, double xw)
+{
+    int last = tone->active + 2;
+
+    for (int i = tone->track_hz > 0.0 ? 0 : 2; i < last; i++) {
+        double s0 = xw + tone->coeff[i] * tone->s1[i] - tone->s2[i];
+        tone->s2[i] = tone->s1[i];
+        tone->s1[i] = s0;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_tone_process
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Feeds count mono samples; fn is called for every frame completed,
+//	  so any chunk size works (a chunk of frame_size yields at most one)
+//	- AC power is weighted by the window too: over a frame that does not
+//	  hold whole cycles, the plain mean square of a sine wobbles by far
+//	  more than a -80 dB residual
+//------------------------------------------------------------------------------
+void ab_tone_process(AbTone *tone, const double *samples, size_t count, AbToneFrameFn fn, void *user)
+{
+    for (size_t n = 0; n < count; n++) {
+        double x = samples[n];
+        double w = tone->window ? tone->window[tone->pos] : 1.0;
+
+        run_resonators(tone, x * w);
+        tone->sum += w * x;
+        tone->sum_squares += w * x * x;
+        tone->weight_sum += w;
+
+        if (++tone->pos == tone->frame_size) {
+            end_frame(tone, fn, user);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_tone_finish
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- A file shorter than one frame is zero-padded into a single frame
+//	  (its AC power covers the real samples only); otherwise the partial
+//	  tail is dropped, as the FFT tools do
+//------------------------------------------------------------------------------
+void ab_tone_finish(AbTone *tone, AbToneFrameFn fn, void *user)
+{
+    if (tone->frames > 0 || tone->pos == 0 || tone->weight_sum <= 0.0) {
+        tone->pos = 0;
+        return;
+    }
+
+    while (tone->pos < tone->frame_size) {
+        run_resonators(tone, 0.0);
+        tone->pos++;
+    }
+    end_frame(tone, fn, user);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_tone_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_tone_free(AbTone *tone)
+{
+    free(tone->coeff);
+    free(tone->s1);
+    free(tone->s2);
+    free(tone->level);
+    free(tone->freq);
+    memset(tone, 0, sizeof(*tone));
+}
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_goertzel.h
+//
+//	libaudiobench: targeted-bin tone analysis for the single-tone tools
+//	(ab_thd_calc -g, ab_gain_calc -F). Instead of a full FFT per frame,
+//	one generalized Goertzel resonator per tracked frequency (fundamental
+//	plus harmonics) runs over every sample, so a file costs O(N * k):
+//	- Frequencies need not sit on a bin; each resonator reads the DTFT of
+//	  the windowed frame at exactly h * fundamental
+//	- Levels are amplitudes, 1.0 = full scale: 2 * |X| / sum(w)
+//	- Each completed frame is handed to a callback, so levels stream out
+//	  while the file is still being read
+//	- Optional tracking: two extra resonators one bin either side of the
+//	  fundamental give a log-parabolic frequency estimate every frame, and
+//	  the harmonics follow it (within +/- track_hz of the nominal)
+//	- The frame's AC power (mean square minus mean^2) is kept alongside,
+//	  for THD+N as everything that is not the fundamental
+//	- Frames read before the estimate settles are flagged unlocked, so
+//	  callers can leave them out of whole-file averages
+//
+//	Typical use:
+//		AbTone tone;
+//		ab_tone_init(&tone, rate, 1000.0, 11, 8192, window->coeffs, 50.0);
+//		while ((n = ab_read_mono(file, channels, buf, 8192)) > 0)
+//			ab_tone_process(&tone, buf, n, on_frame, ctx);
+//		ab_tone_finish(&tone, on_frame, ctx);
+//		ab_tone_free(&tone);
+//------------------------------------------------------------------------------
+#ifndef AB_GOERTZEL_H
+#define AB_GOERTZEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AB_TONE_TRACK_FLOOR		1e-5									//	Fundamentals below -100 dBFS are not tracked
+#define AB_TONE_LOCK_BINS		0.1										//	Estimate moved less than this: frame is locked
+
+typedef struct {
+    double sample_rate;
+    int frame_size;
+    int tones;													//	Fundamental + harmonics
+    int active;													//	Tones below Nyquist at the current estimate
+    const double *window;										//	frame_size coefficients, NULL = rectangular
+    double window_sum;
+    double nominal;												//	Fundamental the caller asked for, Hz
+    double track_hz;											//	0 = fixed frequencies
+    double fundamental;											//	Current estimate, Hz
+    double *coeff;												//	2 cos(w): [0..1] probes, [2..] tones
+    double *s1;
+    double *s2;
+    int pos;													//	Samples into the current frame
+    double sum;													//	Window-weighted sums of the current frame
+    double sum_squares;
+    double weight_sum;
+    uint64_t frames;											//	Completed frames
+
+    //	Last completed frame (valid inside the callback)
+    double *level;												//	[tones] amplitude, 0 above Nyquist
+    double *freq;												//	[tones] Hz the level was read at, 0 above Nyquist
+    double ac_power;											//	Window-weighted mean square with DC removed
+    int locked;													//	Levels were read on the tone (always 1 untracked)
+} AbTone;
+
+typedef void (*AbToneFrameFn)(const AbTone *tone, void *user);
+
+int ab_tone_init(AbTone *tone, double sample_rate, double fundamental, int tones,
+                 int frame_size, const double *window, double track_hz);
+void ab_tone_process(AbTone *tone, const double *samples, size_t count, AbToneFrameFn fn, void *user);
+void ab_tone_finish(AbTone *tone, AbToneFrameFn fn, void *user);
+void ab_tone_free(AbTone *tone);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,13 +24,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <portaudio.h>
 #include <popt.h>
+#include "ab_devcache.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
+#define CACHE_FILE			".ab_list_dev"								//	Default inventory, in the home directory
+
 //------------------------------------------------------------------------------
 // Device filter modes
 //------------------------------------------------------------------------------
@@ -40,6 +44,28 @@ typedef enum {
     FILTER_OUTPUT													//	Show only output devices
 } DeviceFilter;
 
+//------------------------------------------------------------------------------
+// One device, as probed from PortAudio or read back from the cache
+//------------------------------------------------------------------------------
+typedef struct {
+    int index;														//	PortAudio device index
+    char name[256];
+    char host_api[64];
+    int max_input_channels;
+    int max_output_channels;
+    double default_sample_rate;
+    double low_input_latency;										//	Seconds
+    double high_input_latency;
+    double low_output_latency;
+    double high_output_latency;
+} DeviceEntry;
+
+typedef struct {
+    DeviceEntry *devices;
+    int count;														//	Entries in devices[]
+    int num_devices;												//	Pa_GetDeviceCount() (some may have no info)
+} DeviceList;
+
 //------------------------------------------------------------------------------
 //	Name:		utf8_display_width
 //
@@ -161,13 +187,13 @@ static void clean_device_name(char *dest, const char *src, size_t dest_size)
 //	- FILTER_INPUT: show only input devices
 //	- FILTER_OUTPUT: show only output devices
 //------------------------------------------------------------------------------
-static int should_display_device(const PaDeviceInfo *device_info, DeviceFilter filter)
+static int should_display_device(const DeviceEntry *device, DeviceFilter filter)
 {
     switch (filter) {
         case FILTER_INPUT:
-            return device_info->maxInputChannels > 0;
+            return device->max_input_channels > 0;
         case FILTER_OUTPUT:
-            return device_info->maxOutputChannels > 0;
+            return device->max_output_channels > 0;
         case FILTER_ALL:
         default:
             return 1;
@@ -185,10 +211,10 @@ static int should_display_device(const PaDeviceInfo *device_info, DeviceFilter f
 //	- Types: "Input", "Output", "Input/Output"
 //	- Based on channel counts
 //------------------------------------------------------------------------------
-static const char* get_device_type(const PaDeviceInfo *device_info)
+static const char* get_device_type(const DeviceEntry *device)
 {
-    int has_input = device_info->maxInputChannels > 0;
-    int has_output = device_info->maxOutputChannels > 0;
+    int has_input = device->max_input_channels > 0;
+    int has_output = device->max_output_channels > 0;
 
     if (has_input && has_output) {
         return "Input/Output";
@@ -230,14 +256,12 @@ static void print_device_table_header(void)
 //	- Displays index, type, name, channels, sample rate, host API
 //	- Handles UTF-8 names with proper alignment
 //------------------------------------------------------------------------------
-static void print_device_row(int device_index,
-                             const PaDeviceInfo *device_info,
-                             const PaHostApiInfo *host_info)
+static void print_device_row(const DeviceEntry *device)
 {
     char clean_name[256];
-    clean_device_name(clean_name, device_info->name, sizeof(clean_name));
+    clean_device_name(clean_name, device->name, sizeof(clean_name));
 
-    const char *device_type = get_device_type(device_info);
+    const char *device_type = get_device_type(device);
 
 //------------------------------------------------------------------------------
 //	Calculate padding for UTF-8 name alignment
@@ -251,29 +275,29 @@ static void print_device_row(int device_index,
 //	Format channel info
 //------------------------------------------------------------------------------
     char channels_str[64];
-    if (device_info->maxInputChannels > 0 && device_info->maxOutputChannels > 0) {
+    if (device->max_input_channels > 0 && device->max_output_channels > 0) {
         snprintf(channels_str, sizeof(channels_str), "%d/%d",
-                device_info->maxInputChannels,
-                device_info->maxOutputChannels);
-    } else if (device_info->maxInputChannels > 0) {
+                device->max_input_channels,
+                device->max_output_channels);
+    } else if (device->max_input_channels > 0) {
         snprintf(channels_str, sizeof(channels_str), "%d in",
-                device_info->maxInputChannels);
+                device->max_input_channels);
     } else {
         snprintf(channels_str, sizeof(channels_str), "%d out",
-                device_info->maxOutputChannels);
+                device->max_output_channels);
     }
 
 //------------------------------------------------------------------------------
 //	Print device row
 //------------------------------------------------------------------------------
     printf("%-5d %-13s %s%*s %-8s %6.0f Hz    %-15s\n",
-           device_index,
+           device->index,
            device_type,
            clean_name,
            padding, "",
            channels_str,
-           device_info->defaultSampleRate,
-           host_info->name);
+           device->default_sample_rate,
+           device->host_api);
 }
 
 //------------------------------------------------------------------------------
@@ -287,55 +311,109 @@ static void print_device_row(int device_index,
 //	- Shows all properties including latency values
 //	- Used for --info mode
 //------------------------------------------------------------------------------
-static void print_device_info_detailed(int device_index,
-                                       const PaDeviceInfo *device_info,
-                                       const PaHostApiInfo *host_info)
+static void print_device_info_detailed(const DeviceEntry *device)
 {
     char clean_name[256];
-    clean_device_name(clean_name, device_info->name, sizeof(clean_name));
+    clean_device_name(clean_name, device->name, sizeof(clean_name));
 
-    printf("\nDevice %d:\n", device_index);
+    printf("\nDevice %d:\n", device->index);
     printf("  Name: %s\n", clean_name);
-    printf("  Host API: %s\n", host_info->name);
-    printf("  Type: %s\n", get_device_type(device_info));
+    printf("  Host API: %s\n", device->host_api);
+    printf("  Type: %s\n", get_device_type(device));
 
-    printf("  Max Input Channels: %d\n", device_info->maxInputChannels);
-    printf("  Max Output Channels: %d\n", device_info->maxOutputChannels);
+    printf("  Max Input Channels: %d\n", device->max_input_channels);
+    printf("  Max Output Channels: %d\n", device->max_output_channels);
 
-    printf("  Default Sample Rate: %.0f Hz\n", device_info->defaultSampleRate);
+    printf("  Default Sample Rate: %.0f Hz\n", device->default_sample_rate);
 
-    if (device_info->maxInputChannels > 0) {
+    if (device->max_input_channels > 0) {
         printf("  Default Low Input Latency: %.4f seconds\n",
-               device_info->defaultLowInputLatency);
+               device->low_input_latency);
         printf("  Default High Input Latency: %.4f seconds\n",
-               device_info->defaultHighInputLatency);
+               device->high_input_latency);
     }
 
-    if (device_info->maxOutputChannels > 0) {
+    if (device->max_output_channels > 0) {
         printf("  Default Low Output Latency: %.4f seconds\n",
-               device_info->defaultLowOutputLatency);
+               device->low_output_latency);
         printf("  Default High Output Latency: %.4f seconds\n",
-               device_info->defaultHighOutputLatency);
+               device->high_output_latency);
     }
 }
 
 //------------------------------------------------------------------------------
-//	Name:		list_audio_devices
+//	Name:		hash_file
+//
+//	Returns:	hash extended with the file's contents (unchanged if unreadable)
+//
+//------------------------------------------------------------------------------
+#ifndef _WIN32
+static uint64_t hash_file(uint64_t hash, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    char block[4096];
+    size_t count;
+
+    if (!file) {
+        return ab_devcache_hash_str(hash, path);
+    }
+    while ((count = fread(block, 1, sizeof(block), file)) > 0) {
+        hash = ab_devcache_hash(hash, block, count);
+    }
+    fclose(file);
+    return hash;
+}
+#endif
+
+//------------------------------------------------------------------------------
+//	Name:		inventory_key
+//
+//	Returns:	1 and the key if this platform has a cheap device signature,
+//				0 if the cache cannot be validated (always probe)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reads only what changes when devices come and go, without starting
+//	  PortAudio: the MMDevices endpoint list with each endpoint's state and
+//	  the installed ASIO drivers on Windows, the ALSA card and PCM lists on
+//	  Linux
+//	- The PortAudio version is part of the key, since it decides the host
+//	  APIs and the device order
+//------------------------------------------------------------------------------
+static int inventory_key(uint64_t *key)
+{
+    uint64_t hash = ab_devcache_hash_str(AB_DEVCACHE_HASH_INIT, Pa_GetVersionText());
+
+#if defined(_WIN32)
+    hash = ab_devcache_hash_endpoints(hash);
+    hash = ab_devcache_hash_registry(hash, "SOFTWARE\\ASIO", NULL);
+#elif defined(__linux__)
+    hash = hash_file(hash, "/proc/asound/cards");
+    hash = hash_file(hash, "/proc/asound/pcm");
+#else
+    (void)hash;
+    return 0;
+#endif
+
+    *key = hash;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		probe_devices
 //
 //	Returns:	0 on success, -1 on error
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Lists all audio devices matching filter
-//	- Initializes PortAudio
-//	- Enumerates devices and displays information
-//	- Optionally shows detailed info for specific device
+//	- Full PortAudio scan: initializes every host API, copies out each
+//	  device's properties and terminates PortAudio again
 //------------------------------------------------------------------------------
-static int list_audio_devices(DeviceFilter filter, int info_device_index)
+static int probe_devices(DeviceList *list)
 {
     PaError err;
-    int num_devices;
-    int displayed_count = 0;
+
+    memset(list, 0, sizeof(*list));
 
 //------------------------------------------------------------------------------
 //	Initialize PortAudio
@@ -350,7 +428,7 @@ static int list_audio_devices(DeviceFilter filter, int info_device_index)
 //------------------------------------------------------------------------------
 //	Get device count
 //------------------------------------------------------------------------------
-    num_devices = Pa_GetDeviceCount();
+    int num_devices = Pa_GetDeviceCount();
     if (num_devices < 0) {
         fprintf(stderr, "Error: Failed to get device count: %s\n",
                 Pa_GetErrorText(num_devices));
@@ -358,9 +436,184 @@ static int list_audio_devices(DeviceFilter filter, int info_device_index)
         return -1;
     }
 
-    if (num_devices == 0) {
+    list->num_devices = num_devices;
+    if (num_devices > 0) {
+        list->devices = (DeviceEntry *)calloc((size_t)num_devices, sizeof(DeviceEntry));
+        if (!list->devices) {
+            fprintf(stderr, "Error: Failed to allocate device list\n");
+            Pa_Terminate();
+            return -1;
+        }
+    }
+
+//------------------------------------------------------------------------------
+//	Copy device and host API info (devices without either are left out)
+//------------------------------------------------------------------------------
+    for (int i = 0; i < num_devices; i++) {
+        const PaDeviceInfo *device_info = Pa_GetDeviceInfo(i);
+        if (!device_info) {
+            continue;
+        }
+        const PaHostApiInfo *host_info = Pa_GetHostApiInfo(device_info->hostApi);
+        if (!host_info) {
+            continue;
+        }
+
+        DeviceEntry *device = &list->devices[list->count++];
+        device->index = i;
+        snprintf(device->name, sizeof(device->name), "%s", device_info->name);
+        snprintf(device->host_api, sizeof(device->host_api), "%s", host_info->name);
+        device->max_input_channels = device_info->maxInputChannels;
+        device->max_output_channels = device_info->maxOutputChannels;
+        device->default_sample_rate = device_info->defaultSampleRate;
+        device->low_input_latency = device_info->defaultLowInputLatency;
+        device->high_input_latency = device_info->defaultHighInputLatency;
+        device->low_output_latency = device_info->defaultLowOutputLatency;
+        device->high_output_latency = device_info->defaultHighOutputLatency;
+    }
+
+    Pa_Terminate();
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		load_cached_devices
+//
+//	Returns:	0 if the inventory was read from the cache, -1 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Records: "count <num_devices>", then one "dev" line per device:
+//	  index, channels in/out, sample rate, four latencies, host API, name
+//------------------------------------------------------------------------------
+static int load_cached_devices(const char *path, uint64_t key, DeviceList *list)
+{
+    char *records = ab_devcache_load(path, key, NULL);
+    char *line = records;
+
+    memset(list, 0, sizeof(*list));
+    if (!records) {
+        return -1;
+    }
+
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+
+        DeviceEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        if (sscanf(line, "count %d", &list->num_devices) == 1 && list->num_devices > 0 && !list->devices) {
+            list->devices = (DeviceEntry *)calloc((size_t)list->num_devices, sizeof(DeviceEntry));
+        } else if (sscanf(line, "dev\t%d\t%d\t%d\t%lf\t%lf\t%lf\t%lf\t%lf\t%63[^\t]\t%255[^\n]",
+                          &entry.index, &entry.max_input_channels, &entry.max_output_channels,
+                          &entry.default_sample_rate,
+                          &entry.low_input_latency, &entry.high_input_latency,
+                          &entry.low_output_latency, &entry.high_output_latency,
+                          entry.host_api, entry.name) == 10 &&
+                   list->devices && list->count < list->num_devices) {
+            list->devices[list->count++] = entry;
+        }
+        line = next;
+    }
+    free(records);
+
+    if (list->num_devices > 0 && !list->devices) {
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		save_cached_devices
+//
+//	Returns:	none (a cache that cannot be written is only a warning)
+//
+//------------------------------------------------------------------------------
+static void save_cached_devices(const char *path, uint64_t key, const DeviceList *list)
+{
+    FILE *file = ab_devcache_begin(path, key);
+
+    if (file) {
+        fprintf(file, "count %d\n", list->num_devices);
+        for (int i = 0; i < list->count; i++) {
+            const DeviceEntry *device = &list->devices[i];
+            fprintf(file, "dev\t%d\t%d\t%d\t%.17g\t%.17g\t%.17g\t%.17g\t%.17g\t",
+                    device->index, device->max_input_channels, device->max_output_channels,
+                    device->default_sample_rate,
+                    device->low_input_latency, device->high_input_latency,
+                    device->low_output_latency, device->high_output_latency);
+            ab_devcache_write_text(file, device->host_api);
+            fputc('\t', file);
+            ab_devcache_write_text(file, device->name);
+            fputc('\n', file);
+        }
+    }
+    if (!file || ab_devcache_commit(file, path) != 0) {
+        fprintf(stderr, "Warning: Could not write device cache '%s'\n", path);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		get_devices
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Uses the cache while its key matches this machine's device signature,
+//	  otherwise (or with 'refresh') probes PortAudio and rewrites it
+//	- With no cache path (--no-cache) PortAudio is always probed and
+//	  nothing is written
+//	- *cached is set when the list came from the cache
+//------------------------------------------------------------------------------
+static int get_devices(const char *cache_path, int refresh, DeviceList *list, int *cached)
+{
+    uint64_t key = 0;
+    int have_key = cache_path && inventory_key(&key);
+
+    *cached = 0;
+    if (have_key && !refresh && load_cached_devices(cache_path, key, list) == 0) {
+        *cached = 1;
+        return 0;
+    }
+
+    if (probe_devices(list) != 0) {
+        return -1;
+    }
+    if (have_key) {
+        save_cached_devices(cache_path, key, list);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		list_audio_devices
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Lists all audio devices matching filter
+//	- Gets the inventory from the cache or PortAudio (see get_devices)
+//	- Enumerates devices and displays information
+//	- Optionally shows detailed info for specific device
+//------------------------------------------------------------------------------
+static int list_audio_devices(DeviceFilter filter, int info_device_index,
+                              const char *cache_path, int refresh)
+{
+    DeviceList list;
+    int cached;
+    int displayed_count = 0;
+
+    if (get_devices(cache_path, refresh, &list, &cached) != 0) {
+        return -1;
+    }
+
+    if (list.num_devices == 0) {
         printf("No audio devices found.\n");
-        Pa_Terminate();
+        free(list.devices);
         return 0;
     }
 
@@ -368,25 +621,28 @@ static int list_audio_devices(DeviceFilter filter, int info_device_index)
 //	Handle --info mode for specific device
 //------------------------------------------------------------------------------
     if (info_device_index >= 0) {
-        if (info_device_index >= num_devices) {
+        if (info_device_index >= list.num_devices) {
             fprintf(stderr, "Error: Device index %d out of range (0-%d)\n",
-                    info_device_index, num_devices - 1);
-            Pa_Terminate();
+                    info_device_index, list.num_devices - 1);
+            free(list.devices);
             return -1;
         }
 
-        const PaDeviceInfo *device_info = Pa_GetDeviceInfo(info_device_index);
-        if (!device_info) {
+        const DeviceEntry *device = NULL;
+        for (int i = 0; i < list.count && !device; i++) {
+            if (list.devices[i].index == info_device_index) {
+                device = &list.devices[i];
+            }
+        }
+        if (!device) {
             fprintf(stderr, "Error: Could not get info for device %d\n",
                     info_device_index);
-            Pa_Terminate();
+            free(list.devices);
             return -1;
         }
 
-        const PaHostApiInfo *host_info = Pa_GetHostApiInfo(device_info->hostApi);
-        print_device_info_detailed(info_device_index, device_info, host_info);
-
-        Pa_Terminate();
+        print_device_info_detailed(device);
+        free(list.devices);
         return 0;
     }
 
@@ -414,31 +670,11 @@ static int list_audio_devices(DeviceFilter filter, int info_device_index)
 //------------------------------------------------------------------------------
 //	Enumerate and display devices
 //------------------------------------------------------------------------------
-    for (int i = 0; i < num_devices; i++) {
-        const PaDeviceInfo *device_info = Pa_GetDeviceInfo(i);
-        if (!device_info) {
+    for (int i = 0; i < list.count; i++) {
+        if (!should_display_device(&list.devices[i], filter)) {
             continue;
         }
-
-//------------------------------------------------------------------------------
-//	Apply filter
-//------------------------------------------------------------------------------
-        if (!should_display_device(device_info, filter)) {
-            continue;
-        }
-
-//------------------------------------------------------------------------------
-//	Get host API info
-//------------------------------------------------------------------------------
-        const PaHostApiInfo *host_info = Pa_GetHostApiInfo(device_info->hostApi);
-        if (!host_info) {
-            continue;
-        }
-
-//------------------------------------------------------------------------------
-//	Print device row
-//------------------------------------------------------------------------------
-        print_device_row(i, device_info, host_info);
+        print_device_row(&list.devices[i]);
         displayed_count++;
     }
 
@@ -454,11 +690,11 @@ static int list_audio_devices(DeviceFilter filter, int info_device_index)
         printf("\nUse --info <index> to see detailed information for a specific device.\n");
         printf("Use with ab_acq to record from a specific device index.\n");
     }
+    if (cached) {
+        printf("Device list from cache '%s' (--refresh to re-probe).\n", cache_path);
+    }
 
-//------------------------------------------------------------------------------
-//	Cleanup
-//------------------------------------------------------------------------------
-    Pa_Terminate();
+    free(list.devices);
     return 0;
 }
 
@@ -484,12 +720,18 @@ int main(int argc, const char **argv)
     int show_output_only = 0;
     int info_device_index = -1;
     int version_flag = 0;
+    int refresh_flag = 0;
+    int no_cache_flag = 0;
+    char *cache_file = NULL;
 
     struct poptOption options[] = {
         {"version",		'v', POPT_ARG_NONE,	&version_flag,		0,	"Show version information",							NULL	},
         {"input",		'i', POPT_ARG_NONE,	&show_input_only,	0,	"Show only input devices",							NULL	},
         {"output",		'o', POPT_ARG_NONE,	&show_output_only,	0,	"Show only output devices",							NULL	},
         {"info",		'I', POPT_ARG_INT,	&info_device_index,	0,	"Show detailed info for specific device index",		"INDEX"	},
+        {"refresh",		'r', POPT_ARG_NONE,	&refresh_flag,		0,	"Re-probe PortAudio and rewrite the device cache",	NULL	},
+        {"no-cache",	'n', POPT_ARG_NONE,	&no_cache_flag,		0,	"Probe PortAudio without reading or writing the cache",	NULL	},
+        {"cache",		'C', POPT_ARG_STRING,	&cache_file,	0,	"Device cache file (default: ~/.ab_list_dev)",		"FILE"	},
         POPT_AUTOHELP
         POPT_TABLEEND
     };
@@ -503,7 +745,10 @@ int main(int argc, const char **argv)
         "  ab_list_dev                # List all devices\n"
         "  ab_list_dev --input        # List input devices only\n"
         "  ab_list_dev --output       # List output devices only\n"
-        "  ab_list_dev --info 0       # Show details for device 0\n");
+        "  ab_list_dev --info 0       # Show details for device 0\n"
+        "  ab_list_dev --refresh      # Re-probe after changing hardware\n\n"
+        "The device list is cached and reused while the installed devices look\n"
+        "unchanged (endpoint and driver lists on Windows, ALSA cards on Linux).\n");
 
     int rc = poptGetNextOpt(popt_ctx);
     if (rc < -1) {
@@ -534,6 +779,12 @@ int main(int argc, const char **argv)
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Resolve the cache file (none with --no-cache)
+//------------------------------------------------------------------------------
+    char cache_path[1024];
+    int have_cache = !no_cache_flag && ab_devcache_path(cache_file, CACHE_FILE, cache_path, sizeof(cache_path));
+
     poptFreeContext(popt_ctx);
 
 //------------------------------------------------------------------------------
@@ -549,5 +800,5 @@ int main(int argc, const char **argv)
 //------------------------------------------------------------------------------
 //	List devices
 //------------------------------------------------------------------------------
-    return list_audio_devices(filter, info_device_index);
+    return list_audio_devices(filter, info_device_index, have_cache ? cache_path : NULL, refresh_flag);
 }
@@ -28,40 +28,7 @@
 #include <sndfile.h>
 #include <popt.h>
 #include <ctype.h>
-
-//------------------------------------------------------------------------------
-//	Name:		get_bit_depth
-//
-//	Returns:	Bit depth (8, 16, 24, 32, 64, or 0 for unknown)
-//
-//------------------------------------------------------------------------------
-//	Detailed description:
-//	- Determines bit depth from SF_INFO format field
-//	- Examines format subtype mask
-//	- Returns appropriate bit depth value
-//------------------------------------------------------------------------------
-int get_bit_depth(int format)
-{
-    int format_subtype = format & SF_FORMAT_SUBMASK;
-
-    switch (format_subtype) {
-    case SF_FORMAT_PCM_S8:
-    case SF_FORMAT_PCM_U8:
-        return 8;
-    case SF_FORMAT_PCM_16:
-        return 16;
-    case SF_FORMAT_PCM_24:
-        return 24;
-    case SF_FORMAT_PCM_32:
-        return 32;
-    case SF_FORMAT_FLOAT:
-        return 32;
-    case SF_FORMAT_DOUBLE:
-        return 64;
-    default:
-        return 0;																//	Unknown
-    }
-}
+#include "ab_core.h"
 
 //------------------------------------------------------------------------------
 //	Name:		is_wav_file
@@ -157,7 +124,7 @@ int list_wav_files(int verbose)
 //------------------------------------------------------------------------------
 //	Get bit depth
 //------------------------------------------------------------------------------
-        int bit_depth = get_bit_depth(sfinfo.format);
+        int bit_depth = ab_bit_depth(sfinfo.format);
 
 //------------------------------------------------------------------------------
 //	Calculate length in seconds
@@ -0,0 +1,299 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_monitor.c
+//
+//	Live level and THD+N monitor; see ab_monitor.h.
+//------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_monitor.h"
+
+//------------------------------------------------------------------------------
+//	Name:		to_db
+//
+//	Returns:	20 log10(value), AB_MONITOR_FLOOR_DB for silence
+//
+//------------------------------------------------------------------------------
+static double to_db(double value)
+{
+    double db = (value > 0.0) ? 20.0 * log10(value) : AB_MONITOR_FLOOR_DB;
+    return (db < AB_MONITOR_FLOOR_DB) ? AB_MONITOR_FLOOR_DB : db;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		tone_frame
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- AbTone frame callback: keeps the frame's THD and THD+N for the next
+//	  update, computed as ab_thd_calc -g does (THD+N is the AC power minus
+//	  the fundamental's A^2 / 2, relative to the fundamental)
+//------------------------------------------------------------------------------
+static void tone_frame(const AbTone *tone, void *user)
+{
+    AbMonitorChannel *ch = (AbMonitorChannel *)user;
+    double fundamental_power = tone->level[0] * tone->level[0];
+    double harmonic_power = 0.0;
+
+    for (int h = 1; h < tone->tones; h++) {
+        harmonic_power += tone->level[h] * tone->level[h];
+    }
+
+    double residual = tone->ac_power - fundamental_power / 2.0;
+    ch->thd = sqrt(harmonic_power / (fundamental_power + 1e-30));
+    ch->thdn = sqrt((residual > 0.0 ? residual : 0.0) / (fundamental_power / 2.0 + 1e-30));
+    ch->level_dbfs = to_db(tone->level[0]);
+    ch->freq = tone->fundamental;
+    ch->locked = tone->locked && tone->level[0] > AB_TONE_TRACK_FLOOR;
+    ch->tone_valid = 1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_monitor_init
+//
+//	Returns:	0 on success, -1 on bad arguments or allocation failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- interval is the update period in seconds (at least one frame)
+//	- harmonics counts the harmonics above the fundamental: 10 = H2..H11
+//	- window (frame_size coefficients, NULL = rectangular) is borrowed and
+//	  must outlive the monitor; track_hz as for ab_tone_init()
+//------------------------------------------------------------------------------
+int ab_monitor_init(AbMonitor *mon, double sample_rate, int channels, double interval,
+                    double fundamental, int harmonics, int frame_size, const double *window,
+                    double track_hz)
+{
+    memset(mon, 0, sizeof(*mon));
+    if (sample_rate <= 0.0 || channels < 1 || interval <= 0.0 || harmonics < 0) {
+        return -1;
+    }
+
+    mon->sample_rate = sample_rate;
+    mon->channels = channels;
+    mon->harmonics = harmonics;
+    mon->interval_frames = (size_t)(interval * sample_rate + 0.5);
+    if (mon->interval_frames == 0) {
+        mon->interval_frames = 1;
+    }
+
+    mon->channel = (AbMonitorChannel *)calloc(channels, sizeof(AbMonitorChannel));
+    mon->scratch = (double *)malloc(AB_MONITOR_CHUNK * sizeof(double));
+    if (!mon->channel || !mon->scratch) {
+        ab_monitor_free(mon);
+        return -1;
+    }
+
+    for (int c = 0; c < channels; c++) {
+        if (ab_tone_init(&mon->channel[c].tone, sample_rate, fundamental, harmonics + 1,
+                         frame_size, window, track_hz) != 0) {
+            ab_monitor_free(mon);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		end_interval
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void end_interval(AbMonitor *mon, AbMonitorFn fn, void *user)
+{
+    for (int c = 0; c < mon->channels; c++) {
+        AbMonitorChannel *ch = &mon->channel[c];
+        double rms = sqrt(ch->sum_squares / mon->pos);
+
+        ch->peak_dbfs = to_db(ch->peak);
+        ch->rms_dbfs = to_db(rms);
+        ch->crest_db = (ch->peak > 0.0 && rms > 0.0) ? ch->peak_dbfs - ch->rms_dbfs : 0.0;
+        ch->peak_hold_dbfs = to_db(ch->peak_hold);
+    }
+    mon->updates++;
+
+    if (fn) {
+        fn(mon, user);
+    }
+
+    for (int c = 0; c < mon->channels; c++) {
+        mon->channel[c].peak = 0.0;
+        mon->channel[c].sum_squares = 0.0;
+    }
+    mon->pos = 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_monitor_push
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Feeds count interleaved frames; fn is called for every update
+//	  interval completed, so any chunk size works (ring spans as they are)
+//	- Segments never cross an interval boundary, so each update covers
+//	  exactly interval_frames frames
+//------------------------------------------------------------------------------
+void ab_monitor_push(AbMonitor *mon, const float *frames, size_t count, AbMonitorFn fn, void *user)
+{
+    int channels = mon->channels;
+
+    while (count > 0) {
+        size_t segment = mon->interval_frames - mon->pos;
+        if (segment > count) {
+            segment = count;
+        }
+        if (segment > AB_MONITOR_CHUNK) {
+            segment = AB_MONITOR_CHUNK;
+        }
+
+        for (int c = 0; c < channels; c++) {
+            AbMonitorChannel *ch = &mon->channel[c];
+            double peak = ch->peak;
+            double sum_squares = 0.0;
+
+            for (size_t i = 0; i < segment; i++) {
+                double x = frames[i * channels + c];
+                double mag = fabs(x);
+                if (mag > peak) {
+                    peak = mag;
+                }
+                sum_squares += x * x;
+                mon->scratch[i] = x;
+            }
+            ch->peak = peak;
+            ch->sum_squares += sum_squares;
+            if (peak > ch->peak_hold) {
+                ch->peak_hold = peak;
+            }
+            ab_tone_process(&ch->tone, mon->scratch, segment, tone_frame, ch);
+        }
+
+        frames += segment * channels;
+        count -= segment;
+        mon->pos += segment;
+        mon->frames += segment;
+        if (mon->pos == mon->interval_frames) {
+            end_interval(mon, fn, user);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_monitor_print
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- One console line per channel for the last update; THD figures are
+//	  shown once a tone frame has completed and the fundamental is above
+//	  the tracking floor, and marked '*' while the tracker is settling
+//	- dropped: frames the tool lost so far (ring full), shown when non-zero
+//------------------------------------------------------------------------------
+void ab_monitor_print(const AbMonitor *mon, FILE *out, uint64_t dropped)
+{
+    double time = (double)mon->frames / mon->sample_rate;
+
+    for (int c = 0; c < mon->channels; c++) {
+        const AbMonitorChannel *ch = &mon->channel[c];
+
+        fprintf(out, "%9.2f s  ch %d  peak %7.2f  rms %7.2f dBFS  crest %5.2f dB  hold %7.2f",
+                time, c, ch->peak_dbfs, ch->rms_dbfs, ch->crest_db, ch->peak_hold_dbfs);
+        if (ch->tone_valid && ch->level_dbfs > to_db(AB_TONE_TRACK_FLOOR)) {
+            fprintf(out, "  THD %8.4f%%  THD+N %8.4f%% @ %9.2f Hz%s",
+                    ch->thd * 100.0, ch->thdn * 100.0, ch->freq, ch->locked ? "" : " *");
+        } else {
+            fprintf(out, "  THD        -   THD+N        -");
+        }
+        if (c == 0 && dropped > 0) {
+            fprintf(out, "  (%llu dropped)", (unsigned long long)dropped);
+        }
+        fprintf(out, "\n");
+    }
+    fflush(out);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_monitor_write_json
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- One JSON object per update on a single line, flushed so it streams
+//	  through a pipe; levels in dBFS (AB_MONITOR_FLOOR_DB for silence),
+//	  THD and THD+N in percent, null until they can be measured
+//------------------------------------------------------------------------------
+void ab_monitor_write_json(const AbMonitor *mon, FILE *out, uint64_t dropped)
+{
+    fprintf(out, "{\"time_s\": %.4f, \"update\": %llu, \"dropped_frames\": %llu, \"channels\": [",
+            (double)mon->frames / mon->sample_rate, (unsigned long long)mon->updates,
+            (unsigned long long)dropped);
+
+    for (int c = 0; c < mon->channels; c++) {
+        const AbMonitorChannel *ch = &mon->channel[c];
+
+        fprintf(out, "%s{\"channel\": %d, \"peak_dbfs\": %.3f, \"rms_dbfs\": %.3f, "
+                "\"crest_db\": %.3f, \"peak_hold_dbfs\": %.3f, ",
+                (c > 0) ? ", " : "", c, ch->peak_dbfs, ch->rms_dbfs, ch->crest_db, ch->peak_hold_dbfs);
+        if (ch->tone_valid && ch->level_dbfs > to_db(AB_TONE_TRACK_FLOOR)) {
+            fprintf(out, "\"freq_hz\": %.3f, \"level_dbfs\": %.3f, \"thd_pct\": %.6f, "
+                    "\"thdn_pct\": %.6f, \"locked\": %s}",
+                    ch->freq, ch->level_dbfs, ch->thd * 100.0, ch->thdn * 100.0,
+                    ch->locked ? "true" : "false");
+        } else {
+            fprintf(out, "\"freq_hz\": null, \"level_dbfs\": %.3f, \"thd_pct\": null, "
+                    "\"thdn_pct\": null, \"locked\": false}",
+                    ch->tone_valid ? ch->level_dbfs : AB_MONITOR_FLOOR_DB);
+        }
+    }
+    fprintf(out, "]}\n");
+    fflush(out);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_monitor_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_monitor_free(AbMonitor *mon)
+{
+    if (mon->channel) {
+        for (int c = 0; c < mon->channels; c++) {
+            ab_tone_free(&mon->channel[c].tone);
+        }
+    }
+    free(mon->channel);
+    free(mon->scratch);
+    memset(mon, 0, sizeof(*mon));
+}
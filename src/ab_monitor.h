@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_monitor.h
+//
+//	libaudiobench: live level and THD+N monitor for the capture tools
+//	(ab_acq -m, ab_acq_asio -m). The tool's input callback pushes samples
+//	into an AbRing as for streaming capture; the consumer thread drains
+//	the ring into the monitor instead of a file:
+//	- Per channel and per update interval: peak, RMS and crest factor
+//	  (dBFS re a full-scale square wave, as ab_check_levels reports),
+//	  plus a peak hold over the whole run
+//	- Per channel, continuously: an AbTone tracker (see ab_goertzel.h)
+//	  over the fundamental and its harmonics; each update reports the
+//	  last completed tone frame's THD, THD+N, level and frequency
+//	- Everything is allocated by ab_monitor_init(); ab_monitor_push()
+//	  only updates sums, so it keeps up with the callback at any rate
+//	- Updates go to a callback, which typically prints them with
+//	  ab_monitor_print() or ab_monitor_write_json() (one JSON line each)
+//
+//	Typical use:
+//		AbMonitor mon;
+//		ab_monitor_init(&mon, rate, channels, 0.5, 1000.0, 10, 8192, window->coeffs, 50.0);
+//		(consumer thread, for each ring span)
+//			ab_monitor_push(&mon, span, frames, on_update, ctx);
+//		ab_monitor_free(&mon);
+//------------------------------------------------------------------------------
+#ifndef AB_MONITOR_H
+#define AB_MONITOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ab_goertzel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AB_MONITOR_CHUNK		1024									//	Frames de-interleaved per ab_tone_process() call
+#define AB_MONITOR_FLOOR_DB		-200.0									//	Reported for silence (keeps JSON finite)
+
+typedef struct {
+    double peak;												//	Current interval
+    double sum_squares;
+    double peak_hold;											//	Whole run
+    AbTone tone;
+
+    //	Last update (valid inside the callback)
+    double peak_dbfs;
+    double rms_dbfs;
+    double crest_db;
+    double peak_hold_dbfs;
+
+    //	Last completed tone frame
+    double level_dbfs;											//	Fundamental amplitude, 0 dBFS = full-scale sine
+    double freq;												//	Fundamental estimate, Hz
+    double thd;													//	Ratios, not percent
+    double thdn;
+    int locked;													//	Tracker settled on the tone
+    int tone_valid;												//	At least one tone frame has completed
+} AbMonitorChannel;
+
+typedef struct {
+    double sample_rate;
+    int channels;
+    int harmonics;												//	Harmonics above the fundamental in the THD
+    size_t interval_frames;										//	Frames per update
+    size_t pos;													//	Frames into the current interval
+    uint64_t frames;											//	Frames pushed since init
+    uint64_t updates;
+    AbMonitorChannel *channel;									//	[channels]
+    double *scratch;											//	AB_MONITOR_CHUNK de-interleaved samples
+} AbMonitor;
+
+typedef void (*AbMonitorFn)(const AbMonitor *mon, void *user);
+
+int ab_monitor_init(AbMonitor *mon, double sample_rate, int channels, double interval,
+                    double fundamental, int harmonics, int frame_size, const double *window,
+                    double track_hz);
+void ab_monitor_push(AbMonitor *mon, const float *frames, size_t count, AbMonitorFn fn, void *user);
+void ab_monitor_print(const AbMonitor *mon, FILE *out, uint64_t dropped);
+void ab_monitor_write_json(const AbMonitor *mon, FILE *out, uint64_t dropped);
+void ab_monitor_free(AbMonitor *mon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_ring.c
+//
+//	Lock-free SPSC sample ring; see ab_ring.h.
+//------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "ab_ring.h"
+
+#define CACHE_LINE				64										//	Keeps the two positions on separate lines
+
+//------------------------------------------------------------------------------
+//	The positions are 64-bit even where size_t is 32-bit: the capacity need
+//	not be a power of two, so a 32-bit counter reduced with % capacity would
+//	jump when it wraps (after 2^32 samples, about 6 h of 8 channels at
+//	48 kHz). 64-bit atomics stay lock-free on 32-bit x86 (cmpxchg8b and
+//	8-byte loads/stores), so the callback side still never blocks.
+//------------------------------------------------------------------------------
+struct AbRing {
+    float *data;
+    size_t capacity;											//	Samples (frames * channels)
+    size_t channels;
+    _Atomic uint64_t write_pos;									//	Samples ever written (producer)
+    char pad[CACHE_LINE];										//	No false sharing between the sides
+    _Atomic uint64_t read_pos;									//	Samples ever read (consumer)
+};
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_create
+//
+//	Returns:	new ring, or NULL on allocation failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Holds frames * channels samples; all allocation happens here, so
+//	  the producer and consumer calls are safe in a real-time callback
+//------------------------------------------------------------------------------
+AbRing *ab_ring_create(size_t frames, int channels)
+{
+    if (frames == 0 || channels < 1) {
+        return NULL;
+    }
+
+    AbRing *ring = (AbRing *)calloc(1, sizeof(AbRing));
+    if (!ring) {
+        return NULL;
+    }
+
+    ring->channels = (size_t)channels;
+    ring->capacity = frames * ring->channels;
+    ring->data = (float *)calloc(ring->capacity, sizeof(float));
+    if (!ring->data) {
+        free(ring);
+        return NULL;
+    }
+    atomic_init(&ring->write_pos, 0);
+    atomic_init(&ring->read_pos, 0);
+    return ring;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_destroy
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Neither side may be using the ring; NULL is ignored
+//------------------------------------------------------------------------------
+void ab_ring_destroy(AbRing *ring)
+{
+    if (ring) {
+        free(ring->data);
+        free(ring);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_capacity
+//
+//	Returns:	capacity in samples
+//
+//------------------------------------------------------------------------------
+size_t ab_ring_capacity(const AbRing *ring)
+{
+    return ring->capacity;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_write
+//
+//	Returns:	number of samples stored (less than count if the ring is full)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Producer side; stores whole frames only (count should be a multiple
+//	  of channels, and so is the result)
+//	- Never blocks or allocates; what does not fit is left to the caller
+//	  to count as dropped
+//------------------------------------------------------------------------------
+size_t ab_ring_write(AbRing *ring, const float *src, size_t count)
+{
+    uint64_t write_pos = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    uint64_t read_pos = atomic_load_explicit(&ring->read_pos, memory_order_acquire);
+    size_t space = ring->capacity - (size_t)(write_pos - read_pos);
+
+    if (count > space) {
+        count = space;
+    }
+    count -= count % ring->channels;
+
+    size_t start = (size_t)(write_pos % ring->capacity);
+    size_t first = ring->capacity - start;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(ring->data + start, src, first * sizeof(float));
+    memcpy(ring->data, src + first, (count - first) * sizeof(float));
+
+    atomic_store_explicit(&ring->write_pos, write_pos + count, memory_order_release);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_peek
+//
+//	Returns:	total number of readable samples (spans->count[0] + [1])
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Consumer side; fills spans with everything written so far, oldest
+//	  first, without copying
+//	- The spans stay valid until the same samples are consumed: the
+//	  producer never writes over unconsumed data
+//------------------------------------------------------------------------------
+size_t ab_ring_peek(AbRing *ring, AbRingSpans *spans)
+{
+    uint64_t read_pos = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+    uint64_t write_pos = atomic_load_explicit(&ring->write_pos, memory_order_acquire);
+    size_t available = (size_t)(write_pos - read_pos);
+    size_t start = (size_t)(read_pos % ring->capacity);
+    size_t first = ring->capacity - start;
+
+    if (first > available) {
+        first = available;
+    }
+    spans->data[0] = ring->data + start;
+    spans->count[0] = first;
+    spans->data[1] = ring->data;
+    spans->count[1] = available - first;
+    return available;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_consume
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Consumer side; releases count samples (at most what the last
+//	  ab_ring_peek() returned) back to the producer
+//------------------------------------------------------------------------------
+void ab_ring_consume(AbRing *ring, size_t count)
+{
+    uint64_t read_pos = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+    atomic_store_explicit(&ring->read_pos, read_pos + count, memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_fill
+//
+//	Returns:	number of samples written but not yet consumed
+//
+//------------------------------------------------------------------------------
+size_t ab_ring_fill(const AbRing *ring)
+{
+    uint64_t read_pos = atomic_load_explicit(&((AbRing *)ring)->read_pos, memory_order_acquire);
+    uint64_t write_pos = atomic_load_explicit(&((AbRing *)ring)->write_pos, memory_order_acquire);
+    return (size_t)(write_pos - read_pos);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_ring_reset
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Empties the ring and restarts both positions at 'position' (a new
+//	  ring starts at 0); neither side may be using the ring
+//	- Lets the tests start the counters just below a 32-bit boundary
+//------------------------------------------------------------------------------
+void ab_ring_reset(AbRing *ring, uint64_t position)
+{
+    atomic_store_explicit(&ring->write_pos, position, memory_order_relaxed);
+    atomic_store_explicit(&ring->read_pos, position, memory_order_release);
+}
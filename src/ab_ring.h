@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_ring.h
+//
+//	libaudiobench: lock-free single-producer / single-consumer sample ring,
+//	shared by every tool that hands audio from a real-time callback to
+//	another thread (ab_acq, ab_audio_visualizer, ab_acq_asio).
+//
+//	- One thread writes (ab_ring_write), one thread reads (ab_ring_peek,
+//	  ab_ring_consume); neither ever waits on the other
+//	- Positions are free-running 64-bit sample counters (also on 32-bit
+//	  builds, so they never wrap in practice); each side publishes its
+//	  own with release ordering and reads the other's with acquire
+//	- The capacity is a whole number of frames and writes store whole
+//	  frames, so every span the reader sees starts and ends on a frame
+//	- ab_ring_peek() returns the readable data as one or two contiguous
+//	  spans (two when it wraps) pointing into the ring: no copy is made,
+//	  and the spans stay valid until the reader consumes them
+//
+//	The ring is opaque so the same C11 implementation can be used from the
+//	C++ ASIO tools.
+//------------------------------------------------------------------------------
+#ifndef AB_RING_H
+#define AB_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct AbRing AbRing;
+
+//------------------------------------------------------------------------------
+//	Readable region returned by ab_ring_peek(); span[1] is empty unless
+//	the region wraps past the end of the buffer
+//------------------------------------------------------------------------------
+typedef struct {
+    const float *data[2];
+    size_t count[2];											//	Samples in each span
+} AbRingSpans;
+
+AbRing *ab_ring_create(size_t frames, int channels);
+void ab_ring_destroy(AbRing *ring);
+size_t ab_ring_capacity(const AbRing *ring);
+
+//	Producer
+size_t ab_ring_write(AbRing *ring, const float *src, size_t count);
+
+//	Consumer
+size_t ab_ring_peek(AbRing *ring, AbRingSpans *spans);
+void ab_ring_consume(AbRing *ring, size_t count);
+
+//	Either side (a snapshot; exact only from the thread that is not moving)
+size_t ab_ring_fill(const AbRing *ring);
+
+//	Neither side running
+void ab_ring_reset(AbRing *ring, uint64_t position);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
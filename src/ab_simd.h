@@ -0,0 +1,368 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_simd.h
+//
+//	Vector kernels for the FFT tools' per-bin and per-sample inner loops
+//	(C and C++):
+//	- Windowing: dst = src * window, optionally narrowing double to float
+//	- Plain double to float narrowing
+//	- Power accumulation: power += re^2 + im^2 over an FFTW complex array
+//	- Power to dBFS conversion for the single precision path
+//	- Per-channel peak and sum of squares over interleaved samples
+//
+//	SSE2 is used when the compiler targets it (always the case for x86-64,
+//	including MinGW-w64); other targets get the plain scalar loops. Results of
+//	the double kernels are bit-identical to the scalar code because every lane
+//	performs the same IEEE operations in the same order.
+//
+//	Arrays may have any alignment (unaligned loads/stores are used), but
+//	fftw_malloc()/fftwf_malloc() buffers avoid split cache lines.
+//------------------------------------------------------------------------------
+#ifndef AB_SIMD_H
+#define AB_SIMD_H
+
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AB_SIMD_SSE2	1
+#endif
+
+#ifdef __cplusplus
+#define AB_RESTRICT		__restrict
+#else
+#define AB_RESTRICT		restrict
+#endif
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_name
+//
+//	Returns:	printable name of the vector instruction set in use
+//
+//------------------------------------------------------------------------------
+static inline const char *ab_simd_name(void)
+{
+#ifdef AB_SIMD_SSE2
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_window_d
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- dst[i] = src[i] * window[i] for i in [0, n)
+//	- dst may equal src (in-place windowing)
+//------------------------------------------------------------------------------
+static inline void ab_simd_window_d(double *dst, const double *src, const double *window, int n)
+{
+    int i = 0;
+#ifdef AB_SIMD_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_mul_pd(_mm_loadu_pd(src + i), _mm_loadu_pd(window + i));
+        __m128d b = _mm_mul_pd(_mm_loadu_pd(src + i + 2), _mm_loadu_pd(window + i + 2));
+        _mm_storeu_pd(dst + i, a);
+        _mm_storeu_pd(dst + i + 2, b);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = src[i] * window[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_window_f
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- dst[i] = (float)src[i] * window[i]: narrows double samples to float and
+//	  windows them in one pass, so the single precision FFT input is written
+//	  once and never exists as a double array
+//------------------------------------------------------------------------------
+static inline void ab_simd_window_f(float *AB_RESTRICT dst, const double *AB_RESTRICT src,
+                                    const float *AB_RESTRICT window, int n)
+{
+    int i = 0;
+#ifdef AB_SIMD_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        __m128 x = _mm_movelh_ps(lo, hi);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(x, _mm_loadu_ps(window + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (float)src[i] * window[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_narrow_f
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- dst[i] = (float)src[i] for i in [0, n), e.g. to fill fftwf input arrays
+//	  from double sample buffers
+//------------------------------------------------------------------------------
+static inline void ab_simd_narrow_f(float *AB_RESTRICT dst, const double *AB_RESTRICT src, size_t n)
+{
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (float)src[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_power_acc_d
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- power[i] += re^2 + im^2, spectrum is an fftw_complex array viewed as
+//	  interleaved doubles
+//------------------------------------------------------------------------------
+static inline void ab_simd_power_acc_d(double *AB_RESTRICT power, const double *AB_RESTRICT spectrum, int bins)
+{
+    int i = 0;
+#ifdef AB_SIMD_SSE2
+    for (; i + 2 <= bins; i += 2) {
+        __m128d a = _mm_loadu_pd(spectrum + 2 * i);						//	re0 im0
+        __m128d b = _mm_loadu_pd(spectrum + 2 * i + 2);					//	re1 im1
+        a = _mm_mul_pd(a, a);
+        b = _mm_mul_pd(b, b);
+        __m128d re = _mm_unpacklo_pd(a, b);
+        __m128d im = _mm_unpackhi_pd(a, b);
+        _mm_storeu_pd(power + i, _mm_add_pd(_mm_loadu_pd(power + i), _mm_add_pd(re, im)));
+    }
+#endif
+    for (; i < bins; i++) {
+        double real = spectrum[2 * i];
+        double imag = spectrum[2 * i + 1];
+        power[i] += real * real + imag * imag;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_power_acc_f
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Single precision version of ab_simd_power_acc_d (fftwf_complex input),
+//	  four bins per step
+//------------------------------------------------------------------------------
+static inline void ab_simd_power_acc_f(float *AB_RESTRICT power, const float *AB_RESTRICT spectrum, int bins)
+{
+    int i = 0;
+#ifdef AB_SIMD_SSE2
+    for (; i + 4 <= bins; i += 4) {
+        __m128 a = _mm_loadu_ps(spectrum + 2 * i);							//	re0 im0 re1 im1
+        __m128 b = _mm_loadu_ps(spectrum + 2 * i + 4);						//	re2 im2 re3 im3
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(power + i, _mm_add_ps(_mm_loadu_ps(power + i), _mm_add_ps(re, im)));
+    }
+#endif
+    for (; i < bins; i++) {
+        float real = spectrum[2 * i];
+        float imag = spectrum[2 * i + 1];
+        power[i] += real * real + imag * imag;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_level_stats
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Updates per-channel running max, min and sum of squares with 'frames'
+//	  interleaved frames of 'channels' samples
+//	- max/min/sum_sq are arrays of 'channels' values that the caller sets to
+//	  zero and carries from one block to the next; peaks are measured from
+//	  zero, so max never drops below 0 and min never rises above 0
+//	- The SIMD path walks blocks of lcm(2, channels) samples so each vector
+//	  lane always holds the same channel; lanes are folded back per channel
+//	  at the end. Channel counts above AB_SIMD_MAX_LEVEL_CHANNELS use the
+//	  scalar loop.
+//------------------------------------------------------------------------------
+#define AB_SIMD_MAX_LEVEL_CHANNELS	64
+
+static inline void ab_simd_level_stats(const double *samples, size_t frames, int channels,
+                                       double *max, double *min, double *sum_sq)
+{
+    size_t total = frames * (size_t)channels;
+    size_t i = 0;
+#ifdef AB_SIMD_SSE2
+    if (channels <= AB_SIMD_MAX_LEVEL_CHANNELS) {
+        int block = (channels % 2 == 0) ? channels : 2 * channels;			//	Samples per lane-aligned block
+        int vectors = block / 2;
+        __m128d vmax[AB_SIMD_MAX_LEVEL_CHANNELS];
+        __m128d vmin[AB_SIMD_MAX_LEVEL_CHANNELS];
+        __m128d vsq[AB_SIMD_MAX_LEVEL_CHANNELS];
+
+        for (int v = 0; v < vectors; v++) {
+            vmax[v] = _mm_setzero_pd();
+            vmin[v] = _mm_setzero_pd();
+            vsq[v] = _mm_setzero_pd();
+        }
+        for (; i + block <= total; i += block) {
+            for (int v = 0; v < vectors; v++) {
+                __m128d x = _mm_loadu_pd(samples + i + 2 * v);
+                vmax[v] = _mm_max_pd(vmax[v], x);
+                vmin[v] = _mm_min_pd(vmin[v], x);
+                vsq[v] = _mm_add_pd(vsq[v], _mm_mul_pd(x, x));
+            }
+        }
+
+//------------------------------------------------------------------------------
+//	Fold lanes back into their channels (lane j of the block is channel
+//	j % channels)
+//------------------------------------------------------------------------------
+        for (int v = 0; v < vectors; v++) {
+            double lane_max[2], lane_min[2], lane_sq[2];
+            _mm_storeu_pd(lane_max, vmax[v]);
+            _mm_storeu_pd(lane_min, vmin[v]);
+            _mm_storeu_pd(lane_sq, vsq[v]);
+            for (int lane = 0; lane < 2; lane++) {
+                int ch = (2 * v + lane) % channels;
+                if (lane_max[lane] > max[ch]) max[ch] = lane_max[lane];
+                if (lane_min[lane] < min[ch]) min[ch] = lane_min[lane];
+                sum_sq[ch] += lane_sq[lane];
+            }
+        }
+    }
+#endif
+    for (; i < total; i++) {
+        int ch = (int)(i % channels);
+        double x = samples[i];
+        if (x > max[ch]) max[ch] = x;
+        if (x < min[ch]) min[ch] = x;
+        sum_sq[ch] += x * x;
+    }
+}
+
+#ifdef AB_SIMD_SSE2
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_log_ps
+//
+//	Returns:	natural logarithm of four positive, normal floats
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Cephes logf(): split x = m * 2^e with m in [sqrt(0.5), sqrt(2)), then a
+//	  degree 9 polynomial in (m - 1); about 1 ulp over the normal range
+//	- Zero, negative and denormal inputs are not handled (callers add a
+//	  positive floor first)
+//------------------------------------------------------------------------------
+static inline __m128 ab_simd_log_ps(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i bits = _mm_castps_si128(x);
+
+    __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126));
+    __m128 e = _mm_cvtepi32_ps(exponent);
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                             _mm_set1_epi32(0x3F000000)));		//	m in [0.5, 1)
+
+    __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+    e = _mm_sub_ps(e, _mm_and_ps(one, small));
+    m = _mm_add_ps(_mm_sub_ps(m, one), _mm_and_ps(m, small));				//	m - 1, or 2m - 1 if small
+
+    __m128 z = _mm_mul_ps(m, m);
+    __m128 y = _mm_set1_ps(7.0376836292e-2f);
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993e-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174e-1f));
+    y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+#endif
+
+//------------------------------------------------------------------------------
+//	Name:		ab_simd_power_db_f
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- db[i] = 20 * log10(sqrt(power[i] * power_scale) * magnitude_scale + noise_floor)
+//	- power_scale is typically 1/windows (averaging), magnitude_scale the FFT
+//	  size and window gain normalisation, noise_floor the bit-depth floor
+//	- noise_floor must be positive; it keeps log10() finite for empty bins
+//------------------------------------------------------------------------------
+static inline void ab_simd_power_db_f(float *AB_RESTRICT db, const float *AB_RESTRICT power, int bins,
+                                      float power_scale, float magnitude_scale, float noise_floor)
+{
+    int i = 0;
+#ifdef AB_SIMD_SSE2
+    const __m128 ps = _mm_set1_ps(power_scale);
+    const __m128 ms = _mm_set1_ps(magnitude_scale);
+    const __m128 fl = _mm_set1_ps(noise_floor);
+    const __m128 to_db = _mm_set1_ps(8.68588963806503655f);				//	20 / ln(10)
+
+    for (; i + 4 <= bins; i += 4) {
+        __m128 mag = _mm_sqrt_ps(_mm_mul_ps(_mm_loadu_ps(power + i), ps));
+        mag = _mm_add_ps(_mm_mul_ps(mag, ms), fl);
+        _mm_storeu_ps(db + i, _mm_mul_ps(ab_simd_log_ps(mag), to_db));
+    }
+#endif
+    for (; i < bins; i++) {
+        db[i] = 20.0f * log10f(sqrtf(power[i] * power_scale) * magnitude_scale + noise_floor);
+    }
+}
+
+#endif
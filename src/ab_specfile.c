@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_specfile.c
+//
+//	Binary spectrum container writer; see ab_specfile.h. The header is
+//	packed byte by byte so its layout does not depend on struct padding;
+//	frames are written as host floats, which are little-endian on every
+//	host the tools are built for.
+//------------------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include "ab_specfile.h"
+
+//------------------------------------------------------------------------------
+//	Little-endian header fields
+//------------------------------------------------------------------------------
+static void put_le32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void put_le64(unsigned char *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static void put_f32(unsigned char *p, float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    put_le32(p, v);
+}
+
+static void put_f64(unsigned char *p, double d)
+{
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    put_le64(p, v);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_specfile_create
+//
+//	Returns:	0 on success, -1 if the file cannot be created or written
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Creates (or truncates) the file and writes the header with a frame
+//	  count of 0; nothing is printed, the caller reports the error
+//------------------------------------------------------------------------------
+int ab_specfile_create(const char *filename, const AbSpecInfo *info, AbSpecFile *spec)
+{
+    unsigned char header[AB_SPEC_HEADER_BYTES];
+
+    memset(spec, 0, sizeof(*spec));
+    if (info->bins < 1) {
+        return -1;
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, "ABSPEC01", 8);
+    put_le32(header + 8, AB_SPEC_HEADER_BYTES);
+    put_le32(header + 12, (uint32_t)info->bins);
+    put_le32(header + 20, (uint32_t)info->sample_rate);
+    put_le32(header + 24, (uint32_t)info->fft_size);
+    put_le32(header + 28, (uint32_t)info->window);
+    put_f32(header + 32, (float)info->window_beta);
+    put_le32(header + 36, (uint32_t)info->average);
+    put_f64(header + 40, info->time_start);
+    put_f64(header + 48, info->time_step);
+    put_f64(header + 56, info->freq_start);
+    put_f64(header + 64, info->freq_step);
+    put_le32(header + 72, (uint32_t)info->freq_scale);
+
+    spec->file = fopen(filename, "wb");
+    if (!spec->file) {
+        return -1;
+    }
+    if (fwrite(header, 1, sizeof(header), spec->file) != sizeof(header) || fflush(spec->file) != 0) {
+        fclose(spec->file);
+        spec->file = NULL;
+        return -1;
+    }
+    spec->bins = info->bins;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_specfile_append
+//
+//	Returns:	0 on success, -1 on a write error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Appends one frame of 'bins' dB values and flushes it, so the file
+//	  only ever grows by whole frames
+//------------------------------------------------------------------------------
+int ab_specfile_append(AbSpecFile *spec, const float *db)
+{
+    if (fwrite(db, sizeof(float), (size_t)spec->bins, spec->file) != (size_t)spec->bins ||
+        fflush(spec->file) != 0) {
+        return -1;
+    }
+    spec->frames++;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_specfile_close
+//
+//	Returns:	0 on success, -1 if the frame count could not be written
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes the final frame count into the header and closes the file
+//	- Safe on a container that was never created
+//------------------------------------------------------------------------------
+int ab_specfile_close(AbSpecFile *spec)
+{
+    int status = 0;
+
+    if (spec->file) {
+        unsigned char count[4];
+        put_le32(count, (uint32_t)spec->frames);
+        if (fseek(spec->file, 16, SEEK_SET) != 0 || fwrite(count, 1, sizeof(count), spec->file) != sizeof(count)) {
+            status = -1;
+        }
+        if (fclose(spec->file) != 0) {
+            status = -1;
+        }
+    }
+    memset(spec, 0, sizeof(*spec));
+    return status;
+}
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_specfile.h
+//
+//	libaudiobench: binary spectrum container, one file per analysis run
+//	instead of one CSV per snapshot.
+//
+//	Layout (little-endian):
+//	- An AB_SPEC_HEADER_BYTES header describing the run (below)
+//	- Then one frame per snapshot: 'bins' float32 magnitudes in dBFS
+//
+//	Offset	Type	Field
+//	0		char[8]	"ABSPEC01"
+//	8		u32		header_bytes (offset of the first frame)
+//	12		u32		bins (values per frame)
+//	16		u32		frames (0 until the file is closed; use the file size)
+//	20		u32		sample_rate
+//	24		u32		fft_size
+//	28		u32		window (AB_WINDOW_* from ab_window.h)
+//	32		f32		window_beta (Kaiser only)
+//	36		u32		average (FFT windows averaged per frame)
+//	40		f64		time_start (s, first frame)
+//	48		f64		time_step (s between frames)
+//	56		f64		freq_start (Hz, first bin)
+//	64		f64		freq_step (Hz per bin, or ratio per bin on a log axis)
+//	72		u32		freq_scale (AB_SPEC_LINEAR or AB_SPEC_LOG)
+//	76		u32		reserved (0)
+//
+//	Frames are appended and flushed one at a time, so a reader watching a
+//	run in progress always sees whole frames: frames = (file size -
+//	header_bytes) / (4 * bins). The frame count is filled in on close.
+//
+//	Reading (B = bins, F = frames):
+//	- numpy:	np.fromfile(f, '<f4', offset=80).reshape(-1, B)
+//	- gnuplot:	splot 'run.abspec' binary skip=80 array=BxF format='%float32'
+//				dx=freq_step dy=time_step origin=(freq_start,time_start,0)
+//------------------------------------------------------------------------------
+#ifndef AB_SPECFILE_H
+#define AB_SPECFILE_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AB_SPEC_HEADER_BYTES	80
+#define AB_SPEC_LINEAR			0										//	f = freq_start + k * freq_step
+#define AB_SPEC_LOG				1										//	f = freq_start * freq_step^k
+
+//------------------------------------------------------------------------------
+//	Run description written to the header
+//------------------------------------------------------------------------------
+typedef struct {
+    int bins;
+    int sample_rate;
+    int fft_size;
+    int window;
+    double window_beta;
+    int average;
+    double time_start;
+    double time_step;
+    double freq_start;
+    double freq_step;
+    int freq_scale;
+} AbSpecInfo;
+
+//------------------------------------------------------------------------------
+//	Open container (caller-owned, filled by ab_specfile_create)
+//------------------------------------------------------------------------------
+typedef struct {
+    FILE *file;
+    int bins;
+    unsigned long frames;										//	Frames appended so far
+} AbSpecFile;
+
+int ab_specfile_create(const char *filename, const AbSpecInfo *info, AbSpecFile *spec);
+int ab_specfile_append(AbSpecFile *spec, const float *db);
+int ab_specfile_close(AbSpecFile *spec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
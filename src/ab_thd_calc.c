@@ -21,14 +21,24 @@
 //	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 //	THE SOFTWARE.
 //------------------------------------------------------------------------------
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <dirent.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <sndfile.h>
 #include <fftw3.h>
 #include <popt.h>
+#include "ab_fft_plan.h"
+#include "ab_window.h"
+#include "ab_core.h"
+#include "ab_goertzel.h"
 
 //------------------------------------------------------------------------------
 // Default analysis parameters
@@ -36,25 +46,71 @@
 #define DEFAULT_FFT_SIZE			8192
 #define DEFAULT_HARMONICS			10
 #define DEFAULT_FUNDAMENTAL_FREQ	1000.0										//	1kHz
+#define PEAK_SEARCH_HZ				50.0										//	+/- search around each harmonic
+#define MANIFEST_LINE_MAX			4096
 
 //------------------------------------------------------------------------------
-//	Name:		apply_hann_window
-//
-//	Returns:	none
-//
+//	Analyzer state: one FFT plan and one set of buffers for every file
+//------------------------------------------------------------------------------
+typedef struct {
+    int fft_size;
+    int harmonic_range;
+    const AbWindow *window;
+    double *audio_buffer;												//	fft_size samples, FFT input
+    fftw_complex *fft_output;											//	fft_size / 2 + 1 bins
+    double *power;														//	Frame-averaged |X|^2 per bin
+    double *magnitude;													//	sqrt(power)
+    fftw_plan plan;														//	NULL in Goertzel mode
+} ThdAnalyzer;
+
 //------------------------------------------------------------------------------
-//	Detailed description:
-//	- Applies Hann window to reduce spectral leakage
-//	- Window function: 0.5 * (1 - cos(2*pi*n/(N-1)))
-//	- Modifies data in-place
+//	Result of analyzing one file (harmonic arrays are owned by the caller)
+//------------------------------------------------------------------------------
+typedef struct {
+    int sample_rate;
+    int channels;
+    sf_count_t file_frames;
+    int fft_frames;														//	FFT frames averaged
+    int fundamental_bin;
+    double measured_freq;
+    double fundamental_mag;												//	Amplitude, 1.0 = full scale
+    double fundamental_db;
+    int *harmonic_bins;													//	[1..harmonic_range], -1 above Nyquist
+    double *harmonic_freqs;												//	[1..harmonic_range] Hz the level was read at
+    double *harmonic_mags;												//	[0] = fundamental
+    double thd_ratio;
+    double thdn_ratio;
+} ThdResult;
+
 //------------------------------------------------------------------------------
-void apply_hann_window(double *data, int size)
-{
-    for (int i = 0; i < size; i++) {
-        double window = 0.5 * (1.0 - cos(2.0 * M_PI * i / (size - 1)));
-        data[i] *= window;
-    }
-}
+//	One batch job: file and the fundamental to look for
+//------------------------------------------------------------------------------
+typedef struct {
+    char *path;
+    double freq;
+} BatchEntry;
+
+typedef struct {
+    BatchEntry *entries;
+    int count;
+    int capacity;
+} BatchList;
+
+//------------------------------------------------------------------------------
+//	Goertzel mode: per-frame output and whole-file power sums
+//------------------------------------------------------------------------------
+typedef struct {
+    FILE *out;															//	Per-frame rows, NULL = none
+    int csv;															//	CSV rows instead of the table
+    int harmonic_range;
+    int max_frames;														//	0 = every frame
+    int frames;
+    int locked_frames;
+    double *power_sum;													//	[0..harmonic_range] sum of amplitude^2, locked frames
+    double ac_sum;														//	Sum of frame AC power, locked frames
+    double *settle_sum;													//	Same for frames read while the tracker settled
+    double settle_ac_sum;
+} GoertzelRun;
 
 //------------------------------------------------------------------------------
 //	Name:		find_peak_bin
@@ -67,7 +123,7 @@ void apply_hann_window(double *data, int size)
 //	- Uses frequency resolution to convert Hz to bin numbers
 //	- Returns bin with maximum magnitude in search range
 //------------------------------------------------------------------------------
-int find_peak_bin(fftw_complex *fft_output, int fft_size, double sample_rate,
+int find_peak_bin(const double *magnitude, int fft_size, double sample_rate,
                   double target_freq, double search_range_hz)
 {
     double freq_resolution = (double)sample_rate / fft_size;
@@ -90,12 +146,8 @@ int find_peak_bin(fftw_complex *fft_output, int fft_size, double sample_rate,
     double peak_magnitude = 0.0;
 
     for (int i = start_bin; i <= end_bin; i++) {
-        double real = fft_output[i][0];
-        double imag = fft_output[i][1];
-        double magnitude = sqrt(real * real + imag * imag);
-
-        if (magnitude > peak_magnitude) {
-            peak_magnitude = magnitude;
+        if (magnitude[i] > peak_magnitude) {
+            peak_magnitude = magnitude[i];
             peak_bin = i;
         }
     }
@@ -104,20 +156,679 @@ int find_peak_bin(fftw_complex *fft_output, int fft_size, double sample_rate,
 }
 
 //------------------------------------------------------------------------------
-//	Name:		get_bin_magnitude
+//	Name:		analyzer_init
 //
-//	Returns:	Magnitude at specified bin
+//	Returns:	0 on success, -1 on allocation failure
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Calculates magnitude from complex FFT output
-//	- Magnitude = sqrt(real^2 + imag^2)
+//	- Allocates the FFT buffers and creates the plan once; every file in a
+//	  batch then reuses them
+//	- The plan is created before any data is read because measured
+//	  planning overwrites the buffers
+//	- Goertzel mode only needs the read buffer: no spectrum, no plan
+//------------------------------------------------------------------------------
+int analyzer_init(ThdAnalyzer *an, int fft_size, int harmonic_range, const AbWindow *window,
+                  unsigned int planner_flags, const char *wisdom_path, int goertzel)
+{
+    int bins = fft_size / 2 + 1;
+
+    memset(an, 0, sizeof(*an));
+    an->fft_size = fft_size;
+    an->harmonic_range = harmonic_range;
+    an->window = window;
+    an->audio_buffer = (double *)malloc(fft_size * sizeof(double));
+    if (goertzel) {
+        return an->audio_buffer ? 0 : -1;
+    }
+    an->fft_output = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * bins);
+    an->power = (double *)malloc(bins * sizeof(double));
+    an->magnitude = (double *)malloc(bins * sizeof(double));
+
+    if (!an->audio_buffer || !an->fft_output || !an->power || !an->magnitude) {
+        return -1;
+    }
+
+    ab_fft_wisdom_load(wisdom_path);
+    an->plan = fftw_plan_dft_r2c_1d(fft_size, an->audio_buffer, an->fft_output, planner_flags);
+    ab_fft_wisdom_save(planner_flags);
+
+    return 0;
+}
+
 //------------------------------------------------------------------------------
-double get_bin_magnitude(fftw_complex *fft_output, int bin)
+//	Name:		analyzer_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void analyzer_free(ThdAnalyzer *an)
 {
-    double real = fft_output[bin][0];
-    double imag = fft_output[bin][1];
-    return sqrt(real * real + imag * imag);
+    if (an->plan) fftw_destroy_plan(an->plan);
+    fftw_free(an->fft_output);
+    free(an->audio_buffer);
+    free(an->power);
+    free(an->magnitude);
+    memset(an, 0, sizeof(*an));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		analyze_file
+//
+//	Returns:	0 on success, -1 if the file could not be opened
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reads consecutive fft_size frames (mono, channels averaged), windows
+//	  and transforms each, and averages |X|^2 per bin
+//	- max_frames limits the number of FFT frames (0 = every complete frame)
+//	- A file shorter than fft_size is zero-padded into a single frame
+//	- Harmonic levels are read at the peak bin near each multiple of freq
+//	- THD+N is the power outside the fundamental's main lobe (and DC) over
+//	  the power inside it, so window normalization cancels out
+//------------------------------------------------------------------------------
+int analyze_file(ThdAnalyzer *an, const char *path, double freq, int max_frames, ThdResult *res)
+{
+    int fft_size = an->fft_size;
+    int bins = fft_size / 2 + 1;
+
+//------------------------------------------------------------------------------
+//	Open the audio file
+//------------------------------------------------------------------------------
+    SF_INFO sfinfo;
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    SNDFILE *infile = sf_open(path, SFM_READ, &sfinfo);
+
+    if (!infile) {
+        fprintf(stderr, "Error: Could not open file '%s'\n", path);
+        fprintf(stderr, "%s\n", sf_strerror(NULL));
+        return -1;
+    }
+
+    res->sample_rate = sfinfo.samplerate;
+    res->channels = sfinfo.channels;
+    res->file_frames = sfinfo.frames;
+
+//------------------------------------------------------------------------------
+//	Check if we have enough samples
+//------------------------------------------------------------------------------
+    if (sfinfo.frames < fft_size) {
+        fprintf(stderr, "Warning: '%s' has fewer samples (%ld) than FFT size (%d)\n",
+                path, (long)sfinfo.frames, fft_size);
+        fprintf(stderr, "         Results may be unreliable. Consider using a smaller FFT size.\n");
+    }
+
+//------------------------------------------------------------------------------
+//	Accumulate the power spectrum over FFT frames
+//------------------------------------------------------------------------------
+    memset(an->power, 0, bins * sizeof(double));
+    int frames = 0;
+
+    while (max_frames == 0 || frames < max_frames) {
+        sf_count_t frames_read = ab_read_mono(infile, sfinfo.channels, an->audio_buffer, fft_size);
+
+        if (frames_read < fft_size) {
+            if (frames > 0) {
+                break;													//	Drop the partial tail frame
+            }
+            for (sf_count_t i = frames_read; i < fft_size; i++) {
+                an->audio_buffer[i] = 0.0;
+            }
+        }
+
+        ab_window_apply(an->window, an->audio_buffer);
+        fftw_execute(an->plan);
+
+        for (int k = 0; k < bins; k++) {
+            double real = an->fft_output[k][0];
+            double imag = an->fft_output[k][1];
+            an->power[k] += real * real + imag * imag;
+        }
+        frames++;
+
+        if (frames_read < fft_size) {
+            break;
+        }
+    }
+
+    sf_close(infile);
+
+    for (int k = 0; k < bins; k++) {
+        an->power[k] /= frames;
+        an->magnitude[k] = sqrt(an->power[k]);
+    }
+    res->fft_frames = frames;
+
+//------------------------------------------------------------------------------
+//	Find fundamental and normalize for FFT size and window coherent gain
+//	(Hann: 0.5, i.e. fft_size / 4)
+//------------------------------------------------------------------------------
+    double sample_rate = sfinfo.samplerate;
+    double freq_resolution = sample_rate / fft_size;
+    double normalization_factor = fft_size / 2.0 * an->window->coherent_gain;
+
+    res->fundamental_bin = find_peak_bin(an->magnitude, fft_size, sample_rate, freq, PEAK_SEARCH_HZ);
+    res->measured_freq = res->fundamental_bin * freq_resolution;
+    res->fundamental_mag = an->magnitude[res->fundamental_bin] / normalization_factor;
+    res->fundamental_db = 20.0 * log10(res->fundamental_mag + 1e-10);
+    res->harmonic_mags[0] = res->fundamental_mag;
+
+//------------------------------------------------------------------------------
+//	Harmonics H2..H(n+1)
+//	THD = sqrt(H2^2 + H3^2 + ... + Hn^2) / H1
+//------------------------------------------------------------------------------
+    double harmonic_sum_squares = 0.0;
+    for (int h = 1; h <= an->harmonic_range; h++) {
+        double harmonic_freq = freq * (h + 1);
+
+        if (harmonic_freq >= sample_rate / 2.0) {
+            res->harmonic_bins[h] = -1;
+            res->harmonic_freqs[h] = 0.0;
+            res->harmonic_mags[h] = 0.0;
+            continue;
+        }
+
+        int harmonic_bin = find_peak_bin(an->magnitude, fft_size, sample_rate, harmonic_freq, PEAK_SEARCH_HZ);
+        res->harmonic_bins[h] = harmonic_bin;
+        res->harmonic_freqs[h] = harmonic_bin * freq_resolution;
+        res->harmonic_mags[h] = an->magnitude[harmonic_bin] / normalization_factor;
+        harmonic_sum_squares += res->harmonic_mags[h] * res->harmonic_mags[h];
+    }
+    res->thd_ratio = sqrt(harmonic_sum_squares) / (res->fundamental_mag + 1e-10);
+
+//------------------------------------------------------------------------------
+//	THD+N: everything but DC and the fundamental, relative to the fundamental
+//------------------------------------------------------------------------------
+    int lobe = ab_window_mainlobe_bins(an->window) + 1;
+    double fundamental_power = 0.0;
+    double residual_power = 0.0;
+
+    for (int k = lobe; k < bins; k++) {
+        if (abs(k - res->fundamental_bin) <= lobe) {
+            fundamental_power += an->power[k];
+        } else {
+            residual_power += an->power[k];
+        }
+    }
+    res->thdn_ratio = sqrt(residual_power / (fundamental_power + 1e-30));
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		goertzel_frame
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- AbTone frame callback: prints the frame (table or CSV, flushed so
+//	  it streams through a pipe) and adds it to the whole-file sums;
+//	  frames read before the tracker locked are summed separately
+//	- THD+N is the frame's AC power minus the fundamental's (A^2 / 2),
+//	  relative to the fundamental
+//------------------------------------------------------------------------------
+void goertzel_frame(const AbTone *tone, void *user)
+{
+    GoertzelRun *run = (GoertzelRun *)user;
+    if (run->max_frames > 0 && run->frames >= run->max_frames) {
+        return;
+    }
+
+    double *power_sum = tone->locked ? run->power_sum : run->settle_sum;
+    double fundamental_power = tone->level[0] * tone->level[0];
+    double harmonic_power = 0.0;
+    for (int h = 0; h <= run->harmonic_range; h++) {
+        double power = tone->level[h] * tone->level[h];
+        power_sum[h] += power;
+        if (h > 0) {
+            harmonic_power += power;
+        }
+    }
+    if (tone->locked) {
+        run->ac_sum += tone->ac_power;
+        run->locked_frames++;
+    } else {
+        run->settle_ac_sum += tone->ac_power;
+    }
+    run->frames++;
+
+    if (!run->out) {
+        return;
+    }
+
+    double residual = tone->ac_power - fundamental_power / 2.0;
+    double thd = sqrt(harmonic_power / (fundamental_power + 1e-30));
+    double thdn = sqrt((residual > 0.0 ? residual : 0.0) / (fundamental_power / 2.0 + 1e-30));
+    double level_db = 20.0 * log10(tone->level[0] + 1e-10);
+    double time = (double)(tone->frames - 1) * tone->frame_size / tone->sample_rate;
+
+    if (run->csv) {
+        fprintf(run->out, "%d,%.4f,%.3f,%d,%.2f,%.6f,%.6f", run->frames, time, tone->freq[0],
+                tone->locked, level_db, thd * 100.0, thdn * 100.0);
+        for (int h = 1; h <= run->harmonic_range; h++) {
+            if (tone->freq[h] <= 0.0) {
+                fprintf(run->out, ",");
+            } else {
+                fprintf(run->out, ",%.2f", 20.0 * log10(tone->level[h] + 1e-10) - level_db);
+            }
+        }
+        fprintf(run->out, "\n");
+    } else {
+        fprintf(run->out, "  %6d  %9.3f  %10.3f  %12.2f  %9.4f  %9.4f%s\n", run->frames, time,
+                tone->freq[0], level_db, thd * 100.0, thdn * 100.0, tone->locked ? "" : "  (settling)");
+    }
+    fflush(run->out);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		analyze_file_goertzel
+//
+//	Returns:	0 on success, -1 if the file could not be opened
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Targeted-bin alternative to analyze_file(): one Goertzel resonator
+//	  per harmonic over every fft_size frame of the file, O(N * k) instead
+//	  of an FFT per frame (see ab_goertzel.h)
+//	- The fundamental is tracked within +/- PEAK_SEARCH_HZ of freq, the
+//	  same range analyze_file() searches, and the harmonics follow it
+//	- frames_out receives one row per frame as it is read (NULL = none);
+//	  the result holds power averages over the locked frames (all frames
+//	  if the tracker never settled), the frequencies of the final
+//	  estimate and bins rounded from them
+//------------------------------------------------------------------------------
+int analyze_file_goertzel(ThdAnalyzer *an, const char *path, double freq, int max_frames,
+                          FILE *frames_out, int csv, ThdResult *res)
+{
+    int fft_size = an->fft_size;
+    int tones = an->harmonic_range + 1;
+
+//------------------------------------------------------------------------------
+//	Open the audio file
+//------------------------------------------------------------------------------
+    SF_INFO sfinfo;
+    memset(&sfinfo, 0, sizeof(sfinfo));
+    SNDFILE *infile = sf_open(path, SFM_READ, &sfinfo);
+
+    if (!infile) {
+        fprintf(stderr, "Error: Could not open file '%s'\n", path);
+        fprintf(stderr, "%s\n", sf_strerror(NULL));
+        return -1;
+    }
+
+    res->sample_rate = sfinfo.samplerate;
+    res->channels = sfinfo.channels;
+    res->file_frames = sfinfo.frames;
+
+    if (sfinfo.frames < fft_size) {
+        fprintf(stderr, "Warning: '%s' has fewer samples (%ld) than the frame size (%d)\n",
+                path, (long)sfinfo.frames, fft_size);
+        fprintf(stderr, "         Results may be unreliable. Consider using a smaller frame size.\n");
+    }
+
+    AbTone tone;
+    GoertzelRun run;
+    memset(&run, 0, sizeof(run));
+    run.out = frames_out;
+    run.csv = csv;
+    run.harmonic_range = an->harmonic_range;
+    run.max_frames = max_frames;
+    run.power_sum = (double *)calloc(tones, sizeof(double));
+    run.settle_sum = (double *)calloc(tones, sizeof(double));
+
+    if (!run.power_sum || !run.settle_sum ||
+        ab_tone_init(&tone, sfinfo.samplerate, freq, tones, fft_size, an->window->coeffs, PEAK_SEARCH_HZ) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(run.power_sum);
+        free(run.settle_sum);
+        sf_close(infile);
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Stream the file a frame at a time
+//------------------------------------------------------------------------------
+    if (frames_out && !csv) {
+        fprintf(frames_out, "Per-frame levels (%d-sample frames):\n", fft_size);
+        fprintf(frames_out, "   Frame   Time (s)   Freq (Hz)  Level (dBFS)    THD (%%)  THD+N (%%)\n");
+        fprintf(frames_out, "  ------  ---------  ----------  ------------  ---------  ---------\n");
+    } else if (frames_out) {
+        fprintf(frames_out, "frame,time_s,freq_hz,locked,level_dbfs,thd_percent,thdn_percent");
+        for (int h = 1; h <= an->harmonic_range; h++) {
+            fprintf(frames_out, ",h%d_dbc", h + 1);
+        }
+        fprintf(frames_out, "\n");
+    }
+
+    sf_count_t frames_read;
+    while ((max_frames == 0 || run.frames < max_frames) &&
+           (frames_read = ab_read_mono(infile, sfinfo.channels, an->audio_buffer, fft_size)) > 0) {
+        ab_tone_process(&tone, an->audio_buffer, (size_t)frames_read, goertzel_frame, &run);
+    }
+    ab_tone_finish(&tone, goertzel_frame, &run);
+    sf_close(infile);
+
+    if (frames_out && !csv) {
+        fprintf(frames_out, "\n");
+    }
+
+//------------------------------------------------------------------------------
+//	Whole-file levels: power averages over the locked frames
+//------------------------------------------------------------------------------
+    double *power_sum = run.power_sum;
+    double ac_sum = run.ac_sum;
+    int frames = run.locked_frames;
+
+    if (frames == 0) {
+        fprintf(stderr, "Warning: '%s': tone did not settle within +/- %.0f Hz of %.0f Hz\n",
+                path, PEAK_SEARCH_HZ, freq);
+        power_sum = run.settle_sum;
+        ac_sum = run.settle_ac_sum;
+        frames = run.frames > 0 ? run.frames : 1;
+    }
+    double freq_resolution = (double)sfinfo.samplerate / fft_size;
+
+    res->fft_frames = run.locked_frames > 0 ? run.locked_frames : run.frames;
+    res->measured_freq = tone.fundamental;
+    res->fundamental_bin = (int)(tone.fundamental / freq_resolution + 0.5);
+    res->fundamental_mag = sqrt(power_sum[0] / frames);
+    res->fundamental_db = 20.0 * log10(res->fundamental_mag + 1e-10);
+    res->harmonic_mags[0] = res->fundamental_mag;
+
+    double harmonic_sum_squares = 0.0;
+    for (int h = 1; h <= an->harmonic_range; h++) {
+        double harmonic_freq = tone.fundamental * (h + 1);
+
+        if (harmonic_freq >= sfinfo.samplerate / 2.0) {
+            res->harmonic_bins[h] = -1;
+            res->harmonic_freqs[h] = 0.0;
+            res->harmonic_mags[h] = 0.0;
+            continue;
+        }
+
+        res->harmonic_bins[h] = (int)(harmonic_freq / freq_resolution + 0.5);
+        res->harmonic_freqs[h] = harmonic_freq;
+        res->harmonic_mags[h] = sqrt(power_sum[h] / frames);
+        harmonic_sum_squares += res->harmonic_mags[h] * res->harmonic_mags[h];
+    }
+    res->thd_ratio = sqrt(harmonic_sum_squares) / (res->fundamental_mag + 1e-10);
+
+    double fundamental_power = power_sum[0] / frames / 2.0;
+    double residual_power = ac_sum / frames - fundamental_power;
+    res->thdn_ratio = sqrt((residual_power > 0.0 ? residual_power : 0.0) / (fundamental_power + 1e-30));
+
+    ab_tone_free(&tone);
+    free(run.power_sum);
+    free(run.settle_sum);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		print_report
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Human-readable harmonic table for single-file mode
+//------------------------------------------------------------------------------
+void print_report(const ThdAnalyzer *an, const ThdResult *res, double freq, int verbose)
+{
+    printf("THD Analysis Results for %.0f Hz Sine Wave\n", freq);
+    printf("========================================\n\n");
+
+    printf("Fundamental Frequency (H1):\n");
+    printf("  Expected: %.0f Hz\n", freq);
+    printf("  Measured: %.2f Hz (bin %d)\n", res->measured_freq, res->fundamental_bin);
+    printf("  Level: %.2f dBFS\n\n", res->fundamental_db);
+
+    printf("Harmonic Analysis:\n");
+    printf("  Harmonic  Frequency (Hz)  Level (dBFS)  Level (dB rel. to H1)\n");
+    printf("  --------  --------------  ------------  ---------------------\n");
+
+    for (int h = 1; h <= an->harmonic_range; h++) {
+        if (res->harmonic_bins[h] < 0) {
+            if (verbose) {
+                printf("  H%-7d  %.2f  (above Nyquist frequency)\n", h + 1, freq * (h + 1));
+            }
+            continue;
+        }
+
+        double harmonic_db = 20.0 * log10(res->harmonic_mags[h] + 1e-10);
+        printf("  H%-7d  %10.2f  %12.2f  %21.2f\n",
+               h + 1, res->harmonic_freqs[h], harmonic_db,
+               harmonic_db - res->fundamental_db);
+    }
+
+    printf("\nTotal Harmonic Distortion (THD):\n");
+    printf("  THD: %.4f%% (%.2f dB)\n", res->thd_ratio * 100.0, 20.0 * log10(res->thd_ratio + 1e-10));
+    printf("  Based on %d harmonics (H2-H%d)\n", an->harmonic_range, an->harmonic_range + 1);
+    printf("  THD+N: %.4f%% (%.2f dB)\n", res->thdn_ratio * 100.0, 20.0 * log10(res->thdn_ratio + 1e-10));
+    if (res->fft_frames > 1) {
+        printf("  Averaged over %d %s frames\n", res->fft_frames, an->plan ? "FFT" : "Goertzel");
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_csv_header
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void write_csv_header(FILE *out, int harmonic_range)
+{
+    fprintf(out, "file,sample_rate,channels,fft_frames,expected_hz,measured_hz,level_dbfs,"
+                 "thd_percent,thd_db,thdn_percent,thdn_db");
+    for (int h = 1; h <= harmonic_range; h++) {
+        fprintf(out, ",h%d_dbc", h + 1);
+    }
+    fprintf(out, "\n");
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_csv_row
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Harmonic levels are relative to H1; harmonics above Nyquist are empty
+//------------------------------------------------------------------------------
+void write_csv_row(FILE *out, const char *path, double freq, int harmonic_range, const ThdResult *res)
+{
+    fprintf(out, "%s,%d,%d,%d,%.2f,%.2f,%.2f,%.6f,%.2f,%.6f,%.2f",
+            path, res->sample_rate, res->channels, res->fft_frames, freq,
+            res->measured_freq, res->fundamental_db,
+            res->thd_ratio * 100.0, 20.0 * log10(res->thd_ratio + 1e-10),
+            res->thdn_ratio * 100.0, 20.0 * log10(res->thdn_ratio + 1e-10));
+    for (int h = 1; h <= harmonic_range; h++) {
+        if (res->harmonic_bins[h] < 0) {
+            fprintf(out, ",");
+        } else {
+            fprintf(out, ",%.2f", 20.0 * log10(res->harmonic_mags[h] + 1e-10) - res->fundamental_db);
+        }
+    }
+    fprintf(out, "\n");
+}
+
+//------------------------------------------------------------------------------
+//	Name:		batch_add
+//
+//	Returns:	0 on success, -1 on allocation failure
+//
+//------------------------------------------------------------------------------
+int batch_add(BatchList *list, const char *path, double freq)
+{
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        BatchEntry *entries = (BatchEntry *)realloc(list->entries, capacity * sizeof(BatchEntry));
+        if (!entries) {
+            return -1;
+        }
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+
+    list->entries[list->count].path = strdup(path);
+    if (!list->entries[list->count].path) {
+        return -1;
+    }
+    list->entries[list->count].freq = freq;
+    list->count++;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		batch_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void batch_free(BatchList *list)
+{
+    for (int i = 0; i < list->count; i++) {
+        free(list->entries[i].path);
+    }
+    free(list->entries);
+    memset(list, 0, sizeof(*list));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		load_manifest
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- One file per line, optionally followed by whitespace and its
+//	  fundamental frequency in Hz; files without one use default_freq
+//	- Blank lines and lines starting with '#' are ignored
+//------------------------------------------------------------------------------
+int load_manifest(const char *manifest, double default_freq, BatchList *list)
+{
+    FILE *fp = fopen(manifest, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Could not open manifest '%s'\n", manifest);
+        return -1;
+    }
+
+    char line[MANIFEST_LINE_MAX];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+//------------------------------------------------------------------------------
+//	Trim leading and trailing whitespace
+//------------------------------------------------------------------------------
+        char *start = line;
+        while (isspace((unsigned char)*start)) start++;
+        char *end = start + strlen(start);
+        while (end > start && isspace((unsigned char)end[-1])) end--;
+        *end = '\0';
+
+        if (*start == '\0' || *start == '#') {
+            continue;
+        }
+
+//------------------------------------------------------------------------------
+//	Split off a trailing frequency field if there is one
+//------------------------------------------------------------------------------
+        double freq = default_freq;
+        char *sep = end;
+        while (sep > start && !isspace((unsigned char)sep[-1])) sep--;
+        if (sep > start) {
+            char *num_end;
+            double value = strtod(sep, &num_end);
+            if (*num_end == '\0' && value > 0.0) {
+                freq = value;
+                while (sep > start && isspace((unsigned char)sep[-1])) sep--;
+                *sep = '\0';
+            }
+        }
+
+        if (batch_add(list, start, freq) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            fclose(fp);
+            return -1;
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		is_wav_file
+//
+//	Returns:	1 if filename ends with .wav (case-insensitive), 0 otherwise
+//
+//------------------------------------------------------------------------------
+int is_wav_file(const char *filename)
+{
+    size_t len = strlen(filename);
+    if (len < 4) {
+        return 0;
+    }
+
+    const char *ext = filename + len - 4;
+    return (tolower(ext[0]) == '.' &&
+            tolower(ext[1]) == 'w' &&
+            tolower(ext[2]) == 'a' &&
+            tolower(ext[3]) == 'v');
+}
+
+//------------------------------------------------------------------------------
+//	Name:		compare_entries
+//
+//	Returns:	strcmp order of the entry paths (for qsort)
+//
+//------------------------------------------------------------------------------
+int compare_entries(const void *a, const void *b)
+{
+    return strcmp(((const BatchEntry *)a)->path, ((const BatchEntry *)b)->path);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		scan_directory
+//
+//	Returns:	0 on success, -1 on error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Adds every .wav file in dir (not recursive), sorted by name so the
+//	  CSV row order is reproducible
+//------------------------------------------------------------------------------
+int scan_directory(const char *dir_path, double freq, BatchList *list)
+{
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "Error: Cannot open directory '%s'\n", dir_path);
+        return -1;
+    }
+
+    int first = list->count;
+    size_t dir_len = strlen(dir_path);
+    int need_sep = dir_len > 0 && dir_path[dir_len - 1] != '/' && dir_path[dir_len - 1] != '\\';
+    struct dirent *entry;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (!is_wav_file(entry->d_name)) {
+            continue;
+        }
+
+        char path[MANIFEST_LINE_MAX];
+        snprintf(path, sizeof(path), "%s%s%s", dir_path, need_sep ? "/" : "", entry->d_name);
+        if (batch_add(list, path, freq) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            closedir(dir);
+            return -1;
+        }
+    }
+
+    closedir(dir);
+    qsort(list->entries + first, list->count - first, sizeof(BatchEntry), compare_entries);
+    return 0;
 }
 
 //------------------------------------------------------------------------------
@@ -125,10 +836,13 @@ double get_bin_magnitude(fftw_complex *fft_output, int bin)
 //
 //	This application:
 //	- Reads audio file containing sine wave
-//	- Performs FFT analysis
+//	- Performs FFT analysis, averaging the spectrum over FFT frames, or
+//	  with -g reads only the harmonic bins (Goertzel, fundamental tracked)
+//	  and streams per-frame levels as it goes
 //	- Identifies fundamental frequency and harmonics
-//	- Calculates Total Harmonic Distortion (THD)
-//	- Displays results in table format
+//	- Calculates Total Harmonic Distortion (THD) and THD+N
+//	- Displays results in table format, or one CSV row per file in
+//	  batch mode (manifest and/or directory), reusing one FFT plan
 //
 //	Libraries:
 //	- libsndfile: Audio file I/O
@@ -141,10 +855,18 @@ int main(int argc, char *argv[])
 //	Command-line option variables
 //------------------------------------------------------------------------------
     char *input_file = NULL;
+    char *manifest_file = NULL;
+    char *input_dir = NULL;
+    char *output_file = NULL;
     int fft_size = DEFAULT_FFT_SIZE;
     int harmonic_range = DEFAULT_HARMONICS;
+    int max_frames = -1;
     double fundamental_freq = DEFAULT_FUNDAMENTAL_FREQ;
     int verbose = 0;
+    char *planner_name = NULL;
+    char *wisdom_path = NULL;
+    char *window_name = NULL;
+    int goertzel = 0;
     int version_flag = 0;
 
 //------------------------------------------------------------------------------
@@ -153,9 +875,17 @@ int main(int argc, char *argv[])
     struct poptOption options[] = {
         {"version",		'v',	POPT_ARG_NONE,		&version_flag,		0,	"Show version information",						NULL	},
         {"file",		'f',	POPT_ARG_STRING,	&input_file,		0,	"Input WAV file containing sine wave",			"FILE"	},
+        {"batch",		'b',	POPT_ARG_STRING,	&manifest_file,		0,	"Batch mode: manifest of files (one per line, optional FREQ)",	"FILE"	},
+        {"dir",			'd',	POPT_ARG_STRING,	&input_dir,			0,	"Batch mode: analyze every .wav file in DIR",	"DIR"	},
+        {"output",		'o',	POPT_ARG_STRING,	&output_file,		0,	"Batch CSV output file (default: stdout)",		"FILE"	},
         {"freq",		'F',	POPT_ARG_DOUBLE,	&fundamental_freq,	0,	"Fundamental frequency in Hz (default: 1000)",	"FREQ"	},
         {"fft-size",	's',	POPT_ARG_INT,		&fft_size,			0,	"FFT size (default: 8192)",						"SIZE"	},
+        {"frames",		'N',	POPT_ARG_INT,		&max_frames,		0,	"FFT frames to average, 0 = all (default: 1, batch: all)",	"COUNT"	},
         {"harmonics",	'n',	POPT_ARG_INT,		&harmonic_range,	0,	"Number of harmonics to analyze (default: 10)",	"COUNT"	},
+        {"planner",		'P',	POPT_ARG_STRING,	&planner_name,		0,	"FFTW planner: estimate, measure, patient, exhaustive",	"MODE"	},
+        {"wisdom",		'W',	POPT_ARG_STRING,	&wisdom_path,		0,	"FFTW wisdom file (default: ~/.ab_fftw_wisdom)",	"FILE"	},
+        {"window",		'w',	POPT_ARG_STRING,	&window_name,		0,	"Window: hann, blackman-harris, flattop, kaiser[:BETA]",	"NAME"	},
+        {"goertzel",	'g',	POPT_ARG_NONE,		&goertzel,			0,	"Goertzel engine: track H1..Hn per frame, stream frame levels",	NULL	},
         {"verbose",		'V',	POPT_ARG_NONE,		&verbose,			0,	"Verbose output",								NULL	},
         POPT_AUTOHELP
         POPT_TABLEEND
@@ -167,11 +897,17 @@ int main(int argc, char *argv[])
     poptContext popt_ctx = poptGetContext(NULL, argc, (const char **)argv, options, 0);
     poptSetOtherOptionHelp(popt_ctx,
         "[OPTIONS]\n\n"
-        "Calculate Total Harmonic Distortion (THD) for a sine wave.\n\n"
+        "Calculate Total Harmonic Distortion (THD) and THD+N for a sine wave.\n\n"
         "Examples:\n"
         "  ab_thd_calc -f test_1khz.wav                      # 1kHz sine wave\n"
         "  ab_thd_calc -f test_10khz.wav -F 10000            # 10kHz sine wave\n"
         "  ab_thd_calc -f test_1khz.wav -s 16384 -n 15       # Custom FFT size and harmonics\n"
+        "  ab_thd_calc -f test_1khz.wav -w blackman-harris   # Low-leakage window for low-THD DACs\n"
+        "  ab_thd_calc -f test_1khz.wav -N 0                 # Average every FFT frame in the file\n"
+        "  ab_thd_calc -b sweep.txt -o thd.csv               # Batch: manifest lines 'FILE [FREQ]'\n"
+        "  ab_thd_calc -d captures/ -F 1000 -o thd.csv       # Batch: every .wav in a directory\n"
+        "  ab_thd_calc -f take.wav -g                        # Goertzel: per-frame levels, then totals\n"
+        "  ab_thd_calc -f take.wav -g -o frames.csv          # Goertzel: per-frame CSV to a file\n"
         "  ab_thd_calc -f test_1khz.wav --verbose            # Verbose output\n");
 
     int rc = poptGetNextOpt(popt_ctx);
@@ -197,13 +933,20 @@ int main(int argc, char *argv[])
 //------------------------------------------------------------------------------
 //	Validate required parameters
 //------------------------------------------------------------------------------
-    if (!input_file) {
-        fprintf(stderr, "Error: Input file is required (use -f or --file)\n");
+    int batch_mode = (manifest_file != NULL || input_dir != NULL);
+    if (!input_file && !batch_mode) {
+        fprintf(stderr, "Error: Input file is required (use -f, or -b/-d for batch mode)\n");
         poptPrintUsage(popt_ctx, stderr, 0);
         poptFreeContext(popt_ctx);
         return 1;
     }
 
+    if (output_file && !batch_mode && !goertzel) {
+        fprintf(stderr, "Error: --output is only used in batch mode (-b or -d) or with --goertzel\n");
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
 //------------------------------------------------------------------------------
 //	Validate FFT size
 //------------------------------------------------------------------------------
@@ -213,6 +956,18 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Validate frame count (single file defaults to one frame, batch and
+//	Goertzel mode to all)
+//------------------------------------------------------------------------------
+    if (max_frames == -1) {
+        max_frames = (batch_mode || goertzel) ? 0 : 1;
+    } else if (max_frames < 0) {
+        fprintf(stderr, "Error: Frame count must be 0 (all) or positive\n");
+        poptFreeContext(popt_ctx);
+        return 1;
+    }
+
 //------------------------------------------------------------------------------
 //	Validate harmonic range
 //------------------------------------------------------------------------------
@@ -231,209 +986,184 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    poptFreeContext(popt_ctx);
-
 //------------------------------------------------------------------------------
-//	Open the audio file
+//	Validate FFTW planner mode
 //------------------------------------------------------------------------------
-    SF_INFO sfinfo;
-    memset(&sfinfo, 0, sizeof(sfinfo));
-    SNDFILE *infile = sf_open(input_file, SFM_READ, &sfinfo);
-
-    if (!infile) {
-        fprintf(stderr, "Error: Could not open file '%s'\n", input_file);
-        fprintf(stderr, "%s\n", sf_strerror(NULL));
+    unsigned int planner_flags;
+    if (ab_fft_parse_planner(planner_name, &planner_flags) != 0) {
+        fprintf(stderr, "Error: Unknown planner '%s' (use estimate, measure, patient or exhaustive)\n", planner_name);
+        poptFreeContext(popt_ctx);
         return 1;
     }
 
 //------------------------------------------------------------------------------
-//	Display file information
+//	Validate window function
 //------------------------------------------------------------------------------
-    if (verbose) {
-        printf("File Information:\n");
-        printf("  File: %s\n", input_file);
-        printf("  Sample rate: %d Hz\n", sfinfo.samplerate);
-        printf("  Channels: %d\n", sfinfo.channels);
-        printf("  Frames: %ld\n", (long)sfinfo.frames);
-        printf("  Duration: %.2f seconds\n", (double)sfinfo.frames / sfinfo.samplerate);
-        printf("\nAnalysis Parameters:\n");
-        printf("  Fundamental frequency: %.0f Hz\n", fundamental_freq);
-        printf("  FFT size: %d\n", fft_size);
-        printf("  Frequency resolution: %.2f Hz\n", (double)sfinfo.samplerate / fft_size);
-        printf("  Harmonics to analyze: %d\n", harmonic_range);
-        printf("\n");
+    int window_type;
+    double window_beta;
+    if (ab_window_parse(window_name, &window_type, &window_beta) != 0) {
+        fprintf(stderr, "Error: Unknown window '%s' (use hann, blackman-harris, flattop or kaiser[:BETA])\n", window_name);
+        poptFreeContext(popt_ctx);
+        return 1;
     }
 
-//------------------------------------------------------------------------------
-//	Check if we have enough samples
-//------------------------------------------------------------------------------
-    if (sfinfo.frames < fft_size) {
-        fprintf(stderr, "Warning: File has fewer samples (%ld) than FFT size (%d)\n",
-                (long)sfinfo.frames, fft_size);
-        fprintf(stderr, "         Results may be unreliable. Consider using a smaller FFT size.\n");
-    }
+    poptFreeContext(popt_ctx);
 
 //------------------------------------------------------------------------------
-//	Allocate buffers
+//	Build the job list: -f, then the manifest, then the directory
 //------------------------------------------------------------------------------
-    double *audio_buffer = (double *)malloc(fft_size * sizeof(double));
-    fftw_complex *fft_output = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (fft_size / 2 + 1));
+    BatchList jobs;
+    memset(&jobs, 0, sizeof(jobs));
 
-    if (!audio_buffer || !fft_output) {
+    if (input_file && batch_add(&jobs, input_file, fundamental_freq) != 0) {
         fprintf(stderr, "Error: Memory allocation failed\n");
-        sf_close(infile);
         return 1;
     }
-
-//------------------------------------------------------------------------------
-//	Read audio data (if stereo, convert to mono by averaging channels)
-//------------------------------------------------------------------------------
-    sf_count_t frames_read;
-    if (sfinfo.channels == 1) {
-        frames_read = sf_read_double(infile, audio_buffer, fft_size);
-    } else {
-//------------------------------------------------------------------------------
-//	Read interleaved multi-channel data and average to mono
-//------------------------------------------------------------------------------
-        double *temp_buffer = (double *)malloc(fft_size * sfinfo.channels * sizeof(double));
-        if (!temp_buffer) {
-            fprintf(stderr, "Error: Memory allocation failed\n");
-            free(audio_buffer);
-            fftw_free(fft_output);
-            sf_close(infile);
-            return 1;
-        }
-
-        frames_read = sf_read_double(infile, temp_buffer, fft_size * sfinfo.channels) / sfinfo.channels;
-
-        for (int i = 0; i < frames_read; i++) {
-            audio_buffer[i] = 0.0;
-            for (int ch = 0; ch < sfinfo.channels; ch++) {
-                audio_buffer[i] += temp_buffer[i * sfinfo.channels + ch];
-            }
-            audio_buffer[i] /= sfinfo.channels;
-        }
-        free(temp_buffer);
+    if (manifest_file && load_manifest(manifest_file, fundamental_freq, &jobs) != 0) {
+        batch_free(&jobs);
+        return 1;
     }
-
-//------------------------------------------------------------------------------
-//	Zero-pad if we didn't read enough samples
-//------------------------------------------------------------------------------
-    for (sf_count_t i = frames_read; i < fft_size; i++) {
-        audio_buffer[i] = 0.0;
+    if (input_dir && scan_directory(input_dir, fundamental_freq, &jobs) != 0) {
+        batch_free(&jobs);
+        return 1;
+    }
+    if (jobs.count == 0) {
+        fprintf(stderr, "Error: No input files found\n");
+        batch_free(&jobs);
+        return 1;
     }
 
 //------------------------------------------------------------------------------
-//	Apply Hann window
-//------------------------------------------------------------------------------
-    apply_hann_window(audio_buffer, fft_size);
-
-//------------------------------------------------------------------------------
-//	Create FFTW plan and execute FFT
-//------------------------------------------------------------------------------
-    fftw_plan plan = fftw_plan_dft_r2c_1d(fft_size, audio_buffer, fft_output, FFTW_ESTIMATE);
-    fftw_execute(plan);
-
-//------------------------------------------------------------------------------
-//	Calculate frequency resolution
-//------------------------------------------------------------------------------
-    double freq_resolution = (double)sfinfo.samplerate / fft_size;
-
-//------------------------------------------------------------------------------
-//	Find fundamental - search within +/- 50 Hz
-//------------------------------------------------------------------------------
-    int fundamental_bin = find_peak_bin(fft_output, fft_size, sfinfo.samplerate,
-                                        fundamental_freq, 50.0);
-    double measured_fundamental_freq = fundamental_bin * freq_resolution;
-    double fundamental_mag = get_bin_magnitude(fft_output, fundamental_bin);
-
-//------------------------------------------------------------------------------
-//	Normalize for FFT size and Hann window (coherent gain = 0.5)
+//	Build the window table, FFT plan and buffers once for every file
 //------------------------------------------------------------------------------
-    double normalization_factor = fft_size / 4.0;
-    fundamental_mag /= normalization_factor;
+    const AbWindow *window = ab_window_get(window_type, fft_size, window_beta);
+    ThdAnalyzer analyzer;
+    memset(&analyzer, 0, sizeof(analyzer));
+    int *harmonic_bins = (int *)malloc((harmonic_range + 1) * sizeof(int));
+    double *harmonic_freqs = (double *)malloc((harmonic_range + 1) * sizeof(double));
+    double *harmonic_mags = (double *)malloc((harmonic_range + 1) * sizeof(double));
 
-//------------------------------------------------------------------------------
-//	Convert to dBFS (relative to full scale)
-//------------------------------------------------------------------------------
-    double fundamental_db = 20.0 * log10(fundamental_mag + 1e-10);
+    if (!window || !harmonic_bins || !harmonic_freqs || !harmonic_mags ||
+        analyzer_init(&analyzer, fft_size, harmonic_range, window, planner_flags, wisdom_path, goertzel) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        free(harmonic_bins);
+        free(harmonic_freqs);
+        free(harmonic_mags);
+        analyzer_free(&analyzer);
+        batch_free(&jobs);
+        return 1;
+    }
 
-//------------------------------------------------------------------------------
-//	Print results header
-//------------------------------------------------------------------------------
-    printf("THD Analysis Results for %.0f Hz Sine Wave\n", fundamental_freq);
-    printf("========================================\n\n");
+    ThdResult result;
+    memset(&result, 0, sizeof(result));
+    result.harmonic_bins = harmonic_bins;
+    result.harmonic_freqs = harmonic_freqs;
+    result.harmonic_mags = harmonic_mags;
 
-    printf("Fundamental Frequency (H1):\n");
-    printf("  Expected: %.0f Hz\n", fundamental_freq);
-    printf("  Measured: %.2f Hz (bin %d)\n", measured_fundamental_freq, fundamental_bin);
-    printf("  Level: %.2f dBFS\n\n", fundamental_db);
+    int status = 0;
 
 //------------------------------------------------------------------------------
-//	Analyze harmonics
+//	Single file: harmonic table
 //------------------------------------------------------------------------------
-    printf("Harmonic Analysis:\n");
-    printf("  Harmonic  Frequency (Hz)  Level (dBFS)  Level (dB rel. to H1)\n");
-    printf("  --------  --------------  ------------  ---------------------\n");
-
-    double *harmonic_magnitudes = (double *)malloc((harmonic_range + 1) * sizeof(double));
-    harmonic_magnitudes[0] = fundamental_mag;						//	Store fundamental for THD calculation
+    if (!batch_mode) {
+        FILE *frames_out = stdout;
+        if (goertzel && output_file) {
+            frames_out = fopen(output_file, "w");
+            if (!frames_out) {
+                fprintf(stderr, "Error: Could not create output file '%s'\n", output_file);
+            }
+        }
 
-    for (int h = 1; h <= harmonic_range; h++) {
-        double harmonic_freq = fundamental_freq * (h + 1);
+        int analyzed = -1;
+        if (frames_out && goertzel) {
+            analyzed = analyze_file_goertzel(&analyzer, input_file, fundamental_freq, max_frames,
+                                             frames_out, output_file != NULL, &result);
+        } else if (frames_out) {
+            analyzed = analyze_file(&analyzer, input_file, fundamental_freq, max_frames, &result);
+        }
 
-//------------------------------------------------------------------------------
-//	Check if harmonic is within Nyquist frequency
-//------------------------------------------------------------------------------
-        if (harmonic_freq >= sfinfo.samplerate / 2.0) {
+        if (analyzed != 0) {
+            status = 1;
+        } else {
             if (verbose) {
-                printf("  H%-7d  %.2f  (above Nyquist frequency)\n", h + 1, harmonic_freq);
+                printf("File Information:\n");
+                printf("  File: %s\n", input_file);
+                printf("  Sample rate: %d Hz\n", result.sample_rate);
+                printf("  Channels: %d\n", result.channels);
+                printf("  Frames: %ld\n", (long)result.file_frames);
+                printf("  Duration: %.2f seconds\n", (double)result.file_frames / result.sample_rate);
+                printf("\nAnalysis Parameters:\n");
+                printf("  Fundamental frequency: %.0f Hz\n", fundamental_freq);
+                printf("  Engine: %s\n", goertzel ? "Goertzel (targeted bins, fundamental tracked)" : "FFT");
+                printf("  %s size: %d\n", goertzel ? "Frame" : "FFT", fft_size);
+                printf("  %s frames averaged: %d\n", goertzel ? "Goertzel" : "FFT", result.fft_frames);
+                printf("  Frequency resolution: %.2f Hz\n", (double)result.sample_rate / fft_size);
+                printf("  Harmonics to analyze: %d\n", harmonic_range);
+                printf("  Window: %s (coherent gain %.4f, ENBW %.3f bins)\n",
+                       ab_window_name(window_type), window->coherent_gain, ab_window_enbw(window));
+                printf("\n");
             }
-            harmonic_magnitudes[h] = 0.0;
-            continue;
+            print_report(&analyzer, &result, fundamental_freq, verbose);
         }
 
-        int harmonic_bin = find_peak_bin(fft_output, fft_size, sfinfo.samplerate,
-                                         harmonic_freq, 50.0);
-        double measured_freq = harmonic_bin * freq_resolution;
-        double harmonic_mag = get_bin_magnitude(fft_output, harmonic_bin);
-        harmonic_mag /= normalization_factor;
-        harmonic_magnitudes[h] = harmonic_mag;
-
-        double harmonic_db = 20.0 * log10(harmonic_mag + 1e-10);
-        double relative_db = harmonic_db - fundamental_db;
-
-        printf("  H%-7d  %10.2f  %12.2f  %21.2f\n",
-               h + 1, measured_freq, harmonic_db, relative_db);
+        if (frames_out && frames_out != stdout) {
+            fclose(frames_out);
+        }
     }
 
 //------------------------------------------------------------------------------
-//	Calculate THD
-//	THD = sqrt(H2^2 + H3^2 + ... + Hn^2) / H1
+//	Batch: one CSV row per file, failures reported and skipped
 //------------------------------------------------------------------------------
-    double harmonic_sum_squares = 0.0;
-    for (int h = 1; h <= harmonic_range; h++) {
-        if (harmonic_magnitudes[h] > 0.0) {
-            harmonic_sum_squares += harmonic_magnitudes[h] * harmonic_magnitudes[h];
+    else {
+        FILE *out = stdout;
+        if (output_file) {
+            out = fopen(output_file, "w");
+            if (!out) {
+                fprintf(stderr, "Error: Could not create output file '%s'\n", output_file);
+                status = 1;
+            }
         }
-    }
 
-    double thd_ratio = sqrt(harmonic_sum_squares) / (fundamental_mag + 1e-10);
-    double thd_percent = thd_ratio * 100.0;
-    double thd_db = 20.0 * log10(thd_ratio + 1e-10);
+        if (out) {
+            int failed = 0;
+            write_csv_header(out, harmonic_range);
 
-    printf("\nTotal Harmonic Distortion (THD):\n");
-    printf("  THD: %.4f%% (%.2f dB)\n", thd_percent, thd_db);
-    printf("  Based on %d harmonics (H2-H%d)\n", harmonic_range, harmonic_range + 1);
+            for (int i = 0; i < jobs.count; i++) {
+                const BatchEntry *job = &jobs.entries[i];
+                int analyzed = goertzel
+                    ? analyze_file_goertzel(&analyzer, job->path, job->freq, max_frames, NULL, 0, &result)
+                    : analyze_file(&analyzer, job->path, job->freq, max_frames, &result);
+                if (analyzed != 0) {
+                    failed++;
+                    continue;
+                }
+                write_csv_row(out, job->path, job->freq, harmonic_range, &result);
+                if (verbose) {
+                    fprintf(stderr, "[%d/%d] %s: THD %.4f%%, THD+N %.4f%% (%d frames)\n",
+                            i + 1, jobs.count, job->path, result.thd_ratio * 100.0,
+                            result.thdn_ratio * 100.0, result.fft_frames);
+                }
+            }
+
+            if (out != stdout) {
+                fclose(out);
+            }
+            if (failed) {
+                fprintf(stderr, "Warning: %d of %d files could not be analyzed\n", failed, jobs.count);
+                status = 1;
+            }
+        }
+    }
 
 //------------------------------------------------------------------------------
 //	Cleanup
 //------------------------------------------------------------------------------
-    free(harmonic_magnitudes);
-    fftw_destroy_plan(plan);
-    fftw_free(fft_output);
-    free(audio_buffer);
-    sf_close(infile);
+    free(harmonic_bins);
+    free(harmonic_freqs);
+    free(harmonic_mags);
+    analyzer_free(&analyzer);
+    ab_window_cache_free();
+    batch_free(&jobs);
 
-    return 0;																//	Exit: status 0 (no error)
+    return status;															//	Exit: 0 (no error), 1 if any file failed
 }
@@ -29,70 +29,1131 @@
 #include <sndfile.h>
 #include <fftw3.h>
 #include <popt.h>
+#include <pthread.h>
+#include "ab_fft_plan.h"
+#include "ab_simd.h"
+#include "ab_window.h"
+#include "ab_core.h"
+#include "ab_wavmap.h"
+#include "ab_specfile.h"
+
+#define STREAM_BLOCK_FRAMES		65536									//	Frames per sf_readf_double() call in streaming mode
+#define MAX_THREADS				64
+#define SLOTS_PER_THREAD		2										//	Snapshots in flight per worker thread
+
+//------------------------------------------------------------------------------
+//	Streaming reader state
+//
+//	Mono ring buffer that is filled front to back from the input file in large
+//	blocks. Frame positions are absolute file frame indices; the ring holds
+//	frames [tail, head).
+//------------------------------------------------------------------------------
+typedef struct {
+    SNDFILE *file;
+    int channels;
+    sf_count_t total_frames;
+    double *ring;															//	Mono samples, capacity is a power of 2
+    sf_count_t mask;														//	Ring capacity - 1
+    sf_count_t head;														//	One past the newest buffered frame
+    sf_count_t tail;														//	Oldest frame still needed
+    double *block;															//	Interleaved read block
+} StreamBuffer;
+
+//------------------------------------------------------------------------------
+//	FFT engine
+//
+//	One r2c plan in either double (fftw) or single (fftwf) precision and the
+//	cached window table (ab_window.h). Power spectra are accumulated in the engine's
+//	precision too, so the float path halves the memory traffic of the
+//	window, FFT and per-bin loops. Samples are read and averaged to mono in
+//	double and narrowed while they are windowed.
+//
+//	The plan is shared by all threads through new-array execute; each thread
+//	owns an FftScratch with its own SIMD-aligned FFT arrays.
+//------------------------------------------------------------------------------
+typedef struct {
+    int single;																//	1 = fftwf path
+    int fft_size;
+    int bins;
+    size_t power_bytes;														//	Size of one power spectrum
+    fftw_plan plan;
+    fftwf_plan plan_f;
+    const AbWindow *window;
+    float *db;																//	dB scratch for write_spectrum and binary output
+} FftEngine;
+
+typedef struct {
+    double *in;
+    fftw_complex *out;
+    float *in_f;
+    fftwf_complex *out_f;
+} FftScratch;
+
+//------------------------------------------------------------------------------
+//	Threaded snapshot processing
+//
+//	The main thread does all file I/O: for each snapshot in a batch it fills a
+//	mono "span" holding every sample the snapshot's windows touch. Workers
+//	then run the FFTs, each with its own buffers, through the single shared
+//	plan (new-array execute). A task covers a range of windows of one
+//	snapshot and accumulates into its own power spectrum, so results do not
+//	depend on which worker ran which task; the main thread reduces and writes
+//	them in snapshot order.
+//------------------------------------------------------------------------------
+typedef struct {
+    const double *span;														//	Mono samples for the snapshot
+    int first_window;
+    int last_window;														//	One past the last window
+    void *power;															//	Partial power spectrum (engine precision)
+} SnapshotTask;
+
+typedef struct WorkerPool WorkerPool;
+
+typedef struct {
+    WorkerPool *pool;
+    pthread_t thread;
+    FftScratch scratch;														//	Allocated before the thread starts
+} WorkerThread;
+
+struct WorkerPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    WorkerThread workers[MAX_THREADS];
+    int num_threads;
+    int generation;															//	Bumped for every batch
+    int shutdown;
+
+    SnapshotTask *tasks;
+    int num_tasks;
+    int next_task;
+    int tasks_done;
+
+    const FftEngine *engine;
+    int hop_size;
+};
+
+//------------------------------------------------------------------------------
+//	Time x frequency matrix output (--binary, --waterfall)
+//
+//	Every snapshot's power spectrum is summed into the current row until
+//	'decimate' snapshots are in it; the row is then converted to dB,
+//	optionally re-binned onto a log frequency axis and appended to the
+//	binary container and/or the gnuplot waterfall text file. Rows are
+//	sized to the plot rather than to the FFT, and the whole matrix comes
+//	out of one run.
+//------------------------------------------------------------------------------
+typedef struct {
+    AbSpecFile binary;
+    FILE *waterfall;														//	"frequency time_ms dBFS" rows for splot
+    int decimate;															//	Snapshots per output row
+    int pending;															//	Snapshots summed into power so far
+    int windows;															//	FFT windows summed into power so far
+    int row_time_ms;														//	Time of the row's first snapshot
+    void *power;															//	Row power sum (engine precision)
+    int columns;															//	Values per row
+    double *band;															//	columns + 1 band edges in FFT bins (NULL = no re-binning)
+    double *freq;															//	Column frequencies (Hz)
+    float *row;
+    double bin_hz;
+} MatrixOutput;
+
+//------------------------------------------------------------------------------
+//	Name:		fft_scratch_alloc
+//
+//	Returns:	0 on success, -1 on allocation failure
+//
+//------------------------------------------------------------------------------
+int fft_scratch_alloc(const FftEngine *engine, FftScratch *scratch)
+{
+    memset(scratch, 0, sizeof(*scratch));
+    if (engine->single) {
+        scratch->in_f = fftwf_alloc_real(engine->fft_size);
+        scratch->out_f = fftwf_alloc_complex(engine->bins);
+        return (scratch->in_f && scratch->out_f) ? 0 : -1;
+    }
+    scratch->in = fftw_alloc_real(engine->fft_size);
+    scratch->out = fftw_alloc_complex(engine->bins);
+    return (scratch->in && scratch->out) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		fft_scratch_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void fft_scratch_free(FftScratch *scratch)
+{
+    fftw_free(scratch->in);
+    fftw_free(scratch->out);
+    fftwf_free(scratch->in_f);
+    fftwf_free(scratch->out_f);
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		fft_engine_free
+//
+//	Returns:	none (safe on a partly initialised engine)
+//
+//------------------------------------------------------------------------------
+void fft_engine_free(FftEngine *engine)
+{
+    if (engine->plan) {
+        fftw_destroy_plan(engine->plan);
+    }
+    if (engine->plan_f) {
+        fftwf_destroy_plan(engine->plan_f);
+    }
+    fftwf_free(engine->db);
+    memset(engine, 0, sizeof(*engine));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		fft_engine_init
+//
+//	Returns:	0 on success, -1 on allocation or planning failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Fetches the window table for fft_size from the window cache
+//	- Plans on temporary arrays (measured planning overwrites them), loading
+//	  and saving the wisdom file for the chosen precision
+//------------------------------------------------------------------------------
+int fft_engine_init(FftEngine *engine, int fft_size, int single, int window_type, double window_beta,
+                    unsigned int planner_flags, const char *wisdom_path)
+{
+    FftScratch scratch;
+
+    memset(engine, 0, sizeof(*engine));
+    engine->single = single;
+    engine->fft_size = fft_size;
+    engine->bins = fft_size / 2 + 1;
+    engine->power_bytes = engine->bins * (single ? sizeof(float) : sizeof(double));
+    engine->window = ab_window_get(window_type, fft_size, window_beta);
+    engine->db = fftwf_alloc_real(engine->bins);
+
+    if (!engine->window || !engine->db || fft_scratch_alloc(engine, &scratch) != 0) {
+        fft_scratch_free(&scratch);
+        fft_engine_free(engine);
+        return -1;
+    }
+
+    if (single) {
+        ab_fftwf_wisdom_load(wisdom_path);
+        engine->plan_f = fftwf_plan_dft_r2c_1d(fft_size, scratch.in_f, scratch.out_f, planner_flags);
+        ab_fftwf_wisdom_save(planner_flags);
+    } else {
+        ab_fft_wisdom_load(wisdom_path);
+        engine->plan = fftw_plan_dft_r2c_1d(fft_size, scratch.in, scratch.out, planner_flags);
+        ab_fft_wisdom_save(planner_flags);
+    }
+    fft_scratch_free(&scratch);
+
+    if (!engine->plan && !engine->plan_f) {
+        fft_engine_free(engine);
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		fft_accumulate
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Windows fft_size mono samples from src into the scratch input, runs
+//	  the FFT and adds |X|^2 into power (float or double per engine)
+//	- src is not modified, so overlapping windows can be read in place
+//------------------------------------------------------------------------------
+void fft_accumulate(const FftEngine *engine, FftScratch *scratch, const double *src, void *power)
+{
+    if (engine->single) {
+        ab_simd_window_f(scratch->in_f, src, engine->window->coeffs_f, engine->fft_size);
+        fftwf_execute_dft_r2c(engine->plan_f, scratch->in_f, scratch->out_f);
+        ab_simd_power_acc_f((float *)power, (const float *)scratch->out_f, engine->bins);
+    } else {
+        ab_simd_window_d(scratch->in, src, engine->window->coeffs, engine->fft_size);
+        fftw_execute_dft_r2c(engine->plan, scratch->in, scratch->out);
+        ab_simd_power_acc_d((double *)power, (const double *)scratch->out, engine->bins);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		power_add
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void power_add(const FftEngine *engine, void *total, const void *partial)
+{
+    if (engine->single) {
+        float *dst = (float *)total;
+        const float *src = (const float *)partial;
+        for (int i = 0; i < engine->bins; i++) {
+            dst[i] += src[i];
+        }
+    } else {
+        double *dst = (double *)total;
+        const double *src = (const double *)partial;
+        for (int i = 0; i < engine->bins; i++) {
+            dst[i] += src[i];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		get_root_filename
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Extracts the root filename without extension
+//	- Handles both forward and backslashes
+//	- Stores result in provided buffer
+//------------------------------------------------------------------------------
+void get_root_filename(const char *filename, char *root, size_t root_size)
+{
+    const char *last_slash = strrchr(filename, '/');
+    if (!last_slash) {
+        last_slash = strrchr(filename, '\\');
+    }
+    const char *base = last_slash ? last_slash + 1 : filename;
+
+    const char *last_dot = strrchr(base, '.');
+    if (last_dot) {
+        size_t len = last_dot - base;
+        if (len >= root_size) len = root_size - 1;
+        strncpy(root, base, len);
+        root[len] = '\0';
+    } else {
+        strncpy(root, base, root_size - 1);
+        root[root_size - 1] = '\0';
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		generate_output_filename
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Generates output filename with timestamp
+//	- Format: root_XXXXms.csv where XXXX is time in milliseconds
+//------------------------------------------------------------------------------
+void generate_output_filename(const char *root, int time_ms, char *output, size_t output_size)
+{
+    snprintf(output, output_size, "%s_%04dms.csv", root, time_ms);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		stream_init
+//
+//	Returns:	0 on success, -1 on allocation failure
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Sizes the ring to hold span_frames plus one read block
+//	- span_frames is the largest range of frames a snapshot needs at once
+//	- Seeks once to start_frame; all further reads are sequential
+//------------------------------------------------------------------------------
+int stream_init(StreamBuffer *sb, SNDFILE *file, const SF_INFO *sfinfo, sf_count_t start_frame, sf_count_t span_frames)
+{
+    sf_count_t capacity = 1;
+    while (capacity < span_frames + STREAM_BLOCK_FRAMES) {
+        capacity <<= 1;
+    }
+
+    sb->file = file;
+    sb->channels = sfinfo->channels;
+    sb->total_frames = sfinfo->frames;
+    sb->mask = capacity - 1;
+    sb->ring = (double *)malloc(capacity * sizeof(double));
+    sb->block = (double *)malloc(STREAM_BLOCK_FRAMES * sfinfo->channels * sizeof(double));
+    if (!sb->ring || !sb->block) {
+        free(sb->ring);
+        free(sb->block);
+        sb->ring = NULL;
+        sb->block = NULL;
+        return -1;
+    }
+
+    sf_seek(file, start_frame, SEEK_SET);
+    sb->head = start_frame;
+    sb->tail = start_frame;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		stream_free
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void stream_free(StreamBuffer *sb)
+{
+    free(sb->ring);
+    free(sb->block);
+    sb->ring = NULL;
+    sb->block = NULL;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		stream_release
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Marks frames before 'frame' as no longer needed
+//	- If 'frame' lies beyond everything read so far, the gap is skipped with
+//	  a single forward seek instead of being read and thrown away
+//------------------------------------------------------------------------------
+void stream_release(StreamBuffer *sb, sf_count_t frame)
+{
+    if (frame > sb->head) {
+        sf_seek(sb->file, frame, SEEK_SET);
+        sb->head = frame;
+    }
+    if (frame > sb->tail) {
+        sb->tail = frame;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		stream_read_window
+//
+//	Returns:	number of frames copied (the rest of dst is zero-filled)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Reads ahead in STREAM_BLOCK_FRAMES blocks until [start, start+count)
+//	  is buffered or the end of the file is reached
+//	- Multi-channel blocks are averaged to mono as they enter the ring
+//	- start must not be earlier than the last stream_release() position
+//------------------------------------------------------------------------------
+sf_count_t stream_read_window(StreamBuffer *sb, sf_count_t start, double *dst, int count)
+{
+    sf_count_t end = start + count;
+    if (end > sb->total_frames) {
+        end = sb->total_frames;
+    }
+
+//------------------------------------------------------------------------------
+//	Fill the ring until the window is covered
+//------------------------------------------------------------------------------
+    while (sb->head < end) {
+        sf_count_t space = (sb->mask + 1) - (sb->head - sb->tail);
+        sf_count_t want = (space < STREAM_BLOCK_FRAMES) ? space : STREAM_BLOCK_FRAMES;
+        sf_count_t got = sf_readf_double(sb->file, sb->block, want);
+        if (got <= 0) {
+            sb->total_frames = sb->head;									//	Short file: treat as end of data
+            if (end > sb->head) {
+                end = sb->head;
+            }
+            break;
+        }
+
+//------------------------------------------------------------------------------
+//	Average to mono in place, then copy into the ring
+//------------------------------------------------------------------------------
+        ab_downmix_mono(sb->block, (size_t)got, sb->channels, sb->block);
+        for (sf_count_t i = 0; i < got; i++) {
+            sb->ring[(sb->head + i) & sb->mask] = sb->block[i];
+        }
+        sb->head += got;
+    }
+
+//------------------------------------------------------------------------------
+//	Copy the window out of the ring in at most two contiguous spans
+//------------------------------------------------------------------------------
+    sf_count_t available = (end > start) ? end - start : 0;
+    sf_count_t first = start & sb->mask;
+    sf_count_t first_len = (sb->mask + 1) - first;
+    if (first_len > available) {
+        first_len = available;
+    }
+    memcpy(dst, sb->ring + first, first_len * sizeof(double));
+    memcpy(dst + first_len, sb->ring, (available - first_len) * sizeof(double));
+    memset(dst + available, 0, (count - available) * sizeof(double));
+
+    return available;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		spectrum_db
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Converts one power sum over 'windows' windowed frames to float dBFS,
+//	  normalised like write_spectrum(); this is what the binary output holds
+//------------------------------------------------------------------------------
+void spectrum_db(const FftEngine *engine, const void *power_sum, int windows, double epsilon, float *db)
+{
+    double normalization = engine->fft_size / 2.0 * engine->window->coherent_gain;
+
+    if (engine->single) {
+        ab_simd_power_db_f(db, (const float *)power_sum, engine->bins,
+                           1.0f / windows, (float)(1.0 / normalization), (float)epsilon);
+        return;
+    }
+
+    const double *power = (const double *)power_sum;
+    for (int i = 0; i < engine->bins; i++) {
+        db[i] = (float)(20.0 * log10(sqrt(power[i] / windows) / normalization + epsilon));
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_spectrum
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes one averaged spectrum as CSV (frequency, dBFS)
+//	- power holds the sum of |FFT|^2 over 'windows' windowed frames
+//	- Magnitudes are normalised for FFT size and the window's coherent gain,
+//	  so a full-scale sine reads 0 dBFS with any window
+//	- The float path converts all bins to dB in one vector pass first
+//------------------------------------------------------------------------------
+void write_spectrum(FILE *outfile, const FftEngine *engine, const void *power_sum, int windows,
+                    double freq_resolution, double epsilon)
+{
+    double normalization = engine->fft_size / 2.0 * engine->window->coherent_gain;
+
+    fprintf(outfile, "\"Frequency (Hz)\",\"Magnitude (dBFS)\"\n");
+
+    if (engine->single) {
+        spectrum_db(engine, power_sum, windows, epsilon, engine->db);
+        for (int i = 0; i < engine->bins; i++) {
+            fprintf(outfile, "%10.2f,%10.2f\n", i * freq_resolution, (double)engine->db[i]);
+        }
+        return;
+    }
+
+    const double *power = (const double *)power_sum;
+    for (int i = 0; i < engine->bins; i++) {
+//------------------------------------------------------------------------------
+//	Average the power spectrum
+//------------------------------------------------------------------------------
+        double avg_power = power[i] / windows;
+//------------------------------------------------------------------------------
+//	Convert back to magnitude
+//------------------------------------------------------------------------------
+        double magnitude = sqrt(avg_power);
+//------------------------------------------------------------------------------
+//	Normalize for FFT size and window (Hann: coherent gain = 0.5, so this is
+//	a division by fft_size / 4.0)
+//------------------------------------------------------------------------------
+        double magnitude_db = 20.0 * log10(magnitude / normalization + epsilon);
+        double frequency = i * freq_resolution;
+
+        fprintf(outfile, "%10.2f,%10.2f\n", frequency, magnitude_db);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		matrix_open
+//
+//	Returns:	0 on success, -1 on error (message printed to stderr)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- log_bins > 0 re-bins each row onto log_bins logarithmically spaced
+//	  bands from freq_min to Nyquist; 0 keeps the FFT bins
+//	- info describes one snapshot per row on the FFT's own bins; the header
+//	  written to the binary container is adjusted for both reductions
+//------------------------------------------------------------------------------
+int matrix_open(MatrixOutput *matrix, const FftEngine *engine, const char *binary_file,
+                const char *waterfall_file, int log_bins, double freq_min, int decimate, AbSpecInfo info)
+{
+    memset(matrix, 0, sizeof(*matrix));
+    matrix->decimate = decimate;
+    matrix->bin_hz = info.freq_step;
+    matrix->columns = (log_bins > 0) ? log_bins : engine->bins;
+    matrix->power = malloc(engine->power_bytes);
+    matrix->freq = (double *)malloc(matrix->columns * sizeof(double));
+    matrix->row = (float *)malloc(matrix->columns * sizeof(float));
+    if (log_bins > 0) {
+        matrix->band = (double *)malloc((matrix->columns + 1) * sizeof(double));
+    }
+    if (!matrix->power || !matrix->freq || !matrix->row || (log_bins > 0 && !matrix->band)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        return -1;
+    }
+    memset(matrix->power, 0, engine->power_bytes);
+
+//------------------------------------------------------------------------------
+//	Frequency axis: band edges r^k * freq_min, centres at the geometric mean
+//------------------------------------------------------------------------------
+    if (log_bins > 0) {
+        double nyquist = info.sample_rate / 2.0;
+        double ratio = pow(nyquist / freq_min, 1.0 / log_bins);
+        for (int c = 0; c <= log_bins; c++) {
+            matrix->band[c] = freq_min * pow(ratio, c) / matrix->bin_hz;
+        }
+        for (int c = 0; c < log_bins; c++) {
+            matrix->freq[c] = freq_min * pow(ratio, c + 0.5);
+        }
+        info.bins = log_bins;
+        info.freq_start = matrix->freq[0];
+        info.freq_step = ratio;
+        info.freq_scale = AB_SPEC_LOG;
+    } else {
+        for (int c = 0; c < matrix->columns; c++) {
+            matrix->freq[c] = c * matrix->bin_hz;
+        }
+    }
+    info.average *= decimate;
+    info.time_step *= decimate;
+
+    if (binary_file && ab_specfile_create(binary_file, &info, &matrix->binary) != 0) {
+        fprintf(stderr, "Error: Could not create binary output file '%s'\n", binary_file);
+        return -1;
+    }
+    if (waterfall_file) {
+        matrix->waterfall = fopen(waterfall_file, "w");
+        if (!matrix->waterfall) {
+            fprintf(stderr, "Error: Could not open waterfall file '%s'\n", waterfall_file);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		matrix_flush
+//
+//	Returns:	0 on success, -1 on a write error
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Converts the pending row to dB and writes it; a band wider than one
+//	  FFT bin takes the peak of the bins in it (tones keep their level), a
+//	  narrower one is interpolated at its centre
+//------------------------------------------------------------------------------
+int matrix_flush(MatrixOutput *matrix, const FftEngine *engine, double epsilon)
+{
+    if (matrix->pending == 0) {
+        return 0;
+    }
+
+    spectrum_db(engine, matrix->power, matrix->windows, epsilon, engine->db);
+    if (matrix->band) {
+        int last_bin = engine->bins - 1;
+        for (int c = 0; c < matrix->columns; c++) {
+            double k0 = matrix->band[c];
+            double k1 = matrix->band[c + 1];
+            if (k1 - k0 >= 1.0) {
+                int first = (int)ceil(k0);
+                int last = (int)floor(k1);
+                if (last > last_bin) {
+                    last = last_bin;
+                }
+                float peak = engine->db[first];
+                for (int k = first + 1; k <= last; k++) {
+                    if (engine->db[k] > peak) {
+                        peak = engine->db[k];
+                    }
+                }
+                matrix->row[c] = peak;
+            } else {
+                double centre = matrix->freq[c] / matrix->bin_hz;
+                int k = (int)centre;
+                if (k >= last_bin) {
+                    matrix->row[c] = engine->db[last_bin];
+                } else {
+                    float frac = (float)(centre - k);
+                    matrix->row[c] = engine->db[k] + (engine->db[k + 1] - engine->db[k]) * frac;
+                }
+            }
+        }
+    } else {
+        memcpy(matrix->row, engine->db, matrix->columns * sizeof(float));
+    }
+
+    int status = 0;
+    if (matrix->binary.file && ab_specfile_append(&matrix->binary, matrix->row) != 0) {
+        status = -1;
+    }
+    if (matrix->waterfall) {
+        for (int c = 0; c < matrix->columns; c++) {
+            fprintf(matrix->waterfall, "%.2f %d %.2f\n", matrix->freq[c], matrix->row_time_ms, (double)matrix->row[c]);
+        }
+        fprintf(matrix->waterfall, "\n");												//	Blank line ends a scan for splot
+        if (ferror(matrix->waterfall)) {
+            status = -1;
+        }
+    }
+
+    memset(matrix->power, 0, engine->power_bytes);
+    matrix->pending = 0;
+    matrix->windows = 0;
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		matrix_add
+//
+//	Returns:	0 on success, -1 on a write error (message printed to stderr)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Adds one snapshot's power sum over 'windows' FFT windows to the
+//	  current row and writes the row once it holds 'decimate' snapshots
+//------------------------------------------------------------------------------
+int matrix_add(MatrixOutput *matrix, const FftEngine *engine, const void *power, int windows,
+               int time_ms, double epsilon)
+{
+    if (matrix->pending == 0) {
+        matrix->row_time_ms = time_ms;
+    }
+    power_add(engine, matrix->power, power);
+    matrix->windows += windows;
+    if (++matrix->pending < matrix->decimate) {
+        return 0;
+    }
+    if (matrix_flush(matrix, engine, epsilon) != 0) {
+        fprintf(stderr, "Error: Could not write spectrum matrix output\n");
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		matrix_close
+//
+//	Returns:	0 on success, -1 on a write error (message printed to stderr)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- A final row with fewer than 'decimate' snapshots is still written,
+//	  averaged over the snapshots it has
+//	- Safe on a matrix that failed to open
+//------------------------------------------------------------------------------
+int matrix_close(MatrixOutput *matrix, const FftEngine *engine, double epsilon)
+{
+    int status = 0;
+
+    if (matrix->power && matrix_flush(matrix, engine, epsilon) != 0) {
+        status = -1;
+    }
+    if (ab_specfile_close(&matrix->binary) != 0) {
+        status = -1;
+    }
+    if (matrix->waterfall && fclose(matrix->waterfall) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Error: Could not write spectrum matrix output\n");
+    }
+
+    free(matrix->power);
+    free(matrix->band);
+    free(matrix->freq);
+    free(matrix->row);
+    memset(matrix, 0, sizeof(*matrix));
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		read_span
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Fills span[0..count) with mono samples starting at 'start'
+//	- A memory-mapped file is converted straight from the mapping
+//	- Streaming mode takes them from the ring; otherwise one seek and one
+//	  read cover the whole snapshot instead of one per window
+//	- Frames past the end of the file are zero
+//------------------------------------------------------------------------------
+void read_span(const AbWavMap *map, StreamBuffer *stream, SNDFILE *infile, const SF_INFO *sfinfo,
+               sf_count_t start, double *span, int count)
+{
+    if (map) {
+        size_t done = ab_wavmap_read_mono(map, (size_t)start, span, (size_t)count);
+        memset(span + done, 0, (count - done) * sizeof(double));
+        return;
+    }
+    if (stream) {
+        stream_release(stream, start);
+        stream_read_window(stream, start, span, count);
+        return;
+    }
+
+    sf_seek(infile, start, SEEK_SET);
+    sf_count_t done = ab_read_mono(infile, sfinfo->channels, span, count);
+    memset(span + done, 0, (count - done) * sizeof(double));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		accumulate_windows
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Adds |FFT|^2 of windows [first, last) of a span into power
+//	- scratch holds the worker's private FFT arrays for the shared plan
+//------------------------------------------------------------------------------
+void accumulate_windows(const WorkerPool *pool, const SnapshotTask *task, FftScratch *scratch)
+{
+    for (int window = task->first_window; window < task->last_window; window++) {
+        fft_accumulate(pool->engine, scratch, task->span + (size_t)window * pool->hop_size, task->power);
+    }
+}
 
 //------------------------------------------------------------------------------
-//	Name:		apply_hann_window
+//	Name:		worker_main
 //
-//	Returns:	none
+//	Returns:	NULL
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Applies Hann window to reduce spectral leakage
-//	- Window function: 0.5 * (1 - cos(2*pi*n/(N-1)))
-//	- Modifies data in-place
+//	- Waits for a batch, takes tasks until none are left, then waits again
 //------------------------------------------------------------------------------
-void apply_hann_window(double *data, int size)
+void *worker_main(void *arg)
 {
-    for (int i = 0; i < size; i++) {
-        double window = 0.5 * (1.0 - cos(2.0 * M_PI * i / (size - 1)));
-        data[i] *= window;
+    WorkerThread *worker = (WorkerThread *)arg;
+    WorkerPool *pool = worker->pool;
+    int seen_generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen_generation = pool->generation;
+
+        while (pool->next_task < pool->num_tasks) {
+            SnapshotTask *task = &pool->tasks[pool->next_task++];
+            pthread_mutex_unlock(&pool->lock);
+            accumulate_windows(pool, task, &worker->scratch);
+            pthread_mutex_lock(&pool->lock);
+            if (++pool->tasks_done == pool->num_tasks) {
+                pthread_cond_signal(&pool->work_done);
+            }
+        }
     }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		get_root_filename
+//	Name:		worker_pool_start
 //
-//	Returns:	none
+//	Returns:	0 on success, -1 if the FFT buffers could not be allocated
+//				or no thread could be started (the pool is then released)
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Extracts the root filename without extension
-//	- Handles both forward and backslashes
-//	- Stores result in provided buffer
+//	- Every worker's FFT buffers are allocated before any thread starts, so
+//	  a running worker never sees a missing buffer
 //------------------------------------------------------------------------------
-void get_root_filename(const char *filename, char *root, size_t root_size)
+int worker_pool_start(WorkerPool *pool, int num_threads, const FftEngine *engine)
 {
-    const char *last_slash = strrchr(filename, '/');
-    if (!last_slash) {
-        last_slash = strrchr(filename, '\\');
+    memset(pool, 0, sizeof(*pool));
+    pool->engine = engine;
+    pool->hop_size = engine->fft_size / 2;
+
+    for (int i = 0; i < num_threads; i++) {
+        pool->workers[i].pool = pool;
+        if (fft_scratch_alloc(engine, &pool->workers[i].scratch) != 0) {
+            for (int j = 0; j <= i; j++) {
+                fft_scratch_free(&pool->workers[j].scratch);
+            }
+            return -1;
+        }
     }
-    const char *base = last_slash ? last_slash + 1 : filename;
 
-    const char *last_dot = strrchr(base, '.');
-    if (last_dot) {
-        size_t len = last_dot - base;
-        if (len >= root_size) len = root_size - 1;
-        strncpy(root, base, len);
-        root[len] = '\0';
-    } else {
-        strncpy(root, base, root_size - 1);
-        root[root_size - 1] = '\0';
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->workers[i].thread, NULL, worker_main, &pool->workers[i]) != 0) {
+            break;
+        }
+        pool->num_threads++;
+    }
+    for (int i = pool->num_threads; i < num_threads; i++) {
+        fft_scratch_free(&pool->workers[i].scratch);
     }
+    if (pool->num_threads == 0) {
+        pthread_cond_destroy(&pool->work_done);
+        pthread_cond_destroy(&pool->work_ready);
+        pthread_mutex_destroy(&pool->lock);
+        return -1;
+    }
+    return 0;
 }
 
 //------------------------------------------------------------------------------
-//	Name:		generate_output_filename
+//	Name:		worker_pool_submit
 //
 //	Returns:	none
 //
 //------------------------------------------------------------------------------
 //	Detailed description:
-//	- Generates output filename with timestamp
-//	- Format: root_XXXXms.csv where XXXX is time in milliseconds
+//	- Hands a batch of tasks to the workers and returns immediately, so the
+//	  caller can read the next batch while this one is computed
 //------------------------------------------------------------------------------
-void generate_output_filename(const char *root, int time_ms, char *output, size_t output_size)
+void worker_pool_submit(WorkerPool *pool, SnapshotTask *tasks, int num_tasks)
 {
-    snprintf(output, output_size, "%s_%04dms.csv", root, time_ms);
+    pthread_mutex_lock(&pool->lock);
+    pool->tasks = tasks;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->tasks_done = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		worker_pool_wait
+//
+//	Returns:	none (blocks until every task of the submitted batch is done)
+//
+//------------------------------------------------------------------------------
+void worker_pool_wait(WorkerPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->tasks_done < pool->num_tasks) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		worker_pool_stop
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void worker_pool_stop(WorkerPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+        fft_scratch_free(&pool->workers[i].scratch);
+    }
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		open_snapshot_output
+//
+//	Returns:	output stream (stdout if no output file), NULL on error
+//
+//------------------------------------------------------------------------------
+FILE *open_snapshot_output(int interval_ms, const char *output_root, const char *output_file,
+                           int time_ms, char *filename, size_t filename_size)
+{
+    FILE *outfile = stdout;
+
+    if (interval_ms > 0) {
+        generate_output_filename(output_root, time_ms, filename, filename_size);
+        outfile = fopen(filename, "w");
+    } else if (output_file) {
+        snprintf(filename, filename_size, "%s", output_file);
+        outfile = fopen(filename, "w");
+    }
+    if (!outfile) {
+        fprintf(stderr, "Error: Could not open output file '%s'\n", filename);
+    }
+    return outfile;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		process_snapshots_threaded
+//
+//	Returns:	0 on success, 1 on error, 2 if the worker pool could not be
+//				started (nothing has been read or written yet)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Processes snapshots in batches of SLOTS_PER_THREAD per worker
+//	- Two batches of spans are used alternately: while the workers compute
+//	  one batch the main thread reads the next
+//	- With fewer snapshots than threads (e.g. one heavily averaged snapshot)
+//	  the windows of each snapshot are split into contiguous chunks
+//	- Partial spectra are summed in chunk order and written in snapshot
+//	  order, so the output is the same on every run
+//	- With matrix output (binary container or waterfall), CSV files are
+//	  only written if output_file was given
+//------------------------------------------------------------------------------
+int process_snapshots_threaded(const AbWavMap *map, SNDFILE *infile, const SF_INFO *sfinfo, StreamBuffer *stream,
+                               const int *snapshot_times_ms, int num_snapshots, double offset_sec,
+                               int avg_count, const FftEngine *engine, int num_threads,
+                               int interval_ms, const char *output_root, const char *output_file,
+                               MatrixOutput *matrix, int quiet, double freq_resolution, double epsilon)
+{
+    int write_csv = !matrix || output_file;
+    int fft_size = engine->fft_size;
+    int hop_size = fft_size / 2;
+    size_t span_frames = (size_t)(avg_count - 1) * hop_size + fft_size;
+
+    int slots = num_threads * SLOTS_PER_THREAD;
+    if (slots > num_snapshots) {
+        slots = num_snapshots;
+    }
+    int chunks = (num_threads + slots - 1) / slots;
+    if (chunks > avg_count) {
+        chunks = avg_count;
+    }
+
+//------------------------------------------------------------------------------
+//	Allocate two sets of spans, tasks and partial spectra
+//------------------------------------------------------------------------------
+    double *spans = (double *)malloc(2 * slots * span_frames * sizeof(double));
+    SnapshotTask *tasks = (SnapshotTask *)malloc(2 * slots * chunks * sizeof(SnapshotTask));
+    char *partials = (char *)malloc((size_t)2 * slots * chunks * engine->power_bytes);
+    void *total = malloc(engine->power_bytes);
+    WorkerPool pool;
+
+    if (!spans || !tasks || !partials || !total) {
+        fprintf(stderr, "Error: Memory allocation failed (%d snapshot buffers of %zu frames)\n",
+                2 * slots, span_frames);
+        free(spans);
+        free(tasks);
+        free(partials);
+        free(total);
+        return 1;
+    }
+    if (worker_pool_start(&pool, num_threads, engine) != 0) {
+        free(spans);
+        free(tasks);
+        free(partials);
+        free(total);
+        return 2;
+    }
+
+    int status = 0;
+    int next_snapshot = 0;
+    int pending_first = 0;														//	First snapshot of the batch in flight
+    int pending_count = 0;
+    int pending_set = 0;
+
+    for (;;) {
+//------------------------------------------------------------------------------
+//	Read the next batch into the set not being computed
+//------------------------------------------------------------------------------
+        int set = pending_count ? 1 - pending_set : 0;
+        int batch_first = next_snapshot;
+        int batch_count = 0;
+
+        while (batch_count < slots && next_snapshot < num_snapshots) {
+            sf_count_t start_frame = (sf_count_t)((offset_sec + (double)snapshot_times_ms[next_snapshot] / 1000.0) * sfinfo->samplerate);
+            if (start_frame >= sfinfo->frames) {
+                next_snapshot = num_snapshots;									//	Past the end: stop here
+                break;
+            }
+
+            int slot = set * slots + batch_count;
+            double *span = spans + (size_t)slot * span_frames;
+            read_span(map, stream, infile, sfinfo, start_frame, span, (int)span_frames);
+
+            for (int c = 0; c < chunks; c++) {
+                SnapshotTask *task = &tasks[slot * chunks + c];
+                task->span = span;
+                task->first_window = (int)((long long)avg_count * c / chunks);
+                task->last_window = (int)((long long)avg_count * (c + 1) / chunks);
+                task->power = partials + ((size_t)slot * chunks + c) * engine->power_bytes;
+                memset(task->power, 0, engine->power_bytes);
+            }
+            batch_count++;
+            next_snapshot++;
+        }
+
+//------------------------------------------------------------------------------
+//	Wait for the batch in flight and write its spectra in order
+//------------------------------------------------------------------------------
+        if (pending_count) {
+            worker_pool_wait(&pool);
+
+            for (int b = 0; b < pending_count; b++) {
+                int snapshot = pending_first + b;
+                int slot = pending_set * slots + b;
+                char filename[1024] = "";
+
+                memset(total, 0, engine->power_bytes);
+                for (int c = 0; c < chunks; c++) {
+                    power_add(engine, total, tasks[slot * chunks + c].power);
+                }
+
+                if (matrix && matrix_add(matrix, engine, total, avg_count,
+                                         snapshot_times_ms[snapshot], epsilon) != 0) {
+                    status = 1;
+                    break;
+                }
+                if (!write_csv) {
+                    if (!quiet && interval_ms > 0) {
+                        fprintf(stderr, "Processing snapshot %d/%d at %d ms\n",
+                                snapshot + 1, num_snapshots, snapshot_times_ms[snapshot]);
+                    }
+                    continue;
+                }
+
+                FILE *outfile = open_snapshot_output(interval_ms, output_root, output_file,
+                                                     snapshot_times_ms[snapshot], filename, sizeof(filename));
+                if (!outfile) {
+                    if (interval_ms > 0) {
+                        continue;
+                    }
+                    status = 1;
+                    break;
+                }
+                if (!quiet && interval_ms > 0) {
+                    fprintf(stderr, "Processing snapshot %d/%d at %d ms -> %s\n",
+                            snapshot + 1, num_snapshots, snapshot_times_ms[snapshot], filename);
+                }
+                write_spectrum(outfile, engine, total, avg_count, freq_resolution, epsilon);
+                if (outfile != stdout) {
+                    fclose(outfile);
+                }
+            }
+            pending_count = 0;
+        }
+
+        if (batch_count == 0 || status != 0) {
+            break;
+        }
+
+//------------------------------------------------------------------------------
+//	Hand the freshly read batch to the workers
+//------------------------------------------------------------------------------
+        worker_pool_submit(&pool, &tasks[set * slots * chunks], batch_count * chunks);
+        pending_first = batch_first;
+        pending_count = batch_count;
+        pending_set = set;
+    }
+
+    worker_pool_stop(&pool);
+    free(spans);
+    free(tasks);
+    free(partials);
+    free(total);
+    return status;
 }
 
 //------------------------------------------------------------------------------
@@ -101,13 +1162,18 @@ void generate_output_filename(const char *root, int time_ms, char *output, size_
 //	This application:
 //	- Reads audio file
 //	- Performs FFT analysis (single or multiple snapshots)
-//	- Outputs frequency spectrum to CSV file(s)
+//	- Outputs frequency spectrum to CSV file(s) and/or the whole time x
+//	  frequency matrix: a binary container (ab_specfile.h) or a gnuplot
+//	  waterfall file, optionally log-frequency re-binned and decimated
 //	- Supports optional averaging of multiple FFTs
 //	- Supports interval-based snapshot mode
+//	- Optional streaming mode reads the file once, front to back
+//	- PCM WAV / RF64 files are memory-mapped, so windows are read without
+//	  seeking
 //
 //	Libraries:
 //	- libsndfile: Audio file I/O
-//	- FFTW3: Fast Fourier Transform
+//	- FFTW3: Fast Fourier Transform (double and single precision)
 //	- libpopt: Command-line parsing
 //------------------------------------------------------------------------------
 int main(int argc, char *argv[])
@@ -117,12 +1183,24 @@ int main(int argc, char *argv[])
 //------------------------------------------------------------------------------
     char *input_file = NULL;
     char *output_file = NULL;
+    char *binary_file = NULL;										//	Binary spectrum container (NULL = none)
+    char *waterfall_file = NULL;									//	gnuplot waterfall matrix (NULL = none)
+    int log_bins = 0;												//	Log-frequency columns (0 = FFT bins)
+    double freq_min = 20.0;											//	Lowest log-frequency band edge (Hz)
+    int decimate = 1;												//	Snapshots averaged per matrix row
     int fft_size = 8192;
     int sample_rate = 0;											//	0 means use file's native sample rate
     int quiet = 0;													//	0 = show diagnostic output, 1 = quiet mode
     int avg_count = 1;												//	Number of FFTs to average (default: 1 = no averaging)
     int interval_ms = 0;											//	Interval in milliseconds for snapshots (0 = single FFT mode)
     double offset_sec = 0.0;										//	Offset in seconds to skip at the beginning
+    int stream_mode = 0;											//	1 = read sequentially into a ring buffer
+    int no_mmap = 0;												//	1 = always read through libsndfile
+    char *planner_name = NULL;										//	FFTW planner effort (NULL = estimate)
+    char *wisdom_path = NULL;										//	FFTW wisdom file (NULL = default location)
+    char *precision_name = NULL;									//	FFT precision (NULL = auto from bit depth)
+    char *window_name = NULL;										//	Window function (NULL = Hann)
+    int num_threads = 1;											//	Worker threads for snapshot FFTs
     int version_flag = 0;
 
 //------------------------------------------------------------------------------
@@ -132,11 +1210,23 @@ int main(int argc, char *argv[])
         {"version",		'v',	POPT_ARG_NONE,		&version_flag,	0,	"Show version information", 									NULL},
         {"input",		'i',	POPT_ARG_STRING,	&input_file,	0,	"Input WAV file",												"FILE"		},
         {"output",		'o',	POPT_ARG_STRING,	&output_file,	0,	"Output CSV file or root name for interval mode",				"FILE"		},
+        {"binary",		'B',	POPT_ARG_STRING,	&binary_file,	0,	"Write all spectra to one binary float32 dB file (CSV then only with -o)",	"FILE"	},
+        {"waterfall",	'Z',	POPT_ARG_STRING,	&waterfall_file,	0,	"Write all spectra as one gnuplot matrix: frequency time_ms dBFS (CSV then only with -o)",	"FILE"	},
+        {"log-bins",	'L',	POPT_ARG_INT,		&log_bins,		0,	"Re-bin matrix output onto N log-spaced bands (default: 0 = FFT bins)",	"N"	},
+        {"freq-min",	'F',	POPT_ARG_DOUBLE,	&freq_min,		0,	"Lowest frequency of the log bands (default: 20 Hz)",		"HZ"		},
+        {"decimate",	'D',	POPT_ARG_INT,		&decimate,		0,	"Average N snapshots per matrix row (default: 1)",			"N"			},
         {"fft-size",	'f',	POPT_ARG_INT,		&fft_size,		0,	"FFT size (default: 8192)",										"SIZE"		},
         {"sample-rate",	's',	POPT_ARG_INT,		&sample_rate,	0,	"Sample rate in Hz (default: use file's native rate)",			"RATE"		},
         {"average",		'a',	POPT_ARG_INT,		&avg_count,		0,	"Number of overlapping FFTs to average (default: 1)",			"COUNT"		},
         {"interval",	't',	POPT_ARG_INT,		&interval_ms,	0,	"Take FFT every N milliseconds (creates multiple files)",		"MS"		},
         {"offset",		'O',	POPT_ARG_DOUBLE,	&offset_sec,	0,	"Offset in seconds to skip at the beginning (default: 0.0)",	"SECONDS"	},
+        {"stream",		'S',	POPT_ARG_NONE,		&stream_mode,	0,	"Streaming mode: one sequential libsndfile pass instead of seeking per window (no memory map)",	NULL	},
+        {"no-mmap",		'M',	POPT_ARG_NONE,		&no_mmap,		0,	"Read through libsndfile instead of memory-mapping PCM WAV/RF64 files",	NULL	},
+        {"planner",		'P',	POPT_ARG_STRING,	&planner_name,	0,	"FFTW planner: estimate, measure, patient, exhaustive (default: estimate)",	"MODE"	},
+        {"wisdom",		'W',	POPT_ARG_STRING,	&wisdom_path,	0,	"FFTW wisdom file (default: $AB_FFTW_WISDOM or ~/.ab_fftw_wisdom)",	"FILE"	},
+        {"window",		'w',	POPT_ARG_STRING,	&window_name,	0,	"Window: hann, blackman-harris, flattop, kaiser[:BETA] (default: hann)",	"NAME"	},
+        {"precision",	'p',	POPT_ARG_STRING,	&precision_name,	0,	"FFT precision: auto, float, double (default: auto, float for 8-24 bit PCM)",	"MODE"	},
+        {"threads",		'T',	POPT_ARG_INT,		&num_threads,	0,	"Worker threads for snapshot/average FFTs (default: 1)",		"N"			},
         {"quiet",		'q',	POPT_ARG_NONE,		&quiet,			0,	"Quiet mode: suppress diagnostic output",						NULL		},
         POPT_AUTOHELP
         POPT_TABLEEND
@@ -205,6 +1295,60 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Validate thread count
+//------------------------------------------------------------------------------
+    if (num_threads < 1 || num_threads > MAX_THREADS) {
+        fprintf(stderr, "Error: Thread count must be between 1 and %d\n", MAX_THREADS);
+        poptFreeContext(opt_context);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate matrix output reduction
+//------------------------------------------------------------------------------
+    if (log_bins < 0 || decimate < 1) {
+        fprintf(stderr, "Error: Log bins must be non-negative and decimation at least 1\n");
+        poptFreeContext(opt_context);
+        return 1;
+    }
+    if (freq_min <= 0.0) {
+        fprintf(stderr, "Error: Minimum frequency must be positive\n");
+        poptFreeContext(opt_context);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate FFTW planner mode
+//------------------------------------------------------------------------------
+    unsigned int planner_flags;
+    if (ab_fft_parse_planner(planner_name, &planner_flags) != 0) {
+        fprintf(stderr, "Error: Unknown planner '%s' (use estimate, measure, patient or exhaustive)\n", planner_name);
+        poptFreeContext(opt_context);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate window function
+//------------------------------------------------------------------------------
+    int window_type;
+    double window_beta;
+    if (ab_window_parse(window_name, &window_type, &window_beta) != 0) {
+        fprintf(stderr, "Error: Unknown window '%s' (use hann, blackman-harris, flattop or kaiser[:BETA])\n", window_name);
+        poptFreeContext(opt_context);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate FFT precision
+//------------------------------------------------------------------------------
+    int precision;
+    if (ab_fft_parse_precision(precision_name, &precision) != 0) {
+        fprintf(stderr, "Error: Unknown precision '%s' (use auto, float or double)\n", precision_name);
+        poptFreeContext(opt_context);
+        return 1;
+    }
+
     poptFreeContext(opt_context);
 
 //------------------------------------------------------------------------------
@@ -219,6 +1363,22 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+//------------------------------------------------------------------------------
+//	Memory-map PCM WAV / RF64 files (libsndfile stays the fallback and the
+//	source of the file information). A map that disagrees with libsndfile
+//	about the layout is not used. An explicit --stream asks for one
+//	sequential libsndfile pass, so it is honoured instead of the map.
+//------------------------------------------------------------------------------
+    AbWavMap wavmap;
+    memset(&wavmap, 0, sizeof(wavmap));
+    if (!no_mmap && !stream_mode && ab_wavmap_open(input_file, &wavmap) == 0) {
+        if ((sf_count_t)wavmap.frames != sfinfo.frames || wavmap.channels != sfinfo.channels ||
+            (wavmap.format & SF_FORMAT_SUBMASK) != (sfinfo.format & SF_FORMAT_SUBMASK)) {
+            ab_wavmap_close(&wavmap);
+        }
+    }
+    const AbWavMap *map = wavmap.base ? &wavmap : NULL;
+
 //------------------------------------------------------------------------------
 //	Use specified sample rate if provided, otherwise use file's native rate
 //------------------------------------------------------------------------------
@@ -230,12 +1390,25 @@ int main(int argc, char *argv[])
     double file_duration = (double)sfinfo.frames / sfinfo.samplerate;
     if (offset_sec < 0.0) {
         fprintf(stderr, "Error: Offset must be non-negative\n");
+        ab_wavmap_close(&wavmap);
         sf_close(infile);
         return 1;
     }
     if (offset_sec >= file_duration) {
         fprintf(stderr, "Error: Offset (%.2f s) exceeds file duration (%.2f s)\n",
                 offset_sec, file_duration);
+        ab_wavmap_close(&wavmap);
+        sf_close(infile);
+        return 1;
+    }
+
+//------------------------------------------------------------------------------
+//	Validate the log-frequency range
+//------------------------------------------------------------------------------
+    if (log_bins > 0 && freq_min >= effective_sample_rate / 2.0) {
+        fprintf(stderr, "Error: Minimum frequency (%.1f Hz) must be below Nyquist (%.1f Hz)\n",
+                freq_min, effective_sample_rate / 2.0);
+        ab_wavmap_close(&wavmap);
         sf_close(infile);
         return 1;
     }
@@ -279,6 +1452,11 @@ int main(int argc, char *argv[])
         break;
     }
 
+//------------------------------------------------------------------------------
+//	Select FFT precision (auto: float when the source has 24 bits or fewer)
+//------------------------------------------------------------------------------
+    int use_float = ab_fft_use_float(precision, bit_depth);
+
 //------------------------------------------------------------------------------
 //	Print file information (to stderr in interval mode, to output file otherwise)
 //------------------------------------------------------------------------------
@@ -298,11 +1476,41 @@ int main(int argc, char *argv[])
             fprintf(info_out, "Offset: %.2f seconds\n", offset_sec);
         }
         fprintf(info_out, "FFT size: %d\n", fft_size);
+        fprintf(info_out, "FFT planner: %s\n", ab_fft_planner_name(planner_flags));
+        fprintf(info_out, "FFT precision: %s (%s)\n", use_float ? "float" : "double", ab_simd_name());
+        fprintf(info_out, "Window: %s", ab_window_name(window_type));
+        if (window_type == AB_WINDOW_KAISER) {
+            fprintf(info_out, " (beta %.2f)", window_beta);
+        }
+        fprintf(info_out, "\n");
         if (interval_ms > 0) {
             fprintf(info_out, "Interval mode: FFT every %d ms\n", interval_ms);
         } else if (avg_count > 1) {
             fprintf(info_out, "FFT averaging: %d windows (50%% overlap)\n", avg_count);
         }
+        if (map) {
+            fprintf(info_out, "Reader: memory-mapped\n");
+        } else if (stream_mode) {
+            fprintf(info_out, "Streaming: %d-frame reads\n", STREAM_BLOCK_FRAMES);
+        }
+        if (num_threads > 1) {
+            fprintf(info_out, "Worker threads: %d\n", num_threads);
+        }
+        if (binary_file) {
+            fprintf(info_out, "Binary output: %s\n", binary_file);
+        }
+        if (waterfall_file) {
+            fprintf(info_out, "Waterfall output: %s\n", waterfall_file);
+        }
+        if ((binary_file || waterfall_file) && (log_bins > 0 || decimate > 1)) {
+            fprintf(info_out, "Matrix: ");
+            if (log_bins > 0) {
+                fprintf(info_out, "%d log bands from %.1f Hz", log_bins, freq_min);
+            } else {
+                fprintf(info_out, "FFT bins");
+            }
+            fprintf(info_out, ", %d snapshot(s) per row\n", decimate);
+        }
         fprintf(info_out, "\n");
     }
 
@@ -319,22 +1527,33 @@ int main(int argc, char *argv[])
     }
 
 //------------------------------------------------------------------------------
-//	Allocate buffers
+//	Create the FFT plan (wisdom from earlier runs makes measured plans cheap)
 //------------------------------------------------------------------------------
-    double *audio_buffer = (double *)malloc(fft_size * sizeof(double));
-    fftw_complex *fft_output = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * (fft_size / 2 + 1));
-    double *power_spectrum = (double *)calloc(fft_size / 2 + 1, sizeof(double));		//	Accumulator for averaged power
+    FftEngine engine;
+    FftScratch scratch;
 
-    if (!audio_buffer || !fft_output || !power_spectrum) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
+    if (fft_engine_init(&engine, fft_size, use_float, window_type, window_beta, planner_flags, wisdom_path) != 0) {
+        fprintf(stderr, "Error: Could not create %s precision FFT plan\n", use_float ? "float" : "double");
+        ab_window_cache_free();
+        ab_wavmap_close(&wavmap);
         sf_close(infile);
         return 1;
     }
 
-//------------------------------------------------------------------------------
-//	Create FFTW plan
-//------------------------------------------------------------------------------
-    fftw_plan plan = fftw_plan_dft_r2c_1d(fft_size, audio_buffer, fft_output, FFTW_ESTIMATE);
+    double *audio_buffer = (double *)fftw_malloc(fft_size * sizeof(double));			//	Mono samples of one window
+    void *power_spectrum = calloc(1, engine.power_bytes);							//	Accumulator for averaged power
+
+    if (!audio_buffer || !power_spectrum || fft_scratch_alloc(&engine, &scratch) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        fftw_free(audio_buffer);
+        free(power_spectrum);
+        fft_scratch_free(&scratch);
+        fft_engine_free(&engine);
+        ab_window_cache_free();
+        ab_wavmap_close(&wavmap);
+        sf_close(infile);
+        return 1;
+    }
 
 //------------------------------------------------------------------------------
 //	Calculate frequency resolution
@@ -372,9 +1591,116 @@ int main(int argc, char *argv[])
         num_snapshots = 1;
     }
 
+//------------------------------------------------------------------------------
+//	Calculate hop size (50% overlap) for averaging
+//------------------------------------------------------------------------------
+    int hop_size = fft_size / 2;
+
+//------------------------------------------------------------------------------
+//	Set up the streaming reader: the ring must hold every window of one
+//	snapshot, i.e. (avg_count - 1) hops plus one full FFT frame
+//------------------------------------------------------------------------------
+    StreamBuffer stream;
+    if (stream_mode) {
+        sf_count_t first_frame = (sf_count_t)(offset_sec * sfinfo.samplerate);
+        sf_count_t span_frames = (sf_count_t)(avg_count - 1) * hop_size + fft_size;
+        if (stream_init(&stream, infile, &sfinfo, first_frame, span_frames) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            free(snapshot_times_ms);
+            free(power_spectrum);
+            fft_scratch_free(&scratch);
+            fft_engine_free(&engine);
+            ab_window_cache_free();
+            fftw_free(audio_buffer);
+            ab_wavmap_close(&wavmap);
+            sf_close(infile);
+            return 1;
+        }
+    }
+
+//------------------------------------------------------------------------------
+//	Open the matrix outputs: one row per 'decimate' snapshots, interval_ms
+//	apart
+//------------------------------------------------------------------------------
+    MatrixOutput matrix;
+    memset(&matrix, 0, sizeof(matrix));
+    if (binary_file || waterfall_file) {
+        AbSpecInfo spec_info;
+        memset(&spec_info, 0, sizeof(spec_info));
+        spec_info.bins = engine.bins;
+        spec_info.sample_rate = effective_sample_rate;
+        spec_info.fft_size = fft_size;
+        spec_info.window = window_type;
+        spec_info.window_beta = window_beta;
+        spec_info.average = avg_count;
+        spec_info.time_start = offset_sec;
+        spec_info.time_step = interval_ms / 1000.0;
+        spec_info.freq_step = freq_resolution;
+        spec_info.freq_scale = AB_SPEC_LINEAR;
+
+        if (matrix_open(&matrix, &engine, binary_file, waterfall_file,
+                        log_bins, freq_min, decimate, spec_info) != 0) {
+            matrix_close(&matrix, &engine, epsilon);
+            if (stream_mode) {
+                stream_free(&stream);
+            }
+            free(snapshot_times_ms);
+            free(power_spectrum);
+            fft_scratch_free(&scratch);
+            fft_engine_free(&engine);
+            ab_window_cache_free();
+            fftw_free(audio_buffer);
+            ab_wavmap_close(&wavmap);
+            sf_close(infile);
+            return 1;
+        }
+    }
+    MatrixOutput *matrix_out = (binary_file || waterfall_file) ? &matrix : NULL;
+    int write_csv = !matrix_out || output_file;
+
+//------------------------------------------------------------------------------
+//	Threaded mode: workers compute, main thread reads and writes in order.
+//	If the pool cannot start, fall through to the single-threaded loop
+//------------------------------------------------------------------------------
+    int threaded_status = 2;
+    if (num_threads > 1) {
+        threaded_status = process_snapshots_threaded(map, infile, &sfinfo, stream_mode ? &stream : NULL,
+                                                     snapshot_times_ms, num_snapshots, offset_sec,
+                                                     avg_count, &engine, num_threads,
+                                                     interval_ms, output_root, output_file,
+                                                     matrix_out, quiet, freq_resolution, epsilon);
+        if (threaded_status == 2) {
+            fprintf(stderr, "Warning: Could not start %d worker threads, continuing single-threaded\n",
+                    num_threads);
+        }
+    }
+    if (threaded_status != 2) {
+        int status = threaded_status;
+        if (matrix_out && matrix_close(&matrix, &engine, epsilon) != 0) {
+            status = 1;
+        }
+        if (!quiet && interval_ms > 0 && status == 0) {
+            fprintf(stderr, "Completed %d snapshots\n", num_snapshots);
+        }
+        if (stream_mode) {
+            stream_free(&stream);
+        }
+        free(snapshot_times_ms);
+        free(power_spectrum);
+        fft_scratch_free(&scratch);
+        fft_engine_free(&engine);
+        ab_window_cache_free();
+        fftw_free(audio_buffer);
+        ab_wavmap_close(&wavmap);
+        sf_close(infile);
+        return status;
+    }
+
 //------------------------------------------------------------------------------
 //	Process each snapshot
 //------------------------------------------------------------------------------
+    int status = 0;
+
     for (int snapshot = 0; snapshot < num_snapshots; snapshot++) {
         int time_ms = snapshot_times_ms[snapshot];
 
@@ -390,13 +1716,25 @@ int main(int argc, char *argv[])
             break;
         }
 
+        if (stream_mode) {
+            stream_release(&stream, start_frame);
+        }
+
 //------------------------------------------------------------------------------
 //	Open output file for this snapshot
 //------------------------------------------------------------------------------
-        FILE *outfile = stdout;
+        FILE *outfile = write_csv ? stdout : NULL;
         char snapshot_filename[1024];
 
-        if (interval_ms > 0) {
+        if (!write_csv) {
+//------------------------------------------------------------------------------
+//	Binary container only: no CSV for this snapshot
+//------------------------------------------------------------------------------
+            if (!quiet && interval_ms > 0) {
+                fprintf(stderr, "Processing snapshot %d/%d at %d ms\n",
+                        snapshot + 1, num_snapshots, time_ms);
+            }
+        } else if (interval_ms > 0) {
 //------------------------------------------------------------------------------
 //	Interval mode: create timestamped file
 //------------------------------------------------------------------------------
@@ -404,9 +1742,10 @@ int main(int argc, char *argv[])
             outfile = fopen(snapshot_filename, "w");
             if (!outfile) {
                 fprintf(stderr, "Error: Could not open output file '%s'\n", snapshot_filename);
-                continue;
-            }
-            if (!quiet) {
+                if (!matrix_out) {
+                    continue;
+                }
+            } else if (!quiet) {
                 fprintf(stderr, "Processing snapshot %d/%d at %d ms -> %s\n",
                         snapshot + 1, num_snapshots, time_ms, snapshot_filename);
             }
@@ -419,9 +1758,15 @@ int main(int argc, char *argv[])
                 fprintf(stderr, "Error: Could not open output file '%s'\n", output_file);
                 free(snapshot_times_ms);
                 free(power_spectrum);
-                fftw_destroy_plan(plan);
-                fftw_free(fft_output);
-                free(audio_buffer);
+                fft_scratch_free(&scratch);
+                fft_engine_free(&engine);
+                ab_window_cache_free();
+                fftw_free(audio_buffer);
+                if (stream_mode) {
+                    stream_free(&stream);
+                }
+                matrix_close(&matrix, &engine, epsilon);
+                ab_wavmap_close(&wavmap);
                 sf_close(infile);
                 return 1;
             }
@@ -430,12 +1775,7 @@ int main(int argc, char *argv[])
 //------------------------------------------------------------------------------
 //	Clear power spectrum accumulator
 //------------------------------------------------------------------------------
-        memset(power_spectrum, 0, (fft_size / 2 + 1) * sizeof(double));
-
-//------------------------------------------------------------------------------
-//	Calculate hop size (50% overlap) for averaging
-//------------------------------------------------------------------------------
-        int hop_size = fft_size / 2;
+        memset(power_spectrum, 0, engine.power_bytes);
 
 //------------------------------------------------------------------------------
 //	Perform sliding window FFT averaging
@@ -447,42 +1787,24 @@ int main(int argc, char *argv[])
 //	Seek to the start position for this window
 //------------------------------------------------------------------------------
             sf_count_t window_start_frame = start_frame + (window * hop_size);
-            sf_seek(infile, window_start_frame, SEEK_SET);
+            sf_count_t frames_read;
 
+            if (map) {
 //------------------------------------------------------------------------------
-//	Read audio data (if stereo, convert to mono by averaging channels)
+//	Memory-mapped: convert the window straight from the mapping
 //------------------------------------------------------------------------------
-            sf_count_t frames_read;
-            if (sfinfo.channels == 1) {
-                frames_read = sf_read_double(infile, audio_buffer, fft_size);
+                frames_read = (sf_count_t)ab_wavmap_read_mono(map, (size_t)window_start_frame, audio_buffer, fft_size);
+            } else if (stream_mode) {
+//------------------------------------------------------------------------------
+//	Streaming mode: take the window from the ring (already mono)
+//------------------------------------------------------------------------------
+                frames_read = stream_read_window(&stream, window_start_frame, audio_buffer, fft_size);
             } else {
 //------------------------------------------------------------------------------
-//	Read interleaved multi-channel data and average to mono
-//------------------------------------------------------------------------------
-                double *temp_buffer = (double *)malloc(fft_size * sfinfo.channels * sizeof(double));
-                if (!temp_buffer) {
-                    fprintf(stderr, "Error: Memory allocation failed\n");
-                    free(audio_buffer);
-                    fftw_free(fft_output);
-                    free(power_spectrum);
-                    fftw_destroy_plan(plan);
-                    sf_close(infile);
-                    if (outfile != stdout) {
-                        fclose(outfile);
-                    }
-                    return 1;
-                }
-
-                frames_read = sf_read_double(infile, temp_buffer, fft_size * sfinfo.channels) / sfinfo.channels;
-
-                for (int i = 0; i < frames_read; i++) {
-                    audio_buffer[i] = 0.0;
-                    for (int ch = 0; ch < sfinfo.channels; ch++) {
-                        audio_buffer[i] += temp_buffer[i * sfinfo.channels + ch];
-                    }
-                    audio_buffer[i] /= sfinfo.channels;
-                }
-                free(temp_buffer);
+//	Read audio data (if stereo, convert to mono by averaging channels)
+//------------------------------------------------------------------------------
+                sf_seek(infile, window_start_frame, SEEK_SET);
+                frames_read = ab_read_mono(infile, sfinfo.channels, audio_buffer, fft_size);
             }
 
 //------------------------------------------------------------------------------
@@ -493,54 +1815,35 @@ int main(int argc, char *argv[])
             }
 
 //------------------------------------------------------------------------------
-//	Apply window function
-//------------------------------------------------------------------------------
-            apply_hann_window(audio_buffer, fft_size);
-
-//------------------------------------------------------------------------------
-//	Execute FFT
+//	Apply window, execute FFT and accumulate power spectrum (magnitude squared)
 //------------------------------------------------------------------------------
-            fftw_execute(plan);
+            fft_accumulate(&engine, &scratch, audio_buffer, power_spectrum);
+        }
 
 //------------------------------------------------------------------------------
-//	Accumulate power spectrum (magnitude squared)
+//	Add this snapshot to the matrix outputs
 //------------------------------------------------------------------------------
-            for (int i = 0; i < fft_size / 2 + 1; i++) {
-                double real = fft_output[i][0];
-                double imag = fft_output[i][1];
-                double magnitude = sqrt(real * real + imag * imag);
-                power_spectrum[i] += magnitude * magnitude;
+        if (matrix_out) {
+            if (matrix_add(&matrix, &engine, power_spectrum, windows_to_average, time_ms, epsilon) != 0) {
+                if (outfile && outfile != stdout) {
+                    fclose(outfile);
+                }
+                status = 1;
+                break;
             }
         }
 
 //------------------------------------------------------------------------------
 //	Write averaged magnitude spectrum for this snapshot
 //------------------------------------------------------------------------------
-        fprintf(outfile, "\"Frequency (Hz)\",\"Magnitude (dBFS)\"\n");
-
-        for (int i = 0; i < fft_size / 2 + 1; i++) {
-//------------------------------------------------------------------------------
-//	Average the power spectrum
-//------------------------------------------------------------------------------
-            double avg_power = power_spectrum[i] / windows_to_average;
-//------------------------------------------------------------------------------
-//	Convert back to magnitude
-//------------------------------------------------------------------------------
-            double magnitude = sqrt(avg_power);
-//------------------------------------------------------------------------------
-//	Normalize for FFT size and Hann window (coherent gain = 0.5)
-//	Division by (fft_size / 4.0) = (fft_size / 2.0) / 0.5
-//------------------------------------------------------------------------------
-            double magnitude_db = 20.0 * log10(magnitude / (fft_size / 4.0) + epsilon);
-            double frequency = i * freq_resolution;
-
-            fprintf(outfile, "%10.2f,%10.2f\n", frequency, magnitude_db);
+        if (outfile) {
+            write_spectrum(outfile, &engine, power_spectrum, windows_to_average, freq_resolution, epsilon);
         }
 
 //------------------------------------------------------------------------------
 //	Close output file for this snapshot (if not stdout)
 //------------------------------------------------------------------------------
-        if (outfile != stdout) {
+        if (outfile && outfile != stdout) {
             fclose(outfile);
         }
     }
@@ -548,16 +1851,24 @@ int main(int argc, char *argv[])
 //------------------------------------------------------------------------------
 //	Cleanup
 //------------------------------------------------------------------------------
-    if (!quiet && interval_ms > 0) {
+    if (matrix_out && matrix_close(&matrix, &engine, epsilon) != 0) {
+        status = 1;
+    }
+    if (!quiet && interval_ms > 0 && status == 0) {
         fprintf(stderr, "Completed %d snapshots\n", num_snapshots);
     }
 
+    if (stream_mode) {
+        stream_free(&stream);
+    }
     free(snapshot_times_ms);
     free(power_spectrum);
-    fftw_destroy_plan(plan);
-    fftw_free(fft_output);
-    free(audio_buffer);
+    fft_scratch_free(&scratch);
+    fft_engine_free(&engine);
+    ab_window_cache_free();
+    fftw_free(audio_buffer);
+    ab_wavmap_close(&wavmap);
     sf_close(infile);
 
-    return 0;																//	Exit: status 0 (no error)
+    return status;															//	Exit: 0 = no error
 }
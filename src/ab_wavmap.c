@@ -0,0 +1,507 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_wavmap.c
+//
+//	Memory-mapped PCM WAV / RF64 reader; see ab_wavmap.h. WAV data is
+//	little-endian, like every host the tools are built for, and samples
+//	are loaded with memcpy() because chunk alignment only guarantees an
+//	even offset.
+//------------------------------------------------------------------------------
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "ab_wavmap.h"
+#include "ab_core.h"
+
+#define CONVERT_BLOCK_SAMPLES	8192									//	Stack block used by ab_wavmap_read_mono()
+#define WAVE_FORMAT_PCM			0x0001
+#define WAVE_FORMAT_IEEE_FLOAT	0x0003
+#define WAVE_FORMAT_EXTENSIBLE	0xFFFE
+#define RF64_SIZE_IN_DS64		0xFFFFFFFFu								//	32-bit size field deferring to ds64
+
+//------------------------------------------------------------------------------
+//	Little-endian header fields
+//------------------------------------------------------------------------------
+static uint16_t get_le16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_le64(const unsigned char *p)
+{
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		map_file
+//
+//	Returns:	0 on success, -1 if the file cannot be opened or mapped
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Maps the whole file read-only and shared; the file handle is closed
+//	  straight away, the mapping keeps the file open
+//	- Files too small to hold a RIFF header are rejected here
+//------------------------------------------------------------------------------
+static int map_file(const char *filename, AbWavMap *map)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < 12 || (unsigned long long)size.QuadPart > SIZE_MAX) {
+        CloseHandle(file);
+        return -1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return -1;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    map->base = view;
+    map->length = (size_t)size.QuadPart;
+    map->handle = mapping;
+    return 0;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12 || (unsigned long long)st.st_size > SIZE_MAX) {
+        close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+
+    map->base = base;
+    map->length = (size_t)st.st_size;
+    map->handle = NULL;
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//	Name:		parse_wav
+//
+//	Returns:	0 if the mapping is a PCM or float WAV / RF64 file, -1 otherwise
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Walks the chunk list up to the data chunk; RF64 / BW64 take the data
+//	  size from the ds64 chunk
+//	- WAVE_FORMAT_EXTENSIBLE is accepted when its sub-format is PCM or
+//	  float and the samples fill their container: wValidBitsPerSample must
+//	  equal the container size (0, unspecified, is taken as full), so
+//	  24-in-32 padding is rejected
+//	- A data chunk running past the end of the file (a capture that is
+//	  still being written) is clamped to the whole frames present
+//------------------------------------------------------------------------------
+static int parse_wav(AbWavMap *map)
+{
+    const unsigned char *file = (const unsigned char *)map->base;
+    size_t length = map->length;
+    int rf64;
+
+    if (memcmp(file, "RIFF", 4) == 0) {
+        rf64 = 0;
+    } else if (memcmp(file, "RF64", 4) == 0 || memcmp(file, "BW64", 4) == 0) {
+        rf64 = 1;
+    } else {
+        return -1;
+    }
+    if (memcmp(file + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+
+    uint64_t ds64_data_size = 0;
+    int have_fmt = 0;
+    int extensible = 0;
+    int format_tag = 0;
+    int block_align = 0;
+    int bits = 0;
+    size_t pos = 12;
+
+    while (pos + 8 <= length) {
+        const unsigned char *chunk = file + pos;
+        const unsigned char *body = chunk + 8;
+        uint64_t size = get_le32(chunk + 4);
+        size_t available = length - pos - 8;
+
+        if (memcmp(chunk, "ds64", 4) == 0 && size >= 16 && available >= 16) {
+            ds64_data_size = get_le64(body + 8);
+        } else if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && available >= 16) {
+            format_tag = get_le16(body);
+            map->channels = get_le16(body + 2);
+            map->sample_rate = (int)get_le32(body + 4);
+            block_align = get_le16(body + 12);
+            bits = get_le16(body + 14);
+            if (format_tag == WAVE_FORMAT_EXTENSIBLE) {
+                if (size < 40 || available < 40) {
+                    return -1;
+                }
+                int valid_bits = get_le16(body + 18);							//	wValidBitsPerSample
+                if (valid_bits != 0 && valid_bits != get_le16(body + 14)) {
+                    return -1;													//	e.g. 24-in-32: leave it to libsndfile
+                }
+                format_tag = get_le16(body + 24);								//	First two bytes of the sub-format GUID
+                extensible = 1;
+            }
+            have_fmt = 1;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) {
+                return -1;
+            }
+            if (rf64 && size == RF64_SIZE_IN_DS64) {
+                size = ds64_data_size;
+            }
+            if (size > available) {
+                size = available;
+            }
+            map->data = body;
+            map->frames = (block_align > 0) ? (size_t)(size / (uint64_t)block_align) : 0;
+            break;
+        }
+
+        if (size > length) {
+            return -1;															//	Corrupt size: no data chunk follows
+        }
+        pos += 8 + (size_t)size + (size_t)(size & 1);
+    }
+    if (!map->data) {
+        return -1;
+    }
+
+//------------------------------------------------------------------------------
+//	Map the fmt chunk onto a libsndfile subtype
+//------------------------------------------------------------------------------
+    int subtype = 0;
+    if (format_tag == WAVE_FORMAT_PCM) {
+        switch (bits) {
+        case 8:
+            subtype = SF_FORMAT_PCM_U8;											//	8-bit WAV is unsigned
+            break;
+        case 16:
+            subtype = SF_FORMAT_PCM_16;
+            break;
+        case 24:
+            subtype = SF_FORMAT_PCM_24;
+            break;
+        case 32:
+            subtype = SF_FORMAT_PCM_32;
+            break;
+        }
+    } else if (format_tag == WAVE_FORMAT_IEEE_FLOAT) {
+        if (bits == 32) {
+            subtype = SF_FORMAT_FLOAT;
+        } else if (bits == 64) {
+            subtype = SF_FORMAT_DOUBLE;
+        }
+    }
+    if (subtype == 0 || map->channels < 1 || map->sample_rate <= 0 ||
+        block_align != map->channels * (bits / 8)) {
+        return -1;
+    }
+
+    int container = rf64 ? SF_FORMAT_RF64 : (extensible ? SF_FORMAT_WAVEX : SF_FORMAT_WAV);
+    map->format = container | subtype;
+    map->bytes_per_sample = bits / 8;
+    map->frame_bytes = (size_t)block_align;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_wavmap_open
+//
+//	Returns:	0 on success, -1 if the file cannot be mapped or is not a
+//				PCM / float WAV or RF64 file (nothing is printed; the caller
+//				falls back to libsndfile)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- map is zeroed on failure, so ab_wavmap_close() is always safe
+//------------------------------------------------------------------------------
+int ab_wavmap_open(const char *filename, AbWavMap *map)
+{
+    memset(map, 0, sizeof(*map));
+
+    if (map_file(filename, map) != 0) {
+        memset(map, 0, sizeof(*map));
+        return -1;
+    }
+    if (parse_wav(map) != 0) {
+        ab_wavmap_close(map);
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_wavmap_close
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+void ab_wavmap_close(AbWavMap *map)
+{
+    if (map->base) {
+#ifdef _WIN32
+        UnmapViewOfFile(map->base);
+        CloseHandle((HANDLE)map->handle);
+#else
+        munmap(map->base, map->length);
+#endif
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		clamp_frames
+//
+//	Returns:	number of frames of [start, start + frames) inside the file
+//
+//------------------------------------------------------------------------------
+static size_t clamp_frames(const AbWavMap *map, size_t start, size_t frames)
+{
+    if (start >= map->frames) {
+        return 0;
+    }
+    return (frames < map->frames - start) ? frames : map->frames - start;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		convert_double
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Converts 'count' interleaved samples from the mapping to double with
+//	  libsndfile's scale factors (all powers of two, so the results match
+//	  sf_readf_double() bit for bit)
+//------------------------------------------------------------------------------
+static void convert_double(int subtype, const unsigned char *src, double *dst, size_t count)
+{
+    switch (subtype) {
+    case SF_FORMAT_PCM_U8:
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = ((int)src[i] - 128) / 128.0;
+        }
+        break;
+    case SF_FORMAT_PCM_16:
+        for (size_t i = 0; i < count; i++) {
+            int16_t s16;
+            memcpy(&s16, src + i * 2, sizeof(s16));
+            dst[i] = s16 / 32768.0;												//	2^15
+        }
+        break;
+    case SF_FORMAT_PCM_24:
+        for (size_t i = 0; i < count; i++) {
+            int32_t s32 = (int32_t)(((uint32_t)src[i*3] << 8) | ((uint32_t)src[i*3+1] << 16) |
+                                    ((uint32_t)src[i*3+2] << 24));
+            dst[i] = (s32 >> 8) / 8388608.0;									//	2^23
+        }
+        break;
+    case SF_FORMAT_PCM_32:
+        for (size_t i = 0; i < count; i++) {
+            int32_t s32;
+            memcpy(&s32, src + i * 4, sizeof(s32));
+            dst[i] = s32 / 2147483648.0;										//	2^31
+        }
+        break;
+    case SF_FORMAT_FLOAT:
+        for (size_t i = 0; i < count; i++) {
+            float f;
+            memcpy(&f, src + i * 4, sizeof(f));
+            dst[i] = f;
+        }
+        break;
+    case SF_FORMAT_DOUBLE:
+        memcpy(dst, src, count * sizeof(double));
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		convert_float
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Single-precision counterpart of convert_double()
+//------------------------------------------------------------------------------
+static void convert_float(int subtype, const unsigned char *src, float *dst, size_t count)
+{
+    switch (subtype) {
+    case SF_FORMAT_PCM_U8:
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = ((int)src[i] - 128) / 128.0f;
+        }
+        break;
+    case SF_FORMAT_PCM_16:
+        for (size_t i = 0; i < count; i++) {
+            int16_t s16;
+            memcpy(&s16, src + i * 2, sizeof(s16));
+            dst[i] = s16 / 32768.0f;
+        }
+        break;
+    case SF_FORMAT_PCM_24:
+        for (size_t i = 0; i < count; i++) {
+            int32_t s32 = (int32_t)(((uint32_t)src[i*3] << 8) | ((uint32_t)src[i*3+1] << 16) |
+                                    ((uint32_t)src[i*3+2] << 24));
+            dst[i] = (s32 >> 8) / 8388608.0f;
+        }
+        break;
+    case SF_FORMAT_PCM_32:
+        for (size_t i = 0; i < count; i++) {
+            int32_t s32;
+            memcpy(&s32, src + i * 4, sizeof(s32));
+            dst[i] = s32 / 2147483648.0f;
+        }
+        break;
+    case SF_FORMAT_FLOAT:
+        memcpy(dst, src, count * sizeof(float));
+        break;
+    case SF_FORMAT_DOUBLE:
+        for (size_t i = 0; i < count; i++) {
+            double d;
+            memcpy(&d, src + i * 8, sizeof(d));
+            dst[i] = (float)d;
+        }
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_wavmap_read_double
+//
+//	Returns:	number of frames converted into dst
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Converts frames [start, start + frames) to interleaved doubles
+//	- Reads never move a file position, so one map can serve any number
+//	  of threads at once
+//------------------------------------------------------------------------------
+size_t ab_wavmap_read_double(const AbWavMap *map, size_t start, double *dst, size_t frames)
+{
+    size_t count = clamp_frames(map, start, frames);
+    convert_double(map->format & SF_FORMAT_SUBMASK, map->data + start * map->frame_bytes,
+                   dst, count * map->channels);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_wavmap_read_float
+//
+//	Returns:	number of frames converted into dst
+//
+//------------------------------------------------------------------------------
+size_t ab_wavmap_read_float(const AbWavMap *map, size_t start, float *dst, size_t frames)
+{
+    size_t count = clamp_frames(map, start, frames);
+    convert_float(map->format & SF_FORMAT_SUBMASK, map->data + start * map->frame_bytes,
+                  dst, count * map->channels);
+    return count;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_wavmap_read_mono
+//
+//	Returns:	number of frames converted into dst
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Mono counterpart of ab_read_mono(): mono files convert straight into
+//	  dst, multi-channel files go through a stack block and
+//	  ab_downmix_mono(), so the result matches ab_read_mono() exactly
+//------------------------------------------------------------------------------
+size_t ab_wavmap_read_mono(const AbWavMap *map, size_t start, double *dst, size_t frames)
+{
+    size_t count = clamp_frames(map, start, frames);
+    int subtype = map->format & SF_FORMAT_SUBMASK;
+
+    if (map->channels == 1) {
+        convert_double(subtype, map->data + start * map->frame_bytes, dst, count);
+        return count;
+    }
+
+    double block[CONVERT_BLOCK_SAMPLES];
+    size_t block_frames = CONVERT_BLOCK_SAMPLES / (size_t)map->channels;
+    size_t done = 0;
+
+    if (block_frames < 1) {
+        return 0;																//	More channels than the block holds
+    }
+
+    while (done < count) {
+        size_t want = count - done;
+        if (want > block_frames) {
+            want = block_frames;
+        }
+        convert_double(subtype, map->data + (start + done) * map->frame_bytes,
+                       block, want * map->channels);
+        ab_downmix_mono(block, want, map->channels, dst + done);
+        done += want;
+    }
+    return done;
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_wavmap.h
+//
+//	libaudiobench: read-only memory-mapped access to PCM WAV and RF64 files,
+//	for analysis that jumps around a long capture (snapshots at arbitrary
+//	times, overlapping windows):
+//	- The header is parsed once; a seek is then pointer arithmetic on the
+//	  mapped data chunk instead of an sf_seek() and a decode into a buffer
+//	- Frames are converted straight from the mapping by a kernel for the
+//	  file's sample format (8/16/24/32-bit PCM, 32/64-bit float)
+//	- The mapping is shared and read-only, so concurrent analysis processes
+//	  over the same capture share one copy in the page cache
+//
+//	Samples use libsndfile's normalisation (integer PCM divided by 2^(bits-1),
+//	float as stored), so results match sf_readf_double() exactly. Files the
+//	mapper does not understand (compressed, big-endian, padded containers)
+//	make ab_wavmap_open() fail and the caller keeps using libsndfile.
+//------------------------------------------------------------------------------
+#ifndef AB_WAVMAP_H
+#define AB_WAVMAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//------------------------------------------------------------------------------
+//	Mapped file (caller-owned, filled by ab_wavmap_open)
+//------------------------------------------------------------------------------
+typedef struct {
+    const unsigned char *data;									//	First byte of the first frame
+    size_t frames;
+    int channels;
+    int sample_rate;
+    int format;													//	libsndfile format (container | subtype)
+    int bytes_per_sample;
+    size_t frame_bytes;											//	bytes_per_sample * channels
+    void *base;													//	Whole-file mapping
+    size_t length;												//	Mapped bytes
+    void *handle;												//	Mapping object (Windows only)
+} AbWavMap;
+
+int ab_wavmap_open(const char *filename, AbWavMap *map);
+void ab_wavmap_close(AbWavMap *map);
+
+size_t ab_wavmap_read_double(const AbWavMap *map, size_t start, double *dst, size_t frames);
+size_t ab_wavmap_read_float(const AbWavMap *map, size_t start, float *dst, size_t frames);
+size_t ab_wavmap_read_mono(const AbWavMap *map, size_t start, double *dst, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,371 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_window.h
+//
+//	FFT window tables shared by the analysis tools (C and C++):
+//	- Hann, 4-term Blackman-Harris (-92 dB), 5-term flat-top and Kaiser
+//	- Coefficients are computed once per (window, size) and cached, in double
+//	  and float, so the hot loops only multiply (see ab_simd.h)
+//	- Each table carries its coherent gain and noise gain
+//
+//	Gains:
+//	- coherent_gain = mean(w): a sine of amplitude A peaks at A * N/2 * cg,
+//	  so amplitude spectra are scaled by ab_window_amplitude_scale()
+//	- noise_gain = mean(w^2): broadband noise per bin is raised by the
+//	  equivalent noise bandwidth ENBW = noise_gain / cg^2 (in bins)
+//	- Cosine-sum windows use their nominal values (a0 and a0^2 + sum(ak^2)/2);
+//	  Kaiser gains are measured from the table
+//
+//	Typical use:
+//		const AbWindow *win = ab_window_get(AB_WINDOW_HANN, n, 0.0);
+//		ab_window_apply(win, buffer);
+//		amplitude = magnitude * ab_window_amplitude_scale(win);
+//		...
+//		ab_window_cache_free();
+//
+//	The cache is not locked: fetch tables before starting worker threads,
+//	after which the returned tables are read-only and can be shared.
+//------------------------------------------------------------------------------
+#ifndef AB_WINDOW_H
+#define AB_WINDOW_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_simd.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define AB_WINDOW_HANN				0
+#define AB_WINDOW_BLACKMAN_HARRIS	1
+#define AB_WINDOW_FLATTOP			2
+#define AB_WINDOW_KAISER			3
+
+#define AB_WINDOW_KAISER_BETA		9.0										//	Default Kaiser beta
+#define AB_WINDOW_CACHE_SLOTS		8
+
+typedef struct {
+    int type;
+    int size;
+    double beta;															//	Kaiser shape parameter
+    double *coeffs;
+    float *coeffs_f;
+    double coherent_gain;													//	mean(w)
+    double noise_gain;														//	mean(w^2)
+} AbWindow;
+
+static AbWindow ab_window_cache[AB_WINDOW_CACHE_SLOTS];
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_parse
+//
+//	Returns:	0 on success, -1 if the name is not recognised
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Accepts "hann", "blackman-harris" (or "bh"), "flattop" (or "flat-top")
+//	  and "kaiser" with an optional shape parameter, e.g. "kaiser:12"
+//	- NULL selects Hann (the historical default)
+//------------------------------------------------------------------------------
+static inline int ab_window_parse(const char *name, int *type, double *beta)
+{
+    *beta = AB_WINDOW_KAISER_BETA;
+
+    if (!name || strcmp(name, "hann") == 0) {
+        *type = AB_WINDOW_HANN;
+    } else if (strcmp(name, "blackman-harris") == 0 || strcmp(name, "bh") == 0) {
+        *type = AB_WINDOW_BLACKMAN_HARRIS;
+    } else if (strcmp(name, "flattop") == 0 || strcmp(name, "flat-top") == 0) {
+        *type = AB_WINDOW_FLATTOP;
+    } else if (strncmp(name, "kaiser", 6) == 0 && (name[6] == '\0' || name[6] == ':')) {
+        *type = AB_WINDOW_KAISER;
+        if (name[6] == ':') {
+            char *end;
+            *beta = strtod(name + 7, &end);
+            if (end == name + 7 || *end != '\0' || *beta < 0.0) {
+                return -1;
+            }
+        }
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_name
+//
+//	Returns:	printable name of a window type
+//
+//------------------------------------------------------------------------------
+static inline const char *ab_window_name(int type)
+{
+    switch (type) {
+    case AB_WINDOW_BLACKMAN_HARRIS:	return "blackman-harris";
+    case AB_WINDOW_FLATTOP:			return "flattop";
+    case AB_WINDOW_KAISER:			return "kaiser";
+    default:						return "hann";
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_bessel_i0
+//
+//	Returns:	modified Bessel function of the first kind, order 0
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Power series sum((x/2)^2k / (k!)^2), run until terms stop contributing;
+//	  converges quickly for the beta range used by Kaiser windows
+//------------------------------------------------------------------------------
+static inline double ab_window_bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double half_sq = x * x / 4.0;
+
+    for (int k = 1; k < 500; k++) {
+        term *= half_sq / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_fill
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Writes the symmetric window (period N - 1) into win->coeffs and sets
+//	  the gains
+//	- The Hann expression is the one the tools have always used, so Hann
+//	  results are unchanged bit for bit
+//------------------------------------------------------------------------------
+static inline void ab_window_fill(AbWindow *win)
+{
+    static const double bh[4] = { 0.35875, 0.48829, 0.14128, 0.01168 };
+    static const double ft[5] = { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 };
+    const double *a = NULL;
+    int terms = 0;
+    int n = win->size;
+    double denom = (n > 1) ? (double)(n - 1) : 1.0;
+
+    switch (win->type) {
+    case AB_WINDOW_HANN:
+        for (int i = 0; i < n; i++) {
+            win->coeffs[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / denom));
+        }
+        win->coherent_gain = 0.5;
+        win->noise_gain = 0.375;
+        return;
+
+    case AB_WINDOW_KAISER: {
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        double i0_beta = ab_window_bessel_i0(win->beta);
+        for (int i = 0; i < n; i++) {
+            double r = 2.0 * i / denom - 1.0;
+            double w = ab_window_bessel_i0(win->beta * sqrt(fmax(0.0, 1.0 - r * r))) / i0_beta;
+            win->coeffs[i] = w;
+            sum += w;
+            sum_sq += w * w;
+        }
+        win->coherent_gain = sum / n;
+        win->noise_gain = sum_sq / n;
+        return;
+    }
+
+    case AB_WINDOW_BLACKMAN_HARRIS:
+        a = bh;
+        terms = 4;
+        break;
+
+    default:
+        a = ft;
+        terms = 5;
+        break;
+    }
+
+//------------------------------------------------------------------------------
+//	Cosine-sum windows: w = a0 - a1 cos(x) + a2 cos(2x) - ...
+//------------------------------------------------------------------------------
+    double noise_gain = a[0] * a[0];
+    for (int k = 1; k < terms; k++) {
+        noise_gain += a[k] * a[k] / 2.0;
+    }
+    for (int i = 0; i < n; i++) {
+        double x = 2.0 * M_PI * i / denom;
+        double w = a[0];
+        for (int k = 1; k < terms; k++) {
+            w += ((k & 1) ? -a[k] : a[k]) * cos(k * x);
+        }
+        win->coeffs[i] = w;
+    }
+    win->coherent_gain = a[0];
+    win->noise_gain = noise_gain;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_get
+//
+//	Returns:	cached window table, NULL on allocation failure or full cache
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Returns the existing table for (type, size, beta) or computes a new one
+//	- beta is only used by Kaiser windows
+//------------------------------------------------------------------------------
+static inline const AbWindow *ab_window_get(int type, int size, double beta)
+{
+    if (size <= 0) {
+        return NULL;
+    }
+    if (type != AB_WINDOW_KAISER) {
+        beta = 0.0;
+    }
+
+    for (int i = 0; i < AB_WINDOW_CACHE_SLOTS; i++) {
+        AbWindow *win = &ab_window_cache[i];
+        if (win->coeffs && win->type == type && win->size == size && win->beta == beta) {
+            return win;
+        }
+    }
+
+    for (int i = 0; i < AB_WINDOW_CACHE_SLOTS; i++) {
+        AbWindow *win = &ab_window_cache[i];
+        if (win->coeffs) {
+            continue;
+        }
+
+        win->coeffs = (double *)malloc(size * sizeof(double));
+        win->coeffs_f = (float *)malloc(size * sizeof(float));
+        if (!win->coeffs || !win->coeffs_f) {
+            free(win->coeffs);
+            free(win->coeffs_f);
+            memset(win, 0, sizeof(*win));
+            return NULL;
+        }
+        win->type = type;
+        win->size = size;
+        win->beta = beta;
+        ab_window_fill(win);
+        for (int j = 0; j < size; j++) {
+            win->coeffs_f[j] = (float)win->coeffs[j];
+        }
+        return win;
+    }
+
+    fprintf(stderr, "Warning: Window cache full (%d tables)\n", AB_WINDOW_CACHE_SLOTS);
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_cache_free
+//
+//	Returns:	none (invalidates every table returned by ab_window_get)
+//
+//------------------------------------------------------------------------------
+static inline void ab_window_cache_free(void)
+{
+    for (int i = 0; i < AB_WINDOW_CACHE_SLOTS; i++) {
+        free(ab_window_cache[i].coeffs);
+        free(ab_window_cache[i].coeffs_f);
+        memset(&ab_window_cache[i], 0, sizeof(ab_window_cache[i]));
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_apply
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Multiplies win->size samples of data by the window in place
+//------------------------------------------------------------------------------
+static inline void ab_window_apply(const AbWindow *win, double *data)
+{
+    ab_simd_window_d(data, data, win->coeffs, win->size);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_amplitude_scale
+//
+//	Returns:	factor converting |FFT| of a windowed sine to its amplitude
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- 1 / (N/2 * coherent_gain); for Hann this is the familiar 4/N
+//------------------------------------------------------------------------------
+static inline double ab_window_amplitude_scale(const AbWindow *win)
+{
+    return 1.0 / (win->size / 2.0 * win->coherent_gain);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_enbw
+//
+//	Returns:	equivalent noise bandwidth in bins
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- noise_gain / coherent_gain^2; subtract 10*log10(ENBW) from a noise
+//	  floor read off an amplitude-scaled spectrum to get level per bin width
+//------------------------------------------------------------------------------
+static inline double ab_window_enbw(const AbWindow *win)
+{
+    return win->noise_gain / (win->coherent_gain * win->coherent_gain);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		ab_window_mainlobe_bins
+//
+//	Returns:	main-lobe half-width in bins (first null of the window kernel)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Hann 2, Blackman-Harris 4, flat-top 5, Kaiser sqrt(1 + (beta/pi)^2)
+//	- Used to decide which bins around a tone belong to the tone itself
+//------------------------------------------------------------------------------
+static inline int ab_window_mainlobe_bins(const AbWindow *win)
+{
+    switch (win->type) {
+    case AB_WINDOW_HANN:			return 2;
+    case AB_WINDOW_BLACKMAN_HARRIS:	return 4;
+    case AB_WINDOW_FLATTOP:			return 5;
+    default:						return (int)ceil(sqrt(1.0 + (win->beta / M_PI) * (win->beta / M_PI)));
+    }
+}
+
+#endif
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	ab_test.h
+//
+//	Check macros shared by the libaudiobench tests in tests/. Each test is a
+//	stand-alone program: failed checks are reported on stderr with their
+//	file and line, and the exit status is non-zero if any check failed.
+//	`make test` runs every program with the scratch directory as argv[1].
+//
+//	Typical use:
+//		AB_CHECK(got == want, "frame %zu: got %g, want %g", i, got, want);
+//		...
+//		return ab_test_report("test_ring");
+//------------------------------------------------------------------------------
+#ifndef AB_TEST_H
+#define AB_TEST_H
+
+#include <stdio.h>
+
+static int ab_test_checks = 0;
+static int ab_test_failures = 0;
+
+//------------------------------------------------------------------------------
+//	Counts a check; on failure prints the condition and a printf-style
+//	description (at least a format string is required)
+//------------------------------------------------------------------------------
+#define AB_CHECK(cond, ...)													\
+    do {																	\
+        ab_test_checks++;													\
+        if (!(cond)) {														\
+            ab_test_failures++;												\
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond);	\
+            fprintf(stderr, __VA_ARGS__);									\
+            fputc('\n', stderr);											\
+        }																	\
+    } while (0)
+
+//------------------------------------------------------------------------------
+//	Name:		ab_test_report
+//
+//	Returns:	exit status for main(): 0 if every check passed, 1 otherwise
+//
+//------------------------------------------------------------------------------
+static inline int ab_test_report(const char *name)
+{
+    printf("%-20s %d checks, %d failed\n", name, ab_test_checks, ab_test_failures);
+    return ab_test_failures ? 1 : 0;
+}
+
+#endif
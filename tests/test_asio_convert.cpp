@@ -0,0 +1,281 @@
+//------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2025 Anthony Verbeck
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//------------------------------------------------------------------------------
+
+/*
+ * test_asio_convert.cpp
+ * Round trip and reference tests for the ASIO sample kernels
+ * (asio/ab_asio_convert.h), built and run by `make -C asio test`
+ *
+ * For every sample type the kernels support, in both byte orders:
+ * - float -> driver format -> float stays within the format's step of the
+ *   clipped input (two steps: the 2^(bits-1) - 1 scale truncates)
+ * - The driver bytes decode, through a byte-at-a-time reference, to
+ *   exactly what the input kernel returns
+ * - Non-dithered Int16/24/32 LSB output is byte-identical to the WAV
+ *   kernels in src/ab_core.c
+ * - TPDF dither leaves a DC input unbiased (against the 2^(bits-1) - 1
+ *   scale) and within two steps
+ * The buffer length is odd, so the SSE2 loops and the scalar tails both run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_asio_convert.h"
+#include "ab_core.h"
+#include "ab_test.h"
+
+#define TEST_SAMPLES    37          // 4 * 8 + 5: vector body and scalar tail
+#define DITHER_PASSES   2000        // Buffers averaged for the dither bias
+
+struct TypeInfo {
+    ASIOSampleType type;
+    const char* name;
+    int bytes;                      // Container size
+    int bits;                       // Significant bits (right justified)
+    bool msb;
+    bool isFloat;
+};
+
+static const TypeInfo types[] = {
+    { ASIOSTInt16LSB,   "Int16LSB",   2, 16, false, false },
+    { ASIOSTInt16MSB,   "Int16MSB",   2, 16, true,  false },
+    { ASIOSTInt24LSB,   "Int24LSB",   3, 24, false, false },
+    { ASIOSTInt24MSB,   "Int24MSB",   3, 24, true,  false },
+    { ASIOSTInt32LSB,   "Int32LSB",   4, 32, false, false },
+    { ASIOSTInt32MSB,   "Int32MSB",   4, 32, true,  false },
+    { ASIOSTInt32LSB16, "Int32LSB16", 4, 16, false, false },
+    { ASIOSTInt32MSB16, "Int32MSB16", 4, 16, true,  false },
+    { ASIOSTInt32LSB18, "Int32LSB18", 4, 18, false, false },
+    { ASIOSTInt32MSB18, "Int32MSB18", 4, 18, true,  false },
+    { ASIOSTInt32LSB20, "Int32LSB20", 4, 20, false, false },
+    { ASIOSTInt32MSB20, "Int32MSB20", 4, 20, true,  false },
+    { ASIOSTInt32LSB24, "Int32LSB24", 4, 24, false, false },
+    { ASIOSTInt32MSB24, "Int32MSB24", 4, 24, true,  false },
+    { ASIOSTFloat32LSB, "Float32LSB", 4, 32, false, true  },
+    { ASIOSTFloat32MSB, "Float32MSB", 4, 32, true,  true  },
+    { ASIOSTFloat64LSB, "Float64LSB", 8, 64, false, true  },
+    { ASIOSTFloat64MSB, "Float64MSB", 8, 64, true,  true  },
+};
+
+//------------------------------------------------------------------------------
+//  Name:       referenceDecode
+//
+//  Returns:    the sample at p, assembled one byte at a time
+//
+//------------------------------------------------------------------------------
+static double referenceDecode(const uint8_t* p, const TypeInfo& t)
+{
+    uint64_t v = 0;
+    for (int b = 0; b < t.bytes; b++) {
+        v |= (uint64_t)p[t.msb ? t.bytes - 1 - b : b] << (8 * b);
+    }
+    if (t.isFloat) {
+        if (t.bytes == 4) {
+            uint32_t u = (uint32_t)v;
+            float f;
+            memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+        double d;
+        memcpy(&d, &v, sizeof(d));
+        return d;
+    }
+    int64_t s = (int64_t)(v << (64 - t.bits)) >> (64 - t.bits);
+    return (double)s / (double)(1LL << (t.bits - 1));
+}
+
+//------------------------------------------------------------------------------
+//  Name:       testType
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+static void testType(const TypeInfo& t)
+{
+    float src[TEST_SAMPLES];
+    float back[TEST_SAMPLES];
+    uint8_t buffer[TEST_SAMPLES * 8];
+
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        src[i] = (float)(1.3 * sin(i * 0.7));                   // Some samples beyond full scale
+    }
+    src[0] = 1.0f;
+    src[1] = -1.0f;
+    src[2] = 0.0f;
+
+    AB_CHECK(ab_asio_sample_size(t.type) == (size_t)t.bytes, "%s: sample size %zu, want %d",
+             t.name, ab_asio_sample_size(t.type), t.bytes);
+    AB_CHECK(ab_asio_sample_type_supported(t.type), "%s: reported unsupported", t.name);
+
+    // Round trip, clipped
+    AbAsioFromFloatFn toDriver = ab_asio_output_converter(t.type, AB_ASIO_CLIP);
+    AbAsioToFloatFn fromDriver = ab_asio_input_converter(t.type);
+    toDriver(src, buffer, TEST_SAMPLES, nullptr);
+    fromDriver(buffer, back, TEST_SAMPLES);
+
+    double step = t.isFloat ? 0.0 : 1.0 / (double)(1LL << (t.bits - 1));
+    double roundTrip = 0.0;
+    double reference = 0.0;
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        double clipped = src[i] > 1.0f ? 1.0 : (src[i] < -1.0f ? -1.0 : src[i]);
+        roundTrip = fmax(roundTrip, fabs(back[i] - clipped));
+        reference = fmax(reference, fabs(back[i] - (float)referenceDecode(buffer + i * t.bytes, t)));
+    }
+    AB_CHECK(roundTrip <= 2.0 * step + 1e-7, "%s: round trip error %.3g, step %.3g", t.name, roundTrip, step);
+    AB_CHECK(reference == 0.0, "%s: input kernel differs from the byte-wise decode by %.3g", t.name, reference);
+
+    // The wrappers run the same kernels
+    uint8_t wrapped[TEST_SAMPLES * 8];
+    ab_asio_from_float(src, t.type, wrapped, TEST_SAMPLES);
+    AB_CHECK(memcmp(wrapped, buffer, TEST_SAMPLES * t.bytes) == 0, "%s: ab_asio_from_float differs", t.name);
+    float wrappedBack[TEST_SAMPLES];
+    ab_asio_to_float(buffer, t.type, wrappedBack, TEST_SAMPLES);
+    AB_CHECK(memcmp(wrappedBack, back, sizeof(back)) == 0, "%s: ab_asio_to_float differs", t.name);
+
+    // Float targets keep overs unless AB_ASIO_CLIP is given
+    if (t.isFloat) {
+        ab_asio_output_converter(t.type, 0)(src, buffer, TEST_SAMPLES, nullptr);
+        fromDriver(buffer, back, TEST_SAMPLES);
+        AB_CHECK(memcmp(back, src, sizeof(src)) == 0, "%s: unclipped float is not stored as is", t.name);
+    }
+
+    // Identical to the WAV writers for the little-endian containers
+    if (t.type == ASIOSTInt16LSB) {
+        int16_t wav[TEST_SAMPLES];
+        ab_float_to_int16(src, wav, TEST_SAMPLES);
+        AB_CHECK(memcmp(wav, buffer, sizeof(wav)) == 0, "%s: differs from ab_float_to_int16", t.name);
+    } else if (t.type == ASIOSTInt24LSB) {
+        uint8_t wav[TEST_SAMPLES * 3];
+        ab_float_to_int24(src, wav, TEST_SAMPLES);
+        AB_CHECK(memcmp(wav, buffer, sizeof(wav)) == 0, "%s: differs from ab_float_to_int24", t.name);
+    } else if (t.type == ASIOSTInt32LSB) {
+        int32_t wav[TEST_SAMPLES];
+        ab_float_to_int32(src, wav, TEST_SAMPLES);
+        AB_CHECK(memcmp(wav, buffer, sizeof(wav)) == 0, "%s: differs from ab_float_to_int32", t.name);
+    }
+
+    // Dither: a DC level between steps averages back to itself, as the
+    // quantizer scales it (in float, full scale at 2^(bits-1) - 1 steps)
+    if (!t.isFloat && t.bits <= 24) {
+        float scale = (float)((1LL << (t.bits - 1)) - 1);
+        float scaled = 0.3f * scale;
+        double target = (double)scaled * step;
+        // The dithered sum is rounded to float before lrintf(): at 24 bits
+        // that grid is 1/4 step here, which bounds the residual bias
+        double ulp = (double)(nextafterf(scaled, 2.0f * scaled) - scaled);
+        double tolerance = (0.05 + 0.5 * ulp) * step;
+        AbAsioDither dither;
+        ab_asio_dither_init(&dither, 7);
+        AbAsioFromFloatFn dithered = ab_asio_output_converter(t.type, AB_ASIO_DITHER);
+        float dc[TEST_SAMPLES];
+        for (int i = 0; i < TEST_SAMPLES; i++) {
+            dc[i] = 0.3f;
+        }
+
+        double mean = 0.0;
+        double worst = 0.0;
+        for (int pass = 0; pass < DITHER_PASSES; pass++) {
+            dithered(dc, buffer, TEST_SAMPLES, &dither);
+            fromDriver(buffer, back, TEST_SAMPLES);
+            for (int i = 0; i < TEST_SAMPLES; i++) {
+                mean += back[i] - target;
+                worst = fmax(worst, fabs(back[i] - dc[i]));
+            }
+        }
+        mean /= (double)DITHER_PASSES * TEST_SAMPLES;
+        AB_CHECK(fabs(mean) < tolerance, "%s: dither bias %.3g steps (limit %.3g)", t.name, mean / step,
+                 tolerance / step);
+        AB_CHECK(worst <= 2.0 * step, "%s: dithered error %.3g steps", t.name, worst / step);
+    }
+}
+
+//------------------------------------------------------------------------------
+//  Name:       testInterleave
+//
+//  Returns:    none
+//
+//------------------------------------------------------------------------------
+static void testInterleave()
+{
+    const int channels = 3;
+    float planes[channels][TEST_SAMPLES];
+    const float* src[channels];
+    float frames[channels * TEST_SAMPLES];
+
+    for (int ch = 0; ch < channels; ch++) {
+        for (int i = 0; i < TEST_SAMPLES; i++) {
+            planes[ch][i] = (float)(ch * 1000 + i);
+        }
+        src[ch] = planes[ch];
+    }
+    ab_asio_interleave(frames, src, channels, TEST_SAMPLES);
+
+    int bad = 0;
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            bad += frames[i * channels + ch] != planes[ch][i];
+        }
+    }
+    AB_CHECK(bad == 0, "%d interleaved samples out of place", bad);
+}
+
+int main()
+{
+    for (const TypeInfo& t : types) {
+        testType(t);
+    }
+    testInterleave();
+
+    // DSD and other non-PCM types: not supported, input converted as
+    // silence, no output kernel and ab_asio_from_float() leaves dst alone
+    AB_CHECK(!ab_asio_sample_type_supported(ASIOSTDSDInt8LSB1), "DSD reported supported");
+    AB_CHECK(ab_asio_output_converter(ASIOSTDSDInt8LSB1, AB_ASIO_CLIP) == nullptr,
+             "DSD has an output kernel");
+    float tone[TEST_SAMPLES];
+    uint8_t guard[TEST_SAMPLES * sizeof(float)];
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        tone[i] = 0.5f;
+    }
+    memset(guard, 0xA5, sizeof(guard));
+    ab_asio_from_float(tone, ASIOSTDSDInt8LSB1, guard, TEST_SAMPLES);
+    int touched = 0;
+    for (size_t i = 0; i < sizeof(guard); i++) {
+        touched += guard[i] != 0xA5;
+    }
+    AB_CHECK(touched == 0, "unsupported output wrote %d bytes", touched);
+
+    float silence[TEST_SAMPLES];
+    uint8_t raw[TEST_SAMPLES];
+    memset(raw, 0x55, sizeof(raw));
+    ab_asio_input_converter(ASIOSTDSDInt8LSB1)(raw, silence, TEST_SAMPLES);
+    int nonzero = 0;
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+        nonzero += silence[i] != 0.0f;
+    }
+    AB_CHECK(nonzero == 0, "unsupported input produced %d non-zero samples", nonzero);
+
+    return ab_test_report("test_asio_convert");
+}
@@ -0,0 +1,223 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	test_goertzel.c
+//
+//	Behaviour of the targeted-bin tone analyser (src/ab_goertzel.c) on
+//	synthetic sines with known levels:
+//	- Fixed frequencies: fundamental and harmonic amplitudes, the frame
+//	  AC power and the frame count, with the input fed in odd-sized chunks
+//	- Harmonics at or above Nyquist are reported as 0
+//	- Tracking: a tone off the nominal frequency is found, the tracker
+//	  locks, and the level is then read on the tone
+//	- A file shorter than one frame still yields one frame
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ab_goertzel.h"
+#include "ab_window.h"
+#include "ab_test.h"
+
+#define RATE					48000.0
+#define FRAME					8192
+#define CHUNK					1000									//	Not a divisor of FRAME
+
+typedef struct {
+    int frames;
+    int locked_frames;
+    double level[5];											//	Last locked frame
+    double freq[5];
+    double fundamental;
+    double ac_power;
+} Collected;
+
+//------------------------------------------------------------------------------
+//	Name:		collect
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void collect(const AbTone *tone, void *user)
+{
+    Collected *c = (Collected *)user;
+
+    c->frames++;
+    if (!tone->locked) {
+        return;
+    }
+    c->locked_frames++;
+    for (int h = 0; h < tone->tones && h < 5; h++) {
+        c->level[h] = tone->level[h];
+        c->freq[h] = tone->freq[h];
+    }
+    c->fundamental = tone->fundamental;
+    c->ac_power = tone->ac_power;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		run
+//
+//	Returns:	none (results in c)
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- samples = sum of amp[h] * sin(2 pi (h + 1) f t + h), in CHUNK blocks
+//------------------------------------------------------------------------------
+static void run(AbTone *tone, double f, const double *amp, int harmonics, size_t samples, Collected *c)
+{
+    double block[CHUNK];
+    size_t done = 0;
+
+    memset(c, 0, sizeof(*c));
+    while (done < samples) {
+        size_t count = (samples - done < CHUNK) ? samples - done : CHUNK;
+        for (size_t i = 0; i < count; i++) {
+            double t = (double)(done + i) / RATE;
+            block[i] = 0.0;
+            for (int h = 0; h < harmonics; h++) {
+                block[i] += amp[h] * sin(2.0 * M_PI * (h + 1) * f * t + h);
+            }
+        }
+        ab_tone_process(tone, block, count, collect, c);
+        done += count;
+    }
+    ab_tone_finish(tone, collect, c);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_fixed
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void test_fixed(const double *window)
+{
+    static const double amp[3] = { 0.5, 0.005, 0.001 };						//	H2 -40 dB, H3 -54 dB
+    AbTone tone;
+    Collected c;
+
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 5, FRAME, window, 0.0) == 0, "init failed");
+    run(&tone, 1000.0, amp, 3, 4 * FRAME + 123, &c);
+
+    AB_CHECK(c.frames == 4, "%d frames, want 4 (the partial tail is dropped)", c.frames);
+    AB_CHECK(c.locked_frames == 4, "untracked frames must always be locked");
+    for (int h = 0; h < 3; h++) {
+        AB_CHECK(fabs(c.level[h] - amp[h]) < 1e-5 * amp[0], "H%d level %.8f, want %.8f",
+                 h + 1, c.level[h], amp[h]);
+        AB_CHECK(c.freq[h] == 1000.0 * (h + 1), "H%d read at %g Hz", h + 1, c.freq[h]);
+    }
+    AB_CHECK(c.level[3] < 1e-6 && c.level[4] < 1e-6, "absent H4/H5 read %.3g / %.3g",
+             c.level[3], c.level[4]);
+
+    double power = (amp[0] * amp[0] + amp[1] * amp[1] + amp[2] * amp[2]) / 2.0;
+    AB_CHECK(fabs(c.ac_power - power) < 1e-4 * power, "AC power %.8f, want %.8f", c.ac_power, power);
+    ab_tone_free(&tone);
+
+//------------------------------------------------------------------------------
+//	10 kHz at 48 kHz: H3 (30 kHz) and up are above Nyquist
+//------------------------------------------------------------------------------
+    static const double one[1] = { 0.25 };
+    AB_CHECK(ab_tone_init(&tone, RATE, 10000.0, 5, FRAME, window, 0.0) == 0, "init failed");
+    AB_CHECK(tone.active == 2, "%d tones below Nyquist, want 2", tone.active);
+    run(&tone, 10000.0, one, 1, 2 * FRAME, &c);
+    AB_CHECK(fabs(c.level[0] - 0.25) < 1e-5, "10 kHz level %.8f", c.level[0]);
+    for (int h = 2; h < 5; h++) {
+        AB_CHECK(tone.level[h] == 0.0 && tone.freq[h] == 0.0, "H%d above Nyquist reads %g at %g Hz",
+                 h + 1, tone.level[h], tone.freq[h]);
+    }
+    ab_tone_free(&tone);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_tracking
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void test_tracking(const double *window)
+{
+    static const double amp[2] = { 0.25, 0.0025 };
+    AbTone tone;
+    Collected c;
+
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 3, FRAME, window, 50.0) == 0, "init failed");
+    run(&tone, 1003.7, amp, 2, 8 * FRAME, &c);
+
+    AB_CHECK(c.locked_frames >= 5, "only %d of %d frames locked", c.locked_frames, c.frames);
+    AB_CHECK(fabs(c.fundamental - 1003.7) < 0.05, "fundamental estimate %.4f Hz, want 1003.7", c.fundamental);
+    AB_CHECK(fabs(c.level[0] - amp[0]) < 1e-3 * amp[0], "tracked level %.6f, want %.6f", c.level[0], amp[0]);
+    AB_CHECK(fabs(c.level[1] - amp[1]) < 2e-2 * amp[1], "tracked H2 level %.6f, want %.6f", c.level[1], amp[1]);
+    AB_CHECK(fabs(c.freq[1] - 2.0 * c.fundamental) < 1e-9, "H2 does not follow the fundamental");
+    ab_tone_free(&tone);
+
+//------------------------------------------------------------------------------
+//	The estimate never leaves nominal +/- track_hz
+//------------------------------------------------------------------------------
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 1, FRAME, window, 10.0) == 0, "init failed");
+    run(&tone, 1100.0, amp, 1, 6 * FRAME, &c);
+    AB_CHECK(tone.fundamental >= 990.0 && tone.fundamental <= 1010.0, "estimate %.3f Hz outside 1000 +/- 10",
+             tone.fundamental);
+    ab_tone_free(&tone);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_short_and_args
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void test_short_and_args(const double *window)
+{
+    static const double amp[1] = { 0.5 };
+    AbTone tone;
+    Collected c;
+
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 3, FRAME, window, 0.0) == 0, "init failed");
+    run(&tone, 1000.0, amp, 1, 3000, &c);
+    AB_CHECK(c.frames == 1, "short input gave %d frames, want 1", c.frames);
+    AB_CHECK(c.level[0] > 0.0 && c.level[0] < 0.5, "zero-padded level %.6f out of range", c.level[0]);
+    ab_tone_free(&tone);
+
+    AB_CHECK(ab_tone_init(&tone, 0.0, 1000.0, 3, FRAME, window, 0.0) != 0, "rate 0 accepted");
+    AB_CHECK(ab_tone_init(&tone, RATE, 0.0, 3, FRAME, window, 0.0) != 0, "fundamental 0 accepted");
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 0, FRAME, window, 0.0) != 0, "0 tones accepted");
+    AB_CHECK(ab_tone_init(&tone, RATE, 1000.0, 3, 0, window, 0.0) != 0, "frame size 0 accepted");
+    ab_tone_free(&tone);
+}
+
+int main(void)
+{
+    const AbWindow *hann = ab_window_get(AB_WINDOW_HANN, FRAME, 0.0);
+    AB_CHECK(hann != NULL, "no Hann window");
+    if (hann) {
+        test_fixed(hann->coeffs);
+        test_tracking(hann->coeffs);
+        test_short_and_args(hann->coeffs);
+    }
+    ab_window_cache_free();
+    return ab_test_report("test_goertzel");
+}
@@ -0,0 +1,328 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	test_ring.c
+//
+//	Behaviour of the SPSC sample ring (src/ab_ring.c):
+//	- Whole-frame writes, full-ring truncation and fill accounting
+//	- Wrap-around: a region crossing the end of the buffer is returned as
+//	  two spans, oldest first, and partial consumes keep the order
+//	- Positions starting just below 2^32 (where a 32-bit counter would
+//	  wrap) keep the sequence intact with a non power of two capacity
+//	- A producer and a consumer thread hand a counting sequence through a
+//	  small ring without losing, repeating or reordering a sample
+//------------------------------------------------------------------------------
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "ab_ring.h"
+#include "ab_test.h"
+
+#define STRESS_SAMPLES			(1u << 20)								//	Samples through the threaded test
+#define STRESS_FRAMES			61										//	Ring size, prime so spans land everywhere
+#define STRESS_CHANNELS			2
+
+//------------------------------------------------------------------------------
+//	Name:		fill_sequence
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void fill_sequence(float *dst, size_t count, float first)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = first + (float)i;
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		check_spans
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- The readable region must be exactly 'count' samples continuing the
+//	  sequence from 'first', split across the spans as expected
+//------------------------------------------------------------------------------
+static void check_spans(AbRing *ring, size_t count, float first, size_t expect_first_span)
+{
+    AbRingSpans spans;
+    size_t total = ab_ring_peek(ring, &spans);
+
+    AB_CHECK(total == count, "peek returned %zu samples, want %zu", total, count);
+    AB_CHECK(spans.count[0] + spans.count[1] == total, "spans hold %zu + %zu, total %zu",
+             spans.count[0], spans.count[1], total);
+    AB_CHECK(spans.count[0] == expect_first_span, "first span %zu samples, want %zu",
+             spans.count[0], expect_first_span);
+
+    size_t k = 0;
+    for (int s = 0; s < 2; s++) {
+        for (size_t i = 0; i < spans.count[s]; i++, k++) {
+            AB_CHECK(spans.data[s][i] == first + (float)k, "span %d sample %zu is %g, want %g",
+                     s, i, spans.data[s][i], first + (float)k);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_single_thread
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void test_single_thread(void)
+{
+    float src[64];
+
+    AB_CHECK(ab_ring_create(0, 2) == NULL, "zero frames must fail");
+    AB_CHECK(ab_ring_create(8, 0) == NULL, "zero channels must fail");
+
+    AbRing *ring = ab_ring_create(8, 2);										//	16 samples
+    AB_CHECK(ring != NULL, "create failed");
+    if (!ring) {
+        return;
+    }
+    AB_CHECK(ab_ring_capacity(ring) == 16, "capacity %zu, want 16", ab_ring_capacity(ring));
+    check_spans(ring, 0, 0.0f, 0);
+
+//------------------------------------------------------------------------------
+//	Contiguous write and consume
+//------------------------------------------------------------------------------
+    fill_sequence(src, 10, 0.0f);
+    AB_CHECK(ab_ring_write(ring, src, 10) == 10, "write of 10 into an empty ring");
+    AB_CHECK(ab_ring_fill(ring) == 10, "fill %zu, want 10", ab_ring_fill(ring));
+    check_spans(ring, 10, 0.0f, 10);
+    ab_ring_consume(ring, 10);
+    AB_CHECK(ab_ring_fill(ring) == 0, "fill %zu after consuming everything", ab_ring_fill(ring));
+
+//------------------------------------------------------------------------------
+//	Write at position 10 of 16: 6 samples at the end, 6 at the start
+//------------------------------------------------------------------------------
+    fill_sequence(src, 12, 100.0f);
+    AB_CHECK(ab_ring_write(ring, src, 12) == 12, "wrapping write of 12");
+    check_spans(ring, 12, 100.0f, 6);
+
+    AbRingSpans spans;
+    ab_ring_peek(ring, &spans);
+    AB_CHECK(spans.data[0] + spans.count[0] == spans.data[1] + ab_ring_capacity(ring),
+             "first span must end at the end of the buffer, second start at its beginning");
+
+//------------------------------------------------------------------------------
+//	Full ring: only whole frames of the 4 free samples are stored
+//------------------------------------------------------------------------------
+    fill_sequence(src, 5, 112.0f);
+    AB_CHECK(ab_ring_write(ring, src, 5) == 4, "write of 5 with 4 free must store 4");
+    AB_CHECK(ab_ring_write(ring, src, 2) == 0, "write into a full ring must store nothing");
+    AB_CHECK(ab_ring_fill(ring) == 16, "fill %zu, want 16", ab_ring_fill(ring));
+    check_spans(ring, 16, 100.0f, 6);
+
+//------------------------------------------------------------------------------
+//	Partial consume inside the first span, then across the wrap
+//------------------------------------------------------------------------------
+    ab_ring_consume(ring, 4);
+    check_spans(ring, 12, 104.0f, 2);
+    ab_ring_consume(ring, 6);													//	Read position now 4
+    check_spans(ring, 6, 110.0f, 6);
+
+    fill_sequence(src, 3, 116.0f);
+    AB_CHECK(ab_ring_write(ring, src, 3) == 2, "odd count must be cut to whole frames");
+    check_spans(ring, 8, 110.0f, 8);
+    ab_ring_consume(ring, 8);
+
+//------------------------------------------------------------------------------
+//	Many laps with varying sizes keep the sequence intact
+//------------------------------------------------------------------------------
+    size_t read_pos = 28;														//	Samples consumed so far
+    size_t next_write = 200;
+    size_t next_read = 200;
+    for (int lap = 0; lap < 500; lap++) {
+        size_t want = (size_t)((lap * 7) % 17) & ~(size_t)1;
+        fill_sequence(src, want, (float)next_write);
+        next_write += ab_ring_write(ring, src, want);
+
+        size_t fill = ab_ring_fill(ring);
+        size_t to_end = 16 - read_pos % 16;
+        AB_CHECK(fill == next_write - next_read, "fill %zu does not match the counters", fill);
+        check_spans(ring, fill, (float)next_read, (fill < to_end) ? fill : to_end);
+
+        size_t take = (lap % 3 == 0) ? fill : fill / 2 - (fill / 2) % 2;
+        ab_ring_consume(ring, take);
+        next_read += take;
+        read_pos += take;
+    }
+
+    ab_ring_destroy(ring);
+    ab_ring_destroy(NULL);
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_counter_wrap
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- 5 frames of 3 channels: 2^32 is not a multiple of 15, so a counter
+//	  reduced to 32 bits would jump to a different slot at the boundary
+//	- The expected first span is computed from the full 64-bit position
+//------------------------------------------------------------------------------
+static void test_counter_wrap(void)
+{
+    const uint64_t start = ((uint64_t)1 << 32) - 40;
+    float src[15];
+
+    AbRing *ring = ab_ring_create(5, 3);
+    AB_CHECK(ring != NULL, "create failed");
+    if (!ring) {
+        return;
+    }
+    ab_ring_reset(ring, start);
+    AB_CHECK(ab_ring_fill(ring) == 0, "fill %zu after reset", ab_ring_fill(ring));
+
+    uint64_t read_pos = start;
+    float next_write = 0.0f;
+    float next_read = 0.0f;
+    for (int lap = 0; lap < 40; lap++) {
+        size_t want = (size_t)(3 + 3 * (lap % 4));								//	3..12, whole frames
+        fill_sequence(src, want, next_write);
+        size_t stored = ab_ring_write(ring, src, want);
+        AB_CHECK(stored == want, "lap %d: stored %zu of %zu", lap, stored, want);
+        next_write += (float)stored;
+
+        size_t fill = (size_t)(next_write - next_read);
+        size_t to_end = 15 - (size_t)(read_pos % 15);
+        check_spans(ring, fill, next_read, (fill < to_end) ? fill : to_end);
+
+        ab_ring_consume(ring, fill);
+        next_read += (float)fill;
+        read_pos += fill;
+    }
+    AB_CHECK(read_pos > ((uint64_t)1 << 32), "test did not cross 2^32 (ended at %llu)",
+             (unsigned long long)read_pos);
+
+    ab_ring_destroy(ring);
+}
+
+//------------------------------------------------------------------------------
+//	Threaded test: the producer writes 0, 1, 2 ... and the consumer checks
+//	every sample it sees
+//------------------------------------------------------------------------------
+typedef struct {
+    AbRing *ring;
+    size_t total;
+} StressArgs;
+
+//------------------------------------------------------------------------------
+//	Name:		producer
+//
+//	Returns:	NULL
+//
+//------------------------------------------------------------------------------
+static void *producer(void *arg)
+{
+    StressArgs *args = (StressArgs *)arg;
+    float block[40];
+    size_t sent = 0;
+
+    while (sent < args->total) {
+        size_t want = sizeof(block) / sizeof(block[0]);
+        if (want > args->total - sent) {
+            want = args->total - sent;
+        }
+        for (size_t i = 0; i < want; i++) {
+            block[i] = (float)((sent + i) % 65536);								//	Exact in float
+        }
+        size_t stored = ab_ring_write(args->ring, block, want);
+        if (stored == 0) {
+            sched_yield();														//	Ring full: let the consumer run
+        }
+        sent += stored;
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		test_threaded
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void test_threaded(void)
+{
+    StressArgs args;
+    pthread_t thread;
+
+    args.ring = ab_ring_create(STRESS_FRAMES, STRESS_CHANNELS);
+    args.total = STRESS_SAMPLES;
+    AB_CHECK(args.ring != NULL, "create failed");
+    if (!args.ring || pthread_create(&thread, NULL, producer, &args) != 0) {
+        AB_CHECK(0, "could not start the producer thread");
+        ab_ring_destroy(args.ring);
+        return;
+    }
+
+    size_t received = 0;
+    size_t errors = 0;
+    while (received < args.total) {
+        AbRingSpans spans;
+        if (ab_ring_peek(args.ring, &spans) == 0) {
+            sched_yield();
+            continue;
+        }
+        for (int s = 0; s < 2; s++) {
+            for (size_t i = 0; i < spans.count[s]; i++) {
+                if (spans.data[s][i] != (float)((received + i) % 65536)) {
+                    errors++;
+                }
+            }
+            AB_CHECK(spans.count[s] % STRESS_CHANNELS == 0, "span of %zu samples is not whole frames",
+                     spans.count[s]);
+            ab_ring_consume(args.ring, spans.count[s]);
+            received += spans.count[s];
+        }
+    }
+    pthread_join(thread, NULL);
+
+    AB_CHECK(errors == 0, "%zu of %zu samples arrived out of sequence", errors, received);
+    AB_CHECK(received == args.total, "received %zu samples, sent %zu", received, args.total);
+    AB_CHECK(ab_ring_fill(args.ring) == 0, "ring not empty at the end");
+    ab_ring_destroy(args.ring);
+}
+
+int main(void)
+{
+    test_single_thread();
+    test_counter_wrap();
+    test_threaded();
+    return ab_test_report("test_ring");
+}
@@ -0,0 +1,399 @@
+//------------------------------------------------------------------------------
+//	The MIT License (MIT)
+//
+//	Copyright (c) 2025 A.C. Verbeck
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//	test_wavmap.c
+//
+//	Behaviour of the memory-mapped WAV / RF64 reader (src/ab_wavmap.c).
+//	Files are written byte by byte from known integer or float samples:
+//	- 16/24/32-bit PCM and 32/64-bit float WAV, stereo with an odd-sized
+//	  chunk (and its pad byte) before the data
+//	- The same as WAVE_FORMAT_EXTENSIBLE and as RF64 (ds64 sizes)
+//	Every file must decode to the exact expected values, to what
+//	sf_readf_double() / sf_readf_float() return, and through the mono and
+//	offset readers; non-WAV input must be refused.
+//
+//	Usage: test_wavmap [scratch directory]
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sndfile.h>
+#include "ab_wavmap.h"
+#include "ab_test.h"
+
+#define TEST_FRAMES				1037									//	Odd, so no read is a neat block
+#define TEST_CHANNELS			2
+#define TEST_RATE				96000
+
+#define WAVE_FORMAT_PCM			1
+#define WAVE_FORMAT_IEEE_FLOAT	3
+#define WAVE_FORMAT_EXTENSIBLE	0xFFFE
+
+typedef enum {
+    CONTAINER_WAV,
+    CONTAINER_WAVEX,
+    CONTAINER_RF64
+} Container;
+
+typedef struct {
+    const char *name;
+    int format_tag;												//	PCM or IEEE float
+    int bits;
+    int sf_subtype;
+} SampleFormat;
+
+static const SampleFormat formats[] = {
+    { "pcm16", WAVE_FORMAT_PCM,        16, SF_FORMAT_PCM_16 },
+    { "pcm24", WAVE_FORMAT_PCM,        24, SF_FORMAT_PCM_24 },
+    { "pcm32", WAVE_FORMAT_PCM,        32, SF_FORMAT_PCM_32 },
+    { "float", WAVE_FORMAT_IEEE_FLOAT, 32, SF_FORMAT_FLOAT },
+    { "double", WAVE_FORMAT_IEEE_FLOAT, 64, SF_FORMAT_DOUBLE },
+};
+
+//------------------------------------------------------------------------------
+//	Little-endian writers
+//------------------------------------------------------------------------------
+static void put16(FILE *f, uint32_t v)
+{
+    fputc((int)(v & 0xFF), f);
+    fputc((int)((v >> 8) & 0xFF), f);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+    put16(f, v & 0xFFFF);
+    put16(f, v >> 16);
+}
+
+static void put64(FILE *f, uint64_t v)
+{
+    put32(f, (uint32_t)v);
+    put32(f, (uint32_t)(v >> 32));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		sample_value
+//
+//	Returns:	test sample i as an integer of 'bits' (PCM) or a float code
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- The first samples are full-scale negative, full-scale positive, 0
+//	  and -1; the rest come from a fixed LCG, so every byte lane varies
+//------------------------------------------------------------------------------
+static int64_t sample_value(size_t i, int bits)
+{
+    int64_t lo = -((int64_t)1 << (bits - 1));
+    int64_t hi = ((int64_t)1 << (bits - 1)) - 1;
+    static const int64_t fixed[] = { 0, 0, 0, -1 };
+
+    switch (i) {
+    case 0:
+        return lo;
+    case 1:
+        return hi;
+    case 2:
+    case 3:
+        return fixed[i];
+    }
+    uint64_t x = (uint64_t)i * 6364136223846793005ULL + 1442695040888963407ULL;
+    x ^= x >> 29;
+    return lo + (int64_t)(x % (uint64_t)(hi - lo + 1));
+}
+
+//------------------------------------------------------------------------------
+//	Name:		expected_value
+//
+//	Returns:	the value every reader must produce for sample i
+//
+//------------------------------------------------------------------------------
+static double expected_value(const SampleFormat *fmt, size_t i)
+{
+    if (fmt->format_tag == WAVE_FORMAT_PCM) {
+        return (double)sample_value(i, fmt->bits) / (double)((int64_t)1 << (fmt->bits - 1));
+    }
+    if (fmt->bits == 32) {
+        return (double)(float)((double)sample_value(i, 24) / 4194304.0);		//	Up to +/- 2.0: float is not clipped
+    }
+    return (double)sample_value(i, 53) / 2251799813685248.0;					//	2^51: exact in double, +/- 2.0
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_sample
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void write_sample(FILE *f, const SampleFormat *fmt, size_t i)
+{
+    if (fmt->format_tag == WAVE_FORMAT_PCM) {
+        uint64_t v = (uint64_t)sample_value(i, fmt->bits);
+        for (int b = 0; b < fmt->bits / 8; b++) {
+            fputc((int)((v >> (8 * b)) & 0xFF), f);
+        }
+    } else if (fmt->bits == 32) {
+        float x = (float)expected_value(fmt, i);
+        uint32_t u;
+        memcpy(&u, &x, sizeof(u));
+        put32(f, u);
+    } else {
+        double x = expected_value(fmt, i);
+        uint64_t u;
+        memcpy(&u, &x, sizeof(u));
+        put64(f, u);
+    }
+}
+
+//------------------------------------------------------------------------------
+//	Name:		write_test_file
+//
+//	Returns:	0 on success, -1 if the file could not be written
+//
+//------------------------------------------------------------------------------
+//	Detailed description:
+//	- Layout: RIFF/RF64 header, ds64 (RF64 only), fmt (16 or 40 bytes),
+//	  a 3-byte "note" chunk plus pad byte, then data
+//	- RF64 writes 0xFFFFFFFF in both 32-bit size fields, as a recorder
+//	  that has passed 4 GiB does
+//------------------------------------------------------------------------------
+static int write_test_file(const char *path, Container container, const SampleFormat *fmt,
+                           int valid_bits)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return -1;
+    }
+
+    uint32_t block_align = (uint32_t)(TEST_CHANNELS * fmt->bits / 8);
+    uint64_t data_size = (uint64_t)TEST_FRAMES * block_align;
+    uint32_t fmt_size = (container == CONTAINER_WAV) ? 16 : 40;
+    uint32_t ds64_size = 28;
+    uint64_t riff_size = 4 + (8 + fmt_size) + (8 + 4) + (8 + data_size);
+    if (container == CONTAINER_RF64) {
+        riff_size += 8 + ds64_size;
+    }
+
+    if (container == CONTAINER_RF64) {
+        fwrite("RF64", 1, 4, f);
+        put32(f, 0xFFFFFFFFu);
+        fwrite("WAVE", 1, 4, f);
+        fwrite("ds64", 1, 4, f);
+        put32(f, ds64_size);
+        put64(f, riff_size);
+        put64(f, data_size);
+        put64(f, TEST_FRAMES);
+        put32(f, 0);														//	No table entries
+    } else {
+        fwrite("RIFF", 1, 4, f);
+        put32(f, (uint32_t)riff_size);
+        fwrite("WAVE", 1, 4, f);
+    }
+
+    fwrite("fmt ", 1, 4, f);
+    put32(f, fmt_size);
+    put16(f, (container == CONTAINER_WAV) ? (uint32_t)fmt->format_tag : WAVE_FORMAT_EXTENSIBLE);
+    put16(f, TEST_CHANNELS);
+    put32(f, TEST_RATE);
+    put32(f, TEST_RATE * block_align);
+    put16(f, block_align);
+    put16(f, (uint32_t)fmt->bits);
+    if (fmt_size == 40) {
+        static const unsigned char guid_tail[14] = {							//	KSDATAFORMAT_SUBTYPE_* after the tag
+            0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+        };
+        put16(f, 22);															//	cbSize
+        put16(f, (uint32_t)valid_bits);											//	Valid bits
+        put32(f, 0x3);															//	Front left | front right
+        put16(f, (uint32_t)fmt->format_tag);
+        fwrite(guid_tail, 1, sizeof(guid_tail), f);
+    }
+
+    fwrite("note", 1, 4, f);
+    put32(f, 3);
+    fwrite("ab\0", 1, 4, f);													//	3 bytes + pad
+
+    fwrite("data", 1, 4, f);
+    put32(f, (container == CONTAINER_RF64) ? 0xFFFFFFFFu : (uint32_t)data_size);
+    for (size_t i = 0; i < (size_t)TEST_FRAMES * TEST_CHANNELS; i++) {
+        write_sample(f, fmt, i);
+    }
+
+    return (fclose(f) == 0) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+//	Name:		check_file
+//
+//	Returns:	none
+//
+//------------------------------------------------------------------------------
+static void check_file(const char *path, Container container, const SampleFormat *fmt)
+{
+    static const int containers[] = { SF_FORMAT_WAV, SF_FORMAT_WAVEX, SF_FORMAT_RF64 };
+    size_t samples = (size_t)TEST_FRAMES * TEST_CHANNELS;
+    AbWavMap map;
+
+    if (ab_wavmap_open(path, &map) != 0) {
+        AB_CHECK(0, "%s: ab_wavmap_open failed", path);
+        return;
+    }
+    AB_CHECK(map.frames == TEST_FRAMES, "%s: %zu frames, want %d", path, map.frames, TEST_FRAMES);
+    AB_CHECK(map.channels == TEST_CHANNELS, "%s: %d channels", path, map.channels);
+    AB_CHECK(map.sample_rate == TEST_RATE, "%s: rate %d", path, map.sample_rate);
+    AB_CHECK(map.format == (containers[container] | fmt->sf_subtype), "%s: format 0x%x, want 0x%x",
+             path, map.format, containers[container] | fmt->sf_subtype);
+
+    double *got = (double *)malloc((samples + 2 * TEST_CHANNELS) * sizeof(double));
+    double *ref = (double *)malloc(samples * sizeof(double));
+    float *got_f = (float *)malloc(samples * sizeof(float));
+    float *ref_f = (float *)malloc(samples * sizeof(float));
+    if (!got || !ref || !got_f || !ref_f) {
+        AB_CHECK(0, "out of memory");
+        free(got);
+        free(ref);
+        free(got_f);
+        free(ref_f);
+        ab_wavmap_close(&map);
+        return;
+    }
+
+//------------------------------------------------------------------------------
+//	Known values, whole file (asking for more frames than there are)
+//------------------------------------------------------------------------------
+    size_t n = ab_wavmap_read_double(&map, 0, got, TEST_FRAMES + 2);
+    AB_CHECK(n == TEST_FRAMES, "%s: read_double returned %zu frames", path, n);
+    size_t bad = 0;
+    for (size_t i = 0; i < samples; i++) {
+        bad += (got[i] != expected_value(fmt, i));
+    }
+    AB_CHECK(bad == 0, "%s: %zu of %zu samples differ from the written values", path, bad, samples);
+
+    n = ab_wavmap_read_float(&map, 0, got_f, TEST_FRAMES);
+    bad = 0;
+    for (size_t i = 0; i < samples; i++) {
+        bad += (got_f[i] != (float)expected_value(fmt, i));
+    }
+    AB_CHECK(n == TEST_FRAMES && bad == 0, "%s: read_float: %zu frames, %zu samples differ", path, n, bad);
+
+//------------------------------------------------------------------------------
+//	Offset, mono and past-the-end reads
+//------------------------------------------------------------------------------
+    size_t start = 501;
+    n = ab_wavmap_read_double(&map, start, got, 16);
+    bad = 0;
+    for (size_t i = 0; i < 16 * TEST_CHANNELS; i++) {
+        bad += (got[i] != expected_value(fmt, start * TEST_CHANNELS + i));
+    }
+    AB_CHECK(n == 16 && bad == 0, "%s: offset read: %zu frames, %zu samples differ", path, n, bad);
+
+    n = ab_wavmap_read_mono(&map, TEST_FRAMES - 3, got, 10);
+    bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t s = (TEST_FRAMES - 3 + i) * TEST_CHANNELS;
+        double mono = (expected_value(fmt, s) + expected_value(fmt, s + 1)) / TEST_CHANNELS;
+        bad += (got[i] != mono);
+    }
+    AB_CHECK(n == 3 && bad == 0, "%s: mono tail read: %zu frames, %zu differ", path, n, bad);
+    AB_CHECK(ab_wavmap_read_double(&map, TEST_FRAMES, got, 4) == 0, "%s: read at the end must be empty", path);
+
+//------------------------------------------------------------------------------
+//	libsndfile must agree bit for bit
+//------------------------------------------------------------------------------
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    SNDFILE *sf = sf_open(path, SFM_READ, &info);
+    AB_CHECK(sf != NULL, "%s: libsndfile cannot open it: %s", path, sf_strerror(NULL));
+    if (sf) {
+        AB_CHECK(info.frames == TEST_FRAMES && info.channels == TEST_CHANNELS,
+                 "%s: libsndfile sees %lld frames, %d channels", path, (long long)info.frames, info.channels);
+        sf_count_t got_frames = sf_readf_double(sf, ref, TEST_FRAMES);
+        ab_wavmap_read_double(&map, 0, got, TEST_FRAMES);
+        AB_CHECK(got_frames == TEST_FRAMES && memcmp(got, ref, samples * sizeof(double)) == 0,
+                 "%s: read_double differs from sf_readf_double", path);
+
+        sf_seek(sf, 0, SEEK_SET);
+        got_frames = sf_readf_float(sf, ref_f, TEST_FRAMES);
+        AB_CHECK(got_frames == TEST_FRAMES && memcmp(got_f, ref_f, samples * sizeof(float)) == 0,
+                 "%s: read_float differs from sf_readf_float", path);
+        sf_close(sf);
+    }
+
+    free(got);
+    free(ref);
+    free(got_f);
+    free(ref_f);
+    ab_wavmap_close(&map);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *container_names[] = { "wav", "wavex", "rf64" };
+    const char *dir = (argc > 1) ? argv[1] : ".";
+    char path[1024];
+
+    for (int c = CONTAINER_WAV; c <= CONTAINER_RF64; c++) {
+        for (size_t k = 0; k < sizeof(formats) / sizeof(formats[0]); k++) {
+            snprintf(path, sizeof(path), "%s/wavmap_%s_%s.wav", dir, container_names[c], formats[k].name);
+            if (write_test_file(path, (Container)c, &formats[k], formats[k].bits) != 0) {
+                AB_CHECK(0, "could not write %s", path);
+                continue;
+            }
+            check_file(path, (Container)c, &formats[k]);
+            remove(path);
+        }
+    }
+
+//------------------------------------------------------------------------------
+//	Extensible 24-in-32 (valid bits below the container) is refused; the
+//	tools then read it through libsndfile
+//------------------------------------------------------------------------------
+    AbWavMap map;
+    snprintf(path, sizeof(path), "%s/wavmap_wavex_pcm24in32.wav", dir);
+    if (write_test_file(path, CONTAINER_WAVEX, &formats[2], 24) == 0) {
+        AB_CHECK(ab_wavmap_open(path, &map) != 0, "24-in-32 extensible file was accepted");
+        ab_wavmap_close(&map);
+        remove(path);
+    } else {
+        AB_CHECK(0, "could not write %s", path);
+    }
+
+//------------------------------------------------------------------------------
+//	Not a WAV file: refused, and the map is left closed
+//------------------------------------------------------------------------------
+    snprintf(path, sizeof(path), "%s/wavmap_not_a_wav.txt", dir);
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        fputs("RIFF....AVI LIST not audio at all", f);
+        fclose(f);
+    }
+    AB_CHECK(ab_wavmap_open(path, &map) != 0, "non-WAV file was accepted");
+    AB_CHECK(map.base == NULL, "failed open left a mapping");
+    ab_wavmap_close(&map);
+    remove(path);
+    AB_CHECK(ab_wavmap_open("/nonexistent/ab_wavmap.wav", &map) != 0, "missing file was accepted");
+
+    return ab_test_report("test_wavmap");
+}